@@ -0,0 +1,170 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "bench_utils.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace bench {
+
+namespace {
+
+// The number of sampled states over which each benchmark iterates.
+const size_t NUM_STATES = 4096;
+
+/* Measures `PushWorldPuzzle::getNextState` for every action in every state. */
+void BM_GetNextState(::benchmark::State& bench_state, const char* filename) {
+  const PushWorldPuzzle puzzle(filename);
+  const auto states = sample_states(puzzle, NUM_STATES);
+  RelativeState next;
+  int num_moved = 0;
+
+  for (auto _ : bench_state) {
+    for (const auto& relative_state : states) {
+      for (int action = 0; action < NUM_ACTIONS; action++) {
+        num_moved += puzzle.getNextState(relative_state.state, action, next);
+      }
+    }
+    ::benchmark::DoNotOptimize(num_moved);
+  }
+  report_calls(bench_state, states.size() * NUM_ACTIONS);
+}
+
+/**
+ * Identical to `BM_GetNextState`, except that `getNextState` uses the given
+ * `kernel`.
+ */
+void BM_GetNextStateKernel(::benchmark::State& bench_state,
+                           const char* filename,
+                           const TransitionKernel kernel) {
+  PushWorldPuzzle puzzle(filename);
+  puzzle.setTransitionKernel(kernel);
+  const auto states = sample_states(puzzle, NUM_STATES);
+  RelativeState next;
+  int num_moved = 0;
+
+  for (auto _ : bench_state) {
+    for (const auto& relative_state : states) {
+      for (int action = 0; action < NUM_ACTIONS; action++) {
+        num_moved += puzzle.getNextState(relative_state.state, action, next);
+      }
+    }
+    ::benchmark::DoNotOptimize(num_moved);
+  }
+  report_calls(bench_state, states.size() * NUM_ACTIONS);
+}
+
+/**
+ * Returns a 12x12 puzzle that contains the agent and `num_objects - 1` movable
+ * objects of one pixel each, which are spread evenly over the grid.
+ */
+PushWorldPuzzle make_puzzle_with_objects(const int num_objects) {
+  const int size = 12;
+  std::vector<std::string> cells(size * size, ".");
+  // 7 is coprime with the number of cells, so all objects are distinct.
+  for (int i = 0; i < num_objects; i++) {
+    cells[i * 7 % cells.size()] = i == 0 ? "A" : "M" + std::to_string(i - 1);
+  }
+  cells[num_objects * 7 % cells.size()] = "G0";
+
+  std::string text;
+  for (int i = 0; i < int(cells.size()); i++) {
+    text += cells[i] + ((i + 1) % size == 0 ? "\n" : " ");
+  }
+  return PushWorldPuzzle::fromText(text);
+}
+
+/**
+ * Identical to `BM_GetNextStateKernel`, except that the puzzle is generated by
+ * `make_puzzle_with_objects` with the number of objects in `range(0)`. This
+ * compares the kernels across the object counts at which
+ * `TransitionKernel::AUTO` selects each of them.
+ */
+void BM_GetNextStateKernelObjects(::benchmark::State& bench_state,
+                                  const TransitionKernel kernel) {
+  auto puzzle = make_puzzle_with_objects(bench_state.range(0));
+  puzzle.setTransitionKernel(kernel);
+  const auto states = sample_states(puzzle, NUM_STATES);
+  RelativeState next;
+  int num_moved = 0;
+
+  for (auto _ : bench_state) {
+    for (const auto& relative_state : states) {
+      for (int action = 0; action < NUM_ACTIONS; action++) {
+        num_moved += puzzle.getNextState(relative_state.state, action, next);
+      }
+    }
+    ::benchmark::DoNotOptimize(num_moved);
+  }
+  report_calls(bench_state, states.size() * NUM_ACTIONS);
+}
+
+/* Measures `PushWorldPuzzle::satisfiesGoal` in every state. */
+void BM_SatisfiesGoal(::benchmark::State& bench_state, const char* filename) {
+  const PushWorldPuzzle puzzle(filename);
+  const auto states = sample_states(puzzle, NUM_STATES);
+  int num_goals = 0;
+
+  for (auto _ : bench_state) {
+    for (const auto& relative_state : states) {
+      num_goals += puzzle.satisfiesGoal(relative_state.state);
+    }
+    ::benchmark::DoNotOptimize(num_goals);
+  }
+  report_calls(bench_state, states.size());
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_GetNextState, level1, LEVEL1_PUZZLE);
+BENCHMARK_CAPTURE(BM_GetNextState, level2, LEVEL2_PUZZLE);
+BENCHMARK_CAPTURE(BM_GetNextState, level3, LEVEL3_PUZZLE);
+BENCHMARK_CAPTURE(BM_GetNextState, level4, LEVEL4_PUZZLE);
+
+BENCHMARK_CAPTURE(BM_GetNextStateKernel, level2_scalar, LEVEL2_PUZZLE,
+                  TransitionKernel::SCALAR);
+BENCHMARK_CAPTURE(BM_GetNextStateKernel, level2_simd, LEVEL2_PUZZLE,
+                  TransitionKernel::SIMD);
+BENCHMARK_CAPTURE(BM_GetNextStateKernel, level2_fixed_size, LEVEL2_PUZZLE,
+                  TransitionKernel::FIXED_SIZE);
+BENCHMARK_CAPTURE(BM_GetNextStateKernel, many_objects_scalar,
+                  MANY_OBJECTS_PUZZLE, TransitionKernel::SCALAR);
+BENCHMARK_CAPTURE(BM_GetNextStateKernel, many_objects_simd,
+                  MANY_OBJECTS_PUZZLE, TransitionKernel::SIMD);
+BENCHMARK_CAPTURE(BM_GetNextStateKernel, many_objects_fixed_size,
+                  MANY_OBJECTS_PUZZLE, TransitionKernel::FIXED_SIZE);
+
+// Fixed-size kernels exist up to `FIXED_SIZE_KERNEL_MAX_OBJECTS` objects.
+BENCHMARK_CAPTURE(BM_GetNextStateKernelObjects, scalar,
+                  TransitionKernel::SCALAR)
+    ->DenseRange(8, FIXED_SIZE_KERNEL_MAX_OBJECTS + 8, 8);
+BENCHMARK_CAPTURE(BM_GetNextStateKernelObjects, simd, TransitionKernel::SIMD)
+    ->DenseRange(8, FIXED_SIZE_KERNEL_MAX_OBJECTS + 8, 8);
+BENCHMARK_CAPTURE(BM_GetNextStateKernelObjects, fixed_size,
+                  TransitionKernel::FIXED_SIZE)
+    ->DenseRange(8, FIXED_SIZE_KERNEL_MAX_OBJECTS, 8);
+
+BENCHMARK_CAPTURE(BM_SatisfiesGoal, level1, LEVEL1_PUZZLE);
+BENCHMARK_CAPTURE(BM_SatisfiesGoal, level2, LEVEL2_PUZZLE);
+BENCHMARK_CAPTURE(BM_SatisfiesGoal, level3, LEVEL3_PUZZLE);
+BENCHMARK_CAPTURE(BM_SatisfiesGoal, level4, LEVEL4_PUZZLE);
+
+}  // namespace bench
+}  // namespace pushworld
@@ -0,0 +1,70 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "bench_utils.h"
+
+#include <vector>
+
+namespace pushworld {
+namespace bench {
+
+const char* const LEVEL1_PUZZLE = "puzzles/level1/A Tight Squeeze.pwp";
+const char* const LEVEL2_PUZZLE = "puzzles/level2/Bottle Opener.pwp";
+const char* const LEVEL3_PUZZLE = "puzzles/level3/Armor.pwp";
+const char* const LEVEL4_PUZZLE = "puzzles/level4/Cup Stacking.pwp";
+const char* const MANY_OBJECTS_PUZZLE = "puzzles/level2/Clean Sweep.pwp";
+
+std::vector<RelativeState> sample_states(const PushWorldPuzzle& puzzle,
+                                         const size_t max_num_states) {
+  const State& initial_state = puzzle.getInitialState();
+
+  RelativeState initial{initial_state, {}};
+  for (int i = 0; i < initial_state.size(); i++) {
+    initial.moved_object_indices.push_back(i);
+  }
+
+  std::vector<RelativeState> states{initial};
+  StateSet visited{initial_state};
+  RelativeState next;
+
+  // `states` doubles as the breadth-first search queue.
+  for (size_t i = 0; i < states.size() && states.size() < max_num_states;
+       i++) {
+    // Copy the state, since `push_back` below may reallocate `states`.
+    const State state = states[i].state;
+    for (int action = 0; action < NUM_ACTIONS; action++) {
+      if (puzzle.getNextState(state, action, next) &&
+          visited.insert(next.state).second) {
+        states.push_back(next);
+        if (states.size() == max_num_states) {
+          break;
+        }
+      }
+    }
+  }
+
+  return states;
+}
+
+void report_calls(::benchmark::State& bench_state,
+                  const size_t calls_per_iteration) {
+  const size_t num_calls = bench_state.iterations() * calls_per_iteration;
+  bench_state.SetItemsProcessed(num_calls);
+  bench_state.counters["time_per_call"] = ::benchmark::Counter(
+      num_calls, ::benchmark::Counter::kIsRate | ::benchmark::Counter::kInvert);
+}
+
+}  // namespace bench
+}  // namespace pushworld
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BENCH_BENCH_UTILS_H_
+#define BENCH_BENCH_UTILS_H_
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace bench {
+
+/*
+ * Paths of representative puzzles from each level of the benchmark, relative
+ * to the directory that contains the benchmark executable.
+ */
+extern const char* const LEVEL1_PUZZLE;
+extern const char* const LEVEL2_PUZZLE;
+extern const char* const LEVEL3_PUZZLE;
+extern const char* const LEVEL4_PUZZLE;
+
+/* The path of a puzzle with many movable objects. */
+extern const char* const MANY_OBJECTS_PUZZLE;
+
+/**
+ * Returns up to `max_num_states` distinct states of the `puzzle` in the order
+ * in which a breadth-first search from the initial state first visits them.
+ * Every returned state except the first is paired with the indices of the
+ * objects that moved from its parent state, as in a real search, and the first
+ * element is the initial state with all objects marked as moved.
+ */
+std::vector<RelativeState> sample_states(const PushWorldPuzzle& puzzle,
+                                         const size_t max_num_states);
+
+/**
+ * Reports the throughput of a benchmark that performs `calls_per_iteration`
+ * calls of the measured function per iteration, as both items per second and
+ * the mean time per call.
+ */
+void report_calls(::benchmark::State& bench_state,
+                  const size_t calls_per_iteration);
+
+}  // namespace bench
+}  // namespace pushworld
+
+#endif /* BENCH_BENCH_UTILS_H_ */
@@ -0,0 +1,51 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+#include "bench_utils.h"
+#include "heuristics/domain_transition_graph.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace bench {
+
+namespace {
+
+/* Measures `build_feasible_movement_graphs` for all objects in a puzzle. */
+void BM_BuildFeasibleMovementGraphs(::benchmark::State& bench_state,
+                                    const char* filename) {
+  const PushWorldPuzzle puzzle(filename);
+
+  for (auto _ : bench_state) {
+    auto graphs = heuristic::build_feasible_movement_graphs(puzzle);
+    ::benchmark::DoNotOptimize(graphs);
+  }
+  report_calls(bench_state, 1);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_BuildFeasibleMovementGraphs, level1, LEVEL1_PUZZLE)
+    ->Unit(::benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_BuildFeasibleMovementGraphs, level2, LEVEL2_PUZZLE)
+    ->Unit(::benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_BuildFeasibleMovementGraphs, level3, LEVEL3_PUZZLE)
+    ->Unit(::benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_BuildFeasibleMovementGraphs, level4, LEVEL4_PUZZLE)
+    ->Unit(::benchmark::kMicrosecond);
+
+}  // namespace bench
+}  // namespace pushworld
@@ -0,0 +1,62 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+#include "bench_utils.h"
+#include "heuristics/novelty.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace bench {
+
+namespace {
+
+// The number of sampled states that each iteration evaluates.
+const size_t NUM_STATES = 4096;
+
+/**
+ * Measures `NoveltyHeuristic::estimate_cost_to_goal` on states in the order of
+ * a breadth-first search. Every iteration starts from a new heuristic, since
+ * the novelty of a state depends on all previously evaluated states.
+ */
+void BM_NoveltyHeuristic(::benchmark::State& bench_state,
+                         const char* filename) {
+  const PushWorldPuzzle puzzle(filename);
+  const auto states = sample_states(puzzle, NUM_STATES);
+  float sum = 0;
+
+  for (auto _ : bench_state) {
+    bench_state.PauseTiming();
+    heuristic::NoveltyHeuristic novelty(puzzle);
+    bench_state.ResumeTiming();
+
+    for (const auto& relative_state : states) {
+      sum += novelty.estimate_cost_to_goal(relative_state);
+    }
+    ::benchmark::DoNotOptimize(sum);
+  }
+  report_calls(bench_state, states.size());
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_NoveltyHeuristic, level1, LEVEL1_PUZZLE);
+BENCHMARK_CAPTURE(BM_NoveltyHeuristic, level2, LEVEL2_PUZZLE);
+BENCHMARK_CAPTURE(BM_NoveltyHeuristic, level3, LEVEL3_PUZZLE);
+BENCHMARK_CAPTURE(BM_NoveltyHeuristic, level4, LEVEL4_PUZZLE);
+
+}  // namespace bench
+}  // namespace pushworld
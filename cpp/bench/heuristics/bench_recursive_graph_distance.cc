@@ -0,0 +1,113 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "bench_utils.h"
+#include "heuristics/recursive_graph_distance.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace bench {
+
+namespace {
+
+// The number of sampled states that each iteration evaluates.
+const size_t NUM_STATES = 1024;
+
+/**
+ * Measures the construction of the tables that are shared by all instances of
+ * `RecursiveGraphDistanceHeuristic` for a puzzle.
+ */
+void BM_RecursiveGraphDistanceTables(::benchmark::State& bench_state,
+                                     const char* filename) {
+  const PushWorldPuzzle puzzle(filename);
+
+  for (auto _ : bench_state) {
+    heuristic::RecursiveGraphDistanceTables tables(puzzle);
+    ::benchmark::DoNotOptimize(tables);
+  }
+  report_calls(bench_state, 1);
+}
+
+/**
+ * Measures `RecursiveGraphDistanceHeuristic::estimate_cost_to_goal` on states
+ * in the order of a breadth-first search.
+ *
+ * If `cold_cache` is true, every iteration starts from a new heuristic with an
+ * empty pushing-cost cache, which resembles the start of a search. Otherwise,
+ * the same heuristic is reused, so after the first iteration all pushing costs
+ * are cached.
+ */
+void BM_RecursiveGraphDistanceHeuristic(::benchmark::State& bench_state,
+                                        const char* filename,
+                                        const bool cold_cache) {
+  const auto puzzle = std::make_shared<PushWorldPuzzle>(filename);
+  const auto tables =
+      std::make_shared<const heuristic::RecursiveGraphDistanceTables>(*puzzle);
+  const auto states = sample_states(*puzzle, NUM_STATES);
+  auto rgd = std::make_unique<heuristic::RecursiveGraphDistanceHeuristic>(
+      puzzle, tables);
+  float sum = 0;
+
+  for (auto _ : bench_state) {
+    if (cold_cache) {
+      bench_state.PauseTiming();
+      rgd = std::make_unique<heuristic::RecursiveGraphDistanceHeuristic>(
+          puzzle, tables);
+      bench_state.ResumeTiming();
+    }
+
+    for (const auto& relative_state : states) {
+      sum += rgd->estimate_cost_to_goal(relative_state);
+    }
+    ::benchmark::DoNotOptimize(sum);
+  }
+  report_calls(bench_state, states.size());
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceTables, level1, LEVEL1_PUZZLE)
+    ->Unit(::benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceTables, level2, LEVEL2_PUZZLE)
+    ->Unit(::benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceTables, level3, LEVEL3_PUZZLE)
+    ->Unit(::benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceTables, level4, LEVEL4_PUZZLE)
+    ->Unit(::benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceHeuristic, level1_cold,
+                  LEVEL1_PUZZLE, true);
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceHeuristic, level2_cold,
+                  LEVEL2_PUZZLE, true);
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceHeuristic, level3_cold,
+                  LEVEL3_PUZZLE, true);
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceHeuristic, level4_cold,
+                  LEVEL4_PUZZLE, true);
+
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceHeuristic, level1_warm,
+                  LEVEL1_PUZZLE, false);
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceHeuristic, level2_warm,
+                  LEVEL2_PUZZLE, false);
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceHeuristic, level3_warm,
+                  LEVEL3_PUZZLE, false);
+BENCHMARK_CAPTURE(BM_RecursiveGraphDistanceHeuristic, level4_warm,
+                  LEVEL4_PUZZLE, false);
+
+}  // namespace bench
+}  // namespace pushworld
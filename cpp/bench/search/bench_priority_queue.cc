@@ -0,0 +1,83 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "bench_utils.h"
+#include "search/priority_queue.h"
+
+namespace pushworld {
+namespace bench {
+
+namespace {
+
+/**
+ * Pushes `bench_state.range(0)` elements with random priorities in the interval
+ * [0, `bench_state.range(1)`) and then pops all of them. Few distinct
+ * priorities resemble the frontier of a search with a coarse heuristic, such as
+ * novelty.
+ */
+template <typename Queue>
+void BM_PushPop(::benchmark::State& bench_state) {
+  const int num_elements = bench_state.range(0);
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<int> distribution(0, bench_state.range(1) - 1);
+  std::vector<int> priorities(num_elements);
+  for (auto& priority : priorities) {
+    priority = distribution(generator);
+  }
+
+  Queue queue;
+  int sum = 0;
+
+  for (auto _ : bench_state) {
+    for (int i = 0; i < num_elements; i++) {
+      queue.push(i, priorities[i]);
+    }
+    while (!queue.empty()) {
+      sum += queue.top();
+      queue.pop();
+    }
+    ::benchmark::DoNotOptimize(sum);
+  }
+  // Each element is pushed and popped once.
+  report_calls(bench_state, 2 * num_elements);
+}
+
+void push_pop_arguments(::benchmark::internal::Benchmark* benchmark) {
+  for (const int num_elements : {1 << 10, 1 << 16}) {
+    for (const int num_priorities : {4, 1 << 10}) {
+      benchmark->Args({num_elements, num_priorities});
+    }
+  }
+  benchmark->ArgNames({"elements", "priorities"});
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_PushPop,
+                   priority_queue::FibonacciPriorityQueue<int, int>)
+    ->Apply(push_pop_arguments);
+BENCHMARK_TEMPLATE(BM_PushPop, priority_queue::BucketPriorityQueue<int, int>)
+    ->Apply(push_pop_arguments);
+BENCHMARK_TEMPLATE(BM_PushPop,
+                   priority_queue::IntegerBucketPriorityQueue<int, int>)
+    ->Apply(push_pop_arguments);
+
+}  // namespace bench
+}  // namespace pushworld
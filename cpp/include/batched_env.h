@@ -0,0 +1,252 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef BATCHED_ENV_H_
+#define BATCHED_ENV_H_
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+
+// The default pixel width of the border drawn to indicate object boundaries.
+static const int DEFAULT_BORDER_WIDTH = 2;
+
+// The default pixel width and height of a discrete position (i.e. cell) in a
+// rendered observation.
+static const int DEFAULT_PIXELS_PER_CELL = 20;
+
+/**
+ * Draws observations of the states of a puzzle into caller-provided buffers.
+ *
+ * Observations are identical to the images from `render_observation_padded`
+ * in the Python package: RGB images with shape (height, width, 3) in row-major
+ * order, with `float` values in [0, 1], in which the image of the puzzle is
+ * centered and padded with zeros.
+ *
+ * All static parts of the image are drawn once on construction, so rendering
+ * a state only copies the background and draws the movable objects and goals.
+ */
+class ObservationRenderer {
+ private:
+  // A solid rectangle of pixels, measured relative to the top left pixel of an
+  // object (or of the image, for static objects).
+  struct Rectangle {
+    int row;
+    int column;
+    int num_rows;
+    int num_columns;
+    float color[3];
+  };
+
+  int m_height;
+  int m_width;
+  int m_pixels_per_cell;
+  int m_row_padding;
+  int m_column_padding;
+  std::vector<float> m_background;
+
+  // `m_object_rectangles[i]` draws the object with index `i` in a `State`.
+  std::vector<std::vector<Rectangle>> m_object_rectangles;
+
+  // Goals are drawn on top of all objects, at fixed positions.
+  std::vector<Rectangle> m_goal_rectangles;
+
+  void draw(const Rectangle& rectangle, const int row, const int column,
+            float* observation) const;
+
+ public:
+  /**
+   * Constructs a renderer for observations with `height_cells` rows and
+   * `width_cells` columns of cells, which must be at least the size of the
+   * `puzzle`.
+   *
+   * Throws `std::invalid_argument` if the puzzle has no object shapes, if the
+   * puzzle does not fit in the observation, or if the `border_width` is not in
+   * [1, (`pixels_per_cell` - 1) / 2].
+   */
+  ObservationRenderer(const PushWorldPuzzle& puzzle, const int height_cells,
+                      const int width_cells, const int pixels_per_cell,
+                      const int border_width);
+
+  /* Returns the number of rows of pixels in each observation. */
+  int getHeight() const { return m_height; };
+
+  /* Returns the number of columns of pixels in each observation. */
+  int getWidth() const { return m_width; };
+
+  /* Returns the number of `float` values in each observation. */
+  size_t getSize() const { return m_background.size(); };
+
+  /**
+   * Writes an observation of the `state` into the `observation`, which must
+   * have room for `getSize()` values.
+   */
+  void render(const Position2D* state, float* observation) const;
+};
+
+/**
+ * Steps a batch of PushWorld environments at once, for reinforcement learning.
+ *
+ * Each environment plays one puzzle at a time, which is randomly selected from
+ * the puzzles given to the constructor whenever the environment is reset. The
+ * rewards are identical to those of `PushWorldEnv` in the Python package: 10
+ * for solving the puzzle, and otherwise the change in the number of achieved
+ * goals minus a step penalty of 0.01.
+ *
+ * The states of all environments are stored in one contiguous array, and all
+ * observations, rewards, and episode flags are written into caller-provided
+ * buffers, so that they can be shared with other languages without copying.
+ * Buffers for observations may be null, in which case nothing is rendered.
+ *
+ * This class is not thread-safe.
+ */
+class BatchedPushWorldEnv {
+ private:
+  std::vector<std::shared_ptr<const PushWorldPuzzle>> m_puzzles;
+  std::vector<ObservationRenderer> m_renderers;
+  int m_num_envs;
+  int m_state_size;
+  int m_max_steps;
+  bool m_auto_reset;
+  std::mt19937_64 m_random_generator;
+
+  // The state of environment `i` begins at `m_states[i * m_state_size]`. Any
+  // positions beyond the number of objects in a puzzle are zero.
+  std::vector<Position2D> m_states;
+  std::vector<int32_t> m_puzzle_indices;
+  std::vector<int32_t> m_steps;
+  std::vector<int32_t> m_achieved_goals;
+
+  // Scratch memory for computing transitions.
+  State m_state;
+  RelativeState m_next;
+  TransitionScratch m_scratch;
+
+  Position2D* getState(const int env) {
+    return m_states.data() + env * m_state_size;
+  };
+
+  int countAchievedGoals(const int env) const;
+
+ public:
+  /**
+   * Constructs `num_envs` environments, all of which must be reset before they
+   * are stepped.
+   *
+   * @param puzzles All puzzles that the environments can play. Every puzzle
+   *   must have object shapes, i.e. it must be loaded from a file.
+   * @param num_envs The number of environments in the batch.
+   * @param max_steps If positive, an episode is truncated after this many
+   *   steps since its most recent reset.
+   * @param auto_reset Whether `step` resets every environment whose episode
+   *   ends.
+   * @param height_cells, width_cells The size of every observation, measured
+   *   in cells. If zero, the maximum size of the `puzzles` is used.
+   * @param pixels_per_cell, border_width Determine how cells are drawn. See
+   *   `ObservationRenderer`.
+   * @param seed Seeds the random selection of puzzles.
+   *
+   * Throws `std::invalid_argument` if any argument is invalid.
+   */
+  BatchedPushWorldEnv(
+      const std::vector<std::shared_ptr<const PushWorldPuzzle>>& puzzles,
+      const int num_envs, const int max_steps = 0, const bool auto_reset = true,
+      const int height_cells = 0, const int width_cells = 0,
+      const int pixels_per_cell = DEFAULT_PIXELS_PER_CELL,
+      const int border_width = DEFAULT_BORDER_WIDTH, const uint64_t seed = 123);
+
+  /* Returns the number of environments in the batch. */
+  int getNumEnvs() const { return m_num_envs; };
+
+  /* Returns the number of puzzles that the environments can play. */
+  int getNumPuzzles() const { return m_puzzles.size(); };
+
+  /* Returns the number of rows of pixels in each observation. */
+  int getObservationHeight() const { return m_renderers[0].getHeight(); };
+
+  /* Returns the number of columns of pixels in each observation. */
+  int getObservationWidth() const { return m_renderers[0].getWidth(); };
+
+  /* Returns the number of `float` values in each observation. */
+  size_t getObservationSize() const { return m_renderers[0].getSize(); };
+
+  /**
+   * Returns the number of positions that are stored for the state of each
+   * environment, which is the maximum number of objects in all puzzles.
+   */
+  int getStateSize() const { return m_state_size; };
+
+  /**
+   * Returns the states of all environments as an array with shape
+   * (`getNumEnvs()`, `getStateSize()`).
+   */
+  const Position2D* getStates() const { return m_states.data(); };
+
+  /* Returns the index of the puzzle that each environment is playing. */
+  const int32_t* getPuzzleIndices() const { return m_puzzle_indices.data(); };
+
+  /* Returns the number of steps since each environment was reset. */
+  const int32_t* getSteps() const { return m_steps.data(); };
+
+  /* Returns the puzzle with the given index. */
+  const PushWorldPuzzle& getPuzzle(const int puzzle_index) const {
+    return *m_puzzles[puzzle_index];
+  };
+
+  /**
+   * Resets all environments to the initial states of randomly selected
+   * puzzles. If `observations` is not null, it receives the observations of
+   * all environments in order.
+   */
+  void reset(float* observations);
+
+  /**
+   * Resets the environment with index `env` to the initial state of the puzzle
+   * with index `puzzle_index`, or of a randomly selected puzzle if
+   * `puzzle_index` is negative. If `observation` is not null, it receives the
+   * observation of this environment.
+   */
+  void resetEnv(const int env, const int puzzle_index, float* observation);
+
+  /**
+   * Performs `actions[i]` in environment `i` for every environment in the
+   * batch, and writes the resulting observations, rewards, and whether each
+   * episode terminated (i.e. solved its puzzle) or was truncated (i.e. reached
+   * the step limit). Each output array must have one element per environment,
+   * and `observations` has `getObservationSize()` values per environment.
+   *
+   * If auto-reset is enabled, every environment whose episode ends is reset,
+   * and its observation is the first observation of the new episode.
+   *
+   * Throws `std::invalid_argument` without changing any environment if an
+   * action is invalid.
+   */
+  void step(const Action* actions, float* observations, double* rewards,
+            uint8_t* terminated, uint8_t* truncated);
+
+  /* Writes the observation of the environment with index `env`. */
+  void render(const int env, float* observation) const;
+};
+
+}  // namespace pushworld
+
+#endif /* BATCHED_ENV_H_ */
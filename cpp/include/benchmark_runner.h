@@ -0,0 +1,129 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BENCHMARK_RUNNER_H_
+#define BENCHMARK_RUNNER_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>  // pair
+#include <vector>
+
+#include "puzzle_collection.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+
+/**
+ * The result of running a planner on a single puzzle, which has the same
+ * fields as the YAML results of `benchmark_rgd.py` in the Python package.
+ */
+struct PlanningResult {
+  // The name of the planner, e.g. "Novelty+RGD".
+  std::string planner;
+
+  // The name of the puzzle file, excluding its directory and extension.
+  std::string puzzle;
+
+  // A string of 'UDLR' characters, or `std::nullopt` if no plan was found.
+  std::optional<std::string> plan;
+
+  // In seconds, the wall-clock time that the planner spent searching for a
+  // plan, including building its heuristics.
+  double planning_time;
+
+  // If a plan was not found, this summarizes why.
+  std::optional<std::string> failure_reason;
+};
+
+/**
+ * Per-puzzle resource limits for `run_planner_with_limits`, which are the
+ * deadline and the memory budget of a `search::SearchContext`. Each limit is
+ * disabled if it is `std::nullopt`.
+ */
+struct PlanningLimits {
+  // In seconds, the maximum wall-clock time to solve a puzzle.
+  std::optional<int> time_limit;
+
+  // In bytes, the maximum memory of the states, search nodes and heuristics
+  // of the search of a puzzle.
+  std::optional<size_t> memory_limit;
+};
+
+/**
+ * Returns the planner name that is reported in the results of the given `mode`
+ * of `solve`. Throws `std::domain_error` if the mode is not recognized.
+ */
+std::string get_planner_name(const std::string& mode);
+
+/**
+ * Returns (puzzle file path, result file path) pairs for every PushWorld puzzle
+ * in the `puzzles_path`, which may be either a .pwp file or a directory that is
+ * searched recursively. Result files have the .yaml extension and replicate
+ * the subdirectory structure of `puzzles_path` within `results_path`. All
+ * directories of the result files are created if they do not exist.
+ *
+ * Pairs are sorted by puzzle file path. Throws `std::invalid_argument` if
+ * `puzzles_path` is a file without the .pwp extension or if it does not exist.
+ */
+std::vector<std::pair<std::string, std::string>> map_puzzle_files(
+    const std::string& puzzles_path, const std::string& results_path);
+
+/**
+ * Returns (puzzle index, result file path) pairs for every puzzle in the
+ * `collection`. Result files have the .yaml extension and replicate the
+ * directories of the puzzles within the archive in `results_path`. All
+ * directories of the result files are created if they do not exist.
+ */
+std::vector<std::pair<size_t, std::string>> map_collection_puzzles(
+    const PuzzleCollection& collection, const std::string& results_path);
+
+/**
+ * Returns the `result` in the YAML format that `yaml.dump` produces in
+ * `benchmark_rgd.py`, with keys in sorted order.
+ */
+std::string to_yaml(const PlanningResult& result);
+
+/**
+ * Solves the puzzle in the `puzzle_path` using the given `mode` of `solve`.
+ *
+ * The puzzle is solved in the calling thread, so multiple puzzles can be
+ * solved concurrently by different threads, each with its own `limits`. The
+ * limits are the deadline and the memory budget of the `search::SearchContext`
+ * of the search, which stops cleanly when it reaches one of them. If building
+ * the heuristics runs out of memory, the result is also a memory error.
+ *
+ * Every plan is verified with `PushWorldPuzzle::isValidPlan` before it is
+ * returned in the result. Throws `std::domain_error` if the mode is not
+ * recognized.
+ */
+PlanningResult run_planner_with_limits(const std::string& mode,
+                                       const std::string& puzzle_path,
+                                       const PlanningLimits& limits);
+
+/**
+ * Identical to `run_planner_with_limits` above, except that the `puzzle` is
+ * already loaded, e.g. from a `PuzzleCollection`, so no files are read. The
+ * `puzzle_name` is reported in the result.
+ */
+PlanningResult run_planner_with_limits(
+    const std::string& mode, const std::shared_ptr<PushWorldPuzzle>& puzzle,
+    const std::string& puzzle_name, const PlanningLimits& limits);
+
+}  // namespace pushworld
+
+#endif /* BENCHMARK_RUNNER_H_ */
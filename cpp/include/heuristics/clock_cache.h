@@ -0,0 +1,221 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HEURISTICS_CLOCK_CACHE_H_
+#define HEURISTICS_CLOCK_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>  // hash
+#include <vector>
+
+namespace pushworld {
+namespace heuristic {
+
+/* Counts the outcomes of operations on a cache. */
+struct CacheStatistics {
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t evictions = 0;
+};
+
+/**
+ * A cache with a fixed memory budget that evicts entries with the CLOCK
+ * algorithm, which approximates least-recently-used eviction.
+ *
+ * Entries are stored inline in an open-addressing hash table with linear
+ * probing. The table doubles in size as entries are inserted until it reaches
+ * the memory budget, after which the cache never allocates. Every entry has a
+ * "referenced" bit that is set when the entry is found. When the cache is full,
+ * a clock hand sweeps over the table, clearing referenced bits until it finds
+ * an unreferenced entry to evict.
+ *
+ * `Key` and `Value` must be default-constructible and copyable.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ClockCache {
+ private:
+  struct Slot {
+    Key key;
+    Value value;
+    size_t hash;
+    bool occupied = false;
+    bool referenced = false;
+  };
+
+  // The minimum number of slots. Must be a power of 2.
+  static constexpr size_t MIN_NUM_SLOTS = 16;
+
+  Hash m_hasher;
+  std::vector<Slot> m_slots;
+  size_t m_slot_mask;
+  size_t m_size;
+  size_t m_max_num_slots;
+  size_t m_hand;
+  CacheStatistics m_statistics;
+
+  /**
+   * Returns the hash of the `key`, with bits mixed by the SplitMix64 finalizer
+   * so that the low bits are suitable for indexing slots.
+   */
+  size_t hash(const Key& key) const {
+    uint64_t x = m_hasher(key);
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+  /**
+   * Returns the slot that contains the `key`, or otherwise the empty slot where
+   * it should be inserted.
+   */
+  size_t findSlot(const Key& key, const size_t hash) const {
+    size_t slot = hash & m_slot_mask;
+    while (m_slots[slot].occupied &&
+           !(m_slots[slot].hash == hash && m_slots[slot].key == key)) {
+      slot = (slot + 1) & m_slot_mask;
+    }
+    return slot;
+  }
+
+  /**
+   * Empties the `slot` and shifts later entries in its probe sequence backward
+   * so that they remain reachable.
+   */
+  void erase(size_t slot) {
+    size_t next = slot;
+    while (true) {
+      next = (next + 1) & m_slot_mask;
+      if (!m_slots[next].occupied) {
+        break;
+      }
+
+      // The entry in `next` can move into `slot` unless its home slot is
+      // cyclically in the interval (slot, next].
+      const size_t home = m_slots[next].hash & m_slot_mask;
+      if (((next - home) & m_slot_mask) >= ((next - slot) & m_slot_mask)) {
+        m_slots[slot] = m_slots[next];
+        slot = next;
+      }
+    }
+    m_slots[slot].occupied = false;
+    m_size--;
+  }
+
+  /* Doubles the number of slots and reinserts all entries. */
+  void grow() {
+    std::vector<Slot> old_slots(m_slots.size() * 2);
+    old_slots.swap(m_slots);
+    m_slot_mask = m_slots.size() - 1;
+
+    for (const auto& old_slot : old_slots) {
+      if (old_slot.occupied) {
+        m_slots[findSlot(old_slot.key, old_slot.hash)] = old_slot;
+      }
+    }
+  }
+
+  /* Evicts one entry that has not been referenced since the hand last passed. */
+  void evict() {
+    while (true) {
+      Slot& slot = m_slots[m_hand];
+      if (slot.occupied) {
+        if (!slot.referenced) {
+          erase(m_hand);
+          m_statistics.evictions++;
+          return;
+        }
+        slot.referenced = false;
+      }
+      m_hand = (m_hand + 1) & m_slot_mask;
+    }
+  }
+
+ public:
+  /**
+   * Constructs an empty cache whose table grows to at most `max_bytes` bytes,
+   * except that the table always has at least `MIN_NUM_SLOTS` slots. At most
+   * half of the slots are occupied, which keeps probe sequences short.
+   */
+  explicit ClockCache(const size_t max_bytes) {
+    m_max_num_slots = MIN_NUM_SLOTS;
+    while (m_max_num_slots * 2 * sizeof(Slot) <= max_bytes) {
+      m_max_num_slots *= 2;
+    }
+    m_slots.resize(MIN_NUM_SLOTS);
+    m_slot_mask = MIN_NUM_SLOTS - 1;
+    m_size = 0;
+    m_hand = 0;
+  }
+
+  /* Returns the number of entries in this cache. */
+  size_t size() const { return m_size; };
+
+  /* Returns the maximum number of entries that this cache can store. */
+  size_t capacity() const { return m_max_num_slots / 2; };
+
+  /* Returns the number of bytes of memory that this cache has allocated. */
+  size_t memoryUsage() const { return m_slots.capacity() * sizeof(Slot); };
+
+  /* Returns the counts of hits, misses, and evictions since construction. */
+  const CacheStatistics& statistics() const { return m_statistics; };
+
+  /**
+   * Returns a pointer to the value associated with the `key`, or `nullptr` if
+   * the key is not in this cache. The pointer is invalidated by `insert`.
+   */
+  const Value* find(const Key& key) {
+    Slot& slot = m_slots[findSlot(key, hash(key))];
+    if (!slot.occupied) {
+      m_statistics.misses++;
+      return nullptr;
+    }
+    m_statistics.hits++;
+    slot.referenced = true;
+    return &slot.value;
+  }
+
+  /**
+   * Associates the `value` with the `key`, which must not already be in this
+   * cache. Evicts an entry if the cache is full.
+   */
+  void insert(const Key& key, const Value& value) {
+    if (m_size == m_slots.size() / 2) {
+      if (m_slots.size() < m_max_num_slots) {
+        grow();
+      } else {
+        evict();
+      }
+    }
+
+    const size_t key_hash = hash(key);
+    Slot& slot = m_slots[findSlot(key, key_hash)];
+    slot.key = key;
+    slot.value = value;
+    slot.hash = key_hash;
+    slot.occupied = true;
+    slot.referenced = false;
+    m_size++;
+  }
+};
+
+}  // namespace heuristic
+}  // namespace pushworld
+
+#endif /* HEURISTICS_CLOCK_CACHE_H_ */
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef HEURISTICS_DEAD_END_DETECTOR_H_
+#define HEURISTICS_DEAD_END_DETECTOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "heuristics/domain_transition_graph.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace heuristic {
+
+/**
+ * Detects states from which the goal is provably unreachable, which allows a
+ * search to discard them before evaluating a heuristic.
+ *
+ * The feasible movement graph of each object over-approximates every movement
+ * that the object can make in any state that is reachable from the initial
+ * state. Regressing from the goal, this class marks every node of a goal
+ * object's graph from which a path to the object's goal position exists. Any
+ * other position of a goal object is a dead end, since no sequence of actions
+ * can move the object from there to its goal position.
+ *
+ * This class is immutable after construction, so it can be shared by any
+ * number of threads.
+ */
+class DeadEndDetector {
+ private:
+  // Indexed by goal index. The goal object has the ID `goal_index + 1`.
+  std::vector<DenseMovementGraph> m_graphs;
+
+  // `m_goal_reachable_bits[i]` has one bit per node of `m_graphs[i]`, which is
+  // set if the goal position is reachable from the node.
+  std::vector<std::vector<uint64_t>> m_goal_reachable_bits;
+
+  // The number of positions in all graphs that are dead ends.
+  int m_num_dead_end_positions;
+
+ public:
+  /* Builds the feasible movement graphs of the `puzzle` to detect dead ends. */
+  explicit DeadEndDetector(const PushWorldPuzzle& puzzle);
+
+  /**
+   * Detects dead ends of the `puzzle` using its `movement_graphs`, as
+   * returned by `build_feasible_movement_graphs`.
+   */
+  DeadEndDetector(const PushWorldPuzzle& puzzle,
+                  const std::unordered_map<
+                      int, std::shared_ptr<FeasibleMovementGraph>>&
+                      movement_graphs);
+
+  /**
+   * Returns whether the object with the given ID cannot reach its goal position
+   * from the `position`. Always returns false for objects without a goal.
+   */
+  bool isDeadEndPosition(const int object_id,
+                         const Position2D position) const {
+    const int goal_index = object_id - 1;
+    if (goal_index < 0 || goal_index >= int(m_graphs.size())) {
+      return false;
+    }
+    const int node = m_graphs[goal_index].getNodeIndex(position);
+    return node < 0 ||
+           !((m_goal_reachable_bits[goal_index][node / 64] >> (node % 64)) & 1);
+  }
+
+  /* Returns whether any goal object in the `state` is in a dead end. */
+  bool isDeadEnd(const State& state) const;
+
+  /**
+   * Returns whether any object in `relative_state.moved_object_indices` is in a
+   * dead end. This is equivalent to `isDeadEnd(relative_state.state)` if the
+   * state before the movement was not a dead end.
+   */
+  bool isDeadEnd(const RelativeState& relative_state) const {
+    for (const int i : relative_state.moved_object_indices) {
+      if (isDeadEndPosition(i, relative_state.state[i])) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Returns the number of positions in the feasible movement graphs of all goal
+   * objects that are dead ends.
+   */
+  int numDeadEndPositions() const { return m_num_dead_end_positions; }
+};
+
+}  // namespace heuristic
+}  // namespace pushworld
+
+#endif /* HEURISTICS_DEAD_END_DETECTOR_H_ */
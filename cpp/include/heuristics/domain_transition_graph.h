@@ -17,6 +17,8 @@
 #ifndef HEURISTICS_DOMAIN_TRANSITION_GRAPH_H_
 #define HEURISTICS_DOMAIN_TRANSITION_GRAPH_H_
 
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -96,6 +98,144 @@ class PathDistances {
   float getDistance(const Position2D start, const Position2D target) const;
 };
 
+/**
+ * A compact, immutable copy of a `FeasibleMovementGraph` that is stored in
+ * dense arrays over the bounding box of its positions.
+ *
+ * Every movement in a `FeasibleMovementGraph` displaces an object by one of the
+ * `ACTION_DISPLACEMENTS`, so the outgoing edges of each position are stored as
+ * a mask with one bit per action. Every position in the graph also has a node
+ * index in the interval [0, numNodes()), assigned in increasing order of
+ * positions.
+ */
+class DenseMovementGraph {
+ public:
+  using ActionMask = uint8_t;
+
+ private:
+  // Bounds of all positions in the graph.
+  int m_min_x;
+  int m_min_y;
+  int m_width;
+  int m_height;
+
+  // For each position in the bounds, stores the node index, or -1 if the
+  // position is not in the graph.
+  std::vector<int> m_node_indices;
+
+  // For each node index, stores the position and the mask of actions that move
+  // to other nodes.
+  std::vector<Position2D> m_positions;
+  std::vector<ActionMask> m_action_masks;
+
+ public:
+  explicit DenseMovementGraph(const FeasibleMovementGraph& graph);
+
+  /* Returns the number of positions in the graph. */
+  int numNodes() const { return m_positions.size(); };
+
+  /* Returns the node index of the `position`, or -1 if it is not a node. */
+  int getNodeIndex(const Position2D position) const {
+    int x, y;
+    displacement_to_xy(position, x, y);
+    x -= m_min_x;
+    y -= m_min_y;
+
+    // Negative values wrap around to large unsigned values.
+    if (unsigned(x) >= unsigned(m_width) || unsigned(y) >= unsigned(m_height)) {
+      return -1;
+    }
+    return m_node_indices[x * m_height + y];
+  };
+
+  /* Returns the position of the node with the given index. */
+  Position2D getPosition(const int node_index) const {
+    return m_positions[node_index];
+  };
+
+  /**
+   * Returns the mask of actions that move from the node with the given index to
+   * another node. Bit `a` is set if action `a` is a feasible movement.
+   */
+  ActionMask getActionMask(const int node_index) const {
+    return m_action_masks[node_index];
+  };
+
+  /**
+   * Returns the node index that a feasible `action` moves to from the node with
+   * the given index.
+   */
+  int getNextNodeIndex(const int node_index, const Action action) const {
+    return getNodeIndex(m_positions[node_index] + ACTION_DISPLACEMENTS[action]);
+  };
+};
+
+/**
+ * Stores the number of movements on the shortest path between every pair of
+ * positions in a `FeasibleMovementGraph`.
+ *
+ * Unlike `PathDistances`, all distances are computed eagerly in the
+ * constructor, so this class is immutable and can be shared by any number of
+ * threads. Distances are stored in a dense matrix of 16-bit integers, which
+ * requires `2 * numNodes()^2` bytes.
+ */
+class AllPairsPathDistances {
+ public:
+  using Distance = uint16_t;
+
+  // Marks pairs of nodes that have no path between them.
+  static constexpr Distance UNREACHABLE = std::numeric_limits<Distance>::max();
+
+ private:
+  DenseMovementGraph m_graph;
+  int m_num_nodes;
+
+  // `m_distances[start * m_num_nodes + target]` contains the distance between
+  // the nodes with indices `start` and `target`.
+  std::vector<Distance> m_distances;
+
+ public:
+  /**
+   * Computes all distances in the `graph`, using up to `num_threads` threads to
+   * run breadth-first searches in parallel.
+   *
+   * Throws `std::domain_error` if the graph has too many positions for its
+   * distances to be stored in a `Distance`.
+   */
+  AllPairsPathDistances(const FeasibleMovementGraph& graph,
+                        const int num_threads = 1);
+
+  /* Returns the dense graph that defines the node indices of all positions. */
+  const DenseMovementGraph& getGraph() const { return m_graph; };
+
+  /* Returns the number of positions in the graph. */
+  int numNodes() const { return m_num_nodes; };
+
+  /**
+   * Returns the number of movements on the shortest path from the node with
+   * index `start` to the node with index `target`, or `UNREACHABLE` if no path
+   * exists.
+   */
+  Distance getNodeDistance(const int start, const int target) const {
+    return m_distances[size_t(start) * m_num_nodes + target];
+  };
+
+  /**
+   * Returns the number of movements on the shortest path from the `start`
+   * position to the `target` position, or infinity if no path exists.
+   */
+  float getDistance(const Position2D start, const Position2D target) const {
+    const int start_index = m_graph.getNodeIndex(start);
+    const int target_index = m_graph.getNodeIndex(target);
+    if (start_index < 0 || target_index < 0) {
+      return std::numeric_limits<float>::infinity();
+    }
+    const Distance distance = getNodeDistance(start_index, target_index);
+    return distance == UNREACHABLE ? std::numeric_limits<float>::infinity()
+                                   : float(distance);
+  };
+};
+
 }  // namespace heuristic
 }  // namespace pushworld
 
@@ -17,9 +17,18 @@
 #ifndef HEURISTICS_HEURISTIC_H_
 #define HEURISTICS_HEURISTIC_H_
 
+#include <cstddef>
+#include <map>
+#include <string>
+
 #include "pushworld_puzzle.h"
 
 namespace pushworld {
+
+namespace search {
+class SearchContext;
+}  // namespace search
+
 namespace heuristic {
 
 /**
@@ -43,6 +52,46 @@ class Heuristic {
    */
   virtual Cost estimate_cost_to_goal(
       const pushworld::RelativeState& relative_state) = 0;
+
+  /**
+   * Estimates the costs of the `num_states` consecutive `states` and writes the
+   * cost of `states[i]` into `costs[i]`. The costs are identical to calling
+   * `estimate_cost_to_goal` on each state in order. Heuristics that combine
+   * other heuristics override this method to evaluate every child heuristic on
+   * the whole batch, which amortizes the virtual calls. By default, calls
+   * `estimate_cost_to_goal` for each state.
+   */
+  virtual void estimate_costs(const pushworld::RelativeState* states,
+                              const size_t num_states, Cost* costs) {
+    for (size_t i = 0; i < num_states; i++) {
+      costs[i] = estimate_cost_to_goal(states[i]);
+    }
+  }
+
+  /**
+   * Adds counters that describe the work done by this heuristic, e.g. cache
+   * hit counts, to the `counters`. Counters with the same name are summed, so
+   * several instances can report into the same map. Does nothing by default.
+   */
+  virtual void add_counters(
+      std::map<std::string, size_t>& /*counters*/) const {}
+
+  /**
+   * Returns the number of bytes of memory that this heuristic has allocated
+   * for state that grows during a search, e.g. caches and visited sets, so
+   * that searches can enforce a memory budget. Returns 0 by default.
+   */
+  virtual size_t memory_usage() const { return 0; }
+
+  /**
+   * Sets the context of the search that evaluates this heuristic, or clears it
+   * if `context` is null. Heuristics with evaluations that can take a long
+   * time may check the `context` during an evaluation and return early once
+   * the search must stop, in which case the returned cost is meaningless.
+   * Does nothing by default.
+   */
+  virtual void set_search_context(
+      const search::SearchContext* /*context*/) {}
 };
 
 }  // namespace heuristic
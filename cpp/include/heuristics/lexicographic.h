@@ -0,0 +1,79 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HEURISTICS_LEXICOGRAPHIC_H_
+#define HEURISTICS_LEXICOGRAPHIC_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>  // pair
+#include <vector>
+
+#include "heuristics/heuristic.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace heuristic {
+
+/**
+ * Combines two heuristics into a lexicographic cost, which orders states first
+ * by the cost of the primary heuristic and then by the cost of the secondary
+ * heuristic.
+ *
+ * An infinite cost from either heuristic indicates that the goal is
+ * unreachable, so in that case both components of the cost are infinite. This
+ * places the state after all states with finite costs.
+ */
+class LexicographicHeuristic : public Heuristic<std::pair<float, float>> {
+ private:
+  std::shared_ptr<Heuristic<float>> m_primary;
+  std::shared_ptr<Heuristic<float>> m_secondary;
+
+  // Reused by `estimate_costs` to avoid allocating memory.
+  std::vector<float> m_primary_costs;
+  std::vector<float> m_secondary_costs;
+
+ public:
+  LexicographicHeuristic(std::shared_ptr<Heuristic<float>> primary,
+                         std::shared_ptr<Heuristic<float>> secondary);
+
+  /**
+   * Returns the pair of costs from the primary and secondary heuristics, or
+   * a pair of infinite costs if either cost is infinite.
+   */
+  std::pair<float, float> estimate_cost_to_goal(
+      const RelativeState& relative_state) override;
+
+  /* Evaluates each heuristic on the whole batch of `states`. */
+  void estimate_costs(const RelativeState* states, const size_t num_states,
+                      std::pair<float, float>* costs) override;
+
+  /* Adds the counters of both heuristics to the `counters`. */
+  void add_counters(std::map<std::string, size_t>& counters) const override;
+
+  /* Returns the memory usage of both heuristics. */
+  size_t memory_usage() const override;
+
+  /* Sets the search context of both heuristics. */
+  void set_search_context(const search::SearchContext* context) override;
+};
+
+}  // namespace heuristic
+}  // namespace pushworld
+
+#endif /* HEURISTICS_LEXICOGRAPHIC_H_ */
@@ -17,10 +17,13 @@
 #ifndef HEURISTICS_NOVELTY_H_
 #define HEURISTICS_NOVELTY_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <unordered_set>
 #include <utility>  // pair
 #include <vector>
 
+#include "heuristics/domain_transition_graph.h"
 #include "heuristics/heuristic.h"
 #include "pushworld_puzzle.h"
 
@@ -46,6 +49,20 @@ struct PositionPairHash {
  * Conference on Artificial Intelligence. 2017.
  *
  * This implementation limits the maximum novelty to 3.
+ *
+ * Visited positions are stored in hash sets by default. When constructed from
+ * a puzzle, the positions of each object are instead indexed by its
+ * `DenseMovementGraph`, which contains every position that the object can
+ * reach, and visited positions and position pairs are stored in dense bitmaps.
+ * Positions that are not in the graphs, and pairs of objects whose bitmap
+ * would be too large, fall back to the hash sets.
+ *
+ * When constructed from a puzzle with `share_interchangeable_objects`, the
+ * objects in each group of `PushWorldPuzzle::getInterchangeableObjects` share
+ * their visited positions, so a state and any permutation of its
+ * interchangeable objects have the same novelty. Searches that canonicalize
+ * states store them in a canonical order, in which an object may occupy a
+ * position that was previously occupied by another object of its group.
  */
 class NoveltyHeuristic : public Heuristic<float> {
  private:
@@ -54,13 +71,54 @@ class NoveltyHeuristic : public Heuristic<float> {
   std::vector<std::vector<std::unordered_set<PositionPair, PositionPairHash>>>
       m_visited_position_pairs;
 
+  // For each object ID, the smallest ID of an object that is interchangeable
+  // with it, which indexes the visited positions of the object.
+  std::vector<int> m_representatives;
+
+  // Indexed by object ID. Empty if positions are only stored in hash sets.
+  // Interchangeable objects have identical graphs.
+  std::vector<DenseMovementGraph> m_movement_graphs;
+
+  // `m_visited_position_bits[r]` has one bit per node of representative `r`.
+  std::vector<std::vector<uint64_t>> m_visited_position_bits;
+
+  // `m_visited_position_pair_bits[r * m_state_size + s]` for representatives
+  // `r <= s` has one bit per pair of nodes of objects `r` and `s`, or is empty
+  // if the pair is stored in `m_visited_position_pairs`.
+  std::vector<std::vector<uint64_t>> m_visited_position_pair_bits;
+
+  // Scratch memory for the node index of every object in a state.
+  std::vector<int> m_node_indices;
+
+  /**
+   * Inserts the positions `p_i` and `p_j` of objects `i != j`, whose node
+   * indices are `n_i` and `n_j`, into the visited pairs of their
+   * representatives. Returns whether the pair was not already visited.
+   */
+  bool visit_position_pair(const int i, const int j, const Position2D p_i,
+                           const Position2D p_j, const int n_i, const int n_j);
+
  public:
+  // The default maximum number of bits in the bitmap of a pair of objects.
+  static constexpr size_t DEFAULT_MAX_PAIR_BITS = size_t(1) << 24;
+
   /**
    * Constructs a heuristic for PushWorld `State` instances that contain the
    * positions of `state_size` objects.
    */
   NoveltyHeuristic(const int state_size);
 
+  /**
+   * Constructs a heuristic for states of the given `puzzle` that stores visited
+   * positions in dense bitmaps. The bitmap of a pair of objects is only
+   * allocated if it requires at most `max_pair_bits` bits. If
+   * `share_interchangeable_objects` is true, interchangeable objects share
+   * their visited positions, as described above.
+   */
+  explicit NoveltyHeuristic(const PushWorldPuzzle& puzzle,
+                            const size_t max_pair_bits = DEFAULT_MAX_PAIR_BITS,
+                            const bool share_interchangeable_objects = false);
+
   /**
    * Measures the novelty of the given `state` by comparing it to previous
    * states provided to this method.
@@ -79,6 +137,12 @@ class NoveltyHeuristic : public Heuristic<float> {
    *     [0, state_size).
    */
   float estimate_cost_to_goal(const RelativeState& relative_state) override;
+
+  /**
+   * Returns the bytes allocated by the bitmaps, and an estimate of the bytes
+   * allocated by the hash sets, of visited positions and position pairs.
+   */
+  size_t memory_usage() const override;
 };
 
 }  // namespace heuristic
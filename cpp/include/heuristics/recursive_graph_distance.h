@@ -17,10 +17,16 @@
 #ifndef HEURISTICS_RECURSIVE_GRAPH_DISTANCE_H_
 #define HEURISTICS_RECURSIVE_GRAPH_DISTANCE_H_
 
+#include <array>
 #include <boost/functional/hash.hpp>
+#include <cstddef>
+#include <map>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "heuristics/clock_cache.h"
 #include "heuristics/domain_transition_graph.h"
 #include "heuristics/heuristic.h"
 #include "pushworld_puzzle.h"
@@ -61,6 +67,110 @@ struct PushingCostCacheKeyHash {
   }
 };
 
+/**
+ * Stores the estimated cost of each `RecursiveGraphDistanceHeuristic` pusher
+ * movement, indexed by the action that moves the pusher. Infinite costs mark
+ * movements that are infeasible or that cannot lead to a push.
+ */
+using PushingCosts = std::array<float, NUM_ACTIONS>;
+
+/**
+ * Immutable tables that the `RecursiveGraphDistanceHeuristic` derives from a
+ * puzzle, independent of any state. All tables are built eagerly by the
+ * constructor, so one instance can be shared by any number of heuristic
+ * instances in any number of threads.
+ *
+ * The tables contain:
+ *   - The feasible movement graph of every object, in its dense form.
+ *   - The distances between all pairs of positions in every movement graph.
+ *   - For every (pusher, pushee, action, pushee position), the positions from
+ * which the pusher can push the pushee without colliding with a static
+ * obstacle, i.e. the "pushing contacts".
+ *
+ * Positions are identified by their node indices in the `DenseMovementGraph`
+ * of the corresponding object.
+ */
+class RecursiveGraphDistanceTables {
+ public:
+  /* A range of node indices that supports range-based `for` loops. */
+  struct NodeIndexRange {
+    const int* first;
+    const int* last;
+
+    const int* begin() const { return first; };
+    const int* end() const { return last; };
+  };
+
+ private:
+  /**
+   * The pushing contacts of one (action, pusher, pushee) combination. The
+   * contacts of the pushee node with index `i` are the pusher node indices in
+   * `contacts[offsets[i]]` up to `contacts[offsets[i + 1]]`.
+   */
+  struct PushingContactTable {
+    std::vector<int> offsets;
+    std::vector<int> contacts;
+  };
+
+  int m_num_objects;
+
+  // Indexed by object ID.
+  std::vector<AllPairsPathDistances> m_path_distances;
+
+  // Indexed by `(action * m_num_objects + pusher_id) * m_num_objects +
+  // pushee_id`.
+  std::vector<PushingContactTable> m_pushing_contacts;
+
+ public:
+  /**
+   * Builds all tables for the `puzzle`, using up to `num_threads` threads to
+   * compute path distances in parallel.
+   */
+  explicit RecursiveGraphDistanceTables(const PushWorldPuzzle& puzzle,
+                                        const int num_threads = 1);
+
+  /* Returns the feasible movement graph of the object with the given ID. */
+  const DenseMovementGraph& getMovementGraph(const int object_id) const {
+    return m_path_distances[object_id].getGraph();
+  };
+
+  /* Returns the path distances of the object with the given ID. */
+  const AllPairsPathDistances& getPathDistances(const int object_id) const {
+    return m_path_distances[object_id];
+  };
+
+  /**
+   * Returns the number of movements on the shortest path from the `start`
+   * position to the `target` position in the movement graph of the object with
+   * the given ID, or infinity if no path exists.
+   */
+  float getDistance(const int object_id, const Position2D start,
+                    const Position2D target) const {
+    return m_path_distances[object_id].getDistance(start, target);
+  };
+
+  /**
+   * Returns the node indices of all positions from which the pusher can
+   * perform the `action` to push the pushee from the node with index
+   * `pushee_node`, such that the pusher's own movement is in its feasible
+   * movement graph. Returns an empty range if `pushee_node` is negative.
+   */
+  NodeIndexRange getPushingContacts(const Action action, const int pusher_id,
+                                    const int pushee_id,
+                                    const int pushee_node) const {
+    const auto& table =
+        m_pushing_contacts[(action * m_num_objects + pusher_id) *
+                               m_num_objects +
+                           pushee_id];
+    if (pushee_node < 0 || table.offsets.empty()) {
+      return NodeIndexRange{nullptr, nullptr};
+    }
+    const int* contacts = table.contacts.data();
+    return NodeIndexRange{contacts + table.offsets[pushee_node],
+                          contacts + table.offsets[pushee_node + 1]};
+  };
+};
+
 /**
  * This Recursive Graph Distance (RGD) heuristic is based on the Fast Downward
  * (FD) heuristic, but with modifications to improve both its speed and the
@@ -83,16 +193,19 @@ class RecursiveGraphDistanceHeuristic : public Heuristic<float> {
  private:
   bool m_fewest_tools;
   std::shared_ptr<PushWorldPuzzle> m_puzzle;
-  std::unordered_map<int, std::shared_ptr<FeasibleMovementGraph>>
-      m_movement_graphs;
-  std::unordered_map<int, PathDistances> m_path_distances;
+  std::shared_ptr<const RecursiveGraphDistanceTables> m_tables;
 
   // A cache of values returned from `get_pushing_costs`.
-  std::unordered_map<PushingCostCacheKey,
-                     std::shared_ptr<std::unordered_map<Position2D, float>>,
-                     PushingCostCacheKeyHash>
+  ClockCache<PushingCostCacheKey, PushingCosts, PushingCostCacheKeyHash>
       m_pushing_cost_cache;
 
+  // See `set_search_context`. `m_stopped` is set once the context must stop
+  // during the current evaluation, after which every recursive pushing cost
+  // is infinite.
+  const search::SearchContext* m_context;
+  int m_calls_until_context_check;
+  bool m_stopped;
+
   /**
    * Returns the estimated cost to move the object with the given `object_id`
    * from its position in the given `state` to the given `goal_position`,
@@ -136,11 +249,11 @@ class RecursiveGraphDistanceHeuristic : public Heuristic<float> {
       const int pushing_depth, const float cost_upper_bound);
 
   /**
-   * Returns a map from pusher positions, which are constrained to be adjacent
-   * to the given `pusher_position`, to the cost of moving the pusher from each
-   * adjacent position into a (possibly non-adjacent) position where it can push
-   * the "pushee" object from the given start position to the given end
-   * position, which must be adjacent.
+   * Returns the costs of moving the pusher from each position that is adjacent
+   * to the given `pusher_position` into a (possibly non-adjacent) position
+   * where it can push the "pushee" object from the given start position to the
+   * given end position, which must be adjacent. Costs are indexed by the action
+   * that moves the pusher from `pusher_position` to each adjacent position.
    *
    * When the pusher's movement from `pusher_position` to an adjacent position
    * directly pushes the pushee from its start position to its end position, the
@@ -150,12 +263,15 @@ class RecursiveGraphDistanceHeuristic : public Heuristic<float> {
    * movement cost, and it searches over all ways that the pusher can make
    * contact with the pushee to determine which has minimum cost.
    */
-  std::shared_ptr<std::unordered_map<Position2D, float>> get_pushing_costs(
+  PushingCosts get_pushing_costs(
       const int pusher_id, const Position2D pusher_position,
       const int pushee_id, const Position2D pushee_start_position,
       const Position2D pushee_end_position);
 
  public:
+  // The default memory budget of the pushing-cost cache in bytes.
+  static const size_t DEFAULT_PUSHING_COST_CACHE_BYTES = size_t(64) << 20;
+
   /**
    * When `fewest_tools` is false, costs are computed by considering an
    * unbounded number of "tools" to perform a single push, where a tool is any
@@ -173,10 +289,30 @@ class RecursiveGraphDistanceHeuristic : public Heuristic<float> {
    * considering all combinations of tools is exponentially expensive in the
    * number of available tools, while setting `fewest_tools` to false results in
    * more accurate estimated costs.
+   *
+   * Intermediate pushing costs are cached in at most
+   * `pushing_cost_cache_bytes` bytes, evicting old entries when the cache is
+   * full. Evictions only affect speed, not the estimated costs.
    */
   RecursiveGraphDistanceHeuristic(
       const std::shared_ptr<PushWorldPuzzle>& puzzle,
-      const bool fewest_tools = true);
+      const bool fewest_tools = true,
+      const size_t pushing_cost_cache_bytes = DEFAULT_PUSHING_COST_CACHE_BYTES);
+
+  /**
+   * Identical to the constructor above, except that the heuristic uses the
+   * given `tables`, which must have been built from the same `puzzle`. Sharing
+   * tables avoids rebuilding them for every heuristic instance, e.g. when each
+   * thread of a parallel search has its own heuristic.
+   *
+   * A heuristic instance is not thread-safe, since it caches pushing costs,
+   * but the shared tables are never modified.
+   */
+  RecursiveGraphDistanceHeuristic(
+      const std::shared_ptr<PushWorldPuzzle>& puzzle,
+      const std::shared_ptr<const RecursiveGraphDistanceTables>& tables,
+      const bool fewest_tools = true,
+      const size_t pushing_cost_cache_bytes = DEFAULT_PUSHING_COST_CACHE_BYTES);
 
   /**
    * Returns the estimated cost to reach the goal in the puzzle provided to the
@@ -185,6 +321,43 @@ class RecursiveGraphDistanceHeuristic : public Heuristic<float> {
    * from the given state.
    */
   float estimate_cost_to_goal(const RelativeState& relative_state) override;
+
+  /**
+   * Adds the hit, miss, and eviction counts of the pushing-cost cache to the
+   * `counters`.
+   */
+  void add_counters(std::map<std::string, size_t>& counters) const override;
+
+  /**
+   * Returns the memory usage of the pushing-cost cache, which is the only
+   * state of this heuristic that grows during a search.
+   */
+  size_t memory_usage() const override {
+    return m_pushing_cost_cache.memoryUsage();
+  };
+
+  /**
+   * Without the fewest-tools constraint, a single evaluation can take a very
+   * long time in puzzles with many objects, so evaluations check the
+   * `context` every `CONTEXT_CHECK_INTERVAL` recursive pushing costs, and
+   * return early once it is cancelled or its deadline has passed.
+   */
+  void set_search_context(const search::SearchContext* context) override {
+    m_context = context;
+  };
+
+  // The number of recursive pushing costs between checks of the context.
+  static const int CONTEXT_CHECK_INTERVAL = 1024;
+
+  /* Returns the hit, miss, and eviction counts of the pushing-cost cache. */
+  const CacheStatistics& getPushingCostCacheStatistics() const {
+    return m_pushing_cost_cache.statistics();
+  };
+
+  /* Returns the number of bytes allocated by the pushing-cost cache. */
+  size_t getPushingCostCacheMemoryUsage() const {
+    return m_pushing_cost_cache.memoryUsage();
+  };
 };
 
 }  // namespace heuristic
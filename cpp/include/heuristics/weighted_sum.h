@@ -17,6 +17,7 @@
 #ifndef HEURISTICS_WEIGHTED_SUM_H_
 #define HEURISTICS_WEIGHTED_SUM_H_
 
+#include <cstddef>
 #include <memory>
 #include <utility>  // pair
 #include <vector>
@@ -37,6 +38,9 @@ class WeightedSumHeuristic : public Heuristic<float> {
  private:
   HeuristicsAndWeights m_heuristics_and_weights;
 
+  // Reused by `estimate_costs` to avoid allocating memory.
+  std::vector<float> m_child_costs;
+
  public:
   /**
    * Constructs this heuristic from a list of (heuristic, weight) pairs.
@@ -48,6 +52,16 @@ class WeightedSumHeuristic : public Heuristic<float> {
    * the constructor.
    */
   float estimate_cost_to_goal(const RelativeState& relative_state) override;
+
+  /* Evaluates every heuristic on the whole batch of `states`. */
+  void estimate_costs(const RelativeState* states, const size_t num_states,
+                      float* costs) override;
+
+  /* Returns the sum of the memory usage of every heuristic. */
+  size_t memory_usage() const override;
+
+  /* Sets the search context of every heuristic. */
+  void set_search_context(const search::SearchContext* context) override;
 };
 
 }  // namespace heuristic
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace pushworld {
+
+/**
+ * A read-only memory mapping of an entire file, which is unmapped when this
+ * object is destroyed. Pages are loaded lazily by the operating system, so
+ * mapping a large file is cheap until its contents are read.
+ */
+class MappedFile {
+ private:
+  void* m_data;
+  size_t m_size;
+
+ public:
+  /**
+   * Maps the file with the given `filename`. Throws `std::invalid_argument` if
+   * the file cannot be opened, is empty, or cannot be mapped.
+   */
+  explicit MappedFile(const std::string& filename);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /* Returns the first byte of the file. */
+  const char* data() const { return static_cast<const char*>(m_data); };
+
+  /* Returns the number of bytes in the file. */
+  size_t size() const { return m_size; };
+};
+
+}  // namespace pushworld
+
+#endif /* MAPPED_FILE_H_ */
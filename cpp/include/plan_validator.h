@@ -0,0 +1,107 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef PLAN_VALIDATOR_H_
+#define PLAN_VALIDATOR_H_
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+
+/**
+ * Converts a string of 'LRUD' characters into a plan. Returns `std::nullopt`
+ * if the string contains any other character.
+ */
+std::optional<Plan> parse_plan(std::string_view plan_string);
+
+/**
+ * A plan that was read by `read_plan_file`, which names the puzzle that it
+ * solves.
+ */
+struct PlanRecord {
+  // The name of the puzzle file, excluding its directory and extension.
+  std::string puzzle;
+
+  // A string of 'UDLR' characters.
+  std::string plan;
+
+  // The file and line of the plan, e.g. "solutions/Tidy Up.yaml:3".
+  std::string source;
+};
+
+/**
+ * Reads the plans in the file with the given `filename`, which is either:
+ *
+ *   - A YAML file with the `puzzle` and `plan` keys, as in
+ *     `benchmark/solutions` or the results of `run_benchmark`. Results without
+ *     a plan contain no records.
+ *   - A text file (any other extension) in which every non-empty line contains
+ *     a puzzle name and a plan, separated by the last space in the line.
+ *
+ * Throws `std::invalid_argument` if the file cannot be read or is malformed.
+ */
+std::vector<PlanRecord> read_plan_file(const std::string& filename);
+
+/* The outcome of `PlanValidator::validate`. */
+struct PlanValidation {
+  // Whether the plan reaches a state that satisfies the goal.
+  bool valid = false;
+
+  // If the plan is not valid, this summarizes why.
+  std::optional<std::string> failure_reason;
+
+  // The number of actions in the plan that moved at least one object.
+  size_t num_moving_actions = 0;
+
+  // If a trace was requested, `trace[t]` contains the indices of the objects
+  // that moved on the `t`-th action of the plan.
+  std::vector<std::vector<int>> trace;
+};
+
+/**
+ * Replays plans in PushWorld puzzles without allocating memory per action.
+ * Each validator owns its state buffers and transition scratch memory, so
+ * validators in different threads can replay plans concurrently, even in the
+ * same puzzle.
+ */
+class PlanValidator {
+ private:
+  State m_state;
+  RelativeState m_next;
+  TransitionScratch m_scratch;
+
+ public:
+  /**
+   * Performs every action of the `plan`, a string of 'LRUD' characters,
+   * starting from the initial state of the `puzzle`. If `record_trace` is
+   * true, the indices of the objects that move on each action are stored in
+   * the returned `trace`.
+   */
+  PlanValidation validate(const PushWorldPuzzle& puzzle,
+                          std::string_view plan,
+                          const bool record_trace = false);
+};
+
+}  // namespace pushworld
+
+#endif /* PLAN_VALIDATOR_H_ */
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLANNER_H_
+#define PLANNER_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "pushworld_puzzle.h"
+#include "search/anytime_search.h"
+#include "search/external_best_first_search.h"
+#include "search/random_action_iterator.h"
+#include "search/search_context.h"
+#include "search/search_statistics.h"
+
+namespace pushworld {
+
+/**
+ * Solves the given puzzle using best-first search with a heuristic determined
+ * by the mode. Supported modes include:
+ *
+ *      "RGD": The recursive graph distance heuristic.
+ *      "N+RGD": A lexicographic combination of the novelty heuristic followed
+ * by the recursive graph distance heuristic.
+ *      "PORTFOLIO": Runs the searches of `default_portfolio()` concurrently
+ * with `solve_portfolio`, and returns the first result. Ignores `num_threads`.
+ *
+ * States in which a goal object provably cannot reach its goal position are
+ * discarded without evaluating the heuristic. See `DeadEndDetector`.
+ *
+ * If `num_threads` is greater than 1, the search is distributed across threads
+ * with `parallel_best_first_search`, and each thread constructs its own
+ * heuristics.
+ *
+ * If `statistics` is not null, it is filled in with measurements of the
+ * search. See `SearchStatistics`.
+ *
+ * Returns `std::nullopt` if no solution exists. Throws `std::domain_error` if
+ * the mode is not recognized.
+ */
+std::optional<Plan> solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
+                          const std::string& mode, const int num_threads = 1,
+                          search::SearchStatistics* statistics = nullptr);
+
+/**
+ * Identical to `solve` above with a single thread, except that the search
+ * stops when a limit of the `context` is reached, e.g. its deadline or memory
+ * budget, and returns why it stopped. The time and memory that it takes to
+ * construct the heuristics are not included in the limits. If `statistics` is
+ * not null, it describes the search up to the point where it stopped.
+ *
+ * Throws `std::domain_error` if the mode is not recognized.
+ */
+search::SearchResult solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
+                           const std::string& mode,
+                           const search::SearchContext& context,
+                           search::SearchStatistics* statistics = nullptr);
+
+/**
+ * Identical to `solve` above with a `context`, except that the search is
+ * distributed across `num_threads` threads as in the first `solve`. The
+ * memory budget of the `context` applies to the sum of all threads.
+ *
+ * If `canonicalize_objects` is true, permutations of interchangeable objects
+ * are pruned as duplicate states. See `PortfolioMember::canonicalize_objects`.
+ *
+ * Throws `std::domain_error` if the mode is not recognized.
+ */
+search::SearchResult solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
+                           const std::string& mode, const int num_threads,
+                           const search::SearchContext& context,
+                           search::SearchStatistics* statistics = nullptr,
+                           const bool canonicalize_objects = false);
+
+/**
+ * Identical to `solve` above with a single thread, except that the search is
+ * `search::external_best_first_search`, which writes the visited states and
+ * the frontier to disk once they exceed the memory budget of the `options`.
+ * This solves puzzles whose search does not fit in memory, at the cost of
+ * reading and writing files. The "PORTFOLIO" mode is not supported.
+ * `canonicalize_objects` is as in the `solve` above.
+ *
+ * Throws `std::domain_error` if the mode is not recognized, and
+ * `std::runtime_error` if the files of the search cannot be written.
+ */
+search::SearchResult solve_external(
+    const std::shared_ptr<PushWorldPuzzle> puzzle, const std::string& mode,
+    const search::ExternalSearchOptions& options,
+    const search::SearchContext& context,
+    search::SearchStatistics* statistics = nullptr,
+    const bool canonicalize_objects = false);
+
+/* One configuration of the searches that `solve_portfolio` runs. */
+struct PortfolioMember {
+  // Either "RGD" or "N+RGD". See `solve`.
+  std::string mode;
+
+  // See `heuristic::RecursiveGraphDistanceHeuristic`.
+  bool fewest_tools = true;
+
+  // The seed of the order in which successors are generated.
+  unsigned int action_seed = search::RandomActionIterator::DEFAULT_SEED;
+
+  // Whether states are only evaluated when they are expanded. See
+  // `search::lazy_best_first_search`.
+  bool lazy_evaluation = false;
+
+  // Whether permutations of interchangeable objects are pruned as duplicate
+  // states, in which case the novelty heuristic shares the positions of
+  // interchangeable objects. See `search::best_first_search`. This reduces the
+  // evaluations on many puzzles, but slows down others, e.g. puzzles with many
+  // identical objects.
+  bool canonicalize_objects = false;
+};
+
+/**
+ * Identical to `solve` above with a `context`, except that the search is
+ * configured by the `member` instead of only by a mode.
+ *
+ * Throws `std::domain_error` if the mode of the `member` is not recognized.
+ */
+search::SearchResult solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
+                           const PortfolioMember& member,
+                           const search::SearchContext& context,
+                           search::SearchStatistics* statistics = nullptr);
+
+/**
+ * Returns the members of the "PORTFOLIO" mode of `solve`: both modes, RGD
+ * without the fewest-tools constraint, and N+RGD with another action seed.
+ */
+std::vector<PortfolioMember> default_portfolio();
+
+/**
+ * Runs one best-first search per member of the `portfolio`, each on its own
+ * thread, and returns the result of the first search that finds a plan or
+ * proves that no plan exists, after cancelling the other searches. Which
+ * configuration is fastest varies a lot between puzzles, so this returns as
+ * soon as the fastest configuration of each puzzle finishes.
+ *
+ * All searches share the puzzle, the RGD tables, and the dead end detector,
+ * while each has its own heuristics, frontier, and visited states. Every
+ * search stops at the deadline of the `context`, and the memory budget of the
+ * `context` is divided evenly between them. If every search reaches a limit,
+ * the status is `MEMORY_LIMIT` if any search ran out of memory, and
+ * `TIME_LIMIT` otherwise.
+ *
+ * If `statistics` is not null, the counters and seconds of all searches are
+ * summed into it, and `total_seconds` is the wall-clock time of all searches.
+ *
+ * Throws `std::invalid_argument` if the `portfolio` is empty, and
+ * `std::domain_error` if the mode of a member is not recognized.
+ */
+search::SearchResult solve_portfolio(
+    const std::shared_ptr<PushWorldPuzzle> puzzle,
+    const std::vector<PortfolioMember>& portfolio,
+    const search::SearchContext& context,
+    search::SearchStatistics* statistics = nullptr);
+
+/**
+ * Solves the given puzzle with `search::anytime_search`, which finds
+ * progressively shorter plans until the `options.deadline` and returns the
+ * shortest plan found. The first plan is found with the heuristic of the mode,
+ * as in `solve`, and shorter plans are found with weighted A* on the recursive
+ * graph distance heuristic.
+ *
+ * `canonicalize_objects` is as in `solve`.
+ *
+ * Returns `std::nullopt` if no plan was found before the deadline or if no
+ * solution exists. Throws `std::domain_error` if the mode is not recognized.
+ */
+std::optional<Plan> solve_anytime(
+    const std::shared_ptr<PushWorldPuzzle> puzzle, const std::string& mode,
+    const search::AnytimeSearchOptions& options,
+    search::SearchStatistics* statistics = nullptr,
+    const bool canonicalize_objects = false);
+
+}  // namespace pushworld
+
+#endif /* PLANNER_H_ */
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef PUSHWORLD_ENV_H_
+#define PUSHWORLD_ENV_H_
+
+/**
+ * A C interface to `BatchedPushWorldEnv`, which is built into the shared
+ * library `libpushworld_env` so that it can be loaded from other languages,
+ * e.g. with `ctypes` in Python.
+ *
+ * All buffers are owned by the caller, except for the arrays returned by
+ * `pushworld_env_states` and `pushworld_env_puzzle_indices`, which remain
+ * valid until the environment is destroyed. Functions that return an `int`
+ * return 0 on success and -1 on failure, in which case
+ * `pushworld_env_last_error` describes the failure.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Returns a description of the most recent failure in the calling thread. */
+const char* pushworld_env_last_error(void);
+
+/**
+ * Creates a batch of environments that play the puzzles in the given files,
+ * which are either in .pwp format or compiled. See the constructor of
+ * `BatchedPushWorldEnv` for the other arguments. Returns null on failure.
+ */
+void* pushworld_env_create(const char* const* puzzle_paths, int num_puzzles,
+                           int num_envs, int max_steps, int auto_reset,
+                           int height_cells, int width_cells,
+                           int pixels_per_cell, int border_width,
+                           uint64_t seed);
+
+/* Destroys an environment from `pushworld_env_create`. */
+void pushworld_env_destroy(void* env);
+
+/* Returns the number of environments in the batch. */
+int pushworld_env_num_envs(const void* env);
+
+/* Writes the (height, width) of every observation, measured in pixels. */
+void pushworld_env_observation_shape(const void* env, int* height, int* width);
+
+/* Returns the number of positions in the state of each environment. */
+int pushworld_env_state_size(const void* env);
+
+/**
+ * Returns the states of all environments, with shape (num_envs, state_size).
+ * Each position is encoded as `x * 10000 + y`.
+ */
+const int32_t* pushworld_env_states(const void* env);
+
+/* Returns the index of the puzzle that each environment is playing. */
+const int32_t* pushworld_env_puzzle_indices(const void* env);
+
+/* See `BatchedPushWorldEnv::reset`. */
+int pushworld_env_reset(void* env, float* observations);
+
+/* See `BatchedPushWorldEnv::resetEnv`. */
+int pushworld_env_reset_env(void* env, int index, int puzzle_index,
+                            float* observation);
+
+/* See `BatchedPushWorldEnv::step`. */
+int pushworld_env_step(void* env, const int32_t* actions, float* observations,
+                       double* rewards, uint8_t* terminated,
+                       uint8_t* truncated);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUSHWORLD_ENV_H_ */
@@ -19,10 +19,15 @@
 
 #include <stdlib.h>
 
+#include <array>
 #include <boost/functional/hash.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace pushworld {
@@ -70,6 +75,10 @@ using Plan = std::vector<Action>;
 // character.
 static const char ACTION_TO_CHAR[] = {'L', 'R', 'U', 'D'};
 
+// The file extension of puzzles in the binary format written by
+// `PushWorldPuzzle::saveCompiled`.
+static const char COMPILED_PUZZLE_EXTENSION[] = ".pwpc";
+
 // Defines a hash function for `State` instances.
 struct StateHash {
   std::size_t operator()(const State& state) const {
@@ -97,6 +106,24 @@ Position2D xy_to_position(const int x, const int y);
  */
 void position_to_xy(const Position2D p, int& x, int& y);
 
+/**
+ * Converts a `Position2D` into separate X and Y values, where both values may
+ * be negative. Unlike `position_to_xy`, this function can convert a signed
+ * displacement `xy_to_position(dx, dy)` back into the original (dx, dy) when
+ * `abs(dy) < POSITION_LIMIT / 2`.
+ *
+ * Every `Position2D` maps to a unique (x, y) pair, even when the above
+ * condition does not hold.
+ */
+inline void displacement_to_xy(const Position2D p, int& x, int& y) {
+  // Shift `p` to a non-negative value so that integer division rounds to the
+  // nearest multiple of `POSITION_LIMIT`.
+  static const int offset =
+      POSITION_LIMIT * POSITION_LIMIT + POSITION_LIMIT / 2;
+  x = (p + offset) / POSITION_LIMIT - POSITION_LIMIT;
+  y = p - x * POSITION_LIMIT;
+}
+
 // A map from action IDs to the position displacements they cause.
 static const Position2D ACTION_DISPLACEMENTS[] = {
     // (0,0) is top left
@@ -162,6 +189,258 @@ struct ObjectCollisions {
   };
 };
 
+/**
+ * A set of `Position2D` values that is stored as a dense bitmap over the
+ * bounding box of its elements. Membership tests only require a bounds check
+ * and a bit lookup, and most positions outside of the set are rejected by the
+ * bounds check without accessing the bitmap.
+ *
+ * Elements may be absolute positions or signed displacements, such as the
+ * relative positions in `ObjectCollisions::dynamic_collisions`.
+ */
+class PositionBitmap {
+ private:
+  int m_min_x;
+  int m_min_y;
+  unsigned int m_width;
+  unsigned int m_height;
+  std::vector<uint64_t> m_bits;
+
+  // All positions in this set, in increasing order.
+  std::vector<Position2D> m_positions;
+
+ public:
+  /* Constructs an empty set. */
+  PositionBitmap() : m_min_x(0), m_min_y(0), m_width(0), m_height(0){};
+
+  /* Constructs a bitmap that contains the given positions. */
+  explicit PositionBitmap(const std::unordered_set<Position2D>& positions);
+
+  /* Returns whether this set contains the position `p`. */
+  bool contains(const Position2D p) const {
+    int x, y;
+    displacement_to_xy(p, x, y);
+
+    // Negative offsets wrap around to large unsigned values, so each bounds
+    // check is a single comparison.
+    const unsigned int dx = x - m_min_x;
+    const unsigned int dy = y - m_min_y;
+    if (dx >= m_width || dy >= m_height) {
+      return false;
+    }
+
+    const unsigned int i = dx * m_height + dy;
+    return (m_bits[i >> 6] >> (i & 63)) & 1;
+  };
+
+  /* Returns whether this set contains no positions. */
+  bool empty() const { return m_positions.empty(); };
+
+  /* Returns the smallest X value of all positions in this set. */
+  int getMinX() const { return m_min_x; };
+
+  /* Returns the smallest Y value of all positions in this set. */
+  int getMinY() const { return m_min_y; };
+
+  /* Returns the width of the bounding box of this set, or 0 if it is empty. */
+  unsigned int getWidth() const { return m_width; };
+
+  /* Returns the height of the bounding box of this set, or 0 if it is empty. */
+  unsigned int getHeight() const { return m_height; };
+
+  /* Returns the number of positions in this set. */
+  size_t size() const { return m_positions.size(); };
+
+  /**
+   * Returns all positions in this set in increasing order. Iterating over this
+   * vector is faster than iterating over an `unordered_set`.
+   */
+  const std::vector<Position2D>& positions() const { return m_positions; };
+};
+
+/**
+ * The bounding boxes of the dynamic collisions between one pusher and every
+ * pushee, stored as a struct of arrays so that all pushees can be tested with
+ * SIMD instructions. Element `j` of each array describes
+ * `CompiledCollisions::getDynamicCollisions(action, pusher, j)`.
+ *
+ * The widths and heights have their sign bits flipped, so that signed SIMD
+ * comparisons with offsets that also have flipped sign bits are equivalent to
+ * unsigned comparisons. Empty bounding boxes have a width of zero.
+ */
+struct CollisionBounds {
+  const int32_t* min_x;
+  const int32_t* min_y;
+  const int32_t* biased_width;
+  const int32_t* biased_height;
+};
+
+/**
+ * A compiled form of `ObjectCollisions` that is optimized for the membership
+ * tests in `PushWorldPuzzle::getNextState`. All collision sets are stored as
+ * `PositionBitmap` instances in flat arrays.
+ *
+ * `ObjectCollisions` remains the format for constructing puzzles and for
+ * exchanging collision information; this class is derived from it.
+ */
+class CompiledCollisions {
+ private:
+  int m_num_objects;
+
+  // Indexed by `action * m_num_objects + object_index`.
+  std::vector<PositionBitmap> m_static_collisions;
+
+  // Indexed by `(action * m_num_objects + pusher_index) * m_num_objects +
+  // pushee_index`.
+  std::vector<PositionBitmap> m_dynamic_collisions;
+
+  // The arrays of `CollisionBounds`, indexed by `(action * m_num_objects +
+  // pusher_index) * m_bounds_stride + pushee_index`. Each row is padded with
+  // empty bounding boxes to a multiple of `SIMD_WIDTH` pushees.
+  int m_bounds_stride;
+  std::vector<int32_t> m_min_x;
+  std::vector<int32_t> m_min_y;
+  std::vector<int32_t> m_biased_width;
+  std::vector<int32_t> m_biased_height;
+
+ public:
+  // The number of pushees in each group that the SIMD kernel of
+  // `PushWorldPuzzle::getNextState` tests at once.
+  static const int SIMD_WIDTH = 4;
+
+  /* Constructs compiled collisions for zero objects. */
+  CompiledCollisions() : m_num_objects(0), m_bounds_stride(0){};
+
+  /**
+   * Compiles the given `collisions` for the given number of objects. Any
+   * collision sets that are missing from `collisions` (e.g. if it was never
+   * resized) are treated as empty.
+   */
+  CompiledCollisions(const ObjectCollisions& collisions,
+                     const int num_objects);
+
+  /**
+   * Equivalent to `ObjectCollisions::static_collisions[action][object_index]`.
+   */
+  const PositionBitmap& getStaticCollisions(const Action action,
+                                            const int object_index) const {
+    return m_static_collisions[action * m_num_objects + object_index];
+  };
+
+  /**
+   * Equivalent to
+   * `ObjectCollisions::dynamic_collisions[action][pusher_index][pushee_index]`.
+   */
+  const PositionBitmap& getDynamicCollisions(const Action action,
+                                             const int pusher_index,
+                                             const int pushee_index) const {
+    return m_dynamic_collisions[(action * m_num_objects + pusher_index) *
+                                    m_num_objects +
+                                pushee_index];
+  };
+
+  /**
+   * Returns the bounding boxes of the dynamic collisions of the pusher with
+   * every pushee, each of which has `getBoundsStride()` elements.
+   */
+  CollisionBounds getDynamicCollisionBounds(const Action action,
+                                            const int pusher_index) const {
+    const size_t row =
+        (action * m_num_objects + pusher_index) * m_bounds_stride;
+    return CollisionBounds{&m_min_x[row], &m_min_y[row], &m_biased_width[row],
+                           &m_biased_height[row]};
+  };
+
+  /**
+   * Returns the number of objects rounded up to a multiple of `SIMD_WIDTH`.
+   */
+  int getBoundsStride() const { return m_bounds_stride; };
+};
+
+/**
+ * Scratch memory for `PushWorldPuzzle::getNextState`, which tracks the objects
+ * that are pushed by an action. Threads that compute transitions concurrently
+ * must each use a separate instance.
+ *
+ * The contents are managed by `getNextState` and are sized on first use, so a
+ * default-constructed instance can be used with any puzzle.
+ */
+struct TransitionScratch {
+  std::vector<int> pushing_frontier;
+  std::vector<int> pushed_object_idxs;
+  std::vector<bool> pushed_objects;
+
+  // The X and Y values of all object positions, which are only used by the
+  // SIMD kernel.
+  std::vector<int32_t> xs;
+  std::vector<int32_t> ys;
+};
+
+/**
+ * Selects how `PushWorldPuzzle::getNextState` finds the objects that an action
+ * pushes. The scalar kernel tests every pair of a pushing object and another
+ * object with a bitmap lookup. The SIMD kernel first tests the bounding boxes
+ * of the collisions with all other objects at once, which is faster in puzzles
+ * with many objects, where most pairs of objects are far apart. The fixed-size
+ * kernels are compiled for each number of objects up to
+ * `FIXED_SIZE_KERNEL_MAX_OBJECTS`, so that their loops can be unrolled and
+ * the pushed objects fit in a bitmask instead of scratch memory.
+ *
+ * All kernels compute identical transitions.
+ */
+enum class TransitionKernel {
+  // Selects the fixed-size kernel if one exists for the number of objects,
+  // otherwise the SIMD kernel if it is available, and otherwise the scalar
+  // kernel. The fixed-size kernels are about a third faster than the SIMD
+  // kernel at every number of objects up to `FIXED_SIZE_KERNEL_MAX_OBJECTS`,
+  // both in `BM_GetNextStateKernelObjects` and on the puzzles of the
+  // benchmark, and the SIMD kernel is faster than the scalar kernel beyond.
+  AUTO,
+  SCALAR,
+  // Falls back to the scalar kernel if SIMD instructions are unavailable.
+  SIMD,
+  // Falls back to the scalar kernel for puzzles with more than
+  // `FIXED_SIZE_KERNEL_MAX_OBJECTS` objects.
+  FIXED_SIZE
+};
+
+// The maximum number of objects for which a fixed-size kernel is compiled.
+static const int FIXED_SIZE_KERNEL_MAX_OBJECTS = 32;
+
+// Whether this build supports the SIMD kernel of `getNextState`.
+#if defined(__SSE2__)
+static const bool SIMD_KERNEL_AVAILABLE = true;
+#else
+static const bool SIMD_KERNEL_AVAILABLE = false;
+#endif
+
+/**
+ * The cells that each object of a puzzle occupies, which are only needed to
+ * draw images of the puzzle. Collisions between objects are computed from the
+ * same cells when a puzzle is loaded.
+ */
+struct ObjectShapes {
+  // `objects[i]` contains the cells of the object with index `i` in a `State`,
+  // relative to the position of the object.
+  std::vector<std::vector<Position2D>> objects;
+
+  // `goals[i]` contains the cells of the goal with index `i` in a `Goal`,
+  // relative to the goal position.
+  std::vector<std::vector<Position2D>> goals;
+
+  // The absolute positions of all walls, including the walls at the boundaries
+  // of the puzzle.
+  std::vector<Position2D> walls;
+
+  // The absolute positions of all walls that only block the agent.
+  std::vector<Position2D> agent_walls;
+
+  bool operator==(const ObjectShapes& other) const {
+    return objects == other.objects && goals == other.goals &&
+           walls == other.walls && agent_walls == other.agent_walls;
+  }
+};
+
 /**
  * A puzzle in the PushWorld environment.
  */
@@ -169,18 +448,63 @@ class PushWorldPuzzle {
  private:
   State m_initial_state;
   int m_num_objects;
+  int m_width;
+  int m_height;
 
   // m_goal[i] contains the target value of m_initial_state[i+1].
   Goal m_goal;
 
   ObjectCollisions m_object_collisions;
+  CompiledCollisions m_compiled_collisions;
+  ObjectShapes m_shapes;
 
-  mutable std::vector<int> m_pushing_frontier;
-  mutable std::vector<int> m_pushed_object_idxs;
-  mutable std::vector<bool> m_pushed_objects;
+  // Used by the `getNextState` overloads that do not take a scratch argument.
+  mutable TransitionScratch m_scratch;
+
+  // Groups of interchangeable objects. See `getInterchangeableObjects`.
+  std::vector<std::vector<int>> m_interchangeable_objects;
+
+  // Whether `getNextState` uses the SIMD kernel.
+  bool m_use_simd_kernel;
+
+  // If not null, `getNextState` calls this fixed-size kernel.
+  using FixedSizeKernel = bool (PushWorldPuzzle::*)(const State&, const Action,
+                                                    RelativeState&) const;
+  FixedSizeKernel m_fixed_size_kernel;
+
+  /**
+   * Implements `getNextState` for puzzles with exactly `N` objects. This
+   * kernel does not use scratch memory.
+   */
+  template <int N>
+  bool getFixedSizeNextState(const State& state, const Action action,
+                             RelativeState& next) const;
+
+  /* Returns the fixed-size kernels, indexed by the number of objects. */
+  template <int... Ns>
+  static std::array<FixedSizeKernel, sizeof...(Ns)> makeFixedSizeKernels(
+      std::integer_sequence<int, Ns...>);
 
   void init();
 
+  /* Sorts the positions of the objects of the `group` in the `state`. Returns
+   * whether the `state` changed. */
+  static bool canonicalizeGroup(const std::vector<int>& group, State& state);
+
+  /* Computes `m_interchangeable_objects` from the collision tables. */
+  void findInterchangeableObjects();
+
+  /* Returns whether objects `i` and `j` have identical collisions with the
+   * walls, with each other, and with all other objects. */
+  bool areInterchangeable(const int i, const int j) const;
+
+  /* Parses the contents of a .pwp file. */
+  void loadText(const std::string_view text);
+
+  /* Constructs an empty puzzle for the static factories to fill in. */
+  PushWorldPuzzle()
+      : m_use_simd_kernel(false), m_fixed_size_kernel(nullptr){};
+
  public:
   /**
    * Loads a PushWorld puzzle from a file.
@@ -195,11 +519,60 @@ class PushWorldPuzzle {
   PushWorldPuzzle(const State& initial_state, const Goal& goal,
                   const ObjectCollisions& entity_collisions);
 
+  /**
+   * Identical to the constructor that loads a file, except that the puzzle is
+   * parsed from the given `text` in .pwp format.
+   */
+  static PushWorldPuzzle fromText(const std::string_view text);
+
+  /**
+   * Loads a puzzle from a file that was written by `saveCompiled`. The file is
+   * memory-mapped, and no pixels are parsed and no collisions are computed, so
+   * this is much faster than loading a .pwp file.
+   *
+   * Throws `std::invalid_argument` if the file cannot be opened or if it is
+   * not a compiled puzzle of the current format version.
+   */
+  static PushWorldPuzzle loadCompiled(const std::string& filename);
+
+  /**
+   * Identical to `loadCompiled`, except that the compiled puzzle is read from
+   * the given `data`, e.g. a region of a memory-mapped archive.
+   */
+  static PushWorldPuzzle fromCompiled(const std::string_view data);
+
+  /**
+   * Returns the initial state, goal, size, collision tables, and object shapes
+   * of this puzzle in a binary format that `fromCompiled` reads. The format
+   * uses the byte order of this machine, so compiled puzzles are caches rather
+   * than a portable exchange format.
+   */
+  std::string toCompiled() const;
+
+  /* Writes the result of `toCompiled` to a file. */
+  void saveCompiled(const std::string& filename) const;
+
   /**
    * Returns the initial positions of all objects.
    */
   const State& getInitialState() const { return m_initial_state; }
 
+  /**
+   * Returns an exclusive upper bound on the X value of every object position.
+   *
+   * For puzzles loaded from files, this is the width of the puzzle including
+   * its boundary walls. For puzzles constructed from an `ObjectCollisions`,
+   * the width is inferred from the positions of all static collisions, which
+   * assumes that static obstacles enclose all objects.
+   */
+  int getWidth() const { return m_width; }
+
+  /**
+   * Returns an exclusive upper bound on the Y value of every object position.
+   * See `getWidth` for details.
+   */
+  int getHeight() const { return m_height; }
+
   /**
    * Returns the goal positions of one or more objects.
    */
@@ -214,6 +587,21 @@ class PushWorldPuzzle {
     return m_object_collisions;
   }
 
+  /**
+   * Returns the same collision information as `getObjectCollisions`, but in a
+   * representation that is faster to query.
+   */
+  const CompiledCollisions& getCompiledCollisions() const {
+    return m_compiled_collisions;
+  }
+
+  /**
+   * Returns the cells of all objects in this puzzle. Puzzles that are
+   * constructed from an `ObjectCollisions` have no cells, so all vectors in
+   * the returned shapes are empty.
+   */
+  const ObjectShapes& getShapes() const { return m_shapes; }
+
   /**
    * Computes the state that results from performing the `action` in the given
    * `state`. The returned `moved_object_indices` in the relative state contain
@@ -222,6 +610,93 @@ class PushWorldPuzzle {
    */
   RelativeState getNextState(const State& state, const Action action) const;
 
+  /**
+   * Identical to the `getNextState` method above, except that the next state is
+   * written into `next`, reusing its memory. Once `next` has been used for one
+   * call, subsequent calls do not allocate memory.
+   *
+   * Returns whether any object moved. If no object moved, `next.state` is not
+   * modified, so the caller can detect that the action had no effect without
+   * copying the `state`. In both cases, `next.moved_object_indices` contains
+   * the indices of all objects that moved.
+   *
+   * `next.state` must not be the same vector as `state`.
+   *
+   * This method and the `getNextState` method above share scratch memory that
+   * belongs to this puzzle, so they must not be called concurrently. Use the
+   * overload below to compute transitions from multiple threads.
+   */
+  bool getNextState(const State& state, const Action action,
+                    RelativeState& next) const;
+
+  /**
+   * Identical to the `getNextState` method above, except that all scratch
+   * memory is provided by the caller. This method can be called concurrently
+   * as long as each thread uses a separate `scratch` and `next`.
+   */
+  bool getNextState(const State& state, const Action action,
+                    RelativeState& next, TransitionScratch& scratch) const;
+
+  /**
+   * Computes the successors of the `num_states` consecutive `states` under
+   * each of the `actions`, so that a search can expand many states at once
+   * into contiguous buffers. `successors[i * actions.size() + j]` is written
+   * as by `getNextState` with `states[i]` and `actions[j]`, and the same
+   * element of `moved` is whether any object moved. Both vectors are resized
+   * to contain at least `num_states * actions.size()` elements, reusing the
+   * memory of existing successors. Returns the number of successors in which
+   * an object moved.
+   *
+   * Like `getNextState` without a scratch argument, this method must not be
+   * called concurrently.
+   */
+  size_t getSuccessors(const State* states, const size_t num_states,
+                       const std::vector<Action>& actions,
+                       std::vector<RelativeState>& successors,
+                       std::vector<uint8_t>& moved) const;
+
+  /**
+   * Selects the kernel of `getNextState`. Defaults to `TransitionKernel::AUTO`.
+   * This must not be called concurrently with `getNextState`.
+   */
+  void setTransitionKernel(const TransitionKernel kernel);
+
+  /**
+   * Returns the kernel that `getNextState` uses, which is never
+   * `TransitionKernel::AUTO`.
+   */
+  TransitionKernel getTransitionKernel() const {
+    if (m_fixed_size_kernel != nullptr) return TransitionKernel::FIXED_SIZE;
+    return m_use_simd_kernel ? TransitionKernel::SIMD
+                             : TransitionKernel::SCALAR;
+  }
+
+  /**
+   * Returns the groups of objects that are interchangeable, which are movable
+   * objects without goals that collide identically with the walls, with each
+   * other, and with every other object, e.g. because they have the same shape.
+   * Swapping the positions of two interchangeable objects in any state results
+   * in an equivalent state, from which the same plans reach the goal. Every
+   * group has at least two objects, in increasing order of their indices.
+   */
+  const std::vector<std::vector<int>>& getInterchangeableObjects() const {
+    return m_interchangeable_objects;
+  }
+
+  /**
+   * Sorts the positions of the objects in every group of interchangeable
+   * objects in the `state`, so that all states that only differ by permuting
+   * interchangeable objects have the same canonical state. Returns whether
+   * the `state` changed.
+   */
+  bool canonicalize(State& state) const {
+    bool changed = false;
+    for (const auto& group : m_interchangeable_objects) {
+      changed |= canonicalizeGroup(group, state);
+    }
+    return changed;
+  }
+
   /**
    * Returns whether the given state satisfies the goal of this puzzle.
    */
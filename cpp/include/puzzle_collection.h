@@ -0,0 +1,167 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PUZZLE_COLLECTION_H_
+#define PUZZLE_COLLECTION_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+
+// The file extension of archives written by `PuzzleCollection::saveArchive`.
+static const char PUZZLE_ARCHIVE_EXTENSION[] = ".pwpa";
+
+/**
+ * Returns whether the `filename` has the extension of a file that
+ * `PuzzleCollection` can read, i.e. ".zip" or `PUZZLE_ARCHIVE_EXTENSION`,
+ * ignoring case.
+ */
+bool is_puzzle_collection(const std::string& filename);
+
+/**
+ * A read-only collection of PushWorld puzzles that are stored in a single
+ * memory-mapped file, which is either:
+ *   - a zip archive of .pwp and/or compiled .pwpc files, such as
+ *     `benchmark/puzzles/level0.zip`, whose entries are stored or deflated, or
+ *   - an archive of compiled puzzles written by `saveArchive`.
+ *
+ * Opening a collection only reads its index, and each puzzle is loaded
+ * directly from the mapped file on request, without extracting files or making
+ * any system calls. Puzzles are ordered by name.
+ *
+ * All methods are `const` and can be called concurrently.
+ */
+class PuzzleCollection {
+ private:
+  // The location of one puzzle in the mapped file.
+  struct Entry {
+    // The path of the puzzle within the archive.
+    std::string_view name;
+
+    // The stored, possibly compressed, bytes of the puzzle.
+    std::string_view data;
+
+    // The number of bytes of the puzzle after decompression.
+    uint32_t size;
+
+    // The zip compression method. Archives of compiled puzzles are stored.
+    uint16_t method;
+
+    // Whether the data is a compiled puzzle, rather than text in .pwp format.
+    bool compiled;
+  };
+
+  MappedFile m_file;
+  std::vector<Entry> m_entries;
+
+  void readZipIndex();
+  void readArchiveIndex();
+
+ public:
+  /**
+   * Opens the collection in the file with the given `filename`. Throws
+   * `std::invalid_argument` if the file cannot be read or is neither a zip
+   * archive nor an archive of compiled puzzles.
+   */
+  explicit PuzzleCollection(const std::string& filename);
+
+  /* Returns the number of puzzles in this collection. */
+  size_t size() const { return m_entries.size(); };
+
+  /**
+   * Returns the path of the puzzle with the given `index` within the archive,
+   * e.g. "level0/walls/train/0001.pwp". The view remains valid for the lifetime
+   * of this collection.
+   */
+  std::string_view getName(const size_t index) const {
+    return m_entries.at(index).name;
+  };
+
+  /**
+   * Loads the puzzle with the given `index`. Throws `std::invalid_argument` if
+   * the puzzle uses an unsupported zip feature, such as encryption, or if its
+   * data is corrupt.
+   */
+  PushWorldPuzzle getPuzzle(const size_t index) const;
+
+  /**
+   * Writes every puzzle in this collection, in compiled form, to an archive
+   * that this class can read without parsing any puzzles.
+   */
+  void saveArchive(const std::string& filename) const;
+};
+
+/**
+ * Writes a zip archive whose .pwp entries can be read by `PuzzleCollection`.
+ * Each entry is compressed and written to the file as soon as it is added, so
+ * only the central directory is kept in memory until `close`.
+ *
+ * Zip64 is not supported, so an archive has less than 65535 entries and 4 GiB.
+ */
+class ZipArchiveWriter {
+ private:
+  // The fields of an entry that are repeated in the central directory.
+  struct Entry {
+    std::string name;
+    uint32_t crc;
+    uint32_t compressed_size;
+    uint32_t size;
+    uint32_t offset;
+  };
+
+  std::string m_filename;
+  std::ofstream m_file;
+  std::vector<Entry> m_entries;
+  uint64_t m_offset;
+
+ public:
+  /**
+   * Creates the file with the given `filename`, replacing any existing file.
+   * Throws `std::invalid_argument` if the file cannot be created.
+   */
+  explicit ZipArchiveWriter(const std::string& filename);
+
+  /* Closes the archive if `close` was not called, ignoring any errors. */
+  ~ZipArchiveWriter();
+
+  ZipArchiveWriter(const ZipArchiveWriter&) = delete;
+  ZipArchiveWriter& operator=(const ZipArchiveWriter&) = delete;
+
+  /**
+   * Compresses the `data` into a new entry with the given `name`, e.g.
+   * "level0/puzzle_1.pwp". Throws `std::domain_error` if the archive would
+   * exceed the limits of the zip format, and `std::runtime_error` if the file
+   * cannot be written.
+   */
+  void add(const std::string& name, const std::string_view data);
+
+  /**
+   * Writes the central directory and closes the file. No entries can be added
+   * afterwards. Throws `std::runtime_error` if the file cannot be written.
+   */
+  void close();
+};
+
+}  // namespace pushworld
+
+#endif /* PUZZLE_COLLECTION_H_ */
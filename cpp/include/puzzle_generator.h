@@ -0,0 +1,110 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef PUZZLE_GENERATOR_H_
+#define PUZZLE_GENERATOR_H_
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pushworld {
+
+/**
+ * The ranges of the randomly generated level-0 puzzles, which match the
+ * arguments of `generate_level0_puzzles` in the Python package. All ranges are
+ * inclusive.
+ */
+struct Level0GeneratorOptions {
+  // The range of both the width and the height of puzzles, which are chosen
+  // independently.
+  int min_puzzle_size = 8;
+  int max_puzzle_size = 12;
+
+  // The number of single-pixel walls inside puzzles.
+  int min_num_walls = 2;
+  int max_num_walls = 4;
+
+  // The number of movable objects that are not goal objects.
+  int min_num_obstacles = 1;
+  int max_num_obstacles = 2;
+
+  // The number of goal objects and goals, which is either 1 or 2.
+  int min_num_goal_objects = 1;
+  int max_num_goal_objects = 1;
+
+  // If false, the agent, goal objects and obstacles are all 1x1. Otherwise,
+  // they are random monominos, dominos or trominos.
+  bool complex_shapes = true;
+};
+
+/**
+ * Randomly generates level-0 puzzles in the same way as `generate.py` in the
+ * Python package, but without writing them to files. Generated puzzles are not
+ * necessarily solvable.
+ *
+ * The sequence of puzzles only depends on the options and the seed, although
+ * it differs from the sequence of the Python package with the same seed.
+ */
+class Level0PuzzleGenerator {
+ private:
+  // The (y, x) offsets of the pixels of an object.
+  using Shape = std::vector<std::pair<int, int>>;
+
+  Level0GeneratorOptions m_options;
+  std::vector<Shape> m_shapes;
+  std::mt19937 m_random;
+
+  /* Returns a uniformly random integer in the inclusive range. */
+  int randomInt(const int min, const int max);
+
+  /**
+   * Draws the object with the `symbol` into a random position of the `grid`
+   * that is clear for its `shape`. Returns false if no clear position was
+   * found after many attempts.
+   */
+  bool placeObject(std::vector<std::vector<std::string>>& grid,
+                   const std::string& symbol, const Shape& shape);
+
+  /**
+   * Attempts to generate one puzzle with the given dimensions and numbers of
+   * objects. Returns an empty string if the objects do not fit.
+   */
+  std::string tryGenerate(const int width, const int height,
+                          const int num_walls, const int num_obstacles,
+                          const int num_goal_objects);
+
+ public:
+  /**
+   * Throws `std::invalid_argument` if any range of the `options` is empty or
+   * out of bounds, e.g. if `min_puzzle_size < 2`.
+   */
+  Level0PuzzleGenerator(const Level0GeneratorOptions& options,
+                        const unsigned int seed);
+
+  /**
+   * Returns the next random puzzle in the .pwp format, which can be loaded
+   * with `PushWorldPuzzle::fromText`. Throws `std::domain_error` if the
+   * objects do not fit in puzzles of the chosen sizes after many attempts.
+   */
+  std::string generate();
+};
+
+}  // namespace pushworld
+
+#endif /* PUZZLE_GENERATOR_H_ */
@@ -0,0 +1,361 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SEARCH_ANYTIME_SEARCH_H_
+#define SEARCH_ANYTIME_SEARCH_H_
+
+#include <algorithm>  // max
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>  // move, pair
+#include <vector>
+
+#include "heuristics/dead_end_detector.h"
+#include "heuristics/heuristic.h"
+#include "pushworld_puzzle.h"
+#include "search/packed_state_set.h"
+#include "search/priority_queue.h"
+#include "search/random_action_iterator.h"
+#include "search/search.h"
+#include "search/search_statistics.h"
+
+namespace pushworld {
+namespace search {
+
+/* Configures an `anytime_search`. */
+struct AnytimeSearchOptions {
+  // The weights of the heuristic in the weighted A* searches that follow the
+  // first plan, in the order in which the searches run.
+  std::vector<int> weights{5, 3, 2, 1};
+
+  // The search returns the best plan found so far at this time.
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::time_point::max();
+
+  // If not empty, this is called with each plan that is shorter than all
+  // previous plans, as soon as the plan is found.
+  std::function<void(const Plan&)> on_plan;
+};
+
+namespace {
+
+/**
+ * Stores the best path to a visited state in the current weighted A* search of
+ * `anytime_search`, and the cached heuristic value of the state.
+ */
+struct AnytimeStateInfo {
+  // The search in which `g` and `node` were assigned, or `NO_SEARCH`.
+  uint32_t search;
+  // The number of actions on the best path to the state.
+  uint32_t g;
+  NodeId node;
+  // The heuristic value of the state, or NaN if it has not been evaluated.
+  float h;
+};
+
+static const uint32_t NO_SEARCH = UINT32_MAX;
+
+// The number of expansions between checks of the deadline.
+static const int DEADLINE_CHECK_INTERVAL = 64;
+
+}  // namespace
+
+/**
+ * Searches for progressively shorter solutions of the given `puzzle` until the
+ * `options.deadline`, and returns the shortest plan found, or `std::nullopt`
+ * if no plan was found.
+ *
+ * This implements Restarting Weighted A* as described in:
+ *
+ * Silvia Richter, Jordan T. Thayer, and Wheeler Ruml. "The joy of forgetting:
+ * Faster anytime search via restarting." Twentieth International Conference
+ * on Automated Planning and Scheduling. 2010.
+ *
+ * The first plan is found with a greedy best-first search that orders states
+ * by the `first_heuristic` in the `first_frontier`, as in `best_first_search`.
+ * Then a weighted A* search runs for each of the `options.weights`, which
+ * orders states by `g + weight * h` for `h` from the `heuristic`, breaking
+ * ties by `h`. Every search restarts from the initial state. Visited states and
+ * their heuristic values are kept across searches, so each state is evaluated
+ * at most once by the `heuristic`. Weighted A* reopens states that are reached
+ * by a shorter path, and it discards states whose path cannot be extended into
+ * a plan shorter than the best plan found so far.
+ *
+ * Since states are only discarded by their path length, a weighted A* search
+ * that exhausts its frontier proves that the best plan is a shortest plan, in
+ * which case this function returns without running the remaining searches.
+ *
+ * If `statistics` is not null, it is reset and then filled in with the summed
+ * counters of all searches. Only the time of the whole search is measured.
+ *
+ * If `dead_ends` is not null, states that it detects as dead ends are
+ * discarded as in `best_first_search`. If `canonicalize_objects` is true,
+ * states are stored and evaluated in their canonical form, also as in
+ * `best_first_search`.
+ *
+ * Throws `std::invalid_argument` if a weight is not positive.
+ */
+template <typename Cost>
+std::optional<Plan> anytime_search(
+    const PushWorldPuzzle& puzzle, heuristic::Heuristic<Cost>& first_heuristic,
+    priority_queue::PriorityQueue<NodeId, Cost>& first_frontier,
+    heuristic::Heuristic<float>& heuristic,
+    const AnytimeSearchOptions& options = AnytimeSearchOptions(),
+    SearchStatistics* statistics = nullptr,
+    const heuristic::DeadEndDetector* dead_ends = nullptr,
+    const bool canonicalize_objects = false) {
+  using Clock = std::chrono::steady_clock;
+  using Priority = std::pair<float, float>;
+
+  for (const int weight : options.weights) {
+    if (weight <= 0) {
+      throw std::invalid_argument("Every weight must be positive.");
+    }
+  }
+
+  const auto search_start = Clock::now();
+  SearchStatistics counters;
+  std::optional<Plan> best_plan;
+
+  // Completes the `statistics` before returning the best plan.
+  const auto finish = [&]() {
+    if (statistics != nullptr) {
+      *statistics = counters;
+      statistics->total_seconds =
+          seconds_between(search_start, Clock::now());
+      first_heuristic.add_counters(statistics->heuristic_counters);
+      if (static_cast<const void*>(&first_heuristic) !=
+          static_cast<const void*>(&heuristic)) {
+        heuristic.add_counters(statistics->heuristic_counters);
+      }
+    }
+    return best_plan;
+  };
+
+  // Permutations of interchangeable objects are the same visited state. See
+  // `PushWorldPuzzle::canonicalize`.
+  State initial_state = puzzle.getInitialState();
+  if (canonicalize_objects) {
+    puzzle.canonicalize(initial_state);
+  }
+
+  if (puzzle.satisfiesGoal(initial_state)) {
+    best_plan = Plan();  // The plan to reach the goal has no actions.
+    if (options.on_plan) {
+      options.on_plan(*best_plan);
+    }
+    return finish();
+  }
+  if (dead_ends != nullptr && dead_ends->isDeadEnd(initial_state)) {
+    return finish();
+  }
+
+  RandomActionIterator action_iterator;
+  PackedStateSet visited{StatePacker(puzzle)};
+  SearchNodeStore nodes;
+  priority_queue::IntegerBucketPriorityQueue<NodeId, Priority> frontier;
+
+  // Indexed by the index of each state in `visited`.
+  std::vector<AnytimeStateInfo> infos;
+
+  std::vector<int> all_object_indices(initial_state.size());
+  for (int i = 0; i < initial_state.size(); i++) {
+    all_object_indices[i] = i;
+  }
+  const RelativeState initial_relative_state{initial_state,
+                                             std::move(all_object_indices)};
+
+  // Reused for every expansion to avoid allocating memory.
+  State parent_state;
+  RelativeState relative_state;
+  int num_expansions = 0;
+
+  // Returns whether the deadline has passed, checking the clock only once per
+  // `DEADLINE_CHECK_INTERVAL` calls.
+  const auto past_deadline = [&]() {
+    return ++num_expansions % DEADLINE_CHECK_INTERVAL == 0 &&
+           Clock::now() >= options.deadline;
+  };
+
+  // Records the plan that ends at the `node` as the best plan.
+  const auto record_plan = [&](const NodeId node) {
+    best_plan = backtrackPlan(puzzle, visited, nodes, node);
+    if (options.on_plan) {
+      options.on_plan(*best_plan);
+    }
+  };
+
+  // Generates the successor of the `parent_state` after the `action` into
+  // `relative_state`. Returns the index of the successor in `visited`, or
+  // `std::nullopt` if nothing moved or if the successor is a dead end.
+  const auto generate = [&](const Action action)
+      -> std::optional<PackedStateSet::Index> {
+    if (!puzzle.getNextState(parent_state, action, relative_state)) {
+      return std::nullopt;
+    }
+    if (canonicalize_objects && puzzle.canonicalize(relative_state.state)) {
+      set_moved_object_indices(parent_state, relative_state);
+    }
+    counters.generations++;
+    if (dead_ends != nullptr && dead_ends->isDeadEnd(relative_state)) {
+      counters.dead_ends++;
+      return std::nullopt;
+    }
+    const auto inserted = visited.insert(relative_state.state);
+    if (inserted.second) {
+      infos.push_back({NO_SEARCH, 0, 0, std::nanf("")});
+    }
+    return inserted.first;
+  };
+
+  // Find the first plan with greedy best-first search.
+  const NodeId root = nodes.add(NO_PARENT, visited.insert(initial_state).first);
+  infos.push_back({NO_SEARCH, 0, 0, std::nanf("")});
+  first_frontier.clear();
+  first_frontier.push(
+      root, first_heuristic.estimate_cost_to_goal(initial_relative_state));
+  counters.evaluations++;
+
+  while (!best_plan && !first_frontier.empty()) {
+    if (past_deadline()) {
+      return finish();
+    }
+    const NodeId parent_node = first_frontier.top();
+    first_frontier.pop();
+    visited.getState(nodes[parent_node].state_index, parent_state);
+    counters.expansions++;
+
+    for (const auto& action : action_iterator.next()) {
+      const auto state_index = generate(action);
+      if (!state_index) {
+        continue;
+      }
+      if (infos[*state_index].search != NO_SEARCH) {
+        counters.duplicates++;
+        continue;
+      }
+      // Mark the state as visited by this search.
+      infos[*state_index].search = 0;
+
+      const NodeId node = nodes.add(parent_node, *state_index, action);
+      if (puzzle.satisfiesGoal(relative_state.state)) {
+        record_plan(node);
+        break;
+      }
+      first_frontier.push(
+          node, first_heuristic.estimate_cost_to_goal(relative_state));
+      counters.evaluations++;
+      counters.max_frontier_size =
+          std::max(counters.max_frontier_size, first_frontier.size());
+    }
+  }
+  if (!best_plan) {
+    return finish();  // No solution exists.
+  }
+
+  // Improve the plan with weighted A*. Each search except the last ends when it
+  // finds a shorter plan, and the last search continues until it exhausts its
+  // frontier.
+  for (uint32_t search = 1; search <= options.weights.size(); search++) {
+    const float weight = options.weights[search - 1];
+    const bool last_search = search == options.weights.size();
+    bool improved = false;
+
+    nodes.clear();
+    frontier.clear();
+    const NodeId root = nodes.add(NO_PARENT, 0);
+    auto& root_info = infos[0];
+    if (std::isnan(root_info.h)) {
+      root_info.h = heuristic.estimate_cost_to_goal(initial_relative_state);
+      counters.evaluations++;
+    }
+    root_info = {search, 0, root, root_info.h};
+    frontier.push(root, Priority(weight * root_info.h, root_info.h));
+
+    while (!improved && !frontier.empty()) {
+      if (past_deadline()) {
+        return finish();
+      }
+      const NodeId parent_node = frontier.top();
+      frontier.pop();
+
+      const auto parent_index = nodes[parent_node].state_index;
+      const uint32_t g = infos[parent_index].g + 1;
+      if (infos[parent_index].node != parent_node ||
+          g + 1 >= best_plan->size()) {
+        // A shorter path to the state was found after this node was pushed, or
+        // no successor can be on a shorter plan than the best plan.
+        continue;
+      }
+      visited.getState(parent_index, parent_state);
+      counters.expansions++;
+
+      for (const auto& action : action_iterator.next()) {
+        const auto state_index = generate(action);
+        if (!state_index) {
+          continue;
+        }
+        auto& info = infos[*state_index];
+        if (info.search == search && info.g <= g) {
+          counters.duplicates++;
+          continue;
+        }
+
+        const NodeId node = nodes.add(parent_node, *state_index, action);
+        info.search = search;
+        info.g = g;
+        info.node = node;
+
+        if (puzzle.satisfiesGoal(relative_state.state)) {
+          // The parent's other successors are also on plans of length `g`, so
+          // none of them can improve on this plan.
+          record_plan(node);
+          improved = !last_search;
+          break;
+        }
+        if (g + 1 >= best_plan->size()) {
+          continue;
+        }
+
+        if (std::isnan(info.h)) {
+          info.h = heuristic.estimate_cost_to_goal(relative_state);
+          counters.evaluations++;
+        }
+        frontier.push(node, Priority(g + weight * info.h, info.h));
+        counters.max_frontier_size =
+            std::max(counters.max_frontier_size, frontier.size());
+      }
+    }
+
+    if (!improved) {
+      // Only states that cannot improve the best plan were discarded, so the
+      // best plan is a shortest plan.
+      break;
+    }
+  }
+
+  return finish();
+}
+
+}  // namespace search
+}  // namespace pushworld
+
+#endif /* SEARCH_ANYTIME_SEARCH_H_ */
@@ -17,14 +17,24 @@
 #ifndef SEARCH_BEST_FIRST_SEARCH_H_
 #define SEARCH_BEST_FIRST_SEARCH_H_
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <optional>
+#include <utility>  // pair, swap
+#include <vector>
 
+#include "heuristics/dead_end_detector.h"
 #include "heuristics/heuristic.h"
 #include "pushworld_puzzle.h"
+#include "search/packed_state_set.h"
 #include "search/priority_queue.h"
 #include "search/random_action_iterator.h"
 #include "search/search.h"
+#include "search/search_context.h"
+#include "search/search_statistics.h"
 
 namespace pushworld {
 namespace search {
@@ -69,18 +79,24 @@ std::optional<Plan> best_first_search(
   frontier.push(std::make_shared<SearchNode>(nullptr, initial_state),
                 heuristic.estimate_cost_to_goal(initial_relative_state));
 
+  // Reused for every successor to avoid allocating memory.
+  RelativeState relative_state;
+
   while (!frontier.empty()) {
     const auto parent_node = frontier.top();
     frontier.pop();
 
     for (const auto& action : action_iterator.next()) {
-      const RelativeState relative_state =
-          puzzle.getNextState(parent_node->state, action);
+      // If nothing moves, the state is the parent's state, which was already
+      // visited.
+      if (!puzzle.getNextState(parent_node->state, action, relative_state)) {
+        continue;
+      }
 
       // Ignore the state if it was already visited.
       if (visited.find(relative_state.state) == visited.end()) {
-        const auto node =
-            std::make_shared<SearchNode>(parent_node, relative_state.state);
+        const auto node = std::make_shared<SearchNode>(
+            parent_node, relative_state.state, action);
 
         if (puzzle.satisfiesGoal(relative_state.state)) {
           // Return the first solution found.
@@ -97,6 +113,523 @@ std::optional<Plan> best_first_search(
   return std::nullopt;
 }
 
+/**
+ * Identical to `best_first_search` above, except that visited states are
+ * stored in a `PackedStateSet`, which requires much less memory per state than
+ * a `StateSet`. Unlike the above function, `visited` also contains the goal
+ * state when a solution is found.
+ */
+template <typename Cost>
+std::optional<Plan> best_first_search(
+    const PushWorldPuzzle& puzzle, heuristic::Heuristic<Cost>& heuristic,
+    priority_queue::PriorityQueue<std::shared_ptr<SearchNode>, Cost>& frontier,
+    PackedStateSet& visited) {
+  const auto& initial_state = puzzle.getInitialState();
+
+  if (puzzle.satisfiesGoal(initial_state)) {
+    return Plan();  // The plan to reach the goal has no actions.
+  }
+
+  RandomActionIterator action_iterator;
+
+  visited.clear();
+  visited.insert(initial_state);
+
+  std::vector<int> all_object_indices(initial_state.size());
+  for (int i = 0; i < initial_state.size(); i++) {
+    all_object_indices[i] = i;
+  }
+  const RelativeState initial_relative_state{initial_state,
+                                             std::move(all_object_indices)};
+
+  frontier.clear();
+  frontier.push(std::make_shared<SearchNode>(nullptr, initial_state),
+                heuristic.estimate_cost_to_goal(initial_relative_state));
+
+  // Reused for every successor to avoid allocating memory.
+  RelativeState relative_state;
+
+  while (!frontier.empty()) {
+    const auto parent_node = frontier.top();
+    frontier.pop();
+
+    for (const auto& action : action_iterator.next()) {
+      if (!puzzle.getNextState(parent_node->state, action, relative_state)) {
+        continue;
+      }
+
+      // Ignore the state if it was already visited.
+      if (visited.insert(relative_state.state).second) {
+        const auto node = std::make_shared<SearchNode>(
+            parent_node, relative_state.state, action);
+
+        if (puzzle.satisfiesGoal(relative_state.state)) {
+          // Return the first solution found.
+          return backtrackPlan(puzzle, node);
+        }
+
+        frontier.push(node, heuristic.estimate_cost_to_goal(relative_state));
+      }
+    }
+  }
+
+  // No solution found
+  return std::nullopt;
+}
+
+/**
+ * Identical to `best_first_search` above, except that search nodes are stored
+ * in the `nodes` arena and the `frontier` contains node IDs, so no memory is
+ * allocated per node other than the arena itself. Each node refers to its state
+ * in `visited` by index instead of storing a copy of the state.
+ *
+ * Both `visited` and `nodes` are cleared when the search begins.
+ *
+ * If `statistics` is not null, it is reset and then filled in with
+ * measurements of the search, including the counters of the `heuristic`.
+ *
+ * If `dead_ends` is not null, new states that it detects as dead ends are
+ * discarded before the `heuristic` is evaluated, and the search returns
+ * `NO_SOLUTION` immediately if the initial state is a dead end.
+ *
+ * The limits of the `context` are checked before the first expansion and then
+ * once every `context.checkInterval()` expansions. The memory usage that is
+ * compared to the budget of the `context` sums `visited`, `nodes`, the node
+ * IDs in the `frontier`, and `heuristic.memory_usage()`. When a limit is
+ * reached, the search returns its status without a plan, and the `statistics`
+ * describe the search up to that point.
+ *
+ * The `heuristic` is given the `context` for the duration of the search. See
+ * `Heuristic::set_search_context`.
+ *
+ * Successors are generated in the random orders of a `RandomActionIterator`
+ * with the given `action_seed`, which breaks ties between states of equal
+ * cost differently for each seed. The successors of every expanded node are
+ * generated with `PushWorldPuzzle::getSuccessors`, and the new ones are
+ * evaluated as one batch with `Heuristic::estimate_costs`.
+ *
+ * If `canonicalize_objects` is true, states are stored in `visited` and
+ * evaluated in their canonical form, in which interchangeable objects are
+ * sorted by position, so states that only differ by permuting interchangeable
+ * objects are duplicates. See `PushWorldPuzzle::canonicalize`. This usually
+ * reduces the number of evaluations, but it can mislead a heuristic that
+ * tracks the positions of individual objects, e.g. the novelty heuristic
+ * unless it shares the positions of interchangeable objects.
+ */
+template <typename Cost>
+SearchResult best_first_search(
+    const PushWorldPuzzle& puzzle, heuristic::Heuristic<Cost>& heuristic,
+    priority_queue::PriorityQueue<NodeId, Cost>& frontier,
+    PackedStateSet& visited, SearchNodeStore& nodes,
+    const SearchContext& context, SearchStatistics* statistics = nullptr,
+    const heuristic::DeadEndDetector* dead_ends = nullptr,
+    const unsigned int action_seed = RandomActionIterator::DEFAULT_SEED,
+    const bool canonicalize_objects = false) {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point search_start;
+  if (statistics != nullptr) {
+    *statistics = SearchStatistics();
+    search_start = Clock::now();
+  }
+
+  heuristic.set_search_context(&context);
+
+  // Clears the search context of the `heuristic` and completes the
+  // `statistics` before returning the `status` and `plan`.
+  const auto finish = [&](const SearchStatus status,
+                          std::optional<Plan> plan = std::nullopt) {
+    heuristic.set_search_context(nullptr);
+    if (statistics != nullptr) {
+      statistics->total_seconds = seconds_between(search_start, Clock::now());
+      heuristic.add_counters(statistics->heuristic_counters);
+    }
+    return SearchResult{status, std::move(plan)};
+  };
+
+  // Permutations of interchangeable objects are the same visited state. See
+  // `PushWorldPuzzle::canonicalize`.
+  State initial_state = puzzle.getInitialState();
+  if (canonicalize_objects) {
+    puzzle.canonicalize(initial_state);
+  }
+
+  if (puzzle.satisfiesGoal(initial_state)) {
+    // The plan to reach the goal has no actions.
+    return finish(SearchStatus::SOLVED, Plan());
+  }
+  if (dead_ends != nullptr && dead_ends->isDeadEnd(initial_state)) {
+    return finish(SearchStatus::NO_SOLUTION);
+  }
+
+  RandomActionIterator action_iterator(
+      RandomActionIterator::DEFAULT_NUM_ACTION_GROUPS, action_seed);
+
+  visited.clear();
+  nodes.clear();
+  const NodeId root = nodes.add(NO_PARENT, visited.insert(initial_state).first);
+
+  std::vector<int> all_object_indices(initial_state.size());
+  for (int i = 0; i < initial_state.size(); i++) {
+    all_object_indices[i] = i;
+  }
+  const RelativeState initial_relative_state{initial_state,
+                                             std::move(all_object_indices)};
+
+  frontier.clear();
+  frontier.push(root, heuristic.estimate_cost_to_goal(initial_relative_state));
+  if (statistics != nullptr) {
+    statistics->evaluations++;
+    statistics->max_frontier_size = 1;
+  }
+
+  // Reused for every expansion to avoid allocating memory. The first
+  // `num_children` successors are the new states of the expanded node, which
+  // are evaluated as a single batch.
+  State parent_state;
+  std::vector<RelativeState> successors;
+  std::vector<uint8_t> moved;
+  std::vector<NodeId> children;
+  std::vector<Cost> costs;
+  Clock::time_point start, end;
+  const size_t check_interval = context.checkInterval();
+  size_t expansions_until_check = 0;
+
+  while (!frontier.empty()) {
+    if (expansions_until_check-- == 0) {
+      expansions_until_check = check_interval - 1;
+      const auto limit = context.check(
+          visited.memoryUsage() + nodes.memoryUsage() +
+          frontier.size() * sizeof(NodeId) + heuristic.memory_usage());
+      if (limit != std::nullopt) {
+        return finish(*limit);
+      }
+    }
+
+    const NodeId parent_node = frontier.top();
+    frontier.pop();
+    visited.getState(nodes[parent_node].state_index, parent_state);
+    if (statistics != nullptr) {
+      statistics->expansions++;
+      start = Clock::now();
+    }
+
+    const auto& actions = action_iterator.next();
+    puzzle.getSuccessors(&parent_state, 1, actions, successors, moved);
+
+    size_t num_children = 0;
+    children.resize(actions.size());
+    for (size_t i = 0; i < actions.size(); i++) {
+      // If nothing moved, the state is the parent's state, which was already
+      // visited.
+      if (!moved[i]) {
+        continue;
+      }
+      RelativeState& relative_state = successors[i];
+      if (canonicalize_objects && puzzle.canonicalize(relative_state.state)) {
+        set_moved_object_indices(parent_state, relative_state);
+      }
+      if (statistics != nullptr) {
+        statistics->generations++;
+      }
+
+      // The parent is not a dead end, so only the moved objects are checked.
+      // Dead ends are not stored in `visited`. A goal state is never a dead
+      // end.
+      if (dead_ends != nullptr && dead_ends->isDeadEnd(relative_state)) {
+        if (statistics != nullptr) {
+          statistics->dead_ends++;
+        }
+        continue;
+      }
+
+      // Ignore the state if it was already visited.
+      const auto inserted = visited.insert(relative_state.state);
+      if (!inserted.second) {
+        if (statistics != nullptr) {
+          statistics->duplicates++;
+        }
+        continue;
+      }
+
+      const NodeId node = nodes.add(parent_node, inserted.first, actions[i]);
+
+      if (puzzle.satisfiesGoal(relative_state.state)) {
+        // Return the first solution found.
+        return finish(SearchStatus::SOLVED,
+                      backtrackPlan(puzzle, visited, nodes, node));
+      }
+
+      std::swap(successors[num_children], successors[i]);
+      children[num_children++] = node;
+    }
+
+    if (num_children == 0) {
+      if (statistics != nullptr) {
+        statistics->successor_seconds += seconds_between(start, Clock::now());
+      }
+      continue;
+    }
+
+    costs.resize(num_children);
+    if (statistics == nullptr) {
+      heuristic.estimate_costs(successors.data(), num_children, costs.data());
+      for (size_t i = 0; i < num_children; i++) {
+        frontier.push(children[i], costs[i]);
+      }
+      continue;
+    }
+
+    end = Clock::now();
+    statistics->successor_seconds += seconds_between(start, end);
+    start = end;
+    heuristic.estimate_costs(successors.data(), num_children, costs.data());
+    statistics->heuristic_seconds += seconds_between(start, Clock::now());
+    statistics->evaluations += num_children;
+
+    for (size_t i = 0; i < num_children; i++) {
+      frontier.push(children[i], costs[i]);
+    }
+    if (frontier.size() > statistics->max_frontier_size) {
+      statistics->max_frontier_size = frontier.size();
+    }
+  }
+
+  // The heuristic may have returned early once the search had to stop, so the
+  // search space is only known to be exhausted if no limit was reached.
+  const auto limit = context.check(0);
+  return finish(limit == std::nullopt ? SearchStatus::NO_SOLUTION : *limit);
+}
+
+/**
+ * Returns whether a heuristic `cost` is infinite, which means that the goal is
+ * provably unreachable. Always returns false for types without infinity.
+ */
+template <typename Cost>
+bool is_infinite_cost(const Cost& cost) {
+  return std::numeric_limits<Cost>::has_infinity &&
+         cost == std::numeric_limits<Cost>::infinity();
+}
+
+/* Lexicographic costs are infinite if their primary cost is, as in
+ * `heuristic::LexicographicHeuristic`. */
+template <typename Primary, typename Secondary>
+bool is_infinite_cost(const std::pair<Primary, Secondary>& cost) {
+  return is_infinite_cost(cost.first);
+}
+
+/**
+ * Identical to the arena `best_first_search` above, except that the heuristic
+ * is evaluated lazily: new states enter the `frontier` with the estimated cost
+ * of their parent, and each state is only evaluated when it is removed from
+ * the `frontier`, before its successors are generated. Most generated states
+ * are never expanded, so this performs far fewer evaluations with expensive
+ * heuristics, at the cost of a less informed order of expansions. This is also
+ * known as deferred evaluation.
+ *
+ * The `moved_object_indices` of an evaluated state are the objects whose
+ * positions differ from its parent's state. States with an infinite cost are
+ * not expanded, and are counted as dead ends in the `statistics`, which also
+ * count the evaluations that were actually performed.
+ */
+template <typename Cost>
+SearchResult lazy_best_first_search(
+    const PushWorldPuzzle& puzzle, heuristic::Heuristic<Cost>& heuristic,
+    priority_queue::PriorityQueue<NodeId, Cost>& frontier,
+    PackedStateSet& visited, SearchNodeStore& nodes,
+    const SearchContext& context, SearchStatistics* statistics = nullptr,
+    const heuristic::DeadEndDetector* dead_ends = nullptr,
+    const unsigned int action_seed = RandomActionIterator::DEFAULT_SEED,
+    const bool canonicalize_objects = false) {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point search_start;
+  if (statistics != nullptr) {
+    *statistics = SearchStatistics();
+    search_start = Clock::now();
+  }
+
+  heuristic.set_search_context(&context);
+
+  // Clears the search context of the `heuristic` and completes the
+  // `statistics` before returning the `status` and `plan`.
+  const auto finish = [&](const SearchStatus status,
+                          std::optional<Plan> plan = std::nullopt) {
+    heuristic.set_search_context(nullptr);
+    if (statistics != nullptr) {
+      statistics->total_seconds = seconds_between(search_start, Clock::now());
+      heuristic.add_counters(statistics->heuristic_counters);
+    }
+    return SearchResult{status, std::move(plan)};
+  };
+
+  // Permutations of interchangeable objects are the same visited state. See
+  // `PushWorldPuzzle::canonicalize`.
+  State initial_state = puzzle.getInitialState();
+  if (canonicalize_objects) {
+    puzzle.canonicalize(initial_state);
+  }
+
+  if (puzzle.satisfiesGoal(initial_state)) {
+    // The plan to reach the goal has no actions.
+    return finish(SearchStatus::SOLVED, Plan());
+  }
+  if (dead_ends != nullptr && dead_ends->isDeadEnd(initial_state)) {
+    return finish(SearchStatus::NO_SOLUTION);
+  }
+
+  RandomActionIterator action_iterator(
+      RandomActionIterator::DEFAULT_NUM_ACTION_GROUPS, action_seed);
+
+  visited.clear();
+  nodes.clear();
+  const NodeId root = nodes.add(NO_PARENT, visited.insert(initial_state).first);
+
+  // The initial state is evaluated when it is expanded, like every other
+  // state, so its priority in the frontier is irrelevant.
+  frontier.clear();
+  frontier.push(root, Cost());
+  if (statistics != nullptr) {
+    statistics->max_frontier_size = 1;
+  }
+
+  // Reused for every expansion to avoid allocating memory.
+  RelativeState relative_state;
+  State parent_state;
+  std::vector<RelativeState> successors;
+  std::vector<uint8_t> moved;
+  Clock::time_point start, end;
+  const size_t check_interval = context.checkInterval();
+  size_t expansions_until_check = 0;
+
+  while (!frontier.empty()) {
+    if (expansions_until_check-- == 0) {
+      expansions_until_check = check_interval - 1;
+      const auto limit = context.check(
+          visited.memoryUsage() + nodes.memoryUsage() +
+          frontier.size() * sizeof(NodeId) + heuristic.memory_usage());
+      if (limit != std::nullopt) {
+        return finish(*limit);
+      }
+    }
+
+    const NodeId node = frontier.top();
+    frontier.pop();
+    if (statistics != nullptr) {
+      statistics->expansions++;
+      start = Clock::now();
+    }
+
+    // Evaluate the state relative to its parent.
+    visited.getState(nodes[node].state_index, relative_state.state);
+    relative_state.moved_object_indices.clear();
+    const NodeId parent_node = nodes[node].parent;
+    if (parent_node == NO_PARENT) {
+      for (int i = 0; i < relative_state.state.size(); i++) {
+        relative_state.moved_object_indices.push_back(i);
+      }
+    } else {
+      visited.getState(nodes[parent_node].state_index, parent_state);
+      for (int i = 0; i < relative_state.state.size(); i++) {
+        if (relative_state.state[i] != parent_state[i]) {
+          relative_state.moved_object_indices.push_back(i);
+        }
+      }
+    }
+    const Cost cost = heuristic.estimate_cost_to_goal(relative_state);
+    if (statistics != nullptr) {
+      end = Clock::now();
+      statistics->heuristic_seconds += seconds_between(start, end);
+      statistics->evaluations++;
+      start = end;
+    }
+
+    // The goal is unreachable from this state, as the eager search would have
+    // found before adding it to the frontier.
+    if (is_infinite_cost(cost)) {
+      if (statistics != nullptr) {
+        statistics->dead_ends++;
+      }
+      continue;
+    }
+
+    const auto& actions = action_iterator.next();
+    puzzle.getSuccessors(&relative_state.state, 1, actions, successors, moved);
+
+    for (size_t i = 0; i < actions.size(); i++) {
+      // If nothing moved, the state is the parent's state, which was already
+      // visited.
+      if (!moved[i]) {
+        continue;
+      }
+      RelativeState& successor = successors[i];
+      if (canonicalize_objects && puzzle.canonicalize(successor.state)) {
+        set_moved_object_indices(relative_state.state, successor);
+      }
+      if (statistics != nullptr) {
+        statistics->generations++;
+      }
+
+      // The parent is not a dead end, so only the moved objects are checked.
+      // Dead ends are not stored in `visited`. A goal state is never a dead
+      // end.
+      if (dead_ends != nullptr && dead_ends->isDeadEnd(successor)) {
+        if (statistics != nullptr) {
+          statistics->dead_ends++;
+        }
+        continue;
+      }
+
+      // Ignore the state if it was already visited.
+      const auto inserted = visited.insert(successor.state);
+      if (!inserted.second) {
+        if (statistics != nullptr) {
+          statistics->duplicates++;
+        }
+        continue;
+      }
+
+      const NodeId child = nodes.add(node, inserted.first, actions[i]);
+
+      if (puzzle.satisfiesGoal(successor.state)) {
+        // Return the first solution found.
+        return finish(SearchStatus::SOLVED,
+                      backtrackPlan(puzzle, visited, nodes, child));
+      }
+
+      frontier.push(child, cost);
+    }
+
+    if (statistics != nullptr) {
+      statistics->successor_seconds += seconds_between(start, Clock::now());
+      if (frontier.size() > statistics->max_frontier_size) {
+        statistics->max_frontier_size = frontier.size();
+      }
+    }
+  }
+
+  // The heuristic may have returned early once the search had to stop, so the
+  // search space is only known to be exhausted if no limit was reached.
+  const auto limit = context.check(0);
+  return finish(limit == std::nullopt ? SearchStatus::NO_SOLUTION : *limit);
+}
+
+/**
+ * Identical to `best_first_search` above, but without limits on time or
+ * memory, so the search only ends when it finds a plan or exhausts the search
+ * space. Returns `std::nullopt` if no solution exists.
+ */
+template <typename Cost>
+std::optional<Plan> best_first_search(
+    const PushWorldPuzzle& puzzle, heuristic::Heuristic<Cost>& heuristic,
+    priority_queue::PriorityQueue<NodeId, Cost>& frontier,
+    PackedStateSet& visited, SearchNodeStore& nodes,
+    SearchStatistics* statistics = nullptr,
+    const heuristic::DeadEndDetector* dead_ends = nullptr) {
+  const SearchContext unlimited;
+  return best_first_search<Cost>(puzzle, heuristic, frontier, visited, nodes,
+                                 unlimited, statistics, dead_ends)
+      .plan;
+}
+
 /* Identical to `best_first_search` above, but without the `visited` argument.
  */
 template <typename Cost>
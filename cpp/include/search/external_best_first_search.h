@@ -0,0 +1,418 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SEARCH_EXTERNAL_BEST_FIRST_SEARCH_H_
+#define SEARCH_EXTERNAL_BEST_FIRST_SEARCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "heuristics/dead_end_detector.h"
+#include "heuristics/heuristic.h"
+#include "pushworld_puzzle.h"
+#include "search/external_storage.h"
+#include "search/packed_state_set.h"
+#include "search/random_action_iterator.h"
+#include "search/search.h"
+#include "search/search_context.h"
+#include "search/search_statistics.h"
+
+namespace pushworld {
+namespace search {
+
+/**
+ * A priority queue of fixed-size records with one bucket of records per cost.
+ * Once the records in memory use more than the memory budget, the buckets with
+ * the highest costs, which are the last to be expanded, are appended to
+ * compressed `RecordFile`s until the records in memory use at most half of the
+ * budget.
+ */
+template <typename Cost>
+class ExternalFrontier {
+ private:
+  struct Bucket {
+    // Records in memory.
+    std::vector<PackedWord> records;
+
+    // Records on disk, of which the blocks before `next_block` were already
+    // popped.
+    std::unique_ptr<RecordFile> file;
+    size_t next_block = 0;
+  };
+
+  ScratchDirectory& m_directory;
+  int m_record_words;
+  size_t m_memory_budget;
+  std::map<Cost, Bucket> m_buckets;
+  size_t m_size;
+  size_t m_memory_words;
+
+  /* Moves the records in memory of the highest-cost buckets to disk. */
+  void spill() {
+    for (auto bucket = m_buckets.rbegin();
+         bucket != m_buckets.rend() &&
+         m_memory_words * sizeof(PackedWord) > m_memory_budget / 2;
+         bucket++) {
+      auto& records = bucket->second.records;
+      if (records.empty()) {
+        continue;
+      }
+      auto& file = bucket->second.file;
+      if (file == nullptr) {
+        file = std::make_unique<RecordFile>(m_directory.newFilePath("open"),
+                                            m_record_words);
+      }
+      file->append(records.data(), records.size() / m_record_words);
+      file->flush();
+      m_memory_words -= records.size();
+      std::vector<PackedWord>().swap(records);
+    }
+  }
+
+ public:
+  /**
+   * Constructs an empty frontier of records with `record_words` words each,
+   * which writes files in the `directory` once the records in memory use more
+   * than `memory_budget` bytes.
+   */
+  ExternalFrontier(ScratchDirectory& directory, const int record_words,
+                   const size_t memory_budget)
+      : m_directory(directory),
+        m_record_words(record_words),
+        m_memory_budget(memory_budget),
+        m_size(0),
+        m_memory_words(0) {}
+
+  /* Returns the number of records in memory and on disk. */
+  size_t size() const { return m_size; };
+
+  bool empty() const { return m_size == 0; };
+
+  /* Adds a copy of the `record` with the given `cost`. */
+  void push(const PackedWord* record, const Cost& cost) {
+    auto& records = m_buckets[cost].records;
+    records.insert(records.end(), record, record + m_record_words);
+    m_size++;
+    m_memory_words += m_record_words;
+    if (m_memory_words * sizeof(PackedWord) > m_memory_budget) {
+      spill();
+    }
+  }
+
+  /**
+   * Removes records with the minimum cost, appending them to `records`, until
+   * the bucket with the minimum cost is empty or at least `max_records` records
+   * were removed. More than `max_records` may be removed, since blocks on disk
+   * are read entirely. Records are not removed in any particular order.
+   */
+  void popBatch(std::vector<PackedWord>& records, const size_t max_records) {
+    const auto bucket = m_buckets.begin();
+    Bucket& lowest = bucket->second;
+    const size_t max_words = max_records * m_record_words;
+    const size_t initial_words = records.size();
+
+    if (lowest.file != nullptr) {
+      std::vector<PackedWord> block;
+      while (lowest.next_block < lowest.file->numBlocks() &&
+             records.size() - initial_words < max_words) {
+        lowest.file->readBlock(lowest.next_block++, block);
+        records.insert(records.end(), block.begin(), block.end());
+      }
+    }
+
+    const size_t num_memory_words =
+        std::min(lowest.records.size(),
+                 max_words - std::min(max_words, records.size() -
+                                                     initial_words));
+    records.insert(records.end(), lowest.records.end() - num_memory_words,
+                   lowest.records.end());
+    lowest.records.resize(lowest.records.size() - num_memory_words);
+    m_memory_words -= num_memory_words;
+    m_size -= (records.size() - initial_words) / m_record_words;
+
+    if (lowest.records.empty() &&
+        (lowest.file == nullptr ||
+         lowest.next_block == lowest.file->numBlocks())) {
+      m_buckets.erase(bucket);
+    }
+  }
+
+  /* Returns the number of bytes of memory that this frontier has allocated. */
+  size_t memoryUsage() const {
+    size_t bytes = m_buckets.size() * sizeof(Bucket);
+    for (const auto& bucket : m_buckets) {
+      bytes += bucket.second.records.capacity() * sizeof(PackedWord);
+      if (bucket.second.file != nullptr) {
+        bytes += bucket.second.file->memoryUsage();
+      }
+    }
+    return bytes;
+  }
+
+  /* Returns the number of bytes that this frontier has written to disk. */
+  size_t diskUsage() const {
+    size_t bytes = 0;
+    for (const auto& bucket : m_buckets) {
+      if (bucket.second.file != nullptr) {
+        bytes += bucket.second.file->diskUsage();
+      }
+    }
+    return bytes;
+  }
+};
+
+/* Configures where and when `external_best_first_search` uses the disk. */
+struct ExternalSearchOptions {
+  // The directory in which a temporary directory is created for the files of
+  // the search. If empty, the system's temporary directory is used.
+  std::string directory;
+
+  // The approximate number of bytes of states that are kept in memory. Half of
+  // the budget is used by the visited states, a quarter by the frontier, and a
+  // quarter by the batch of states that is being expanded.
+  size_t memory_budget = size_t(1) << 30;
+};
+
+/**
+ * Identical to the arena `best_first_search`, except that the visited states
+ * and the frontier are written to disk when they exceed the memory budget of
+ * the `options`, so the size of the search is limited by the disk instead of
+ * memory. The visited states are an `ExternalStateMap` and the frontier is an
+ * `ExternalFrontier` of (state, parent) records of packed states.
+ *
+ * States are expanded in batches of the lowest-cost bucket of the frontier.
+ * Each batch is sorted, and the states that are already visited are removed
+ * from it before it is expanded. Successors that are visited states in memory
+ * are discarded immediately, while successors that are only visited on disk
+ * are discarded when their batch is expanded. Since states within a batch are
+ * expanded in sorted order, and since the heuristic may evaluate states that
+ * are discarded later, the search is not identical to `best_first_search`.
+ *
+ * As in `best_first_search`, states are stored in their canonical form if
+ * `canonicalize_objects` is true.
+ *
+ * The memory usage that is compared to the budget of the `context` sums the
+ * visited states, the frontier, the batch, and `heuristic.memory_usage()`.
+ *
+ * Throws `std::runtime_error` if a file of the search cannot be written.
+ */
+template <typename Cost>
+SearchResult external_best_first_search(
+    const PushWorldPuzzle& puzzle, heuristic::Heuristic<Cost>& heuristic,
+    const ExternalSearchOptions& options, const SearchContext& context,
+    SearchStatistics* statistics = nullptr,
+    const heuristic::DeadEndDetector* dead_ends = nullptr,
+    const bool canonicalize_objects = false) {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point search_start;
+  if (statistics != nullptr) {
+    *statistics = SearchStatistics();
+    search_start = Clock::now();
+  }
+
+  heuristic.set_search_context(&context);
+
+  // Clears the search context of the `heuristic` and completes the
+  // `statistics` before returning the `status` and `plan`.
+  const auto finish = [&](const SearchStatus status,
+                          std::optional<Plan> plan = std::nullopt) {
+    heuristic.set_search_context(nullptr);
+    if (statistics != nullptr) {
+      statistics->total_seconds = seconds_between(search_start, Clock::now());
+      heuristic.add_counters(statistics->heuristic_counters);
+    }
+    return SearchResult{status, std::move(plan)};
+  };
+
+  // Permutations of interchangeable objects are the same visited state. See
+  // `PushWorldPuzzle::canonicalize`.
+  State initial_state = puzzle.getInitialState();
+  if (canonicalize_objects) {
+    puzzle.canonicalize(initial_state);
+  }
+
+  if (puzzle.satisfiesGoal(initial_state)) {
+    // The plan to reach the goal has no actions.
+    return finish(SearchStatus::SOLVED, Plan());
+  }
+  if (dead_ends != nullptr && dead_ends->isDeadEnd(initial_state)) {
+    return finish(SearchStatus::NO_SOLUTION);
+  }
+
+  const StatePacker packer(puzzle);
+  const int state_words = packer.numWords();
+
+  // Every record is a state followed by its parent state. The parent of the
+  // initial state is itself.
+  const int record_words = 2 * state_words;
+  const size_t batch_records = std::max<size_t>(
+      1, options.memory_budget / 4 / (record_words * sizeof(PackedWord)));
+
+  ScratchDirectory directory(options.directory);
+  ExternalStateMap visited(packer, directory, options.memory_budget / 2);
+  ExternalFrontier<Cost> frontier(directory, record_words,
+                                  options.memory_budget / 4);
+
+  // Returns the plan that reaches the goal state in the `record`, whose
+  // ancestors are all in `visited`.
+  const auto backtrack = [&](const PackedWord* record) {
+    std::vector<State> path(2);
+    packer.unpack(record, path[0]);
+    packer.unpack(record + state_words, path[1]);
+    std::vector<PackedWord> state(record + state_words, record + record_words);
+    std::vector<PackedWord> parent(state_words);
+    while (visited.findParent(state.data(), parent.data()) && parent != state) {
+      path.emplace_back();
+      packer.unpack(parent.data(), path.back());
+      state.swap(parent);
+    }
+    std::reverse(path.begin(), path.end());
+    return planFromStates(puzzle, path);
+  };
+
+  std::vector<int> all_object_indices(initial_state.size());
+  for (int i = 0; i < initial_state.size(); i++) {
+    all_object_indices[i] = i;
+  }
+  const RelativeState initial_relative_state{initial_state,
+                                             std::move(all_object_indices)};
+
+  std::vector<PackedWord> record(record_words);
+  packer.pack(initial_state, record.data());
+  packer.pack(initial_state, record.data() + state_words);
+  frontier.push(record.data(),
+                heuristic.estimate_cost_to_goal(initial_relative_state));
+  if (statistics != nullptr) {
+    statistics->evaluations++;
+    statistics->max_frontier_size = 1;
+  }
+
+  RandomActionIterator action_iterator;
+
+  // Reused for every expansion to avoid allocating memory.
+  std::vector<PackedWord> batch;
+  State parent_state;
+  RelativeState relative_state;
+  Clock::time_point start, end;
+  const size_t check_interval = context.checkInterval();
+  size_t expansions_until_check = 0;
+
+  while (!frontier.empty()) {
+    batch.clear();
+    frontier.popBatch(batch, batch_records);
+    const size_t num_popped = batch.size() / record_words;
+    sort_unique_records(batch, record_words, state_words);
+    visited.removeContained(batch, record_words);
+    if (statistics != nullptr) {
+      statistics->duplicates += num_popped - batch.size() / record_words;
+    }
+
+    for (size_t r = 0; r < batch.size(); r += record_words) {
+      if (expansions_until_check-- == 0) {
+        expansions_until_check = check_interval - 1;
+        const auto limit = context.check(
+            visited.memoryUsage() + frontier.memoryUsage() +
+            batch.capacity() * sizeof(PackedWord) + heuristic.memory_usage());
+        if (limit != std::nullopt) {
+          return finish(*limit);
+        }
+      }
+
+      const PackedWord* parent = batch.data() + r;
+      visited.insert(parent, parent + state_words);
+      packer.unpack(parent, parent_state);
+      std::copy(parent, parent + state_words, record.data() + state_words);
+      if (statistics != nullptr) {
+        statistics->expansions++;
+      }
+
+      for (const auto& action : action_iterator.next()) {
+        if (statistics != nullptr) {
+          start = Clock::now();
+        }
+
+        const bool moved =
+            puzzle.getNextState(parent_state, action, relative_state);
+        if (moved && canonicalize_objects &&
+            puzzle.canonicalize(relative_state.state)) {
+          set_moved_object_indices(parent_state, relative_state);
+        }
+        const bool dead_end = moved && dead_ends != nullptr &&
+                              dead_ends->isDeadEnd(relative_state);
+        bool duplicate = false;
+        if (moved && !dead_end) {
+          packer.pack(relative_state.state, record.data());
+          duplicate = visited.containsInMemory(record.data());
+        }
+
+        if (statistics != nullptr) {
+          statistics->successor_seconds +=
+              seconds_between(start, Clock::now());
+          if (moved) {
+            statistics->generations++;
+            statistics->dead_ends += dead_end;
+            statistics->duplicates += duplicate;
+          }
+        }
+
+        // Ignore the state if nothing moved, if it is a dead end, or if it is
+        // a visited state in memory.
+        if (!moved || dead_end || duplicate) {
+          continue;
+        }
+
+        if (puzzle.satisfiesGoal(relative_state.state)) {
+          // Return the first solution found.
+          return finish(SearchStatus::SOLVED, backtrack(record.data()));
+        }
+
+        if (statistics == nullptr) {
+          frontier.push(record.data(),
+                        heuristic.estimate_cost_to_goal(relative_state));
+          continue;
+        }
+
+        start = Clock::now();
+        const Cost cost = heuristic.estimate_cost_to_goal(relative_state);
+        end = Clock::now();
+        statistics->heuristic_seconds += seconds_between(start, end);
+        statistics->evaluations++;
+
+        frontier.push(record.data(), cost);
+        if (frontier.size() > statistics->max_frontier_size) {
+          statistics->max_frontier_size = frontier.size();
+        }
+      }
+    }
+  }
+
+  // The heuristic may have returned early once the search had to stop, so the
+  // search space is only known to be exhausted if no limit was reached.
+  const auto limit = context.check(0);
+  return finish(limit == std::nullopt ? SearchStatus::NO_SOLUTION : *limit);
+}
+
+}  // namespace search
+}  // namespace pushworld
+
+#endif /* SEARCH_EXTERNAL_BEST_FIRST_SEARCH_H_ */
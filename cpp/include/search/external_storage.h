@@ -0,0 +1,262 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEARCH_EXTERNAL_STORAGE_H_
+#define SEARCH_EXTERNAL_STORAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "search/packed_state_set.h"
+
+namespace pushworld {
+namespace search {
+
+/**
+ * Sorts the records in `records`, which each contain `record_words` words, in
+ * lexicographic order of their first `key_words` words. Only the first of
+ * several records with equal keys is kept.
+ */
+void sort_unique_records(std::vector<PackedWord>& records,
+                         const int record_words, const int key_words);
+
+/**
+ * A temporary directory with a unique name, which is removed along with its
+ * contents when this object is destroyed.
+ */
+class ScratchDirectory {
+ private:
+  std::string m_path;
+  int m_next_file_id;
+
+ public:
+  /**
+   * Creates a new directory inside the `parent` directory, or inside the
+   * system's temporary directory if `parent` is empty. Throws
+   * `std::runtime_error` if the directory cannot be created.
+   */
+  explicit ScratchDirectory(const std::string& parent = "");
+  ~ScratchDirectory();
+
+  ScratchDirectory(const ScratchDirectory&) = delete;
+  ScratchDirectory& operator=(const ScratchDirectory&) = delete;
+
+  const std::string& path() const { return m_path; };
+
+  /* Returns the path of a file in this directory that has not been returned
+   * before. The file is not created. */
+  std::string newFilePath(const std::string& prefix);
+};
+
+/**
+ * A file of fixed-size records of `recordWords()` words each. Records are
+ * appended into blocks of about `BLOCK_BYTES` bytes, and every block is
+ * compressed with zlib when it is written. The first record of every block is
+ * also kept in memory, so that files of sorted records can be searched by
+ * only decompressing a single block.
+ *
+ * The file is removed when this object is destroyed. Throws
+ * `std::runtime_error` if any file operation fails.
+ */
+class RecordFile {
+ public:
+  // The uncompressed size of a block, unless a single record is larger.
+  static constexpr size_t BLOCK_BYTES = size_t(64) << 10;
+
+ private:
+  struct Block {
+    uint64_t offset;
+    uint32_t compressed_bytes;
+    uint32_t num_records;
+  };
+
+  std::string m_path;
+  std::FILE* m_file;
+  int m_record_words;
+  size_t m_records_per_block;
+  size_t m_size;
+  uint64_t m_file_bytes;
+
+  std::vector<Block> m_blocks;
+
+  // `m_first_records[i * m_record_words ...]` is the first record of block i.
+  std::vector<PackedWord> m_first_records;
+
+  // Records that have been appended but not yet written in a block.
+  std::vector<PackedWord> m_buffer;
+
+  // Scratch memory for compressed blocks.
+  mutable std::vector<unsigned char> m_compressed;
+
+  /* Compresses and writes the records in `m_buffer` as a new block. */
+  void writeBuffer();
+
+ public:
+  /* Creates an empty file at `path`, replacing any existing file. */
+  RecordFile(const std::string& path, const int record_words);
+  ~RecordFile();
+
+  RecordFile(const RecordFile&) = delete;
+  RecordFile& operator=(const RecordFile&) = delete;
+
+  /* Returns the number of words in every record. */
+  int recordWords() const { return m_record_words; };
+
+  /* Returns the number of records in this file, including buffered records. */
+  size_t size() const { return m_size; };
+
+  /* Appends `num_records` consecutive records starting at `records`. */
+  void append(const PackedWord* records, const size_t num_records);
+
+  /* Writes any buffered records in a final block. */
+  void flush();
+
+  /* Returns the number of written blocks. */
+  size_t numBlocks() const { return m_blocks.size(); };
+
+  /* Returns a pointer to the first record of the `block`. */
+  const PackedWord* firstRecord(const size_t block) const {
+    return m_first_records.data() + block * m_record_words;
+  };
+
+  /* Decompresses the records of the `block` into `records`. */
+  void readBlock(const size_t block, std::vector<PackedWord>& records) const;
+
+  /* Returns the number of bytes that have been written to the file. */
+  size_t diskUsage() const { return m_file_bytes; };
+
+  /* Returns the number of bytes of memory that this object has allocated. */
+  size_t memoryUsage() const {
+    return m_blocks.capacity() * sizeof(Block) +
+           (m_first_records.capacity() + m_buffer.capacity()) *
+               sizeof(PackedWord) +
+           m_compressed.capacity();
+  };
+};
+
+/**
+ * A map from visited states to their parent states, for searches whose visited
+ * states do not fit in memory.
+ *
+ * Recently inserted states are stored in memory in a `PackedStateSet`. Once
+ * they use more than the memory budget, they are written to disk as a sorted
+ * run of (state, parent) records in a `RecordFile`, and the memory is
+ * released. Runs are merged into one when there are more than `MAX_RUNS`.
+ *
+ * States on disk are not checked individually. Instead, searches remove all
+ * visited states from sorted batches of states with `removeContained`, which
+ * only decompresses the blocks of each run that may contain a batch state.
+ * This is known as delayed duplicate detection.
+ */
+class ExternalStateMap {
+ public:
+  static constexpr int MAX_RUNS = 16;
+
+ private:
+  StatePacker m_packer;
+  int m_state_words;
+  ScratchDirectory& m_directory;
+  size_t m_memory_budget;
+
+  // States in memory, and `m_memory_parents[i * m_state_words ...]` contains
+  // the parent of the state with index `i`.
+  PackedStateSet m_memory_states;
+  std::vector<PackedWord> m_memory_parents;
+
+  // Sorted runs of (state, parent) records, from oldest to newest. No state
+  // is in more than one run or in both a run and memory.
+  std::vector<std::unique_ptr<RecordFile>> m_runs;
+  size_t m_num_disk_states;
+
+  // Scratch memory for decompressed blocks.
+  mutable std::vector<PackedWord> m_block;
+
+  /* Writes all states in memory to a new run, and then releases the memory. */
+  void flush();
+
+  /* Merges all runs into a single run. */
+  void mergeRuns();
+
+  /**
+   * Returns a pointer to the record in `m_block` of the `run` whose state is
+   * `state`, or null if no record of the run contains the `state`. If
+   * `loaded_block` is the index of the block in `m_block`, it is not read
+   * again. Otherwise it is updated to the index of the block that is read.
+   */
+  const PackedWord* findInRun(const RecordFile& run, const PackedWord* state,
+                              size_t& loaded_block) const;
+
+ public:
+  /**
+   * Constructs an empty map of states that are encoded by the `packer`, which
+   * writes runs to files in the `directory` once the states in memory use more
+   * than `memory_budget` bytes.
+   */
+  ExternalStateMap(const StatePacker& packer, ScratchDirectory& directory,
+                   const size_t memory_budget);
+
+  /* Returns the number of states in this map. */
+  size_t size() const { return m_memory_states.size() + m_num_disk_states; };
+
+  /* Returns the number of states that have been written to disk. */
+  size_t numDiskStates() const { return m_num_disk_states; };
+
+  /* Returns the number of sorted runs on disk. */
+  size_t numRuns() const { return m_runs.size(); };
+
+  /**
+   * Returns whether the packed `state` is one of the states that are currently
+   * stored in memory. States on disk are not checked.
+   */
+  bool containsInMemory(const PackedWord* state) const {
+    return m_memory_states.findPacked(state).second;
+  };
+
+  /**
+   * Inserts the packed `state` with the given `parent`. The `state` must not
+   * be on disk. Does nothing if the `state` is already in memory.
+   */
+  void insert(const PackedWord* state, const PackedWord* parent);
+
+  /**
+   * Removes every record from `records` that begins with a packed state in
+   * this map, where each record has `record_words` words. The records must be
+   * sorted by their states with `sort_unique_records`.
+   */
+  void removeContained(std::vector<PackedWord>& records,
+                       const int record_words) const;
+
+  /**
+   * Writes the parent of the packed `state` into `parent`. Returns false if
+   * this map does not contain the `state`.
+   */
+  bool findParent(const PackedWord* state, PackedWord* parent) const;
+
+  /* Returns the number of bytes of memory that this map has allocated. */
+  size_t memoryUsage() const;
+
+  /* Returns the number of bytes that the runs of this map use on disk. */
+  size_t diskUsage() const;
+};
+
+}  // namespace search
+}  // namespace pushworld
+
+#endif /* SEARCH_EXTERNAL_STORAGE_H_ */
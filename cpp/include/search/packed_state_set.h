@@ -0,0 +1,193 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEARCH_PACKED_STATE_SET_H_
+#define SEARCH_PACKED_STATE_SET_H_
+
+#include <cstdint>
+#include <utility>  // pair
+#include <vector>
+
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace search {
+
+// A `PackedState` is stored as a fixed number of 64-bit words, which depends on
+// the puzzle. See `StatePacker`.
+using PackedWord = uint64_t;
+
+/**
+ * Converts `State` instances to and from a compact bit-packed encoding.
+ *
+ * Every position is encoded with just enough bits to store X and Y values in
+ * the intervals [0, width) and [0, height), and the positions of all objects
+ * are concatenated into an array of `numWords()` words. For example, a puzzle
+ * with 10 objects in a 20x20 grid requires 10 bits per position, so its states
+ * are packed into 2 words.
+ */
+class StatePacker {
+ private:
+  int m_num_objects;
+  int m_width;
+  int m_height;
+  int m_bits_y;
+  int m_bits_per_position;
+  int m_num_words;
+
+ public:
+  /**
+   * Constructs a packer for states of the given `puzzle`, using the bounds
+   * returned by `getWidth` and `getHeight`.
+   */
+  explicit StatePacker(const PushWorldPuzzle& puzzle);
+
+  /**
+   * Constructs a packer for states that contain `num_objects` positions, each
+   * satisfying `0 <= x < width` and `0 <= y < height`.
+   */
+  StatePacker(const int num_objects, const int width, const int height);
+
+  /* Returns the number of objects in every state. */
+  int numObjects() const { return m_num_objects; };
+
+  /* Returns the number of words in every packed state. */
+  int numWords() const { return m_num_words; };
+
+  /**
+   * Writes the packed encoding of the `state` into `numWords()` words starting
+   * at `packed`.
+   *
+   * Throws `std::domain_error` if any position is outside of the bounds
+   * provided to the constructor.
+   */
+  void pack(const State& state, PackedWord* packed) const;
+
+  /**
+   * Decodes the `numWords()` words starting at `packed` into the `state`,
+   * reusing its memory.
+   */
+  void unpack(const PackedWord* packed, State& state) const;
+
+  /**
+   * Returns a hash of the `numWords()` words starting at `packed`. All bits of
+   * the hash are well mixed, so any subset of bits can be used to partition
+   * states.
+   */
+  uint64_t hash(const PackedWord* packed) const;
+};
+
+/**
+ * A set of `State` instances that stores packed states inline in a flat array
+ * and finds them with an open-addressing hash table.
+ *
+ * States are never removed (other than by `clear`), so every state has a
+ * stable `Index` in the order in which states were inserted. The hash table
+ * only stores these indices, which requires 4 bytes per slot in addition to
+ * the packed states themselves.
+ */
+class PackedStateSet {
+ public:
+  using Index = uint32_t;
+
+ private:
+  StatePacker m_packer;
+
+  // `m_states[i * num_words ...]` contains the packed state with index `i`.
+  std::vector<PackedWord> m_states;
+  Index m_size;
+
+  // Each slot stores `index + 1` of a state, or 0 if the slot is empty. The
+  // number of slots is always a power of 2.
+  std::vector<Index> m_slots;
+  size_t m_slot_mask;
+
+  // Scratch memory to pack states in `insert` and `contains`.
+  mutable std::vector<PackedWord> m_buffer;
+
+  /**
+   * Returns the slot that contains the given packed state, or otherwise the
+   * empty slot where it should be inserted.
+   */
+  size_t findSlot(const PackedWord* packed) const;
+
+  /* Doubles the number of slots and reinserts all states. */
+  void grow();
+
+ public:
+  /* Constructs an empty set of states that are encoded by the `packer`. */
+  explicit PackedStateSet(const StatePacker& packer);
+
+  /* Returns the packer that encodes the states in this set. */
+  const StatePacker& getPacker() const { return m_packer; };
+
+  /* Returns the number of states in this set. */
+  size_t size() const { return m_size; };
+
+  /* Returns whether this set contains no states. */
+  bool empty() const { return m_size == 0; };
+
+  /* Removes all states. */
+  void clear();
+
+  /**
+   * Inserts the `state` into this set if it is not already present.
+   *
+   * Returns a pair of the index of the state and a bool that is true if the
+   * state was inserted or false if it was already present.
+   *
+   * Throws `std::domain_error` if the state is new and the set already
+   * contains the maximum number of states that an `Index` can identify.
+   */
+  std::pair<Index, bool> insert(const State& state);
+
+  /**
+   * Identical to `insert`, except that the state is provided in its packed
+   * encoding, which must have been produced by a packer that is equivalent to
+   * `getPacker()`.
+   */
+  std::pair<Index, bool> insertPacked(const PackedWord* packed);
+
+  /* Returns whether this set contains the `state`. */
+  bool contains(const State& state) const;
+
+  /**
+   * Returns a pair of the index of the given packed state and true if this set
+   * contains it, or otherwise a pair of an unspecified index and false. The
+   * state must have been packed as in `insertPacked`.
+   */
+  std::pair<Index, bool> findPacked(const PackedWord* packed) const;
+
+  /**
+   * Decodes the state with the given `index` into `state`, reusing its memory.
+   */
+  void getState(const Index index, State& state) const {
+    m_packer.unpack(getPackedState(index), state);
+  };
+
+  /* Returns a pointer to the packed state with the given `index`. */
+  const PackedWord* getPackedState(const Index index) const {
+    return m_states.data() + size_t(index) * m_packer.numWords();
+  };
+
+  /* Returns the number of bytes of memory that this set has allocated. */
+  size_t memoryUsage() const;
+};
+
+}  // namespace search
+}  // namespace pushworld
+
+#endif /* SEARCH_PACKED_STATE_SET_H_ */
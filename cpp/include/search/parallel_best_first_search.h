@@ -0,0 +1,578 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEARCH_PARALLEL_BEST_FIRST_SEARCH_H_
+#define SEARCH_PARALLEL_BEST_FIRST_SEARCH_H_
+
+#include <algorithm>  // reverse
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "heuristics/dead_end_detector.h"
+#include "heuristics/heuristic.h"
+#include "pushworld_puzzle.h"
+#include "search/packed_state_set.h"
+#include "search/priority_queue.h"
+#include "search/random_action_iterator.h"
+#include "search/search.h"
+#include "search/search_context.h"
+#include "search/search_statistics.h"
+#include "search/spsc_queue.h"
+
+namespace pushworld {
+namespace search {
+
+/* Constructs a new heuristic instance for each thread of a parallel search. */
+template <typename Cost>
+using HeuristicFactory =
+    std::function<std::unique_ptr<heuristic::Heuristic<Cost>>()>;
+
+/* Constructs a new frontier for each thread of a parallel search. */
+template <typename Cost>
+using FrontierFactory = std::function<std::unique_ptr<
+    priority_queue::PriorityQueue<PackedStateSet::Index, Cost>>()>;
+
+namespace detail {
+
+/**
+ * Implements `parallel_best_first_search`, which is a variant of Hash
+ * Distributed A* (HDA*) for greedy best-first search.
+ *
+ * Every state is owned by exactly one thread, which is determined by a hash of
+ * the packed state. Each thread has a separate shard of the visited states, a
+ * frontier, and a heuristic. When a thread expands a state, it sends each
+ * successor state to its owner in a message that contains the packed state, a
+ * reference to its parent state, and a bitmask of the objects that moved.
+ * Messages are batched and sent through a lock-free queue for each pair of
+ * threads. Owners discard duplicate states and evaluate the heuristic of new
+ * states, so the heuristic is never evaluated on duplicates.
+ */
+template <typename Cost>
+class ParallelBestFirstSearch {
+ private:
+  // Identifies a visited state by `(shard << 32) | index`.
+  using StateRef = uint64_t;
+  static constexpr StateRef NO_STATE = UINT64_MAX;
+
+  // The number of messages in a full batch.
+  static constexpr size_t BATCH_SIZE = 64;
+
+  // The number of batches that can be in transit between each pair of threads.
+  static constexpr size_t QUEUE_CAPACITY = 64;
+
+  // Partial batches are sent after this many expansions so that idle threads
+  // do not wait for a batch to fill up.
+  static constexpr int FLUSH_INTERVAL = 32;
+
+  using Batch = std::vector<PackedWord>;
+
+  struct Shard {
+    PackedStateSet visited;
+
+    // `parents[i]` refers to the parent of the visited state with index `i`.
+    std::vector<StateRef> parents;
+
+    std::unique_ptr<priority_queue::PriorityQueue<PackedStateSet::Index, Cost>>
+        frontier;
+    std::unique_ptr<heuristic::Heuristic<Cost>> heuristic;
+
+    // `outgoing[i]` contains the batch of messages to send to shard `i`.
+    std::vector<Batch> outgoing;
+
+    // `incoming[i]` receives batches of messages from shard `i`.
+    std::vector<std::unique_ptr<SpscQueue<Batch>>> incoming;
+
+    // Scratch memory of the owner thread.
+    RelativeState relative_state;
+
+    // Counters of this shard's work, which are summed after the search.
+    SearchStatistics statistics;
+
+    // The memory that the owner thread measured at its last check of the
+    // search context, which the other threads read to sum the usage of all
+    // shards.
+    std::atomic<size_t> memory_usage{0};
+
+    explicit Shard(const StatePacker& packer) : visited(packer){};
+  };
+
+  const PushWorldPuzzle& m_puzzle;
+  const SearchContext& m_context;
+  const heuristic::DeadEndDetector* const m_dead_ends;
+  const bool m_canonicalize_objects;
+  const StatePacker m_packer;
+  const int m_num_threads;
+  const int m_num_objects;
+
+  // The number of words in a message, which contains a parent reference, a
+  // packed state, and a bitmask of moved objects.
+  const int m_mask_words;
+  const int m_message_words;
+
+  std::vector<std::unique_ptr<Shard>> m_shards;
+
+  // The number of threads that are actively searching plus the number of
+  // batches that have been sent but not yet processed. The search is exhausted
+  // when this reaches zero, since idle threads only become active by receiving
+  // a batch.
+  std::atomic<int64_t> m_work;
+
+  // The first visited state that satisfies the goal.
+  std::atomic<StateRef> m_goal;
+
+  // The status of the search if no goal is found, which is `NO_SOLUTION`
+  // unless a thread reached a limit of the context.
+  std::atomic<SearchStatus> m_status;
+
+  // Set when any thread must stop, either because the goal was found, because
+  // a limit of the context was reached, or because a thread failed with an
+  // exception.
+  std::atomic<bool> m_stop;
+  std::exception_ptr m_exception;
+  std::atomic<bool> m_has_exception;
+
+  /* Returns the shard that owns the given packed state. */
+  int owner(const PackedWord* packed) const {
+    // The low bits of the hash select slots within a shard's visited set, so
+    // use the high bits to decorrelate shards from slots.
+    return (m_packer.hash(packed) >> 32) % m_num_threads;
+  };
+
+  /* Processes a message that was sent to the shard with the given `id`. */
+  void receive(const int id, const PackedWord* message) {
+    Shard& shard = *m_shards[id];
+    const PackedWord* packed = message + 1;
+    const auto inserted = shard.visited.insertPacked(packed);
+    if (!inserted.second) {
+      shard.statistics.duplicates++;
+      return;  // Ignore previously visited states.
+    }
+    shard.parents.push_back(message[0]);
+
+    auto& relative_state = shard.relative_state;
+    m_packer.unpack(packed, relative_state.state);
+
+    if (m_puzzle.satisfiesGoal(relative_state.state)) {
+      StateRef expected = NO_STATE;
+      m_goal.compare_exchange_strong(expected,
+                                     (StateRef(id) << 32) | inserted.first);
+      m_stop = true;
+      return;
+    }
+
+    const PackedWord* mask = packed + m_packer.numWords();
+    relative_state.moved_object_indices.clear();
+    for (int i = 0; i < m_num_objects; i++) {
+      if ((mask[i / 64] >> (i % 64)) & 1) {
+        relative_state.moved_object_indices.push_back(i);
+      }
+    }
+
+    shard.frontier->push(
+        inserted.first,
+        shard.heuristic->estimate_cost_to_goal(relative_state));
+    shard.statistics.evaluations++;
+    shard.statistics.max_frontier_size = std::max(
+        shard.statistics.max_frontier_size, shard.frontier->size());
+  };
+
+  /**
+   * Returns the memory that shard `id` stores, which sums its visited states,
+   * parent references, the indices in its frontier, its outgoing batches, and
+   * the memory usage of its heuristic.
+   */
+  size_t shard_memory_usage(const int id) const {
+    const Shard& shard = *m_shards[id];
+    size_t bytes = shard.visited.memoryUsage() +
+                   shard.parents.capacity() * sizeof(StateRef) +
+                   shard.frontier->size() * sizeof(PackedStateSet::Index) +
+                   shard.heuristic->memory_usage();
+    for (const auto& batch : shard.outgoing) {
+      bytes += batch.capacity() * sizeof(PackedWord);
+    }
+    return bytes;
+  };
+
+  /**
+   * Checks the limits of the context on behalf of shard `id`, given the memory
+   * usage of all shards at their last check. Returns true and stops all
+   * threads if a limit has been reached.
+   */
+  bool reached_limit(const int id) {
+    m_shards[id]->memory_usage = shard_memory_usage(id);
+    size_t memory_usage = 0;
+    for (const auto& shard : m_shards) {
+      memory_usage += shard->memory_usage;
+    }
+
+    const auto limit = m_context.check(memory_usage);
+    if (limit == std::nullopt) {
+      return false;
+    }
+    SearchStatus expected = SearchStatus::NO_SOLUTION;
+    m_status.compare_exchange_strong(expected, *limit);
+    m_stop = true;
+    return true;
+  };
+
+  /**
+   * Sends the outgoing batch from shard `id` to shard `dest`. Returns false if
+   * the queue to `dest` is full, in which case the batch is retained.
+   */
+  bool flush(const int id, const int dest) {
+    Batch& batch = m_shards[id]->outgoing[dest];
+    if (batch.empty()) {
+      return true;
+    }
+
+    // Count the batch before it becomes visible to the receiver.
+    m_work++;
+    if (!m_shards[dest]->incoming[id]->try_push(batch)) {
+      m_work--;
+      return false;
+    }
+    batch = Batch();
+    batch.reserve(BATCH_SIZE * m_message_words);
+    return true;
+  };
+
+  /* Runs the search loop of the thread that owns shard `id`. */
+  void run_worker(const int id) {
+    Shard& shard = *m_shards[id];
+    RandomActionIterator action_iterator;
+    TransitionScratch scratch;
+    State parent_state;
+    RelativeState next;
+    Batch batch;
+    std::vector<PackedWord> message(m_message_words);
+
+    // Every thread begins in the active state, which is counted in `m_work`.
+    bool active = true;
+    int num_expansions = 0;
+
+    // As in `best_first_search`, the context is checked before the first
+    // expansion and then once every `checkInterval()` expansions.
+    const size_t check_interval = m_context.checkInterval();
+    size_t expansions_until_check = 0;
+
+    while (!m_stop) {
+      // Process all incoming messages.
+      for (int src = 0; src < m_num_threads; src++) {
+        if (src == id) continue;
+        while (shard.incoming[src]->try_pop(batch)) {
+          if (!active) {
+            m_work++;
+            active = true;
+          }
+          for (size_t i = 0; i < batch.size(); i += m_message_words) {
+            receive(id, batch.data() + i);
+          }
+          // The batch is no longer in transit.
+          m_work--;
+        }
+      }
+
+      if (!shard.frontier->empty()) {
+        if (expansions_until_check-- == 0) {
+          expansions_until_check = check_interval - 1;
+          if (reached_limit(id)) {
+            break;
+          }
+        }
+
+        const auto index = shard.frontier->top();
+        shard.frontier->pop();
+        shard.visited.getState(index, parent_state);
+        message[0] = (StateRef(id) << 32) | index;
+        shard.statistics.expansions++;
+
+        for (const auto action : action_iterator.next()) {
+          if (!m_puzzle.getNextState(parent_state, action, next, scratch)) {
+            continue;
+          }
+          if (m_canonicalize_objects && m_puzzle.canonicalize(next.state)) {
+            set_moved_object_indices(parent_state, next);
+          }
+          shard.statistics.generations++;
+
+          // Dead ends are discarded before they are sent to their owner.
+          if (m_dead_ends != nullptr && m_dead_ends->isDeadEnd(next)) {
+            shard.statistics.dead_ends++;
+            continue;
+          }
+
+          PackedWord* packed = message.data() + 1;
+          m_packer.pack(next.state, packed);
+          PackedWord* mask = packed + m_packer.numWords();
+          std::fill(mask, mask + m_mask_words, 0);
+          for (const int i : next.moved_object_indices) {
+            mask[i / 64] |= PackedWord(1) << (i % 64);
+          }
+
+          const int dest = owner(packed);
+          if (dest == id) {
+            receive(id, message.data());
+          } else {
+            auto& outgoing = shard.outgoing[dest];
+            outgoing.insert(outgoing.end(), message.begin(), message.end());
+            if (outgoing.size() >= BATCH_SIZE * m_message_words) {
+              flush(id, dest);
+            }
+          }
+        }
+
+        if (++num_expansions % FLUSH_INTERVAL == 0) {
+          for (int dest = 0; dest < m_num_threads; dest++) {
+            flush(id, dest);
+          }
+        }
+        continue;
+      }
+
+      // The frontier is empty, so send all remaining messages before idling.
+      bool flushed = true;
+      for (int dest = 0; dest < m_num_threads; dest++) {
+        flushed = flush(id, dest) && flushed;
+      }
+
+      if (flushed && active) {
+        active = false;
+        m_work--;
+      }
+      if (!active && m_work == 0) {
+        break;  // No thread has any remaining work.
+      }
+      std::this_thread::yield();
+    }
+  };
+
+ public:
+  ParallelBestFirstSearch(const PushWorldPuzzle& puzzle,
+                          const HeuristicFactory<Cost>& make_heuristic,
+                          const FrontierFactory<Cost>& make_frontier,
+                          const int num_threads, const SearchContext& context,
+                          const heuristic::DeadEndDetector* dead_ends,
+                          const bool canonicalize_objects)
+      : m_puzzle(puzzle),
+        m_context(context),
+        m_dead_ends(dead_ends),
+        m_canonicalize_objects(canonicalize_objects),
+        m_packer(puzzle),
+        m_num_threads(num_threads),
+        m_num_objects(puzzle.getInitialState().size()),
+        m_mask_words((m_num_objects + 63) / 64),
+        m_message_words(1 + m_packer.numWords() + m_mask_words),
+        m_work(num_threads),
+        m_goal(NO_STATE),
+        m_status(SearchStatus::NO_SOLUTION),
+        m_stop(false),
+        m_has_exception(false) {
+    for (int i = 0; i < num_threads; i++) {
+      auto shard = std::make_unique<Shard>(m_packer);
+      shard->frontier = make_frontier();
+      shard->heuristic = make_heuristic();
+      shard->heuristic->set_search_context(&context);
+      shard->outgoing.resize(num_threads);
+      for (int j = 0; j < num_threads; j++) {
+        shard->incoming.push_back(
+            std::make_unique<SpscQueue<Batch>>(QUEUE_CAPACITY));
+      }
+      m_shards.push_back(std::move(shard));
+    }
+  };
+
+  /**
+   * Runs the search from the `initial_state`, which may be canonicalized. See
+   * `parallel_best_first_search`. If `statistics` is not null, the counters of
+   * all threads are summed into it, including the peak frontier sizes.
+   */
+  SearchResult run(const State& initial_state, SearchStatistics* statistics) {
+    // Send the initial state to its owner, with all objects marked as moved.
+    std::vector<PackedWord> message(m_message_words, ~PackedWord(0));
+    message[0] = NO_STATE;
+    m_packer.pack(initial_state, message.data() + 1);
+    receive(owner(message.data() + 1), message.data());
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < m_num_threads; i++) {
+      threads.emplace_back([this, i]() {
+        try {
+          run_worker(i);
+        } catch (...) {
+          if (!m_has_exception.exchange(true)) {
+            m_exception = std::current_exception();
+          }
+          m_stop = true;
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    for (const auto& shard : m_shards) {
+      shard->heuristic->set_search_context(nullptr);
+    }
+    if (m_has_exception) {
+      std::rethrow_exception(m_exception);
+    }
+
+    if (statistics != nullptr) {
+      for (const auto& shard : m_shards) {
+        statistics->expansions += shard->statistics.expansions;
+        statistics->generations += shard->statistics.generations;
+        statistics->duplicates += shard->statistics.duplicates;
+        statistics->evaluations += shard->statistics.evaluations;
+        statistics->dead_ends += shard->statistics.dead_ends;
+        // The threads reach their peaks at different times, so this sum is
+        // an upper bound of the peak size of all frontiers together.
+        statistics->max_frontier_size += shard->statistics.max_frontier_size;
+        shard->heuristic->add_counters(statistics->heuristic_counters);
+      }
+    }
+
+    StateRef ref = m_goal;
+    if (ref == NO_STATE) {
+      if (m_status != SearchStatus::NO_SOLUTION) {
+        return SearchResult{m_status};
+      }
+      // The heuristics may have returned early once the search had to stop,
+      // so the search space is only known to be exhausted if no limit was
+      // reached.
+      const auto limit = m_context.check(0);
+      return SearchResult{limit.value_or(SearchStatus::NO_SOLUTION)};
+    }
+
+    // Follow parent references across shards back to the initial state.
+    std::vector<State> path;
+    while (ref != NO_STATE) {
+      const Shard& shard = *m_shards[ref >> 32];
+      const auto index = PackedStateSet::Index(ref & UINT32_MAX);
+      path.emplace_back();
+      shard.visited.getState(index, path.back());
+      ref = shard.parents[index];
+    }
+    std::reverse(path.begin(), path.end());
+
+    return SearchResult{SearchStatus::SOLVED, planFromStates(m_puzzle, path)};
+  };
+};
+
+}  // namespace detail
+
+/**
+ * A multi-threaded variant of `best_first_search`, which partitions states
+ * across `num_threads` threads by their hash. Each thread constructs its own
+ * heuristic and frontier with the given factories, and each thread expands the
+ * states in its frontier in order of minimum estimated cost.
+ *
+ * States are expanded in a globally approximate order of minimum cost, and the
+ * order depends on the timing of threads, so the returned plan can differ
+ * between runs. Any state-dependent heuristic (e.g. the novelty heuristic)
+ * only observes states that are owned by its thread.
+ *
+ * Every thread checks the limits of the `context` before its first expansion
+ * and then once every `context.checkInterval()` expansions, as in
+ * `best_first_search`. The memory usage that is compared to the budget of the
+ * `context` sums the visited states, parent references, frontiers, message
+ * batches, and heuristics of all threads, where each thread contributes its
+ * usage at its last check. When any thread reaches a limit, all threads stop
+ * and the search returns the status of the limit without a plan. Each
+ * heuristic is given the `context` for the duration of the search.
+ *
+ * If `statistics` is not null, it is reset and then filled in with the summed
+ * counters of all threads. `max_frontier_size` is the sum of the peak frontier
+ * size of each thread, which is at least the peak total size of the frontiers.
+ * Time is only measured for the whole search.
+ *
+ * If `dead_ends` is not null, every thread discards the successor states that
+ * it detects as dead ends, as in `best_first_search`. It is shared by all
+ * threads.
+ *
+ * If `canonicalize_objects` is true, states are stored and evaluated in their
+ * canonical form, as in `best_first_search`.
+ *
+ * Throws `std::invalid_argument` if `num_threads` is not positive.
+ */
+template <typename Cost>
+SearchResult parallel_best_first_search(
+    const PushWorldPuzzle& puzzle, const HeuristicFactory<Cost>& make_heuristic,
+    const FrontierFactory<Cost>& make_frontier, const int num_threads,
+    const SearchContext& context, SearchStatistics* statistics = nullptr,
+    const heuristic::DeadEndDetector* dead_ends = nullptr,
+    const bool canonicalize_objects = false) {
+  if (num_threads < 1) {
+    throw std::invalid_argument("The number of threads must be positive.");
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  if (statistics != nullptr) {
+    *statistics = SearchStatistics();
+  }
+
+  State initial_state = puzzle.getInitialState();
+  if (canonicalize_objects) {
+    puzzle.canonicalize(initial_state);
+  }
+
+  SearchResult result{SearchStatus::NO_SOLUTION};
+  if (puzzle.satisfiesGoal(initial_state)) {
+    // The plan to reach the goal has no actions.
+    result = SearchResult{SearchStatus::SOLVED, Plan()};
+  } else if (dead_ends == nullptr || !dead_ends->isDeadEnd(initial_state)) {
+    result = detail::ParallelBestFirstSearch<Cost>(
+                 puzzle, make_heuristic, make_frontier, num_threads, context,
+                 dead_ends, canonicalize_objects)
+                 .run(initial_state, statistics);
+  }
+
+  if (statistics != nullptr) {
+    statistics->total_seconds =
+        seconds_between(start, std::chrono::steady_clock::now());
+  }
+  return result;
+}
+
+/**
+ * Identical to `parallel_best_first_search` above, but without limits on time
+ * or memory, so the search only ends when it finds a plan or exhausts the
+ * search space. Returns `std::nullopt` if no solution exists.
+ */
+template <typename Cost>
+std::optional<Plan> parallel_best_first_search(
+    const PushWorldPuzzle& puzzle, const HeuristicFactory<Cost>& make_heuristic,
+    const FrontierFactory<Cost>& make_frontier, const int num_threads,
+    SearchStatistics* statistics = nullptr,
+    const heuristic::DeadEndDetector* dead_ends = nullptr) {
+  const SearchContext unlimited;
+  return parallel_best_first_search<Cost>(puzzle, make_heuristic,
+                                          make_frontier, num_threads,
+                                          unlimited, statistics, dead_ends)
+      .plan;
+}
+
+}  // namespace search
+}  // namespace pushworld
+
+#endif /* SEARCH_PARALLEL_BEST_FIRST_SEARCH_H_ */
@@ -17,10 +17,17 @@
 #ifndef SEARCH_PRIORITY_QUEUE_H_
 #define SEARCH_PRIORITY_QUEUE_H_
 
+#include <algorithm>  // std::max, std::move
 #include <boost/heap/fibonacci_heap.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <stack>
+#include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>  // std::pair, std::make_pair
+#include <vector>
 
 namespace priority_queue {
 
@@ -109,6 +116,132 @@ struct ComparePriority {
 
 }  // namespace
 
+// Implementation details of `IntegerBucketPriorityQueue`, which are not in the
+// anonymous namespace because its members use them.
+namespace detail {
+
+/**
+ * Returns the priority that is stored in the overflow bucket of an
+ * `IntegerBucketPriorityQueue`, which is infinity if the `Priority` type
+ * supports it.
+ */
+template <typename Priority>
+constexpr Priority overflow_priority() {
+  return std::numeric_limits<Priority>::has_infinity
+             ? std::numeric_limits<Priority>::infinity()
+             : std::numeric_limits<Priority>::max();
+}
+
+/**
+ * An array of buckets that are indexed by integer priorities, which is shared
+ * by all `IntegerBucketPriorityQueue` classes. Every `Bucket` type must provide
+ * `empty` and `clear` methods.
+ *
+ * Buckets are stored contiguously from the minimum to the maximum priority
+ * that has been pushed since construction, so memory usage is linear in the
+ * range of priorities rather than in the number of elements. The overflow
+ * priority is stored in a separate bucket.
+ */
+template <typename Bucket, typename Priority>
+class IntegerBucketArray {
+ private:
+  // The minimum number of buckets to add when the range of priorities grows
+  // below the first bucket.
+  static constexpr size_t MIN_GROWTH = 16;
+
+  // `m_buckets[i]` contains elements with priority `m_offset + i`.
+  std::vector<Bucket> m_buckets;
+  int64_t m_offset;
+
+  Bucket m_overflow;
+
+  // No bucket below this index contains elements. If this index is equal to
+  // the number of buckets, only the overflow bucket may contain elements.
+  size_t m_min;
+
+  /* Adds buckets so that the first bucket has a priority of at most `value`. */
+  void grow_below(const int64_t value) {
+    const size_t growth = std::max<size_t>(
+        m_offset - value, std::max(m_buckets.size(), MIN_GROWTH));
+    std::vector<Bucket> buckets(growth + m_buckets.size());
+    std::move(m_buckets.begin(), m_buckets.end(), buckets.begin() + growth);
+    m_buckets.swap(buckets);
+    m_offset -= growth;
+    m_min += growth;
+  };
+
+ public:
+  IntegerBucketArray() : m_offset(0), m_min(0){};
+
+  /* Removes all elements from all buckets, but retains allocated buckets. */
+  void clear() {
+    for (auto& bucket : m_buckets) {
+      bucket.clear();
+    }
+    m_overflow.clear();
+    m_min = m_buckets.size();
+  };
+
+  /**
+   * Returns the bucket for the `priority`, allocating it if necessary.
+   *
+   * Throws `std::invalid_argument` if the `priority` is not an integer or the
+   * overflow priority.
+   */
+  Bucket& get(const Priority& priority) {
+    if (priority >= overflow_priority<Priority>()) {
+      return m_overflow;
+    }
+
+    if constexpr (std::is_floating_point<Priority>::value) {
+      // This also rejects NaN and negative infinity.
+      if (!(std::floor(priority) == priority) || std::isinf(priority)) {
+        throw std::invalid_argument(
+            "IntegerBucketPriorityQueue priorities must be integers or "
+            "infinity.");
+      }
+    }
+
+    const int64_t value = static_cast<int64_t>(priority);
+
+    if (m_buckets.empty()) {
+      m_offset = value;
+      m_min = 0;
+    } else if (value < m_offset) {
+      grow_below(value);
+    }
+
+    const size_t index = value - m_offset;
+    if (index >= m_buckets.size()) {
+      m_buckets.resize(index + 1);
+    }
+    if (index < m_min) {
+      m_min = index;
+    }
+    return m_buckets[index];
+  };
+
+  /**
+   * Returns the non-empty bucket with the minimum priority. If all buckets
+   * are empty, returns the overflow bucket.
+   */
+  Bucket& min_bucket() {
+    while (m_min < m_buckets.size() && m_buckets[m_min].empty()) {
+      m_min++;
+    }
+    return m_min < m_buckets.size() ? m_buckets[m_min] : m_overflow;
+  };
+
+  /* Returns the priority of the `min_bucket`. */
+  Priority min_priority() {
+    min_bucket();
+    return m_min < m_buckets.size() ? Priority(m_offset + int64_t(m_min))
+                                    : overflow_priority<Priority>();
+  };
+};
+
+}  // namespace detail
+
 /**
  * A priority queue that uses a Fibonacci heap so that `push` and `top` have
  * O(1) complexity and `pop` has O(log N) complexity for N elements in the
@@ -221,6 +354,131 @@ class BucketPriorityQueue : public PriorityQueue<Element, Priority> {
   };
 };
 
+/**
+ * A priority queue for integer priorities that stores elements in an array of
+ * buckets indexed by priority, so that `push`, `top`, and `pop` have O(1)
+ * complexity when the range of priorities in the queue is small. This suits
+ * heuristics with small integer costs, such as the RGD heuristic.
+ *
+ * Elements with equal priorities are returned in last-in-first-out order.
+ *
+ * Priorities may be negative. Every priority must be an integer, except for
+ * infinity (or the maximum value of an integral `Priority` type), which is
+ * stored in a separate overflow bucket. Memory usage is linear in the range
+ * of finite priorities that have been pushed into the queue.
+ *
+ * The specialization for `std::pair<Primary, Secondary>` priorities compares
+ * priorities lexicographically, where both components have the requirements
+ * above.
+ */
+template <typename Element, typename Priority>
+class IntegerBucketPriorityQueue : public PriorityQueue<Element, Priority> {
+ private:
+  detail::IntegerBucketArray<std::vector<Element>, Priority> m_buckets;
+  size_t m_num_elements;
+
+ public:
+  /*
+   * Template classes cannot be compiled into libraries without knowing the
+   * template types, so to avoid restricting supported template types, all
+   * methods in this class are defined in this header file.
+   */
+
+  IntegerBucketPriorityQueue() : m_num_elements(0){};
+
+  size_t size() const override { return m_num_elements; };
+
+  bool empty() const override { return m_num_elements == 0; };
+
+  void clear() override {
+    m_buckets.clear();
+    m_num_elements = 0;
+  };
+
+  void push(const Element& element, const Priority& priority) override {
+    m_buckets.get(priority).push_back(element);
+    m_num_elements++;
+  };
+
+  Element top() override {
+    if (m_num_elements == 0) {
+      throw std::out_of_range("The priority queue is empty.");
+    }
+    return m_buckets.min_bucket().back();
+  };
+
+  Priority min_priority() override {
+    if (m_num_elements == 0) {
+      throw std::out_of_range("The priority queue is empty.");
+    }
+    return m_buckets.min_priority();
+  };
+
+  void pop() override {
+    if (m_num_elements == 0) {
+      throw std::out_of_range("The priority queue is empty.");
+    }
+    m_buckets.min_bucket().pop_back();
+    m_num_elements--;
+  };
+};
+
+/**
+ * An `IntegerBucketPriorityQueue` with lexicographic priorities, which are
+ * ordered first by the `Primary` priority and then by the `Secondary`
+ * priority. Each primary bucket contains a queue of secondary buckets.
+ */
+template <typename Element, typename Primary, typename Secondary>
+class IntegerBucketPriorityQueue<Element, std::pair<Primary, Secondary>>
+    : public PriorityQueue<Element, std::pair<Primary, Secondary>> {
+ private:
+  detail::IntegerBucketArray<IntegerBucketPriorityQueue<Element, Secondary>,
+                             Primary>
+      m_buckets;
+  size_t m_num_elements;
+
+ public:
+  IntegerBucketPriorityQueue() : m_num_elements(0){};
+
+  size_t size() const override { return m_num_elements; };
+
+  bool empty() const override { return m_num_elements == 0; };
+
+  void clear() override {
+    m_buckets.clear();
+    m_num_elements = 0;
+  };
+
+  void push(const Element& element,
+            const std::pair<Primary, Secondary>& priority) override {
+    m_buckets.get(priority.first).push(element, priority.second);
+    m_num_elements++;
+  };
+
+  Element top() override {
+    if (m_num_elements == 0) {
+      throw std::out_of_range("The priority queue is empty.");
+    }
+    return m_buckets.min_bucket().top();
+  };
+
+  std::pair<Primary, Secondary> min_priority() override {
+    if (m_num_elements == 0) {
+      throw std::out_of_range("The priority queue is empty.");
+    }
+    const Primary primary = m_buckets.min_priority();
+    return std::make_pair(primary, m_buckets.min_bucket().min_priority());
+  };
+
+  void pop() override {
+    if (m_num_elements == 0) {
+      throw std::out_of_range("The priority queue is empty.");
+    }
+    m_buckets.min_bucket().pop();
+    m_num_elements--;
+  };
+};
+
 }  // namespace priority_queue
 
 #endif /* SEARCH_PRIORITY_QUEUE_H_ */
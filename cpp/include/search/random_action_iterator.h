@@ -43,13 +43,22 @@ class RandomActionIterator {
   std::vector<std::vector<pushworld::Action>>::iterator m_next_action_group;
 
  public:
+  static const int DEFAULT_NUM_ACTION_GROUPS = 1000;
+
+  // The default seed of the random shuffles.
+  static const unsigned int DEFAULT_SEED = 42;
+
   /**
    * For computational efficiency, a finite number of groups of all `PushWorld`
    * actions are constructed when this iterator is initialized, and the `next`
    * method loops through each of the groups without repeatedly performing
    * random shuffles after initialization.
+   *
+   * Iterators with the same `seed` produce the same sequence of groups.
    */
-  RandomActionIterator(const int num_action_groups = 1000);
+  RandomActionIterator(
+      const int num_action_groups = DEFAULT_NUM_ACTION_GROUPS,
+      const unsigned int seed = DEFAULT_SEED);
 
   /* Returns a vector that contains all `PushWorld` actions in a random order.
    */
@@ -17,39 +17,171 @@
 #ifndef SEARCH_SEARCH_H_
 #define SEARCH_SEARCH_H_
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "pushworld_puzzle.h"
+#include "search/packed_state_set.h"
 
 namespace pushworld {
 namespace search {
 
+// The action of a node that does not store the action that generated it, such
+// as a root node.
+static const Action NO_ACTION = -1;
+
 /**
  * Stores a node in a search tree in which each node corresponds to a puzzle
  * state. Also stores a reference to the parent node that resulted in this
- * node's state.
- *
- * Note: To conserve memory, the action that transitions the `parent->state` to
- * this node's `state` is not stored here.
+ * node's state, and optionally the action that transitions the
+ * `parent->state` to this node's `state`.
  */
 struct SearchNode {
   // If this is a root node, the parent is `nullptr`.
   const std::shared_ptr<SearchNode> parent;
   const State state;
 
+  // If `NO_ACTION`, `backtrackPlan` reconstructs the action from the states.
+  const Action action;
+
   // This constructor is required to support `make_shared<SearchNode>(parent,
-  // state)`.
-  SearchNode(const std::shared_ptr<SearchNode>& parent_, const State& state_)
-      : parent(parent_), state(state_){};
+  // state, action)`.
+  SearchNode(const std::shared_ptr<SearchNode>& parent_, const State& state_,
+             const Action action_ = NO_ACTION)
+      : parent(parent_), state(state_), action(action_){};
 };
 
 /**
  * Returns the sequence of actions (i.e. the `Plan`) that advances the puzzle
- * state from from the root ancestor of the `end_node` to the `end_node`.
+ * state from the root ancestor of the `end_node` to the `end_node`.
+ * Actions that are not stored in the nodes are reconstructed by finding the
+ * action that transitions each parent's state to its child's state.
  */
 Plan backtrackPlan(const PushWorldPuzzle& puzzle,
                    const std::shared_ptr<SearchNode>& end_node);
 
+// Identifies a node in a `SearchNodeStore`.
+using NodeId = uint32_t;
+
+// The parent ID of root nodes.
+static const NodeId NO_PARENT = UINT32_MAX;
+
+/**
+ * A compact alternative to `SearchNode` that is stored in a `SearchNodeStore`.
+ * Instead of storing a copy of its state, the node stores the index of its
+ * state in a `PackedStateSet`.
+ */
+struct CompactSearchNode {
+  // If this is a root node, the parent is `NO_PARENT`.
+  NodeId parent;
+  PackedStateSet::Index state_index;
+};
+
+/**
+ * An append-only arena of `CompactSearchNode` instances, which are identified
+ * by their `NodeId` in the order in which they were added.
+ *
+ * Nodes are allocated in fixed-size chunks, so adding a node never copies
+ * existing nodes, and memory usage grows linearly with the number of nodes.
+ *
+ * Each node can also store the action that generated it from its parent,
+ * which `backtrackPlan` uses instead of reconstructing the action. Actions are
+ * stored in four bits per node beside the chunks of nodes, because both fields
+ * of a `CompactSearchNode` need all of their 32 bits.
+ */
+class SearchNodeStore {
+ private:
+  static const int CHUNK_BITS = 16;
+  static const NodeId CHUNK_SIZE = NodeId(1) << CHUNK_BITS;
+
+  std::vector<std::unique_ptr<CompactSearchNode[]>> m_chunks;
+
+  // Each byte stores the actions of two consecutive nodes, plus one so that
+  // the zero-initialized bits are `NO_ACTION`.
+  std::vector<std::unique_ptr<uint8_t[]>> m_action_chunks;
+  NodeId m_size;
+
+ public:
+  SearchNodeStore() : m_size(0){};
+
+  /* Returns the number of nodes in this store. */
+  size_t size() const { return m_size; };
+
+  /* Removes all nodes. */
+  void clear() {
+    m_chunks.clear();
+    m_action_chunks.clear();
+    m_size = 0;
+  };
+
+  /**
+   * Adds a node with the given `parent` and `state_index`, and returns its ID.
+   * The `action` transitions the state of the `parent` to the state of the
+   * node, or is `NO_ACTION` if it is unknown.
+   */
+  NodeId add(const NodeId parent, const PackedStateSet::Index state_index,
+             const Action action = NO_ACTION) {
+    const NodeId offset = m_size & (CHUNK_SIZE - 1);
+    if (offset == 0) {
+      m_chunks.emplace_back(new CompactSearchNode[CHUNK_SIZE]);
+      m_action_chunks.emplace_back(new uint8_t[CHUNK_SIZE / 2]());
+    }
+    m_chunks.back()[offset] = {parent, state_index};
+    m_action_chunks.back()[offset / 2] |= uint8_t(action + 1)
+                                          << (offset % 2 * 4);
+    return m_size++;
+  };
+
+  /* Returns the node with the given ID. */
+  const CompactSearchNode& operator[](const NodeId id) const {
+    return m_chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+  };
+
+  /**
+   * Returns the action that generated the node with the given ID, or
+   * `NO_ACTION` if it was not stored.
+   */
+  Action getAction(const NodeId id) const {
+    const NodeId offset = id & (CHUNK_SIZE - 1);
+    const uint8_t bits = m_action_chunks[id >> CHUNK_BITS][offset / 2];
+    return Action((bits >> (offset % 2 * 4)) & 0xF) - 1;
+  };
+
+  /* Returns the number of bytes of memory that this store has allocated. */
+  size_t memoryUsage() const {
+    return m_chunks.size() *
+           (CHUNK_SIZE * sizeof(CompactSearchNode) + CHUNK_SIZE / 2);
+  };
+};
+
+/**
+ * Returns the sequence of actions (i.e. the `Plan`) that advances the puzzle
+ * state from the root ancestor of the `end_node` to the `end_node`, where all
+ * nodes are stored in `nodes` and their states are stored in `states`. As
+ * above, only the actions that are not stored in `nodes` are reconstructed.
+ */
+Plan backtrackPlan(const PushWorldPuzzle& puzzle, const PackedStateSet& states,
+                   const SearchNodeStore& nodes, const NodeId end_node);
+
+/**
+ * Sets `next.moved_object_indices` to the indices of all objects whose
+ * positions in `next.state` differ from their positions in the
+ * `parent_state`, in increasing order.
+ */
+void set_moved_object_indices(const State& parent_state, RelativeState& next);
+
+/**
+ * Returns the sequence of actions (i.e. the `Plan`) that advances the puzzle
+ * through each consecutive pair of states in the `path`, which begins at the
+ * first state.
+ *
+ * Throws `std::invalid_argument` if no action transitions between a pair of
+ * consecutive states.
+ */
+Plan planFromStates(const PushWorldPuzzle& puzzle,
+                    const std::vector<State>& path);
+
 }  // namespace search
 }  // namespace pushworld
 
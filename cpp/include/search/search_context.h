@@ -0,0 +1,169 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SEARCH_SEARCH_CONTEXT_H_
+#define SEARCH_SEARCH_CONTEXT_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <string>
+
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace search {
+
+/* The outcome of a search that is given a `SearchContext`. */
+enum class SearchStatus {
+  // A plan was found.
+  SOLVED,
+
+  // The search space was exhausted, so no plan exists.
+  NO_SOLUTION,
+
+  // The deadline of the context passed before a plan was found.
+  TIME_LIMIT,
+
+  // The search used more memory than the budget of the context.
+  MEMORY_LIMIT,
+
+  // `SearchContext::cancel` was called before a plan was found.
+  CANCELLED,
+};
+
+/* Returns the name of the `status`, e.g. "TIME_LIMIT". */
+std::string to_string(const SearchStatus status);
+
+/* The plan of a search, along with why the search stopped. */
+struct SearchResult {
+  SearchStatus status;
+
+  // Only contains a value if the `status` is `SOLVED`.
+  std::optional<Plan> plan;
+};
+
+/**
+ * Limits that a search checks cooperatively while it runs: a deadline, a
+ * budget of bytes for the states and nodes that the search stores, and a flag
+ * that any thread can set to cancel the search. All limits are disabled by
+ * default.
+ *
+ * Since reading the clock and summing memory usage is not free, searches only
+ * check the limits once every `checkInterval()` expansions, so a search can
+ * overshoot a limit by that many expansions.
+ */
+class SearchContext {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t DEFAULT_CHECK_INTERVAL = 256;
+
+  SearchContext() = default;
+
+  /**
+   * Constructs a context with the same limits as the `parent`, which is also
+   * cancelled when the `parent` is cancelled, but which can be cancelled on
+   * its own. The `parent` must outlive this context. E.g. each of several
+   * concurrent searches can have a child of the caller's context, so that the
+   * first search to finish can cancel the others.
+   */
+  explicit SearchContext(const SearchContext* parent)
+      : m_parent(parent),
+        m_deadline(parent->m_deadline),
+        m_memory_limit(parent->m_memory_limit),
+        m_check_interval(parent->m_check_interval){};
+
+  // Not copyable, since a copy would not observe cancellation of the original.
+  SearchContext(const SearchContext&) = delete;
+  SearchContext& operator=(const SearchContext&) = delete;
+
+  /* Stops any search using this context at its next check. Thread-safe. */
+  void cancel() { m_cancelled.store(true, std::memory_order_relaxed); };
+
+  /**
+   * Returns whether `cancel` has been called on this context or on any of its
+   * ancestors. Thread-safe.
+   */
+  bool cancelled() const {
+    return m_cancelled.load(std::memory_order_relaxed) ||
+           (m_parent != nullptr && m_parent->cancelled());
+  };
+
+  /* Searches stop once the `deadline` has passed. */
+  void setDeadline(const Clock::time_point deadline) {
+    m_deadline = deadline;
+  };
+
+  /* Sets the deadline to `seconds` from now. */
+  void setTimeLimit(const double seconds) {
+    setDeadline(
+        Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(seconds)));
+  };
+
+  Clock::time_point deadline() const { return m_deadline; };
+
+  /**
+   * Searches stop once the memory that they and their heuristics have
+   * allocated exceeds `bytes`.
+   */
+  void setMemoryLimit(const size_t bytes) { m_memory_limit = bytes; };
+
+  size_t memoryLimit() const { return m_memory_limit; };
+
+  /**
+   * Sets the number of expansions between checks of the limits. Throws
+   * `std::invalid_argument` if `expansions` is zero.
+   */
+  void setCheckInterval(const size_t expansions);
+
+  size_t checkInterval() const { return m_check_interval; };
+
+  /**
+   * Returns the status that a search should stop with, or `std::nullopt` if no
+   * limit has been reached, given that the search has allocated `memory_usage`
+   * bytes. Cancellation takes precedence over the memory limit, which takes
+   * precedence over the deadline.
+   */
+  std::optional<SearchStatus> check(const size_t memory_usage) const {
+    if (cancelled()) {
+      return SearchStatus::CANCELLED;
+    }
+    if (memory_usage > m_memory_limit) {
+      return SearchStatus::MEMORY_LIMIT;
+    }
+    if (m_deadline != Clock::time_point::max() && Clock::now() >= m_deadline) {
+      return SearchStatus::TIME_LIMIT;
+    }
+    return std::nullopt;
+  };
+
+ private:
+  const SearchContext* m_parent = nullptr;
+  Clock::time_point m_deadline = Clock::time_point::max();
+  size_t m_memory_limit = std::numeric_limits<size_t>::max();
+  size_t m_check_interval = DEFAULT_CHECK_INTERVAL;
+  std::atomic<bool> m_cancelled{false};
+};
+
+}  // namespace search
+}  // namespace pushworld
+
+#endif /* SEARCH_SEARCH_CONTEXT_H_ */
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEARCH_SEARCH_STATISTICS_H_
+#define SEARCH_SEARCH_STATISTICS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace pushworld {
+namespace search {
+
+/**
+ * Measurements of a single search, which searches fill in when they are given
+ * a non-null `SearchStatistics*`. Searches that are given `nullptr` skip all
+ * measurements, including reading the clock.
+ */
+struct SearchStatistics {
+  // The number of states removed from the frontier to generate successors.
+  size_t expansions = 0;
+
+  // The number of successor states in which at least one object moved.
+  size_t generations = 0;
+
+  // The number of generated states that had already been visited.
+  size_t duplicates = 0;
+
+  // The number of calls to `Heuristic::estimate_cost_to_goal`.
+  size_t evaluations = 0;
+
+  // The number of generated states that were discarded as dead ends before
+  // checking whether they were visited. See `heuristic::DeadEndDetector`.
+  size_t dead_ends = 0;
+
+  // The maximum number of states in the frontier at any time. In a parallel
+  // search, this is the sum of the maximum sizes of every thread's frontier.
+  size_t max_frontier_size = 0;
+
+  // Seconds spent in heuristic evaluations and in generating successor states.
+  // Only measured by serial searches.
+  double heuristic_seconds = 0.0;
+  double successor_seconds = 0.0;
+
+  // Seconds of wall-clock time spent in the whole search.
+  double total_seconds = 0.0;
+
+  // Counters reported by the heuristic. See `Heuristic::add_counters`.
+  std::map<std::string, size_t> heuristic_counters;
+};
+
+/* Returns the number of seconds between two time points. */
+inline double seconds_between(
+    const std::chrono::steady_clock::time_point& start,
+    const std::chrono::steady_clock::time_point& end) {
+  return std::chrono::duration<double>(end - start).count();
+}
+
+/* Returns the `statistics` as a single-line JSON object. */
+std::string to_json(const SearchStatistics& statistics);
+
+/* Returns the `statistics` as a YAML mapping with one key per line. */
+std::string to_yaml(const SearchStatistics& statistics);
+
+}  // namespace search
+}  // namespace pushworld
+
+#endif /* SEARCH_SEARCH_STATISTICS_H_ */
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2022 DeepMind Technologies Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEARCH_SPSC_QUEUE_H_
+#define SEARCH_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>  // move
+
+namespace pushworld {
+namespace search {
+
+/**
+ * A bounded lock-free queue for exactly one producer thread and one consumer
+ * thread. Elements are moved into and out of a ring buffer, so no memory is
+ * allocated after construction.
+ *
+ * The producer must only call `try_push`, and the consumer must only call
+ * `try_pop`.
+ */
+template <typename T>
+class SpscQueue {
+ private:
+  // Separate the indices onto different cache lines so that the producer and
+  // consumer do not contend for the same line.
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  std::unique_ptr<T[]> m_slots;
+  size_t m_mask;
+
+  // The index of the next element to pop. Only written by the consumer.
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head;
+
+  // The index of the next element to push. Only written by the producer.
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail;
+
+ public:
+  /**
+   * Constructs a queue that holds at most `capacity` elements, which must be a
+   * positive power of 2.
+   */
+  explicit SpscQueue(const size_t capacity)
+      : m_slots(new T[capacity]), m_mask(capacity - 1), m_head(0), m_tail(0) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+      throw std::invalid_argument(
+          "The capacity of an SpscQueue must be a positive power of 2.");
+    }
+  };
+
+  /**
+   * Moves the `element` into the back of this queue and returns true, or
+   * returns false without modifying the `element` if this queue is full.
+   */
+  bool try_push(T& element) {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+      return false;
+    }
+    m_slots[tail & m_mask] = std::move(element);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  };
+
+  /**
+   * Moves the front element of this queue into `element` and returns true, or
+   * returns false if this queue is empty.
+   */
+  bool try_pop(T& element) {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    element = std::move(m_slots[head & m_mask]);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  };
+};
+
+}  // namespace search
+}  // namespace pushworld
+
+#endif /* SEARCH_SPSC_QUEUE_H_ */
@@ -0,0 +1,357 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "batched_env.h"
+
+#include <algorithm>  // copy, fill, max, min
+#include <cstring>    // memcpy
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+namespace pushworld {
+
+namespace {
+
+// The colors of all objects, which match `Colors` in the Python package.
+struct Color {
+  uint8_t red, green, blue;
+};
+static const Color AGENT_COLOR{0x00, 0xDC, 0x00};
+static const Color AGENT_BORDER_COLOR{0x00, 0x6E, 0x00};
+static const Color AGENT_WALL_COLOR{0xFA, 0xC7, 0x1E};
+static const Color AGENT_WALL_BORDER_COLOR{0x7D, 0x64, 0x0F};
+static const Color GOAL_BORDER_COLOR{0xB9, 0x00, 0x00};
+static const Color GOAL_OBJECT_COLOR{0xDC, 0x00, 0x00};
+static const Color GOAL_OBJECT_BORDER_COLOR{0x6E, 0x00, 0x00};
+static const Color MOVABLE_COLOR{0x46, 0x9B, 0xFF};
+static const Color MOVABLE_BORDER_COLOR{0x23, 0x48, 0x7F};
+static const Color WALL_COLOR{0x0A, 0x0A, 0x0A};
+static const Color WALL_BORDER_COLOR{0x05, 0x05, 0x05};
+
+// The (row, column) offsets of the neighbors of a cell, in the order in which
+// the Python package draws their borders.
+static const int BORDER_OFFSETS[][2] = {{-1, 0}, {1, 0},  {0, -1}, {0, 1},
+                                        {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+static const double GOAL_REWARD = 10.0;
+static const double STEP_PENALTY = 0.01;
+
+}  // namespace
+
+void ObservationRenderer::draw(const Rectangle& rectangle, const int row,
+                               const int column, float* observation) const {
+  const int first_pixel =
+      (row + rectangle.row) * m_width + column + rectangle.column;
+  float* pixel = observation + first_pixel * 3;
+  const int row_stride = (m_width - rectangle.num_columns) * 3;
+
+  for (int r = 0; r < rectangle.num_rows; r++) {
+    for (int c = 0; c < rectangle.num_columns; c++) {
+      *pixel++ = rectangle.color[0];
+      *pixel++ = rectangle.color[1];
+      *pixel++ = rectangle.color[2];
+    }
+    pixel += row_stride;
+  }
+}
+
+ObservationRenderer::ObservationRenderer(const PushWorldPuzzle& puzzle,
+                                         const int height_cells,
+                                         const int width_cells,
+                                         const int pixels_per_cell,
+                                         const int border_width)
+    : m_pixels_per_cell(pixels_per_cell) {
+  const auto& shapes = puzzle.getShapes();
+  if (shapes.objects.empty()) {
+    throw std::invalid_argument(
+        "Only puzzles that are loaded from files can be rendered.");
+  }
+  if (border_width < 1) {
+    throw std::invalid_argument("border_width must be >= 1");
+  }
+  if (pixels_per_cell < 1 + 2 * border_width) {
+    throw std::invalid_argument(
+        "pixels_per_cell must be >= 1 + 2*border_width");
+  }
+  if (height_cells < puzzle.getHeight() || width_cells < puzzle.getWidth()) {
+    throw std::invalid_argument(
+        "The observation size is smaller than the puzzle size.");
+  }
+
+  m_height = height_cells * pixels_per_cell;
+  m_width = width_cells * pixels_per_cell;
+  m_row_padding = (m_height - puzzle.getHeight() * pixels_per_cell) / 2;
+  m_column_padding = (m_width - puzzle.getWidth() * pixels_per_cell) / 2;
+
+  // Computes the rectangles that draw an object with the given cells, in the
+  // same order as `_draw_object` in the Python package.
+  const auto make_rectangles = [&](const std::vector<Position2D>& cells,
+                                   const Color* fill_color,
+                                   const Color& border_color) {
+    const std::unordered_set<Position2D> cell_set(cells.begin(), cells.end());
+    const auto make_rectangle = [](const int row, const int column,
+                                   const int num_rows, const int num_columns,
+                                   const Color& color) {
+      return Rectangle{row,
+                       column,
+                       num_rows,
+                       num_columns,
+                       {static_cast<float>(color.red) / 255,
+                        static_cast<float>(color.green) / 255,
+                        static_cast<float>(color.blue) / 255}};
+    };
+
+    std::vector<Rectangle> rectangles;
+    for (const auto cell : cells) {
+      int x, y;
+      position_to_xy(cell, x, y);
+      const int row = y * pixels_per_cell;
+      const int column = x * pixels_per_cell;
+
+      if (fill_color != nullptr) {
+        rectangles.push_back(make_rectangle(row, column, pixels_per_cell,
+                                            pixels_per_cell, *fill_color));
+      }
+
+      for (const auto& offset : BORDER_OFFSETS) {
+        const int dr = offset[0];
+        const int dc = offset[1];
+        if (cell_set.count(xy_to_position(x + dc, y + dr))) continue;
+
+        // The adjacent cell is empty, so draw a border.
+        rectangles.push_back(make_rectangle(
+            row + std::max(0, dr) * (pixels_per_cell - border_width),
+            column + std::max(0, dc) * (pixels_per_cell - border_width),
+            dr == 0 ? pixels_per_cell : border_width,
+            dc == 0 ? pixels_per_cell : border_width, border_color));
+      }
+    }
+    return rectangles;
+  };
+
+  // Draw the static objects into the background. The image of the puzzle is
+  // white, and its padding is black.
+  m_background.assign(static_cast<size_t>(m_height) * m_width * 3, 0);
+  const Rectangle puzzle_area{0,
+                              0,
+                              puzzle.getHeight() * pixels_per_cell,
+                              puzzle.getWidth() * pixels_per_cell,
+                              {1, 1, 1}};
+  draw(puzzle_area, m_row_padding, m_column_padding, m_background.data());
+
+  for (const auto& rectangle : make_rectangles(
+           shapes.agent_walls, &AGENT_WALL_COLOR, AGENT_WALL_BORDER_COLOR)) {
+    draw(rectangle, m_row_padding, m_column_padding, m_background.data());
+  }
+  for (const auto& rectangle :
+       make_rectangles(shapes.walls, &WALL_COLOR, WALL_BORDER_COLOR)) {
+    draw(rectangle, m_row_padding, m_column_padding, m_background.data());
+  }
+
+  const int num_goals = shapes.goals.size();
+  for (int i = 0; i < shapes.objects.size(); i++) {
+    if (i == AGENT) {
+      m_object_rectangles.push_back(make_rectangles(
+          shapes.objects[i], &AGENT_COLOR, AGENT_BORDER_COLOR));
+    } else if (i <= num_goals) {
+      m_object_rectangles.push_back(make_rectangles(
+          shapes.objects[i], &GOAL_OBJECT_COLOR, GOAL_OBJECT_BORDER_COLOR));
+    } else {
+      m_object_rectangles.push_back(make_rectangles(
+          shapes.objects[i], &MOVABLE_COLOR, MOVABLE_BORDER_COLOR));
+    }
+  }
+
+  // Goals are transparent, so only their borders are drawn.
+  for (int i = 0; i < num_goals; i++) {
+    int x, y;
+    position_to_xy(puzzle.getGoal()[i], x, y);
+    for (auto rectangle :
+         make_rectangles(shapes.goals[i], nullptr, GOAL_BORDER_COLOR)) {
+      rectangle.row += y * pixels_per_cell;
+      rectangle.column += x * pixels_per_cell;
+      m_goal_rectangles.push_back(rectangle);
+    }
+  }
+}
+
+void ObservationRenderer::render(const Position2D* state,
+                                 float* observation) const {
+  std::memcpy(observation, m_background.data(),
+              m_background.size() * sizeof(float));
+
+  for (int i = 0; i < m_object_rectangles.size(); i++) {
+    int x, y;
+    position_to_xy(state[i], x, y);
+    const int row = m_row_padding + y * m_pixels_per_cell;
+    const int column = m_column_padding + x * m_pixels_per_cell;
+    for (const auto& rectangle : m_object_rectangles[i]) {
+      draw(rectangle, row, column, observation);
+    }
+  }
+
+  for (const auto& rectangle : m_goal_rectangles) {
+    draw(rectangle, m_row_padding, m_column_padding, observation);
+  }
+}
+
+BatchedPushWorldEnv::BatchedPushWorldEnv(
+    const std::vector<std::shared_ptr<const PushWorldPuzzle>>& puzzles,
+    const int num_envs, const int max_steps, const bool auto_reset,
+    const int height_cells, const int width_cells, const int pixels_per_cell,
+    const int border_width, const uint64_t seed)
+    : m_puzzles(puzzles),
+      m_num_envs(num_envs),
+      m_state_size(0),
+      m_max_steps(max_steps),
+      m_auto_reset(auto_reset),
+      m_random_generator(seed) {
+  if (puzzles.empty()) {
+    throw std::invalid_argument("At least one puzzle is required.");
+  }
+  if (num_envs < 1) {
+    throw std::invalid_argument("num_envs must be positive");
+  }
+
+  int max_height = height_cells;
+  int max_width = width_cells;
+  for (const auto& puzzle : puzzles) {
+    m_state_size =
+        std::max<int>(m_state_size, puzzle->getInitialState().size());
+    if (height_cells == 0) {
+      max_height = std::max(max_height, puzzle->getHeight());
+    }
+    if (width_cells == 0) {
+      max_width = std::max(max_width, puzzle->getWidth());
+    }
+  }
+
+  for (const auto& puzzle : puzzles) {
+    m_renderers.emplace_back(*puzzle, max_height, max_width, pixels_per_cell,
+                             border_width);
+  }
+
+  m_states.assign(static_cast<size_t>(num_envs) * m_state_size, 0);
+  m_puzzle_indices.assign(num_envs, 0);
+  m_steps.assign(num_envs, 0);
+  m_achieved_goals.assign(num_envs, 0);
+}
+
+int BatchedPushWorldEnv::countAchievedGoals(const int env) const {
+  const auto& goal = m_puzzles[m_puzzle_indices[env]]->getGoal();
+  const Position2D* state = m_states.data() + env * m_state_size;
+
+  int count = 0;
+  for (int i = 0; i < goal.size(); i++) {
+    count += state[i + 1] == goal[i];
+  }
+  return count;
+}
+
+void BatchedPushWorldEnv::reset(float* observations) {
+  const size_t observation_size = getObservationSize();
+  for (int env = 0; env < m_num_envs; env++) {
+    resetEnv(env, -1,
+             observations == nullptr ? nullptr
+                                     : observations + env * observation_size);
+  }
+}
+
+void BatchedPushWorldEnv::resetEnv(const int env, const int puzzle_index,
+                                   float* observation) {
+  if (env < 0 || env >= m_num_envs) {
+    throw std::invalid_argument("Invalid environment index: " +
+                                std::to_string(env));
+  }
+  if (puzzle_index >= static_cast<int>(m_puzzles.size())) {
+    throw std::invalid_argument("Invalid puzzle index: " +
+                                std::to_string(puzzle_index));
+  }
+
+  if (puzzle_index < 0) {
+    std::uniform_int_distribution<int> distribution(0, m_puzzles.size() - 1);
+    m_puzzle_indices[env] = distribution(m_random_generator);
+  } else {
+    m_puzzle_indices[env] = puzzle_index;
+  }
+
+  const auto& initial_state =
+      m_puzzles[m_puzzle_indices[env]]->getInitialState();
+  Position2D* state = getState(env);
+  std::fill(std::copy(initial_state.begin(), initial_state.end(), state),
+            state + m_state_size, 0);
+
+  m_steps[env] = 0;
+  m_achieved_goals[env] = countAchievedGoals(env);
+
+  if (observation != nullptr) {
+    render(env, observation);
+  }
+}
+
+void BatchedPushWorldEnv::step(const Action* actions, float* observations,
+                               double* rewards, uint8_t* terminated,
+                               uint8_t* truncated) {
+  for (int env = 0; env < m_num_envs; env++) {
+    if (actions[env] < 0 || actions[env] >= NUM_ACTIONS) {
+      throw std::invalid_argument("Invalid action: " +
+                                  std::to_string(actions[env]));
+    }
+  }
+
+  const size_t observation_size = getObservationSize();
+
+  for (int env = 0; env < m_num_envs; env++) {
+    const auto& puzzle = *m_puzzles[m_puzzle_indices[env]];
+    const int num_objects = puzzle.getInitialState().size();
+    Position2D* state = getState(env);
+
+    m_state.assign(state, state + num_objects);
+    if (puzzle.getNextState(m_state, actions[env], m_next, m_scratch)) {
+      std::copy(m_next.state.begin(), m_next.state.end(), state);
+    }
+    m_steps[env]++;
+
+    const int previous_achieved_goals = m_achieved_goals[env];
+    m_achieved_goals[env] = countAchievedGoals(env);
+    const bool is_terminated =
+        m_achieved_goals[env] == static_cast<int>(puzzle.getGoal().size());
+    const bool is_truncated = m_max_steps > 0 && m_steps[env] >= m_max_steps;
+
+    rewards[env] = is_terminated ? GOAL_REWARD
+                                 : m_achieved_goals[env] -
+                                       previous_achieved_goals - STEP_PENALTY;
+    terminated[env] = is_terminated;
+    truncated[env] = is_truncated;
+
+    float* observation = observations == nullptr
+                             ? nullptr
+                             : observations + env * observation_size;
+
+    if (m_auto_reset && (is_terminated || is_truncated)) {
+      resetEnv(env, -1, observation);
+    } else if (observation != nullptr) {
+      render(env, observation);
+    }
+  }
+}
+
+void BatchedPushWorldEnv::render(const int env, float* observation) const {
+  m_renderers[m_puzzle_indices[env]].render(
+      m_states.data() + env * m_state_size, observation);
+}
+
+}  // namespace pushworld
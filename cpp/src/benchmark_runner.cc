@@ -0,0 +1,284 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark_runner.h"
+
+#include <algorithm>  // sort
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <new>  // bad_alloc
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>  // pair
+#include <vector>
+
+#include "planner.h"
+#include "pushworld_puzzle.h"
+#include "search/search_context.h"
+
+namespace fs = std::filesystem;
+
+namespace pushworld {
+
+namespace {
+
+static const std::string PUZZLE_EXTENSION = ".pwp";
+static const std::string RESULT_EXTENSION = ".yaml";
+
+/* Returns whether the `path` has the puzzle extension, ignoring case. */
+bool has_puzzle_extension(const fs::path& path) {
+  std::string extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension == PUZZLE_EXTENSION;
+}
+
+/**
+ * Returns whether a YAML scalar must be quoted so that it is not parsed as a
+ * different type or as YAML syntax.
+ */
+bool needs_quotes(const std::string& value) {
+  if (value.empty() || value.front() == ' ' || value.back() == ' ') {
+    return true;
+  }
+  if (std::string("-?:,[]{}#&*!|>'\"%@`").find(value.front()) !=
+      std::string::npos) {
+    return true;
+  }
+  if (value.find(": ") != std::string::npos ||
+      value.find(" #") != std::string::npos || value.back() == ':') {
+    return true;
+  }
+  for (const char c : value) {
+    if (std::iscntrl(static_cast<unsigned char>(c))) {
+      return true;
+    }
+  }
+
+  // Check for values that YAML parses as numbers, booleans, or null.
+  std::string lower = value;
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  for (const char* keyword :
+       {"~", "null", "true", "false", "yes", "no", "on", "off", ".inf",
+        ".nan"}) {
+    if (lower == keyword) {
+      return true;
+    }
+  }
+  double number;
+  const auto parsed =
+      std::from_chars(value.data(), value.data() + value.size(), number);
+  return parsed.ec == std::errc() && parsed.ptr == value.data() + value.size();
+}
+
+/* Returns the `value` as a YAML scalar. */
+std::string to_yaml_string(const std::optional<std::string>& value) {
+  if (value == std::nullopt) {
+    return "null";
+  }
+  if (!needs_quotes(*value)) {
+    return *value;
+  }
+
+  // Single-quoted scalars only need to escape single quotes.
+  std::string quoted = "'";
+  for (const char c : *value) {
+    quoted += c;
+    if (c == '\'') {
+      quoted += '\'';
+    }
+  }
+  return quoted + "'";
+}
+
+/* Returns the `value` in the shortest form that round-trips. */
+std::string to_yaml_number(const double value) {
+  char buffer[64];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  std::string number(buffer, result.ptr);
+
+  // `yaml.dump` writes floats with a decimal point.
+  if (number.find_first_of(".e") == std::string::npos) {
+    number += ".0";
+  }
+  return number;
+}
+
+/**
+ * Solves the `puzzle` in the calling thread, with the `limits` as the deadline
+ * and memory budget of the search, and returns its result. See
+ * `run_planner_with_limits`.
+ */
+PlanningResult solve_with_limits(const std::string& mode,
+                                 const std::shared_ptr<PushWorldPuzzle>& puzzle,
+                                 const std::string& puzzle_name,
+                                 const PlanningLimits& limits) {
+  using Clock = std::chrono::steady_clock;
+
+  PlanningResult result;
+  result.planner = get_planner_name(mode);
+  result.puzzle = puzzle_name;
+
+  search::SearchContext context;
+  if (limits.time_limit != std::nullopt) {
+    context.setTimeLimit(*limits.time_limit);
+  }
+  if (limits.memory_limit != std::nullopt) {
+    context.setMemoryLimit(*limits.memory_limit);
+  }
+
+  const auto start = Clock::now();
+  search::SearchResult search_result;
+  try {
+    search_result = solve(puzzle, mode, context);
+  } catch (const std::bad_alloc&) {
+    // E.g. the heuristics do not fit in memory, which the search only checks
+    // after they are built.
+    search_result.status = search::SearchStatus::MEMORY_LIMIT;
+  }
+  result.planning_time =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  switch (search_result.status) {
+    case search::SearchStatus::SOLVED:
+      if (puzzle->isValidPlan(*search_result.plan)) {
+        result.plan = "";
+        for (const Action action : *search_result.plan) {
+          *result.plan += ACTION_TO_CHAR[action];
+        }
+      } else {
+        result.failure_reason = "invalid plan";
+      }
+      break;
+    case search::SearchStatus::NO_SOLUTION:
+      result.failure_reason = "no solution exists";
+      break;
+    case search::SearchStatus::TIME_LIMIT:
+      result.failure_reason = "time limit reached";
+      result.planning_time = *limits.time_limit;
+      break;
+    case search::SearchStatus::MEMORY_LIMIT:
+      result.failure_reason = "memory error";
+      break;
+    case search::SearchStatus::CANCELLED:
+      result.failure_reason = "unknown";
+      break;
+  }
+  return result;
+}
+
+}  // namespace
+
+std::string get_planner_name(const std::string& mode) {
+  if (mode == "RGD") {
+    return "RGD";
+  } else if (mode == "N+RGD") {
+    return "Novelty+RGD";
+  } else if (mode == "PORTFOLIO") {
+    return "Portfolio";
+  }
+  throw std::domain_error("Unrecognized mode: " + mode);
+}
+
+std::vector<std::pair<std::string, std::string>> map_puzzle_files(
+    const std::string& puzzles_path, const std::string& results_path) {
+  const fs::path input_path(puzzles_path);
+  const fs::path output_path(results_path);
+  std::vector<std::pair<std::string, std::string>> file_paths;
+
+  if (fs::is_regular_file(input_path)) {
+    if (!has_puzzle_extension(input_path)) {
+      throw std::invalid_argument(
+          "The given file does not have the expected extension (" +
+          PUZZLE_EXTENSION + "): " + puzzles_path);
+    }
+    fs::create_directories(output_path);
+    file_paths.emplace_back(
+        input_path.string(),
+        (output_path / input_path.stem()).string() + RESULT_EXTENSION);
+    return file_paths;
+  }
+
+  if (!fs::is_directory(input_path)) {
+    throw std::invalid_argument("No such file or directory: " + puzzles_path);
+  }
+
+  for (const auto& entry : fs::recursive_directory_iterator(input_path)) {
+    if (!entry.is_regular_file() || !has_puzzle_extension(entry.path())) {
+      continue;
+    }
+    const fs::path subdirectory =
+        entry.path().parent_path().lexically_relative(input_path);
+    const fs::path result_directory =
+        subdirectory == "." ? output_path : output_path / subdirectory;
+    fs::create_directories(result_directory);
+    file_paths.emplace_back(
+        entry.path().string(),
+        (result_directory / entry.path().stem()).string() + RESULT_EXTENSION);
+  }
+
+  std::sort(file_paths.begin(), file_paths.end());
+  return file_paths;
+}
+
+std::string to_yaml(const PlanningResult& result) {
+  // Keys are sorted, which matches the default of `yaml.dump`.
+  std::string yaml;
+  if (result.failure_reason != std::nullopt) {
+    yaml += "failure_reason: " + to_yaml_string(result.failure_reason) + "\n";
+  }
+  yaml += "plan: " + to_yaml_string(result.plan) + "\n";
+  yaml += "planner: " + to_yaml_string(result.planner) + "\n";
+  yaml += "planning_time: " + to_yaml_number(result.planning_time) + "\n";
+  yaml += "puzzle: " + to_yaml_string(result.puzzle) + "\n";
+  return yaml;
+}
+
+std::vector<std::pair<size_t, std::string>> map_collection_puzzles(
+    const PuzzleCollection& collection, const std::string& results_path) {
+  const fs::path output_path(results_path);
+  std::vector<std::pair<size_t, std::string>> result_paths;
+
+  for (size_t i = 0; i < collection.size(); i++) {
+    const fs::path name(collection.getName(i));
+    const fs::path result_directory = output_path / name.parent_path();
+    fs::create_directories(result_directory);
+    result_paths.emplace_back(
+        i, (result_directory / name.stem()).string() + RESULT_EXTENSION);
+  }
+  return result_paths;
+}
+
+PlanningResult run_planner_with_limits(const std::string& mode,
+                                       const std::string& puzzle_path,
+                                       const PlanningLimits& limits) {
+  // Check the mode before loading the puzzle.
+  get_planner_name(mode);
+  return solve_with_limits(mode, std::make_shared<PushWorldPuzzle>(puzzle_path),
+                           fs::path(puzzle_path).stem().string(), limits);
+}
+
+PlanningResult run_planner_with_limits(
+    const std::string& mode, const std::shared_ptr<PushWorldPuzzle>& puzzle,
+    const std::string& puzzle_name, const PlanningLimits& limits) {
+  return solve_with_limits(mode, puzzle, puzzle_name, limits);
+}
+
+}  // namespace pushworld
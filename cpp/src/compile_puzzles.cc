@@ -0,0 +1,73 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "puzzle_collection.h"
+#include "pushworld_puzzle.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * Converts PushWorld puzzles in .pwp format into compiled puzzles that can be
+ * loaded with `PushWorldPuzzle::loadCompiled`.
+ */
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::cout << "Usage: compile_puzzles <output> <puzzles>...\n\n"
+                 "Writes every given PushWorld puzzle in the compiled format, "
+                 "which loads without parsing or computing collisions. Each "
+                 "puzzle <name>.pwp is saved as <output>/<name>"
+              << pushworld::COMPILED_PUZZLE_EXTENSION
+              << ", and each puzzle collection <name>.zip is saved as a "
+                 "single archive <output>/<name>"
+              << pushworld::PUZZLE_ARCHIVE_EXTENSION
+              << ".\n\n"
+                 "Arguments:\n"
+                 "    <output>  : The directory in which to save compiled "
+                 "puzzles. It is created if it does not exist.\n"
+                 "    <puzzles> : Paths of .pwp files or puzzle "
+                 "collections.\n\n";
+    return 0;
+  }
+
+  try {
+    const fs::path output_path = argv[1];
+    fs::create_directories(output_path);
+
+    for (int i = 2; i < argc; i++) {
+      const fs::path puzzle_path = argv[i];
+      fs::path compiled_path = output_path / puzzle_path.filename();
+
+      if (pushworld::is_puzzle_collection(puzzle_path.string())) {
+        const pushworld::PuzzleCollection collection(puzzle_path.string());
+        compiled_path.replace_extension(pushworld::PUZZLE_ARCHIVE_EXTENSION);
+        collection.saveArchive(compiled_path.string());
+        continue;
+      }
+
+      const pushworld::PushWorldPuzzle puzzle(puzzle_path.string());
+      compiled_path.replace_extension(pushworld::COMPILED_PUZZLE_EXTENSION);
+      puzzle.saveCompiled(compiled_path.string());
+    }
+  } catch (std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,373 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <algorithm>  // max
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>  // move
+#include <vector>
+
+#include "planner.h"
+#include "puzzle_collection.h"
+#include "puzzle_generator.h"
+#include "pushworld_puzzle.h"
+#include "search/search_context.h"
+
+namespace {
+
+static const char* USAGE =
+    "Usage: generate_puzzles [options] <output>\n\n"
+    "Generates random level-0 PushWorld puzzles, as `generate.py` in the "
+    "Python package does, and solves them on a pool of threads while they "
+    "are generated. Puzzles that are solved within the time limit are "
+    "streamed into a zip archive, which contains `puzzle_<i>.pwp` for "
+    "consecutive indices and a `plans.txt` file with the plan of each "
+    "puzzle, in the text format of `validate_plans`.\n\n"
+    "Arguments:\n"
+    "    <output> : The path of the zip archive to create, which can be read "
+    "as a puzzle collection by `run_benchmark` and `validate_plans`.\n\n"
+    "Options:\n"
+    "    --num-puzzles <N>       : The number of puzzles to generate. Fewer "
+    "puzzles are saved if some are not solved. Defaults to 5.\n"
+    "    --seed <N>              : The seed of the random puzzles. Defaults "
+    "to 0.\n"
+    "    --mode <mode>           : The heuristic mode of `run_planner` that "
+    "solves the puzzles. Defaults to \"RGD\".\n"
+    "    --time-limit <sec>      : The maximum time to solve each puzzle. "
+    "Defaults to 2.\n"
+    "    --min-plan-length <N>   : Only saves puzzles whose plan has at least "
+    "this many actions. Defaults to 1.\n"
+    "    --threads <N>           : The number of puzzles to solve in "
+    "parallel. Defaults to the number of hardware threads.\n"
+    "    --shapes <simple|complex>\n"
+    "                            : If \"simple\", all objects are 1x1. "
+    "Defaults to \"complex\".\n"
+    "    --min-puzzle-size <N>, --max-puzzle-size <N>\n"
+    "                            : The range of the width and height of "
+    "puzzles. Defaults to 8 and 12.\n"
+    "    --min-walls <N>, --max-walls <N>\n"
+    "                            : The range of the number of single-pixel "
+    "walls. Defaults to 2 and 4.\n"
+    "    --min-obstacles <N>, --max-obstacles <N>\n"
+    "                            : The range of the number of movable "
+    "obstacles. Defaults to 1 and 2.\n"
+    "    --min-goals <N>, --max-goals <N>\n"
+    "                            : The range of the number of goal objects, "
+    "which is 1 or 2. Defaults to 1 and 1.\n\n";
+
+/**
+ * A queue with a maximum size, in which `push` waits while the queue is full
+ * and `pop` waits while it is empty. This keeps the stages of the pipeline in
+ * step without holding all puzzles in memory.
+ */
+template <typename T>
+class BoundedQueue {
+ private:
+  std::mutex m_mutex;
+  std::condition_variable m_not_empty;
+  std::condition_variable m_not_full;
+  std::deque<T> m_items;
+  const size_t m_capacity;
+  bool m_closed;
+
+ public:
+  explicit BoundedQueue(const size_t capacity)
+      : m_capacity(std::max<size_t>(1, capacity)), m_closed(false) {}
+
+  /**
+   * Adds the `item` to the back of the queue, waiting until there is space.
+   * Returns false, and discards the item, if the queue is closed.
+   */
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_not_full.wait(lock,
+                    [this] { return m_closed || m_items.size() < m_capacity; });
+    if (m_closed) {
+      return false;
+    }
+    m_items.push_back(std::move(item));
+    m_not_empty.notify_one();
+    return true;
+  }
+
+  /**
+   * Removes the item at the front of the queue, waiting until there is one.
+   * Returns `std::nullopt` once the queue is closed and empty.
+   */
+  std::optional<T> pop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_not_empty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+    if (m_items.empty()) {
+      return std::nullopt;
+    }
+    T item = std::move(m_items.front());
+    m_items.pop_front();
+    m_not_full.notify_one();
+    return item;
+  }
+
+  /* Stops accepting items. Items in the queue can still be popped. */
+  void close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+  }
+};
+
+/* A generated puzzle, and its plan once it is solved. */
+struct GeneratedPuzzle {
+  // The position of the puzzle in the sequence of generated puzzles.
+  size_t index;
+
+  // The puzzle in the .pwp format.
+  std::string text;
+
+  std::optional<pushworld::Plan> plan;
+};
+
+/* Parses a non-negative integer from a command-line option. */
+int parse_option(const std::string& option, const std::string& value) {
+  const std::string error = "Invalid value for " + option + ": " + value;
+  size_t end = 0;
+  int number = 0;
+  try {
+    number = std::stoi(value, &end);
+  } catch (const std::exception&) {
+    throw std::invalid_argument(error);
+  }
+  if (end != value.size() || number < 0) {
+    throw std::invalid_argument(error);
+  }
+  return number;
+}
+
+/* Returns the 'LRUD' string of the `plan`. */
+std::string plan_to_string(const pushworld::Plan& plan) {
+  std::string plan_string;
+  for (const auto action : plan) {
+    plan_string += pushworld::ACTION_TO_CHAR[action];
+  }
+  return plan_string;
+}
+
+}  // namespace
+
+/**
+ * Generates random puzzles on one thread, solves them on a pool of threads,
+ * and writes the solved puzzles to a zip archive on the main thread, in the
+ * order in which they were generated.
+ */
+int main(int argc, char* argv[]) {
+  try {
+    int num_threads = std::max(1u, std::thread::hardware_concurrency());
+    int num_puzzles = 5;
+    unsigned int seed = 0;
+    std::string mode = "RGD";
+    double time_limit = 2;
+    size_t min_plan_length = 1;
+    pushworld::Level0GeneratorOptions options;
+    std::vector<std::string> args;
+
+    // Maps options to the integers that they set.
+    const std::map<std::string, int*> int_options = {
+        {"--threads", &num_threads},
+        {"--num-puzzles", &num_puzzles},
+        {"--min-puzzle-size", &options.min_puzzle_size},
+        {"--max-puzzle-size", &options.max_puzzle_size},
+        {"--min-walls", &options.min_num_walls},
+        {"--max-walls", &options.max_num_walls},
+        {"--min-obstacles", &options.min_num_obstacles},
+        {"--max-obstacles", &options.max_num_obstacles},
+        {"--min-goals", &options.min_num_goal_objects},
+        {"--max-goals", &options.max_num_goal_objects},
+    };
+
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      const bool is_int_option = int_options.count(arg) > 0;
+      if (is_int_option || arg == "--seed" || arg == "--mode" ||
+          arg == "--time-limit" || arg == "--min-plan-length" ||
+          arg == "--shapes") {
+        if (++i == argc) {
+          throw std::invalid_argument("Missing value for " + arg);
+        }
+        const std::string value = argv[i];
+        if (is_int_option) {
+          *int_options.at(arg) = parse_option(arg, value);
+        } else if (arg == "--seed") {
+          seed = parse_option(arg, value);
+        } else if (arg == "--mode") {
+          mode = value;
+        } else if (arg == "--time-limit") {
+          time_limit = parse_option(arg, value);
+        } else if (arg == "--min-plan-length") {
+          min_plan_length = parse_option(arg, value);
+        } else if (value == "simple" || value == "complex") {
+          options.complex_shapes = value == "complex";
+        } else {
+          throw std::invalid_argument("Invalid value for " + arg + ": " +
+                                      value);
+        }
+      } else {
+        args.push_back(arg);
+      }
+    }
+
+    if (args.size() != 1) {
+      std::cout << USAGE;
+      return 0;
+    }
+    if (num_puzzles < 1) {
+      throw std::invalid_argument("num_puzzles must be at least 1");
+    }
+    num_threads = std::max(1, num_threads);
+
+    // Fail before starting any thread if the options or the output are
+    // invalid.
+    pushworld::Level0PuzzleGenerator generator(options, seed);
+    pushworld::ZipArchiveWriter archive(args[0]);
+
+    // The queues hold a few puzzles per thread, so that workers rarely wait
+    // for the generator or the writer.
+    BoundedQueue<GeneratedPuzzle> generated(4 * num_threads);
+    BoundedQueue<GeneratedPuzzle> solved(4 * num_threads);
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    std::atomic<bool> failed(false);
+
+    // Stops all stages of the pipeline after the first error.
+    auto fail = [&](std::exception_ptr e) {
+      {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (error == nullptr) {
+          error = e;
+        }
+      }
+      failed = true;
+      generated.close();
+      solved.close();
+    };
+
+    std::thread generator_thread([&]() {
+      try {
+        for (int i = 0; i < num_puzzles; i++) {
+          if (!generated.push(GeneratedPuzzle{size_t(i), generator.generate(),
+                                              std::nullopt})) {
+            break;
+          }
+        }
+      } catch (...) {
+        fail(std::current_exception());
+      }
+      generated.close();
+    });
+
+    std::atomic<int> num_running_workers(num_threads);
+
+    // Each worker solves the next generated puzzle. Puzzles that are not
+    // solved within the time limit are passed on without a plan, so that the
+    // writer can keep the order of the generated puzzles.
+    auto worker = [&]() {
+      try {
+        std::optional<GeneratedPuzzle> puzzle;
+        while (!failed && (puzzle = generated.pop())) {
+          pushworld::search::SearchContext context;
+          context.setTimeLimit(time_limit);
+          puzzle->plan =
+              pushworld::solve(std::make_shared<pushworld::PushWorldPuzzle>(
+                                   pushworld::PushWorldPuzzle::fromText(
+                                       puzzle->text)),
+                               mode, context)
+                  .plan;
+          if (!solved.push(std::move(*puzzle))) {
+            break;
+          }
+        }
+      } catch (...) {
+        fail(std::current_exception());
+      }
+      if (--num_running_workers == 0) {
+        solved.close();
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back(worker);
+    }
+
+    // Writes the solved puzzles in the order in which they were generated, so
+    // that the archive only depends on the seed and the options.
+    std::map<size_t, GeneratedPuzzle> pending;
+    size_t next_index = 0;
+    size_t num_saved = 0;
+    std::string plans;
+
+    try {
+      std::optional<GeneratedPuzzle> puzzle;
+      while ((puzzle = solved.pop())) {
+        pending.emplace(puzzle->index, std::move(*puzzle));
+
+        for (auto it = pending.begin();
+             it != pending.end() && it->first == next_index;
+             it = pending.erase(it), next_index++) {
+          const auto& plan = it->second.plan;
+          if (!plan.has_value() || plan->size() < min_plan_length) {
+            continue;
+          }
+          const std::string name = "puzzle_" + std::to_string(num_saved++);
+          archive.add(name + ".pwp", it->second.text);
+          plans += name + " " + plan_to_string(*plan) + "\n";
+        }
+      }
+    } catch (...) {
+      fail(std::current_exception());
+    }
+
+    generator_thread.join();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+
+    archive.add("plans.txt", plans);
+    archive.close();
+
+    std::cout << num_saved << "/" << num_puzzles << " puzzles were saved\n";
+  } catch (std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << "\n";
+    return 1;
+  } catch (...) {
+    std::cerr << "UNKNOWN ERROR\n";
+    return 1;
+  }
+  return 0;
+}
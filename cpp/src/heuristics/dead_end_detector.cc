@@ -0,0 +1,100 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "heuristics/dead_end_detector.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "heuristics/domain_transition_graph.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace heuristic {
+
+DeadEndDetector::DeadEndDetector(const PushWorldPuzzle& puzzle)
+    : DeadEndDetector(puzzle, build_feasible_movement_graphs(puzzle)) {}
+
+DeadEndDetector::DeadEndDetector(
+    const PushWorldPuzzle& puzzle,
+    const std::unordered_map<int, std::shared_ptr<FeasibleMovementGraph>>&
+        movement_graphs)
+    : m_num_dead_end_positions(0) {
+  const auto& goal = puzzle.getGoal();
+  m_graphs.reserve(goal.size());
+  m_goal_reachable_bits.resize(goal.size());
+
+  // Reused for every goal object.
+  std::vector<std::vector<int>> predecessors;
+  std::vector<int> frontier;
+
+  for (int goal_index = 0; goal_index < int(goal.size()); goal_index++) {
+    m_graphs.emplace_back(*movement_graphs.at(goal_index + 1));
+    const auto& graph = m_graphs.back();
+    const int num_nodes = graph.numNodes();
+    auto& reachable_bits = m_goal_reachable_bits[goal_index];
+    reachable_bits.assign((num_nodes + 63) / 64, 0);
+
+    predecessors.assign(num_nodes, {});
+    for (int node = 0; node < num_nodes; node++) {
+      const auto action_mask = graph.getActionMask(node);
+      for (Action action = 0; action < NUM_ACTIONS; action++) {
+        if (action_mask & (1 << action)) {
+          predecessors[graph.getNextNodeIndex(node, action)].push_back(node);
+        }
+      }
+    }
+
+    // Breadth-first search backwards from the goal position. The goal position
+    // may not be in the graph, in which case every position is a dead end.
+    int num_reachable = 0;
+    frontier.clear();
+    const int goal_node = graph.getNodeIndex(goal[goal_index]);
+    if (goal_node >= 0) {
+      reachable_bits[goal_node / 64] |= uint64_t(1) << (goal_node % 64);
+      frontier.push_back(goal_node);
+      num_reachable++;
+    }
+    while (!frontier.empty()) {
+      const int node = frontier.back();
+      frontier.pop_back();
+      for (const int predecessor : predecessors[node]) {
+        uint64_t& word = reachable_bits[predecessor / 64];
+        const uint64_t mask = uint64_t(1) << (predecessor % 64);
+        if (!(word & mask)) {
+          word |= mask;
+          frontier.push_back(predecessor);
+          num_reachable++;
+        }
+      }
+    }
+
+    m_num_dead_end_positions += num_nodes - num_reachable;
+  }
+}
+
+bool DeadEndDetector::isDeadEnd(const State& state) const {
+  for (int goal_index = 0; goal_index < int(m_graphs.size()); goal_index++) {
+    if (isDeadEndPosition(goal_index + 1, state[goal_index + 1])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace heuristic
+}  // namespace pushworld
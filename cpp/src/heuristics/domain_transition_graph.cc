@@ -14,11 +14,18 @@
 
 #include "heuristics/domain_transition_graph.h"
 
+#include <algorithm>  // max, min, sort
 #include <boost/functional/hash.hpp>
+#include <climits>
 #include <limits>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>  // swap
+#include <vector>
 
 namespace pushworld {
 namespace heuristic {
@@ -299,5 +306,109 @@ float PathDistances::getDistance(const Position2D source,
   return iterator->second->getDistance(source);
 };
 
+DenseMovementGraph::DenseMovementGraph(const FeasibleMovementGraph& graph) {
+  m_positions.reserve(graph.size());
+  for (const auto& pair : graph) {
+    m_positions.push_back(pair.first);
+  }
+  std::sort(m_positions.begin(), m_positions.end());
+
+  // Find the bounds of all positions.
+  int x, y;
+  int max_x = INT_MIN;
+  int max_y = INT_MIN;
+  m_min_x = INT_MAX;
+  m_min_y = INT_MAX;
+
+  for (const auto position : m_positions) {
+    displacement_to_xy(position, x, y);
+    m_min_x = std::min(m_min_x, x);
+    m_min_y = std::min(m_min_y, y);
+    max_x = std::max(max_x, x);
+    max_y = std::max(max_y, y);
+  }
+
+  if (m_positions.empty()) {
+    m_min_x = m_min_y = m_width = m_height = 0;
+    return;
+  }
+  m_width = max_x - m_min_x + 1;
+  m_height = max_y - m_min_y + 1;
+
+  const size_t num_nodes = m_positions.size();
+  m_node_indices.assign(size_t(m_width) * size_t(m_height), -1);
+  for (size_t i = 0; i < num_nodes; i++) {
+    displacement_to_xy(m_positions[i], x, y);
+    m_node_indices[(x - m_min_x) * m_height + (y - m_min_y)] = int(i);
+  }
+
+  m_action_masks.assign(num_nodes, 0);
+  for (size_t i = 0; i < num_nodes; i++) {
+    for (const auto next_position : graph.at(m_positions[i])) {
+      const Action action =
+          DISPLACEMENTS_TO_ACTIONS.at(next_position - m_positions[i]);
+      m_action_masks[i] |= ActionMask(1) << action;
+    }
+  }
+}
+
+AllPairsPathDistances::AllPairsPathDistances(
+    const FeasibleMovementGraph& graph, const int num_threads)
+    : m_graph(graph), m_num_nodes(m_graph.numNodes()) {
+  // The longest possible path visits every node once.
+  if (m_num_nodes >= UNREACHABLE) {
+    throw std::domain_error(
+        "Too many positions to store path distances: " +
+        std::to_string(m_num_nodes));
+  }
+
+  // Convert the graph into adjacency lists of node indices.
+  std::vector<std::vector<int>> adjacent_nodes(m_num_nodes);
+  for (int i = 0; i < m_num_nodes; i++) {
+    const auto mask = m_graph.getActionMask(i);
+    for (Action action = 0; action < NUM_ACTIONS; action++) {
+      if (mask & (1 << action)) {
+        adjacent_nodes[i].push_back(m_graph.getNextNodeIndex(i, action));
+      }
+    }
+  }
+
+  m_distances.assign(size_t(m_num_nodes) * m_num_nodes, UNREACHABLE);
+
+  // Each row of distances is computed by an independent breadth-first search
+  // from its start node. Threads process disjoint rows.
+  auto compute_rows = [&](const int first_row, const int row_step) {
+    std::vector<int> frontier, next_frontier;
+    for (int start = first_row; start < m_num_nodes; start += row_step) {
+      Distance* distances = m_distances.data() + size_t(start) * m_num_nodes;
+      distances[start] = 0;
+      frontier.assign(1, start);
+
+      for (Distance depth = 1; !frontier.empty(); depth++) {
+        next_frontier.clear();
+        for (const int node : frontier) {
+          for (const int next_node : adjacent_nodes[node]) {
+            if (distances[next_node] == UNREACHABLE) {
+              distances[next_node] = depth;
+              next_frontier.push_back(next_node);
+            }
+          }
+        }
+        std::swap(frontier, next_frontier);
+      }
+    }
+  };
+
+  const int pool_size = std::max(1, std::min(num_threads, m_num_nodes));
+  std::vector<std::thread> threads;
+  for (int i = 1; i < pool_size; i++) {
+    threads.emplace_back(compute_rows, i, pool_size);
+  }
+  compute_rows(0, pool_size);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 }  // namespace heuristic
 }  // namespace pushworld
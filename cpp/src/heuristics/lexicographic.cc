@@ -0,0 +1,96 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "heuristics/lexicographic.h"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>  // pair
+#include <vector>
+
+#include "heuristics/heuristic.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace heuristic {
+
+LexicographicHeuristic::LexicographicHeuristic(
+    std::shared_ptr<Heuristic<float>> primary,
+    std::shared_ptr<Heuristic<float>> secondary)
+    : m_primary(std::move(primary)), m_secondary(std::move(secondary)) {
+  if (m_primary == nullptr || m_secondary == nullptr) {
+    throw std::invalid_argument(
+        "Both heuristics of a lexicographic heuristic must be provided.");
+  }
+}
+
+std::pair<float, float> LexicographicHeuristic::estimate_cost_to_goal(
+    const RelativeState& relative_state) {
+  static const float INF = std::numeric_limits<float>::infinity();
+
+  // Both heuristics are always evaluated, since some heuristics (e.g. the
+  // novelty heuristic) update their internal state with every call.
+  const float primary = m_primary->estimate_cost_to_goal(relative_state);
+  const float secondary = m_secondary->estimate_cost_to_goal(relative_state);
+
+  if (std::isinf(primary) || std::isinf(secondary)) {
+    return std::make_pair(INF, INF);
+  }
+
+  return std::make_pair(primary, secondary);
+}
+
+void LexicographicHeuristic::estimate_costs(const RelativeState* states,
+                                            const size_t num_states,
+                                            std::pair<float, float>* costs) {
+  static const float INF = std::numeric_limits<float>::infinity();
+
+  m_primary_costs.resize(num_states);
+  m_secondary_costs.resize(num_states);
+  m_primary->estimate_costs(states, num_states, m_primary_costs.data());
+  m_secondary->estimate_costs(states, num_states, m_secondary_costs.data());
+
+  for (size_t i = 0; i < num_states; i++) {
+    const float primary = m_primary_costs[i];
+    const float secondary = m_secondary_costs[i];
+    costs[i] = std::isinf(primary) || std::isinf(secondary)
+                   ? std::make_pair(INF, INF)
+                   : std::make_pair(primary, secondary);
+  }
+}
+
+void LexicographicHeuristic::add_counters(
+    std::map<std::string, size_t>& counters) const {
+  m_primary->add_counters(counters);
+  m_secondary->add_counters(counters);
+}
+
+size_t LexicographicHeuristic::memory_usage() const {
+  return m_primary->memory_usage() + m_secondary->memory_usage();
+}
+
+void LexicographicHeuristic::set_search_context(
+    const search::SearchContext* context) {
+  m_primary->set_search_context(context);
+  m_secondary->set_search_context(context);
+}
+
+}  // namespace heuristic
+}  // namespace pushworld
@@ -14,9 +14,48 @@
 
 #include "heuristics/novelty.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>  // iota
+#include <unordered_set>
+#include <utility>  // swap
+#include <vector>
+
+#include "heuristics/domain_transition_graph.h"
+#include "pushworld_puzzle.h"
+
 namespace pushworld {
 namespace heuristic {
 
+namespace {
+
+/**
+ * Returns an estimate of the bytes allocated by the `set`, assuming that each
+ * element is stored in a separate node with a pointer to the next node.
+ */
+template <typename T, typename Hash>
+size_t hash_set_memory_usage(const std::unordered_set<T, Hash>& set) {
+  return set.bucket_count() * sizeof(void*) +
+         set.size() * (sizeof(T) + sizeof(void*));
+}
+
+/* Returns the number of 64-bit words that store `num_bits` bits. */
+size_t num_words(const size_t num_bits) { return (num_bits + 63) / 64; }
+
+/* Sets the given bit to 1. Returns whether the bit was previously 0. */
+bool test_and_set(std::vector<uint64_t>& bits, const size_t bit) {
+  uint64_t& word = bits[bit / 64];
+  const uint64_t mask = uint64_t(1) << (bit % 64);
+  if (word & mask) {
+    return false;
+  }
+  word |= mask;
+  return true;
+}
+
+}  // namespace
+
 NoveltyHeuristic::NoveltyHeuristic(const int state_size)
     : m_state_size(state_size) {
   m_visited_positions.resize(state_size);
@@ -25,12 +64,116 @@ NoveltyHeuristic::NoveltyHeuristic(const int state_size)
   for (auto& position_pairs : m_visited_position_pairs) {
     position_pairs.resize(state_size);
   }
+
+  m_representatives.resize(state_size);
+  std::iota(m_representatives.begin(), m_representatives.end(), 0);
+}
+
+NoveltyHeuristic::NoveltyHeuristic(const PushWorldPuzzle& puzzle,
+                                   const size_t max_pair_bits,
+                                   const bool share_interchangeable_objects)
+    : NoveltyHeuristic(puzzle.getInitialState().size()) {
+  auto movement_graphs = build_feasible_movement_graphs(puzzle);
+
+  // Since interchangeable objects can be swapped in any state, each of them
+  // can reach every position that any object in its group can reach.
+  const std::vector<std::vector<int>> no_groups;
+  const auto& groups = share_interchangeable_objects
+                           ? puzzle.getInterchangeableObjects()
+                           : no_groups;
+  for (const auto& group : groups) {
+    auto merged_graph = std::make_shared<FeasibleMovementGraph>();
+    for (const int i : group) {
+      m_representatives[i] = group.front();
+      for (const auto& [position, next_positions] : *movement_graphs.at(i)) {
+        (*merged_graph)[position].insert(next_positions.begin(),
+                                         next_positions.end());
+      }
+    }
+    for (const int i : group) {
+      movement_graphs[i] = merged_graph;
+    }
+  }
+
+  m_movement_graphs.reserve(m_state_size);
+  m_visited_position_bits.resize(m_state_size);
+  for (int i = 0; i < m_state_size; i++) {
+    const int r = m_representatives[i];
+    if (r == i) {
+      m_movement_graphs.emplace_back(*movement_graphs.at(i));
+      m_visited_position_bits[i].assign(
+          num_words(m_movement_graphs[i].numNodes()), 0);
+    } else {
+      // Copy the node indices of the representative.
+      m_movement_graphs.push_back(m_movement_graphs[r]);
+    }
+  }
+
+  m_visited_position_pair_bits.resize(m_state_size * m_state_size);
+  for (int r = 0; r < m_state_size; r++) {
+    if (m_representatives[r] != r) {
+      continue;
+    }
+    for (int s = r; s < m_state_size; s++) {
+      if (m_representatives[s] != s) {
+        continue;
+      }
+      const size_t num_bits = size_t(m_movement_graphs[r].numNodes()) *
+                              m_movement_graphs[s].numNodes();
+      if (num_bits <= max_pair_bits) {
+        m_visited_position_pair_bits[r * m_state_size + s].assign(
+            num_words(num_bits), 0);
+      }
+    }
+  }
+
+  m_node_indices.resize(m_state_size);
+}
+
+bool NoveltyHeuristic::visit_position_pair(const int i, const int j,
+                                           const Position2D p_i,
+                                           const Position2D p_j, const int n_i,
+                                           const int n_j) {
+  // Order with smaller representatives first. This reduces memory usage by
+  // half compared to storing both {p_i, p_j} and {p_j, p_i} in the visited
+  // set. Pairs of interchangeable objects are ordered by their positions.
+  const bool swap = m_representatives[i] > m_representatives[j];
+  const int r = m_representatives[swap ? j : i];
+  const int s = m_representatives[swap ? i : j];
+  Position2D p_r = swap ? p_j : p_i;
+  Position2D p_s = swap ? p_i : p_j;
+  int n_r = swap ? n_j : n_i;
+  int n_s = swap ? n_i : n_j;
+
+  if (n_r >= 0 && n_s >= 0) {
+    auto& bits = m_visited_position_pair_bits[r * m_state_size + s];
+    if (!bits.empty()) {
+      if (r == s && n_r > n_s) {
+        std::swap(n_r, n_s);
+      }
+      return test_and_set(bits,
+                          size_t(n_r) * m_movement_graphs[s].numNodes() + n_s);
+    }
+  }
+  if (r == s && p_r > p_s) {
+    std::swap(p_r, p_s);
+  }
+  return m_visited_position_pairs[r][s].insert(PositionPair{p_r, p_s}).second;
 }
 
 float NoveltyHeuristic::estimate_cost_to_goal(
     const RelativeState& relative_state) {
   int j;
   float novelty = 3.0f;
+  const auto& state = relative_state.state;
+
+  // Objects without a node index are only stored in the hash sets.
+  const bool dense = !m_movement_graphs.empty();
+  if (dense) {
+    for (j = 0; j < m_state_size; j++) {
+      m_node_indices[j] = m_movement_graphs[j].getNodeIndex(state[j]);
+    }
+  }
 
   // This loop computes the novelty and updates the set of visited positions.
   // The novelty is 1 if any object is in a position that has never occurred in
@@ -38,34 +181,21 @@ float NoveltyHeuristic::estimate_cost_to_goal(
   // The novelty is 2 if any pair of objects are in a combination of positions
   // that has never occurred in any state previously provided to this method.
   for (const int i : relative_state.moved_object_indices) {
-    const auto& p_i = relative_state.state[i];
+    const auto& p_i = state[i];
+    const int r = m_representatives[i];
+    const int n_i = dense ? m_node_indices[i] : -1;
 
-    if (m_visited_positions[i].insert(p_i).second) {
+    if (n_i >= 0 ? test_and_set(m_visited_position_bits[r], n_i)
+                 : m_visited_positions[r].insert(p_i).second) {
       novelty = 1.0f;
     }
 
-    for (j = 0; j < i; j++) {
-      const auto& p_j = relative_state.state[j];
-
-      // Order with smaller indices first. This reduces memory usage by half
-      // compared to storing both {p_i, p_j} and {p_j, p_i} in the visited set.
-      PositionPair p{p_j, p_i};
-      if (m_visited_position_pairs[j][i].insert(std::move(p)).second) {
-        if (novelty > 2.0f) {
-          novelty = 2.0f;
-        }
+    for (j = 0; j < m_state_size; j++) {
+      if (j == i) {
+        continue;
       }
-    }
-
-    j++;  // skip i==j
-
-    for (; j < m_state_size; j++) {
-      const auto& p_j = relative_state.state[j];
-
-      // Order with smaller indices first. This reduces memory usage by half
-      // compared to storing both {p_i, p_j} and {p_j, p_i} in the visited set.
-      PositionPair p{p_i, p_j};
-      if (m_visited_position_pairs[i][j].insert(std::move(p)).second) {
+      if (visit_position_pair(i, j, p_i, state[j], n_i,
+                              dense ? m_node_indices[j] : -1)) {
         if (novelty > 2.0f) {
           novelty = 2.0f;
         }
@@ -76,5 +206,24 @@ float NoveltyHeuristic::estimate_cost_to_goal(
   return novelty;
 }
 
+size_t NoveltyHeuristic::memory_usage() const {
+  size_t bytes = 0;
+  for (const auto& positions : m_visited_positions) {
+    bytes += hash_set_memory_usage(positions);
+  }
+  for (const auto& row : m_visited_position_pairs) {
+    for (const auto& pairs : row) {
+      bytes += hash_set_memory_usage(pairs);
+    }
+  }
+  for (const auto& bits : m_visited_position_bits) {
+    bytes += bits.capacity() * sizeof(uint64_t);
+  }
+  for (const auto& bits : m_visited_position_pair_bits) {
+    bytes += bits.capacity() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
 }  // namespace heuristic
 }  // namespace pushworld
@@ -17,35 +17,110 @@
 #include <assert.h>
 
 #include <limits>
+#include <map>
 #include <memory>
+#include <optional>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "heuristics/domain_transition_graph.h"
 #include "pushworld_puzzle.h"
+#include "search/search_context.h"
 
 namespace pushworld {
 namespace heuristic {
 
-RecursiveGraphDistanceHeuristic::RecursiveGraphDistanceHeuristic(
-    const std::shared_ptr<PushWorldPuzzle>& puzzle, const bool fewest_tools)
-    : m_puzzle(puzzle),
-      m_movement_graphs(build_feasible_movement_graphs(*puzzle)),
-      m_fewest_tools(fewest_tools) {
-  for (const auto& pair : m_movement_graphs) {
-    m_path_distances.emplace(pair.first, PathDistances(pair.second));
+RecursiveGraphDistanceTables::RecursiveGraphDistanceTables(
+    const PushWorldPuzzle& puzzle, const int num_threads)
+    : m_num_objects(puzzle.getInitialState().size()) {
+  const auto movement_graphs = build_feasible_movement_graphs(puzzle);
+
+  // Distances dominate the cost of building the tables, so the available
+  // threads parallelize the searches within each graph.
+  m_path_distances.reserve(m_num_objects);
+  for (int object_id = 0; object_id < m_num_objects; object_id++) {
+    m_path_distances.emplace_back(*movement_graphs.at(object_id), num_threads);
   }
 
+  const auto& collisions = puzzle.getCompiledCollisions();
+  m_pushing_contacts.resize(NUM_ACTIONS * m_num_objects * m_num_objects);
+
+  for (Action action = 0; action < NUM_ACTIONS; action++) {
+    const DenseMovementGraph::ActionMask action_bit = 1 << action;
+
+    for (int pusher_id = 0; pusher_id < m_num_objects; pusher_id++) {
+      const auto& pusher_graph = getMovementGraph(pusher_id);
+
+      for (int pushee_id = 0; pushee_id < m_num_objects; pushee_id++) {
+        const auto& relative_positions =
+            collisions.getDynamicCollisions(action, pusher_id, pushee_id)
+                .positions();
+        if (pushee_id == pusher_id || relative_positions.empty()) {
+          continue;
+        }
+
+        auto& table =
+            m_pushing_contacts[(action * m_num_objects + pusher_id) *
+                                   m_num_objects +
+                               pushee_id];
+        const auto& pushee_graph = getMovementGraph(pushee_id);
+        const int num_pushee_nodes = pushee_graph.numNodes();
+        table.offsets.reserve(num_pushee_nodes + 1);
+
+        for (int pushee_node = 0; pushee_node < num_pushee_nodes;
+             pushee_node++) {
+          table.offsets.push_back(table.contacts.size());
+          const Position2D pushee_position =
+              pushee_graph.getPosition(pushee_node);
+
+          for (const auto relative_position : relative_positions) {
+            // Check that the pusher does not collide with a static obstacle
+            // while performing the pushing movement.
+            const int pusher_node =
+                pusher_graph.getNodeIndex(pushee_position + relative_position);
+            if (pusher_node >= 0 &&
+                (pusher_graph.getActionMask(pusher_node) & action_bit)) {
+              table.contacts.push_back(pusher_node);
+            }
+          }
+        }
+        table.offsets.push_back(table.contacts.size());
+      }
+    }
+  }
+}
+
+RecursiveGraphDistanceHeuristic::RecursiveGraphDistanceHeuristic(
+    const std::shared_ptr<PushWorldPuzzle>& puzzle, const bool fewest_tools,
+    const size_t pushing_cost_cache_bytes)
+    : RecursiveGraphDistanceHeuristic(
+          puzzle, std::make_shared<RecursiveGraphDistanceTables>(*puzzle),
+          fewest_tools, pushing_cost_cache_bytes){};
+
+RecursiveGraphDistanceHeuristic::RecursiveGraphDistanceHeuristic(
+    const std::shared_ptr<PushWorldPuzzle>& puzzle,
+    const std::shared_ptr<const RecursiveGraphDistanceTables>& tables,
+    const bool fewest_tools, const size_t pushing_cost_cache_bytes)
+    : m_fewest_tools(fewest_tools),
+      m_puzzle(puzzle),
+      m_tables(tables),
+      m_pushing_cost_cache(pushing_cost_cache_bytes),
+      m_context(nullptr),
+      m_calls_until_context_check(CONTEXT_CHECK_INTERVAL),
+      m_stopped(false) {
   // Validate an assumption inside `get_recursive_pushing_cost`.
   assert(AGENT == 0);
 };
 
 float RecursiveGraphDistanceHeuristic::estimate_cost_to_goal(
     const RelativeState& relative_state) {
+  m_stopped = false;
   float cost = 0.0f;
   const auto& goal = m_puzzle->getGoal();
 
-  for (int object_id = 0; object_id < goal.size();) {
+  for (int object_id = 0; object_id < int(goal.size());) {
     const auto goal_position = goal[object_id++];
 
     if (m_fewest_tools) {
@@ -65,6 +140,14 @@ float RecursiveGraphDistanceHeuristic::estimate_cost_to_goal(
   return cost;
 };
 
+void RecursiveGraphDistanceHeuristic::add_counters(
+    std::map<std::string, size_t>& counters) const {
+  const auto& statistics = m_pushing_cost_cache.statistics();
+  counters["rgd_pushing_cost_cache_hits"] += statistics.hits;
+  counters["rgd_pushing_cost_cache_misses"] += statistics.misses;
+  counters["rgd_pushing_cost_cache_evictions"] += statistics.evictions;
+}
+
 float RecursiveGraphDistanceHeuristic::get_goal_cost(
     const State& state, const int object_id, const Position2D goal_position,
     const int pushing_depth) {
@@ -77,17 +160,35 @@ float RecursiveGraphDistanceHeuristic::get_goal_cost(
   float min_cost = std::numeric_limits<float>::infinity();
   const std::unordered_set<int> skipped_object_ids;  // empty set
 
+  const auto& graph = m_tables->getMovementGraph(object_id);
+  const auto& distances = m_tables->getPathDistances(object_id);
+  const int current_node = graph.getNodeIndex(current_position);
+  const int goal_node = graph.getNodeIndex(goal_position);
+  if (current_node < 0 || goal_node < 0) {
+    return min_cost;
+  }
+
   // Consider each feasible movement of the object.
-  for (const auto& effect_position :
-       m_movement_graphs.at(object_id)->at(current_position)) {
+  const auto action_mask = graph.getActionMask(current_node);
+  for (Action action = 0; action < NUM_ACTIONS; action++) {
+    if (!(action_mask & (1 << action))) {
+      continue;
+    }
+
     // Get the distance from the effect position to the goal position.
-    const float goal_distance_cost = m_path_distances.at(object_id).getDistance(
-        effect_position, goal_position);
+    const auto distance = distances.getNodeDistance(
+        graph.getNextNodeIndex(current_node, action), goal_node);
+    if (distance == AllPairsPathDistances::UNREACHABLE) {
+      continue;
+    }
+    const float goal_distance_cost = distance;
 
     if (goal_distance_cost >= min_cost) {
       continue;
     }
 
+    const Position2D effect_position =
+        current_position + ACTION_DISPLACEMENTS[action];
     min_cost = goal_distance_cost +
                get_recursive_pushing_cost(state, object_id, current_position,
                                           effect_position, skipped_object_ids,
@@ -116,6 +217,14 @@ float RecursiveGraphDistanceHeuristic::get_recursive_pushing_cost(
     const Position2D effect_position,
     const std::unordered_set<int>& skipped_object_ids, const int pushing_depth,
     const float cost_upper_bound) {
+  if (m_context != nullptr && --m_calls_until_context_check <= 0) {
+    m_calls_until_context_check = CONTEXT_CHECK_INTERVAL;
+    m_stopped = m_stopped || m_context->check(0) != std::nullopt;
+  }
+  if (m_stopped) {
+    return std::numeric_limits<float>::infinity();
+  }
+
   float min_cost = cost_upper_bound;
 
   std::unordered_set<int> next_skipped_object_ids(skipped_object_ids);
@@ -146,8 +255,10 @@ float RecursiveGraphDistanceHeuristic::get_recursive_pushing_cost(
         get_pushing_costs(pusher_id, pusher_position, object_id,
                           current_position, effect_position);
 
-    for (const auto pair : *pushing_costs) {
-      const float pusher_distance_cost = pair.second;
+    for (Action pusher_action = 0; pusher_action < NUM_ACTIONS;
+         pusher_action++) {
+      // Infinite costs are always skipped.
+      const float pusher_distance_cost = pushing_costs[pusher_action];
       if (pusher_distance_cost >= min_cost) {
         continue;
       }
@@ -163,7 +274,7 @@ float RecursiveGraphDistanceHeuristic::get_recursive_pushing_cost(
         min_cost = pusher_distance_cost +
                    get_recursive_pushing_cost(
                        state, pusher_id, pusher_position,
-                       pair.first,  // pusher_effect_position
+                       pusher_position + ACTION_DISPLACEMENTS[pusher_action],
                        next_skipped_object_ids, pushing_depth - 1,
                        min_cost - pusher_distance_cost);
       }
@@ -173,81 +284,79 @@ float RecursiveGraphDistanceHeuristic::get_recursive_pushing_cost(
   return min_cost;
 }
 
-std::shared_ptr<std::unordered_map<Position2D, float>>
-RecursiveGraphDistanceHeuristic::get_pushing_costs(
+PushingCosts RecursiveGraphDistanceHeuristic::get_pushing_costs(
     const int pusher_id, const Position2D pusher_position, const int pushee_id,
     const Position2D pushee_start_position,
     const Position2D pushee_end_position) {
   PushingCostCacheKey args{pusher_id, pusher_position, pushee_id,
                            pushee_start_position, pushee_end_position};
 
-  const auto cached_costs = m_pushing_cost_cache.find(args);
-  if (cached_costs != m_pushing_cost_cache.end()) {
-    return cached_costs->second;
+  const PushingCosts* cached_costs = m_pushing_cost_cache.find(args);
+  if (cached_costs != nullptr) {
+    return *cached_costs;
   }
 
-  auto costs = std::make_shared<std::unordered_map<Position2D, float>>();
-
-  const float displacement = pushee_end_position - pushee_start_position;
-  const Action action = DISPLACEMENTS_TO_ACTIONS.at(displacement);
-  const auto& collisions = m_puzzle->getObjectCollisions();
-
-  const auto& pusher_graph = m_movement_graphs.at(pusher_id);
-  const auto& pusher_next_positions = pusher_graph->at(pusher_position);
-  const auto& relative_positions =
-      collisions.dynamic_collisions.at(action).at(pusher_id).at(pushee_id);
-
-  // Consider every relative position from which the pusher can push the pushee
-  // to its end position.
-  for (const auto relative_position : relative_positions) {
-    const Position2D pushing_start_position =
-        pushee_start_position + relative_position;
-    const Position2D pushing_end_position =
-        pushing_start_position + displacement;
-
-    const auto& pushing_movements = pusher_graph->find(pushing_start_position);
-
-    // Check that the pusher does not collide with a static obstacle while
-    // performing the pushing movement.
-    if (pushing_movements != pusher_graph->end() &&
-        pushing_movements->second.find(pushing_end_position) !=
-            pushing_movements->second.end()) {
-      /*
-      For all pusher positions that are adjacent to the pusher's current
-      position, compute the graph distance from each adjacent position to the
-      position where the pusher makes contact with the pushee.
-      */
-      for (const auto pusher_next_position : pusher_next_positions) {
-        float distance_cost;
-
-        if (pushing_start_position == pusher_position &&
-            pushing_end_position == pusher_next_position) {
-          // This is a simultaneous push, so there is no cost.
-          distance_cost = 0;
-        } else {
-          distance_cost = m_path_distances.at(pusher_id).getDistance(
-              pusher_next_position, pushing_start_position);
-
-          if (distance_cost == std::numeric_limits<float>::infinity()) {
-            continue;
-          }
+  PushingCosts costs;
+  costs.fill(std::numeric_limits<float>::infinity());
+
+  const Action action =
+      DISPLACEMENTS_TO_ACTIONS.at(pushee_end_position - pushee_start_position);
+
+  const auto& pusher_graph = m_tables->getMovementGraph(pusher_id);
+  const auto& pusher_distances = m_tables->getPathDistances(pusher_id);
+  const int pusher_node = pusher_graph.getNodeIndex(pusher_position);
+  const int pushee_node = m_tables->getMovementGraph(pushee_id).getNodeIndex(
+      pushee_start_position);
+
+  // Find the nodes that are adjacent to the pusher's current position.
+  const auto pusher_action_mask =
+      pusher_node < 0 ? 0 : pusher_graph.getActionMask(pusher_node);
+  int pusher_next_nodes[NUM_ACTIONS];
+  for (Action a = 0; a < NUM_ACTIONS; a++) {
+    if (pusher_action_mask & (1 << a)) {
+      pusher_next_nodes[a] = pusher_graph.getNextNodeIndex(pusher_node, a);
+    }
+  }
 
-          // Add 1 for the cost of the transition.
-          distance_cost += 1;
-        }
+  // Consider every position from which the pusher can push the pushee to its
+  // end position.
+  for (const int contact_node : m_tables->getPushingContacts(
+           action, pusher_id, pushee_id, pushee_node)) {
+    /*
+    For all pusher positions that are adjacent to the pusher's current
+    position, compute the graph distance from each adjacent position to the
+    position where the pusher makes contact with the pushee.
+    */
+    for (Action a = 0; a < NUM_ACTIONS; a++) {
+      if (!(pusher_action_mask & (1 << a))) {
+        continue;
+      }
+
+      float distance_cost;
 
-        const auto best_cost_pair = costs->find(pusher_next_position);
-        if (best_cost_pair == costs->end()) {
-          (*costs)[pusher_next_position] = distance_cost;
-        } else if (distance_cost < best_cost_pair->second) {
-          best_cost_pair->second = distance_cost;
+      if (contact_node == pusher_node && a == action) {
+        // This is a simultaneous push, so there is no cost.
+        distance_cost = 0;
+      } else {
+        const auto distance =
+            pusher_distances.getNodeDistance(pusher_next_nodes[a], contact_node);
+
+        if (distance == AllPairsPathDistances::UNREACHABLE) {
+          continue;
         }
+
+        // Add 1 for the cost of the transition.
+        distance_cost = distance + 1.0f;
+      }
+
+      if (distance_cost < costs[a]) {
+        costs[a] = distance_cost;
       }
     }
   }
 
   // Cache the result.
-  m_pushing_cost_cache[args] = costs;
+  m_pushing_cost_cache.insert(args, costs);
   return costs;
 }
 
@@ -14,6 +14,7 @@
 
 #include "heuristics/weighted_sum.h"
 
+#include <cstddef>
 #include <memory>
 #include <utility>  // pair
 #include <vector>
@@ -46,5 +47,41 @@ float WeightedSumHeuristic::estimate_cost_to_goal(
   return cost;
 }
 
+void WeightedSumHeuristic::estimate_costs(const RelativeState* states,
+                                          const size_t num_states,
+                                          float* costs) {
+  auto it = m_heuristics_and_weights.begin();
+
+  // The first heuristic writes directly into the `costs`, and the costs are
+  // summed in the same order as in `estimate_cost_to_goal`.
+  it->first->estimate_costs(states, num_states, costs);
+  for (size_t i = 0; i < num_states; i++) {
+    costs[i] *= it->second;
+  }
+
+  m_child_costs.resize(num_states);
+  while (++it != m_heuristics_and_weights.end()) {
+    it->first->estimate_costs(states, num_states, m_child_costs.data());
+    for (size_t i = 0; i < num_states; i++) {
+      costs[i] += m_child_costs[i] * it->second;
+    }
+  }
+}
+
+size_t WeightedSumHeuristic::memory_usage() const {
+  size_t bytes = 0;
+  for (const auto& heuristic_and_weight : m_heuristics_and_weights) {
+    bytes += heuristic_and_weight.first->memory_usage();
+  }
+  return bytes;
+}
+
+void WeightedSumHeuristic::set_search_context(
+    const search::SearchContext* context) {
+  for (auto& heuristic_and_weight : m_heuristics_and_weights) {
+    heuristic_and_weight.first->set_search_context(context);
+  }
+}
+
 }  // namespace heuristic
 }  // namespace pushworld
@@ -0,0 +1,47 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace pushworld {
+
+MappedFile::MappedFile(const std::string& filename)
+    : m_data(MAP_FAILED), m_size(0) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::invalid_argument("Unable to open file: " + filename);
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    m_size = file_stat.st_size;
+    m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (m_data == MAP_FAILED) {
+    throw std::invalid_argument("Unable to map file: " + filename);
+  }
+}
+
+MappedFile::~MappedFile() { munmap(m_data, m_size); }
+
+}  // namespace pushworld
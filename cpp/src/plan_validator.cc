@@ -0,0 +1,219 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "plan_validator.h"
+
+#include <algorithm>  // find
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>  // move, swap
+#include <vector>
+
+#include "pushworld_puzzle.h"
+
+namespace fs = std::filesystem;
+
+namespace pushworld {
+
+namespace {
+
+static const std::string YAML_EXTENSION = ".yaml";
+
+/* Returns the action of the 'LRUD' character `c`, or -1 if there is none. */
+int char_to_action(const char c) {
+  const char* end = ACTION_TO_CHAR + NUM_ACTIONS;
+  const char* it = std::find(ACTION_TO_CHAR, end, c);
+  return it == end ? -1 : it - ACTION_TO_CHAR;
+}
+
+/* Returns the `text` without leading and trailing whitespace. */
+std::string_view strip(std::string_view text) {
+  const auto begin = text.find_first_not_of(" \t\r");
+  if (begin == std::string_view::npos) {
+    return std::string_view();
+  }
+  const auto end = text.find_last_not_of(" \t\r");
+  return text.substr(begin, end - begin + 1);
+}
+
+/**
+ * Parses a YAML scalar in the forms that `yaml.dump` and
+ * `pushworld::to_yaml` write. Returns `std::nullopt` for null values.
+ */
+std::optional<std::string> parse_yaml_scalar(std::string_view value,
+                                             const std::string& source) {
+  value = strip(value);
+  if (value.empty() || value == "~" || value == "null") {
+    return std::nullopt;
+  }
+
+  const char quote = value.front();
+  if (quote != '\'' && quote != '"') {
+    // Plain scalars end at a comment.
+    const auto comment = value.find(" #");
+    return std::string(strip(value.substr(0, comment)));
+  }
+
+  std::string scalar;
+  for (size_t i = 1; i < value.size(); i++) {
+    const char c = value[i];
+    if (c == quote) {
+      // Single-quoted scalars escape a quote by repeating it.
+      if (quote == '\'' && i + 1 < value.size() && value[i + 1] == '\'') {
+        scalar += c;
+        i++;
+        continue;
+      }
+      return scalar;
+    }
+    if (quote == '"' && c == '\\' && i + 1 < value.size()) {
+      scalar += value[++i];
+      continue;
+    }
+    scalar += c;
+  }
+  throw std::invalid_argument("Unterminated YAML string: " + source);
+}
+
+/* Reads the plan of a YAML result or solution file. */
+std::vector<PlanRecord> read_yaml_plan(std::ifstream& file,
+                                       const std::string& filename) {
+  std::optional<std::string> puzzle;
+  std::optional<std::string> plan;
+  size_t plan_line = 0;
+
+  std::string line;
+  for (size_t line_number = 1; std::getline(file, line); line_number++) {
+    // Only top-level keys are read.
+    if (line.empty() || line.front() == '#' || line.front() == ' ') {
+      continue;
+    }
+    const auto colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    const std::string_view key = std::string_view(line).substr(0, colon);
+    const std::string source = filename + ":" + std::to_string(line_number);
+    if (key == "puzzle") {
+      puzzle = parse_yaml_scalar(line.substr(colon + 1), source);
+    } else if (key == "plan") {
+      plan = parse_yaml_scalar(line.substr(colon + 1), source);
+      plan_line = line_number;
+    }
+  }
+
+  std::vector<PlanRecord> records;
+  if (plan != std::nullopt) {
+    if (puzzle == std::nullopt) {
+      throw std::invalid_argument("Missing puzzle name: " + filename);
+    }
+    records.push_back(PlanRecord{std::move(*puzzle), std::move(*plan),
+                                 filename + ":" + std::to_string(plan_line)});
+  }
+  return records;
+}
+
+/* Reads a text file that contains one puzzle name and plan per line. */
+std::vector<PlanRecord> read_text_plans(std::ifstream& file,
+                                        const std::string& filename) {
+  std::vector<PlanRecord> records;
+  std::string line;
+  for (size_t line_number = 1; std::getline(file, line); line_number++) {
+    const std::string_view text = strip(line);
+    if (text.empty()) {
+      continue;
+    }
+    const std::string source = filename + ":" + std::to_string(line_number);
+    const auto separator = text.find_last_of(" \t");
+    if (separator == std::string_view::npos) {
+      throw std::invalid_argument("Expected a puzzle name and a plan: " +
+                                  source);
+    }
+    records.push_back(PlanRecord{std::string(strip(text.substr(0, separator))),
+                                 std::string(text.substr(separator + 1)),
+                                 source});
+  }
+  return records;
+}
+
+}  // namespace
+
+std::optional<Plan> parse_plan(const std::string_view plan_string) {
+  Plan plan;
+  plan.reserve(plan_string.size());
+  for (const char c : plan_string) {
+    const int action = char_to_action(c);
+    if (action < 0) {
+      return std::nullopt;
+    }
+    plan.push_back(action);
+  }
+  return plan;
+}
+
+std::vector<PlanRecord> read_plan_file(const std::string& filename) {
+  std::ifstream file(filename);
+  if (!file) {
+    throw std::invalid_argument("Unable to read the plan file: " + filename);
+  }
+  if (fs::path(filename).extension() == YAML_EXTENSION) {
+    return read_yaml_plan(file, filename);
+  }
+  return read_text_plans(file, filename);
+}
+
+PlanValidation PlanValidator::validate(const PushWorldPuzzle& puzzle,
+                                       const std::string_view plan,
+                                       const bool record_trace) {
+  PlanValidation result;
+  if (record_trace) {
+    result.trace.reserve(plan.size());
+  }
+
+  // `assign` reuses the memory of the previous plan.
+  const State& initial_state = puzzle.getInitialState();
+  m_state.assign(initial_state.begin(), initial_state.end());
+
+  for (size_t t = 0; t < plan.size(); t++) {
+    const int action = char_to_action(plan[t]);
+    if (action < 0) {
+      result.failure_reason = "invalid action '" + std::string(1, plan[t]) +
+                              "' at step " + std::to_string(t);
+      return result;
+    }
+
+    // Alternate between two buffers, as in `PushWorldPuzzle::isValidPlan`.
+    if (puzzle.getNextState(m_state, action, m_next, m_scratch)) {
+      std::swap(m_state, m_next.state);
+      result.num_moving_actions++;
+    }
+    if (record_trace) {
+      result.trace.push_back(m_next.moved_object_indices);
+    }
+  }
+
+  result.valid = puzzle.satisfiesGoal(m_state);
+  if (!result.valid) {
+    result.failure_reason = "goal not reached";
+  }
+  return result;
+}
+
+}  // namespace pushworld
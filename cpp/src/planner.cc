@@ -0,0 +1,377 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "planner.h"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>  // pair
+#include <vector>
+
+#include "heuristics/dead_end_detector.h"
+#include "heuristics/lexicographic.h"
+#include "heuristics/novelty.h"
+#include "heuristics/recursive_graph_distance.h"
+#include "pushworld_puzzle.h"
+#include "search/anytime_search.h"
+#include "search/best_first_search.h"
+#include "search/external_best_first_search.h"
+#include "search/packed_state_set.h"
+#include "search/parallel_best_first_search.h"
+#include "search/priority_queue.h"
+#include "search/search.h"
+#include "search/search_context.h"
+#include "search/search_statistics.h"
+
+namespace pushworld {
+
+namespace {
+
+/* Solves the puzzle with `parallel_best_first_search`. See `solve`. */
+search::SearchResult solve_in_parallel(
+    const std::shared_ptr<PushWorldPuzzle> puzzle, const std::string& mode,
+    const int num_threads, const search::SearchContext& context,
+    search::SearchStatistics* statistics, const bool canonicalize_objects) {
+  using search::PackedStateSet;
+
+  // All threads share the same read-only RGD tables, which are built in
+  // parallel, and the same dead end detector.
+  const auto tables =
+      std::make_shared<const heuristic::RecursiveGraphDistanceTables>(
+          *puzzle, num_threads);
+  const heuristic::DeadEndDetector dead_ends(*puzzle);
+
+  if (mode == "RGD") {
+    return search::parallel_best_first_search<float>(
+        *puzzle,
+        [&]() {
+          return std::make_unique<heuristic::RecursiveGraphDistanceHeuristic>(
+              puzzle, tables);
+        },
+        [&]() {
+          return std::make_unique<priority_queue::IntegerBucketPriorityQueue<
+              PackedStateSet::Index, float>>();
+        },
+        num_threads, context, statistics, &dead_ends, canonicalize_objects);
+  } else if (mode == "N+RGD") {
+    using Cost = std::pair<float, float>;
+    return search::parallel_best_first_search<Cost>(
+        *puzzle,
+        [&]() {
+          return std::make_unique<heuristic::LexicographicHeuristic>(
+              std::make_shared<heuristic::NoveltyHeuristic>(
+                  *puzzle, heuristic::NoveltyHeuristic::DEFAULT_MAX_PAIR_BITS,
+                  canonicalize_objects),
+              std::make_shared<heuristic::RecursiveGraphDistanceHeuristic>(
+                  puzzle, tables));
+        },
+        [&]() {
+          return std::make_unique<priority_queue::IntegerBucketPriorityQueue<
+              PackedStateSet::Index, Cost>>();
+        },
+        num_threads, context, statistics, &dead_ends, canonicalize_objects);
+  } else {
+    throw std::domain_error("Unrecognized mode: " + mode);
+  }
+}
+
+/* Throws `std::domain_error` if the `mode` is neither "RGD" nor "N+RGD". */
+void check_mode(const std::string& mode) {
+  if (mode != "RGD" && mode != "N+RGD") {
+    throw std::domain_error("Unrecognized mode: " + mode);
+  }
+}
+
+/**
+ * Runs `best_first_search` with the configuration of the `member`, using the
+ * given RGD `tables` and `dead_ends`, which are shared by all searches of a
+ * portfolio. See `solve`.
+ */
+search::SearchResult run_best_first_search(
+    const std::shared_ptr<PushWorldPuzzle>& puzzle,
+    const PortfolioMember& member,
+    const std::shared_ptr<const heuristic::RecursiveGraphDistanceTables>&
+        tables,
+    const heuristic::DeadEndDetector& dead_ends,
+    const search::SearchContext& context,
+    search::SearchStatistics* statistics) {
+  search::PackedStateSet visited{search::StatePacker(*puzzle)};
+  search::SearchNodeStore nodes;
+  auto rgd = std::make_shared<heuristic::RecursiveGraphDistanceHeuristic>(
+      puzzle, tables, member.fewest_tools);
+
+  // Runs the eager or lazy search with the given heuristic and frontier.
+  const auto search = [&](auto& heuristic, auto& frontier) {
+    return member.lazy_evaluation
+               ? search::lazy_best_first_search(
+                     *puzzle, heuristic, frontier, visited, nodes, context,
+                     statistics, &dead_ends, member.action_seed,
+                     member.canonicalize_objects)
+               : search::best_first_search(
+                     *puzzle, heuristic, frontier, visited, nodes, context,
+                     statistics, &dead_ends, member.action_seed,
+                     member.canonicalize_objects);
+  };
+
+  // All RGD and novelty heuristic values are either integers or infinite.
+  if (member.mode == "RGD") {
+    priority_queue::IntegerBucketPriorityQueue<search::NodeId, float> frontier;
+    return search(*rgd, frontier);
+  } else if (member.mode == "N+RGD") {
+    priority_queue::IntegerBucketPriorityQueue<search::NodeId,
+                                               std::pair<float, float>>
+        frontier;
+    heuristic::LexicographicHeuristic heuristic(
+        std::make_shared<heuristic::NoveltyHeuristic>(
+            *puzzle, heuristic::NoveltyHeuristic::DEFAULT_MAX_PAIR_BITS,
+            member.canonicalize_objects),
+        rgd);
+    return search(heuristic, frontier);
+  } else {
+    throw std::domain_error("Unrecognized mode: " + member.mode);
+  }
+}
+
+}  // namespace
+
+std::optional<Plan> solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
+                          const std::string& mode, const int num_threads,
+                          search::SearchStatistics* statistics) {
+  const search::SearchContext unlimited;
+  return solve(puzzle, mode, num_threads, unlimited, statistics).plan;
+}
+
+search::SearchResult solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
+                           const std::string& mode, const int num_threads,
+                           const search::SearchContext& context,
+                           search::SearchStatistics* statistics,
+                           const bool canonicalize_objects) {
+  if (num_threads > 1 && mode != "PORTFOLIO") {
+    return solve_in_parallel(puzzle, mode, num_threads, context, statistics,
+                             canonicalize_objects);
+  }
+  if (mode == "PORTFOLIO") {
+    auto portfolio = default_portfolio();
+    for (auto& member : portfolio) {
+      member.canonicalize_objects = canonicalize_objects;
+    }
+    return solve_portfolio(puzzle, portfolio, context, statistics);
+  }
+  PortfolioMember member{mode};
+  member.canonicalize_objects = canonicalize_objects;
+  return solve(puzzle, member, context, statistics);
+}
+
+search::SearchResult solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
+                           const std::string& mode,
+                           const search::SearchContext& context,
+                           search::SearchStatistics* statistics) {
+  if (mode == "PORTFOLIO") {
+    return solve_portfolio(puzzle, default_portfolio(), context, statistics);
+  }
+  return solve(puzzle, PortfolioMember{mode}, context, statistics);
+}
+
+search::SearchResult solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
+                           const PortfolioMember& member,
+                           const search::SearchContext& context,
+                           search::SearchStatistics* statistics) {
+  check_mode(member.mode);
+
+  const auto tables =
+      std::make_shared<const heuristic::RecursiveGraphDistanceTables>(*puzzle);
+  const heuristic::DeadEndDetector dead_ends(*puzzle);
+  return run_best_first_search(puzzle, member, tables, dead_ends, context,
+                               statistics);
+}
+
+search::SearchResult solve_external(
+    const std::shared_ptr<PushWorldPuzzle> puzzle, const std::string& mode,
+    const search::ExternalSearchOptions& options,
+    const search::SearchContext& context,
+    search::SearchStatistics* statistics, const bool canonicalize_objects) {
+  check_mode(mode);
+
+  const heuristic::DeadEndDetector dead_ends(*puzzle);
+  auto rgd = std::make_shared<heuristic::RecursiveGraphDistanceHeuristic>(
+      puzzle,
+      std::make_shared<const heuristic::RecursiveGraphDistanceTables>(*puzzle));
+
+  if (mode == "RGD") {
+    return search::external_best_first_search(*puzzle, *rgd, options, context,
+                                              statistics, &dead_ends,
+                                              canonicalize_objects);
+  }
+  heuristic::LexicographicHeuristic heuristic(
+      std::make_shared<heuristic::NoveltyHeuristic>(
+          *puzzle, heuristic::NoveltyHeuristic::DEFAULT_MAX_PAIR_BITS,
+          canonicalize_objects),
+      rgd);
+  return search::external_best_first_search(*puzzle, heuristic, options,
+                                            context, statistics, &dead_ends,
+                                            canonicalize_objects);
+}
+
+std::vector<PortfolioMember> default_portfolio() {
+  return {{"RGD"}, {"N+RGD"}, {"RGD", false}, {"N+RGD", true, 7}};
+}
+
+search::SearchResult solve_portfolio(
+    const std::shared_ptr<PushWorldPuzzle> puzzle,
+    const std::vector<PortfolioMember>& portfolio,
+    const search::SearchContext& context,
+    search::SearchStatistics* statistics) {
+  using Clock = std::chrono::steady_clock;
+  using search::SearchStatus;
+
+  if (portfolio.empty()) {
+    throw std::invalid_argument("The portfolio must have at least one member");
+  }
+  for (const auto& member : portfolio) {
+    check_mode(member.mode);
+  }
+  const int num_members = portfolio.size();
+
+  const auto tables =
+      std::make_shared<const heuristic::RecursiveGraphDistanceTables>(
+          *puzzle, num_members);
+  const heuristic::DeadEndDetector dead_ends(*puzzle);
+
+  // Each search has a child of the `context`, so that the first search to
+  // finish can cancel the others without cancelling the `context`.
+  std::vector<std::unique_ptr<search::SearchContext>> contexts;
+  for (int i = 0; i < num_members; i++) {
+    contexts.push_back(std::make_unique<search::SearchContext>(&context));
+    contexts.back()->setMemoryLimit(context.memoryLimit() / num_members);
+  }
+
+  std::vector<search::SearchResult> results(num_members);
+  std::vector<search::SearchStatistics> member_statistics(num_members);
+  std::vector<std::exception_ptr> exceptions(num_members);
+  std::atomic<int> winner(-1);
+
+  const auto cancel_others = [&](const int id) {
+    for (int i = 0; i < num_members; i++) {
+      if (i != id) {
+        contexts[i]->cancel();
+      }
+    }
+  };
+
+  const Clock::time_point start = Clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_members; i++) {
+    threads.emplace_back([&, i]() {
+      try {
+        results[i] = run_best_first_search(
+            puzzle, portfolio[i], tables, dead_ends, *contexts[i],
+            statistics == nullptr ? nullptr : &member_statistics[i]);
+        const SearchStatus status = results[i].status;
+        int no_winner = -1;
+        if ((status == SearchStatus::SOLVED ||
+             status == SearchStatus::NO_SOLUTION) &&
+            winner.compare_exchange_strong(no_winner, i)) {
+          cancel_others(i);
+        }
+      } catch (...) {
+        exceptions[i] = std::current_exception();
+        cancel_others(i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (const auto& exception : exceptions) {
+    if (exception != nullptr) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+  if (statistics != nullptr) {
+    *statistics = search::SearchStatistics();
+    for (const auto& member : member_statistics) {
+      statistics->expansions += member.expansions;
+      statistics->generations += member.generations;
+      statistics->duplicates += member.duplicates;
+      statistics->evaluations += member.evaluations;
+      statistics->dead_ends += member.dead_ends;
+      statistics->max_frontier_size += member.max_frontier_size;
+      statistics->heuristic_seconds += member.heuristic_seconds;
+      statistics->successor_seconds += member.successor_seconds;
+      for (const auto& counter : member.heuristic_counters) {
+        statistics->heuristic_counters[counter.first] += counter.second;
+      }
+    }
+    statistics->total_seconds = search::seconds_between(start, Clock::now());
+  }
+
+  if (winner >= 0) {
+    return std::move(results[winner]);
+  }
+  if (context.cancelled()) {
+    return {SearchStatus::CANCELLED, std::nullopt};
+  }
+  for (const auto& result : results) {
+    if (result.status == SearchStatus::MEMORY_LIMIT) {
+      return {SearchStatus::MEMORY_LIMIT, std::nullopt};
+    }
+  }
+  return {SearchStatus::TIME_LIMIT, std::nullopt};
+}
+
+std::optional<Plan> solve_anytime(
+    const std::shared_ptr<PushWorldPuzzle> puzzle, const std::string& mode,
+    const search::AnytimeSearchOptions& options,
+    search::SearchStatistics* statistics, const bool canonicalize_objects) {
+  // In the N+RGD mode, weighted A* uses a separate RGD heuristic from the
+  // lexicographic heuristic so that their counters are reported separately.
+  // Both share the same tables.
+  const auto tables =
+      std::make_shared<const heuristic::RecursiveGraphDistanceTables>(*puzzle);
+  auto rgd = std::make_shared<heuristic::RecursiveGraphDistanceHeuristic>(
+      puzzle, tables);
+  const heuristic::DeadEndDetector dead_ends(*puzzle);
+
+  if (mode == "RGD") {
+    priority_queue::IntegerBucketPriorityQueue<search::NodeId, float> frontier;
+    return search::anytime_search(*puzzle, *rgd, frontier, *rgd, options,
+                                  statistics, &dead_ends,
+                                  canonicalize_objects);
+  } else if (mode == "N+RGD") {
+    priority_queue::IntegerBucketPriorityQueue<search::NodeId,
+                                               std::pair<float, float>>
+        frontier;
+    heuristic::LexicographicHeuristic heuristic(
+        std::make_shared<heuristic::NoveltyHeuristic>(
+            *puzzle, heuristic::NoveltyHeuristic::DEFAULT_MAX_PAIR_BITS,
+            canonicalize_objects),
+        std::make_shared<heuristic::RecursiveGraphDistanceHeuristic>(puzzle,
+                                                                     tables));
+    return search::anytime_search(*puzzle, heuristic, frontier, *rgd, options,
+                                  statistics, &dead_ends,
+                                  canonicalize_objects);
+  } else {
+    throw std::domain_error("Unrecognized mode: " + mode);
+  }
+}
+
+}  // namespace pushworld
@@ -0,0 +1,134 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "pushworld_env.h"
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "batched_env.h"
+#include "pushworld_puzzle.h"
+
+using pushworld::BatchedPushWorldEnv;
+
+static_assert(std::is_same<pushworld::Action, int32_t>::value &&
+                  std::is_same<pushworld::Position2D, int32_t>::value,
+              "The C interface requires 32-bit actions and positions.");
+
+namespace {
+
+thread_local std::string last_error;
+
+/* Loads a puzzle in .pwp format or in the compiled format. */
+std::shared_ptr<const pushworld::PushWorldPuzzle> load_puzzle(
+    const std::string& path) {
+  const std::string extension = pushworld::COMPILED_PUZZLE_EXTENSION;
+  if (path.size() >= extension.size() &&
+      path.compare(path.size() - extension.size(), extension.size(),
+                   extension) == 0) {
+    return std::make_shared<pushworld::PushWorldPuzzle>(
+        pushworld::PushWorldPuzzle::loadCompiled(path));
+  }
+  return std::make_shared<pushworld::PushWorldPuzzle>(path);
+}
+
+/* Calls `function`, converting exceptions into a return value of -1. */
+template <typename Function>
+int call(Function function) {
+  try {
+    function();
+    return 0;
+  } catch (std::exception& e) {
+    last_error = e.what();
+  } catch (...) {
+    last_error = "Unknown error";
+  }
+  return -1;
+}
+
+const BatchedPushWorldEnv& cast(const void* env) {
+  return *static_cast<const BatchedPushWorldEnv*>(env);
+}
+
+BatchedPushWorldEnv& cast(void* env) {
+  return *static_cast<BatchedPushWorldEnv*>(env);
+}
+
+}  // namespace
+
+const char* pushworld_env_last_error(void) { return last_error.c_str(); }
+
+void* pushworld_env_create(const char* const* puzzle_paths,
+                           const int num_puzzles, const int num_envs,
+                           const int max_steps, const int auto_reset,
+                           const int height_cells, const int width_cells,
+                           const int pixels_per_cell, const int border_width,
+                           const uint64_t seed) {
+  BatchedPushWorldEnv* env = nullptr;
+  call([&]() {
+    std::vector<std::shared_ptr<const pushworld::PushWorldPuzzle>> puzzles;
+    for (int i = 0; i < num_puzzles; i++) {
+      puzzles.push_back(load_puzzle(puzzle_paths[i]));
+    }
+    env = new BatchedPushWorldEnv(puzzles, num_envs, max_steps, auto_reset,
+                                  height_cells, width_cells, pixels_per_cell,
+                                  border_width, seed);
+  });
+  return env;
+}
+
+void pushworld_env_destroy(void* env) {
+  delete static_cast<BatchedPushWorldEnv*>(env);
+}
+
+int pushworld_env_num_envs(const void* env) { return cast(env).getNumEnvs(); }
+
+void pushworld_env_observation_shape(const void* env, int* height,
+                                     int* width) {
+  *height = cast(env).getObservationHeight();
+  *width = cast(env).getObservationWidth();
+}
+
+int pushworld_env_state_size(const void* env) {
+  return cast(env).getStateSize();
+}
+
+const int32_t* pushworld_env_states(const void* env) {
+  return cast(env).getStates();
+}
+
+const int32_t* pushworld_env_puzzle_indices(const void* env) {
+  return cast(env).getPuzzleIndices();
+}
+
+int pushworld_env_reset(void* env, float* observations) {
+  return call([&]() { cast(env).reset(observations); });
+}
+
+int pushworld_env_reset_env(void* env, const int index, const int puzzle_index,
+                            float* observation) {
+  return call([&]() { cast(env).resetEnv(index, puzzle_index, observation); });
+}
+
+int pushworld_env_step(void* env, const int32_t* actions, float* observations,
+                       double* rewards, uint8_t* terminated,
+                       uint8_t* truncated) {
+  return call([&]() {
+    cast(env).step(actions, observations, rewards, terminated, truncated);
+  });
+}
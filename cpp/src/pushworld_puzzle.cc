@@ -14,14 +14,27 @@
 
 #include "pushworld_puzzle.h"
 
-#include <algorithm>  // min, max
-#include <boost/algorithm/string.hpp>
+#include <algorithm>  // all_of, min, max, sort, unique
+#include <array>
+#include <cctype>     // tolower
+#include <climits>    // INT_MIN, INT_MAX
+#include <cstdint>
+#include <cstring>  // memcmp
 #include <fstream>
 #include <map>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_set>
+#include <utility>  // swap
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>  // SSE2 intrinsics
+#endif
+
+#include "mapped_file.h"
+
 namespace pushworld {
 
 // A private namespace to not expose this code
@@ -37,6 +50,9 @@ struct Point {
   bool operator==(const Point& other) const {
     return this->x == other.x && this->y == other.y;
   }
+  bool operator<(const Point& other) const {
+    return this->x < other.x || (this->x == other.x && this->y < other.y);
+  }
   Point operator+(const Point& other) const {
     return Point{this->x + other.x, this->y + other.y};
   }
@@ -47,19 +63,22 @@ struct Point {
   Point operator-() const { return Point{-this->x, -this->y}; }
 };
 
-struct PointHash {
-  std::size_t operator()(const Point& p) const {
-    std::size_t seed = 0;
-    boost::hash_combine(seed, p.x);
-    boost::hash_combine(seed, p.y);
-    return seed;
-  }
-};
-
-using PointSet = std::unordered_set<Point, PointHash>;
+// The pixels of an object, in increasing order without duplicates once
+// `sortPixels` is called.
+using Pixels = std::vector<Point>;
 
 int point_to_position(const Point& p) { return p.x * POSITION_LIMIT + p.y; };
 
+/* Converts the pixels of an object into positions, preserving their order. */
+std::vector<Position2D> pixels_to_positions(const Pixels& pixels) {
+  std::vector<Position2D> positions;
+  positions.reserve(pixels.size());
+  for (const auto& pixel : pixels) {
+    positions.push_back(point_to_position(pixel));
+  }
+  return positions;
+};
+
 static const Point POINT_DISPLACEMENTS[] = {
     // (0,0) is top left
     Point{-1, 0},  // LEFT
@@ -68,7 +87,13 @@ static const Point POINT_DISPLACEMENTS[] = {
     Point{0, 1}    // DOWN
 };
 
-Point getObjectPosition(const PointSet& pixels) {
+/* Sorts the pixels and removes duplicates. */
+void sortPixels(Pixels& pixels) {
+  std::sort(pixels.begin(), pixels.end());
+  pixels.erase(std::unique(pixels.begin(), pixels.end()), pixels.end());
+};
+
+Point getObjectPosition(const Pixels& pixels) {
   Point position{INT_MAX, INT_MAX};
   for (const auto& pixel : pixels) {
     position.x = std::min(pixel.x, position.x);
@@ -77,7 +102,7 @@ Point getObjectPosition(const PointSet& pixels) {
   return position;
 };
 
-Point getObjectSize(const PointSet& pixels) {
+Point getObjectSize(const Pixels& pixels) {
   Point size{0, 0};
   for (const auto& pixel : pixels) {
     size.x = std::max(pixel.x + 1, size.x);
@@ -87,29 +112,71 @@ Point getObjectSize(const PointSet& pixels) {
 };
 
 /* Subtracts the position from the pixels. */
-PointSet offsetObjectPixels(PointSet& pixels, Point position) {
-  PointSet offset;
-  for (const auto& pixel : pixels) {
-    offset.insert(pixel - position);
+void offsetObjectPixels(Pixels& pixels, const Point& position) {
+  for (auto& pixel : pixels) {
+    pixel = pixel - position;
   }
-  return offset;
 };
 
 /**
- * After adding the `offset` to all points in `s1`, returns whether any of the
- * resulting points occur in `s2`.
+ * A dense bitmap of the pixels of an object within their bounding box, which
+ * answers membership queries without hashing.
  */
-bool pointsOverlap(const PointSet& s1, const PointSet& s2,
-                   const Point& offset) {
-  for (const auto& p : s1)
-    if (s2.find(offset + p) != s2.end()) return true;
-  return false;
+class PixelGrid {
+ private:
+  Point m_min;
+  Point m_max;
+  int m_height;
+  std::vector<bool> m_cells;
+
+ public:
+  explicit PixelGrid(const Pixels& pixels)
+      : m_min{INT_MAX, INT_MAX}, m_max{INT_MIN, INT_MIN} {
+    for (const auto& pixel : pixels) {
+      m_min.x = std::min(pixel.x, m_min.x);
+      m_min.y = std::min(pixel.y, m_min.y);
+      m_max.x = std::max(pixel.x, m_max.x);
+      m_max.y = std::max(pixel.y, m_max.y);
+    }
+    if (pixels.empty()) {
+      m_height = 0;
+      return;
+    }
+
+    m_height = m_max.y - m_min.y + 1;
+    m_cells.resize((m_max.x - m_min.x + 1) * m_height, false);
+    for (const auto& pixel : pixels) {
+      m_cells[(pixel.x - m_min.x) * m_height + (pixel.y - m_min.y)] = true;
+    }
+  };
+
+  /* Returns whether this grid contains no pixels. */
+  bool empty() const { return m_cells.empty(); };
+
+  /* Returns the minimum X and Y values of all pixels. */
+  const Point& min() const { return m_min; };
+
+  /* Returns the maximum X and Y values of all pixels. */
+  const Point& max() const { return m_max; };
+
+  bool contains(const Point& p) const {
+    return p.x >= m_min.x && p.y >= m_min.y && p.x <= m_max.x &&
+           p.y <= m_max.y &&
+           m_cells[(p.x - m_min.x) * m_height + (p.y - m_min.y)];
+  };
 };
 
 /**
  * Computes all positions of a "pusher" object relative to a "pushee" object
  * such that moving the pusher according to the `action` results in a collision
- * with the pushee.
+ * with the pushee, considering only relative positions in the box from `lower`
+ * to `upper` (inclusive).
+ *
+ * A relative position is a collision if the moved pusher overlaps the pushee
+ * and the unmoved pusher does not. Every relative position in which the moved
+ * pusher overlaps the pushee lies within the bounding box of the pushee minus
+ * the bounding box of the pusher, so candidates are only tested within that
+ * box.
  *
  * @param[out] collisions This set is updated to include the positions of the
  * pusher relative to the pushee that result in collisions.
@@ -117,26 +184,63 @@ bool pointsOverlap(const PointSet& s1, const PointSet& s2,
  * pusher.
  * @param[in] pusher_pixels The set of all pixels in the pusher object. These
  * pixel positions are measured in the frame of the pusher.
- * @param[in] pushee_pixels The set of all pixels in the pushee object. These
- * pixel positions are measured in the frame of the pushee.
+ * @param[in] pushee_grid The pixels of the pushee object, measured in the frame
+ * of the pushee.
  */
 void populateCollisions(std::unordered_set<Position2D>& collisions,
-                        const int action, const PointSet& pusher_pixels,
-                        const PointSet& pushee_pixels) {
-  const Point displacement = POINT_DISPLACEMENTS[action];
-  PointSet relative_positions;
-
-  for (const auto& pusher_px : pusher_pixels) {
-    for (const auto& pushee_px : pushee_pixels)
-      relative_positions.insert(pushee_px - (pusher_px + displacement));
+                        const int action, const Pixels& pusher_pixels,
+                        const PixelGrid& pushee_grid, Point lower,
+                        Point upper) {
+  if (pusher_pixels.empty() || pushee_grid.empty()) {
+    return;
   }
 
-  for (const auto& relative_position : relative_positions) {
-    if (!pointsOverlap(pusher_pixels, pushee_pixels, relative_position))
-      collisions.insert(point_to_position(relative_position));
+  // The bounding box of all relative positions in which the moved pusher
+  // overlaps the pushee.
+  const Point displacement = POINT_DISPLACEMENTS[action];
+  const Point pusher_min = getObjectPosition(pusher_pixels);
+  const Point pusher_max = getObjectSize(pusher_pixels) - Point{1, 1};
+  const Point overlap_min = pushee_grid.min() - pusher_max - displacement;
+  const Point overlap_max = pushee_grid.max() - pusher_min - displacement;
+
+  lower.x = std::max(lower.x, overlap_min.x);
+  lower.y = std::max(lower.y, overlap_min.y);
+  upper.x = std::min(upper.x, overlap_max.x);
+  upper.y = std::min(upper.y, overlap_max.y);
+
+  Point relative_position;
+  for (relative_position.x = lower.x; relative_position.x <= upper.x;
+       relative_position.x++) {
+    for (relative_position.y = lower.y; relative_position.y <= upper.y;
+         relative_position.y++) {
+      bool hits = false;
+      bool overlaps = false;
+      for (const auto& pusher_px : pusher_pixels) {
+        const Point p = pusher_px + relative_position;
+        if (pushee_grid.contains(p)) {
+          overlaps = true;
+          break;
+        }
+        hits = hits || pushee_grid.contains(p + displacement);
+      }
+      if (hits && !overlaps) {
+        collisions.insert(point_to_position(relative_position));
+      }
+    }
   }
 };
 
+/**
+ * Identical to `populateCollisions` without bounds on relative positions.
+ */
+void populateCollisions(std::unordered_set<Position2D>& collisions,
+                        const int action, const Pixels& pusher_pixels,
+                        const PixelGrid& pushee_grid) {
+  populateCollisions(collisions, action, pusher_pixels, pushee_grid,
+                     Point{INT_MIN / 2, INT_MIN / 2},
+                     Point{INT_MAX / 2, INT_MAX / 2});
+};
+
 /**
  * This function is identical to `populateCollisions` except for applying an
  * additional constraint that all of the pusher's pixels must satisfy `0 <= x <
@@ -145,32 +249,196 @@ void populateCollisions(std::unordered_set<Position2D>& collisions,
  * `action`.
  */
 void populateBoundedCollisions(std::unordered_set<Position2D>& collisions,
-                               const int action, const PointSet& pusher_pixels,
-                               const PointSet& pushee_pixels, const int width,
+                               const int action, const Pixels& pusher_pixels,
+                               const PixelGrid& pushee_grid, const int width,
                                const int height) {
-  const Point displacement = POINT_DISPLACEMENTS[action];
-  PointSet relative_positions;
-
   // Note that if the pusher has size 1, `max_x` will be `width - 1`, so the
   // inequality `x <= max_x` is equivalent to `x < width` for integer values.
   const Point pusher_size = getObjectSize(pusher_pixels);
   const auto max_x = width - pusher_size.x;
   const auto max_y = height - pusher_size.y;
 
-  for (const auto& pusher_px : pusher_pixels) {
-    for (const auto& pushee_px : pushee_pixels)
-      relative_positions.insert(pushee_px - (pusher_px + displacement));
-  }
+  populateCollisions(collisions, action, pusher_pixels, pushee_grid,
+                     Point{0, 0}, Point{max_x, max_y});
+};
+
+/**
+ * Increases the `width` and `height` as needed so that they are exclusive upper
+ * bounds on the X and Y values of the position `p`, with a margin of one
+ * additional position. The margin accounts for static obstacles beyond `p`.
+ */
+void expandBounds(const Position2D p, int& width, int& height) {
+  const int x = p / POSITION_LIMIT;
+  const int y = p % POSITION_LIMIT;
+  width = std::max(x + 2, width);
+  height = std::max(y + 2, height);
+};
+
+/* Returns whether `c` separates elements in a row of a puzzle file. */
+bool isSpace(const char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+};
 
-  for (const auto& relative_position : relative_positions) {
-    if (relative_position.x >= 0 && relative_position.y >= 0 &&
-        relative_position.x <= max_x && relative_position.y <= max_y &&
-        !pointsOverlap(pusher_pixels, pushee_pixels, relative_position)) {
-      collisions.insert(point_to_position(relative_position));
+/**
+ * Parses the contents of a PushWorld puzzle file, adding the pixels of every
+ * element to `obj_pixels`. Element IDs are converted to lowercase. Empty lines
+ * are ignored.
+ *
+ * @param[out] num_columns The number of elements in every row.
+ * @param[out] num_rows The number of non-empty rows.
+ */
+void parsePuzzle(const std::string_view text,
+                 std::map<std::string, Pixels>& obj_pixels, int& num_columns,
+                 int& num_rows) {
+  std::string elem_id;
+  const char* c = text.data();
+  const char* const end = c + text.size();
+
+  num_columns = 0;
+  num_rows = 0;
+
+  while (c != end) {
+    const int y = num_rows + 1;
+    int x = 0;
+
+    // Parse one line.
+    while (c != end && *c != '\n') {
+      if (isSpace(*c)) {
+        c++;
+        continue;
+      }
+
+      // Parse one cell, which contains elements separated by '+'.
+      x++;
+      while (c != end && *c != '\n' && !isSpace(*c)) {
+        if (*c == '+') {
+          c++;
+          continue;
+        }
+
+        elem_id.clear();
+        while (c != end && *c != '\n' && *c != '+' && !isSpace(*c)) {
+          elem_id.push_back(std::tolower(static_cast<unsigned char>(*c)));
+          c++;
+        }
+        if (elem_id != ".") {
+          auto pixels = obj_pixels.find(elem_id);
+          if (pixels == obj_pixels.end()) {
+            pixels = obj_pixels.emplace(elem_id, Pixels()).first;
+          }
+          pixels->second.push_back(Point{x, y});
+        }
+      }
+    }
+    if (c != end) {
+      c++;  // skip the line break
     }
+
+    if (x == 0) {
+      continue;  // ignore empty lines
+    } else if (num_rows == 0) {
+      num_columns = x;
+    } else if (x != num_columns) {
+      throw std::invalid_argument(
+          "Rows do not contain the same number of elements.");
+    }
+    num_rows++;
+  }
+};
+
+// The first bytes of every compiled puzzle file.
+static const char COMPILED_PUZZLE_MAGIC[4] = {'P', 'W', 'P', 'C'};
+
+// Incremented whenever the compiled puzzle format changes.
+static const int32_t COMPILED_PUZZLE_VERSION = 2;
+
+/* Appends the number of `positions` followed by the positions in sorted order.
+ */
+void appendPositions(std::vector<int32_t>& buffer,
+                     const std::unordered_set<Position2D>& positions) {
+  buffer.push_back(positions.size());
+  const size_t begin = buffer.size();
+  buffer.insert(buffer.end(), positions.begin(), positions.end());
+  std::sort(buffer.begin() + begin, buffer.end());
+};
+
+/* Appends the number of `positions` followed by the positions in their order.
+ */
+void appendPositions(std::vector<int32_t>& buffer,
+                     const std::vector<Position2D>& positions) {
+  buffer.push_back(positions.size());
+  buffer.insert(buffer.end(), positions.begin(), positions.end());
+};
+
+/* Appends the number of `shapes` followed by each shape. */
+void appendShapes(std::vector<int32_t>& buffer,
+                  const std::vector<std::vector<Position2D>>& shapes) {
+  buffer.push_back(shapes.size());
+  for (const auto& positions : shapes) {
+    appendPositions(buffer, positions);
   }
 };
 
+/**
+ * Reads consecutive 32-bit integers from a compiled puzzle, throwing
+ * `std::invalid_argument` if the file ends too early.
+ */
+class CompiledPuzzleReader {
+ private:
+  const int32_t* m_next;
+  const int32_t* m_end;
+
+ public:
+  CompiledPuzzleReader(const char* data, const size_t size)
+      : m_next(reinterpret_cast<const int32_t*>(data)),
+        m_end(m_next + size / sizeof(int32_t)){};
+
+  /* Returns the next `count` integers and advances past them. */
+  const int32_t* read(const size_t count) {
+    if (count > m_end - m_next) {
+      throw std::invalid_argument("The compiled puzzle file is truncated.");
+    }
+    const int32_t* values = m_next;
+    m_next += count;
+    return values;
+  };
+
+  /* Returns the next integer, which must be in the interval [0, `limit`]. */
+  int32_t readCount(const int32_t limit) {
+    const int32_t count = *read(1);
+    if (count < 0 || count > limit) {
+      throw std::invalid_argument("The compiled puzzle file is corrupt.");
+    }
+    return count;
+  };
+
+  /* Reads a set of positions written by `appendPositions`. */
+  void readPositions(std::unordered_set<Position2D>& positions) {
+    const int32_t count = readCount(INT32_MAX);
+    const int32_t* values = read(count);
+    positions.reserve(count);
+    positions.insert(values, values + count);
+  };
+
+  /* Reads a vector of positions written by `appendPositions`. */
+  void readPositions(std::vector<Position2D>& positions) {
+    const int32_t count = readCount(INT32_MAX);
+    const int32_t* values = read(count);
+    positions.assign(values, values + count);
+  };
+
+  /* Reads the shapes written by `appendShapes`. */
+  void readShapes(std::vector<std::vector<Position2D>>& shapes) {
+    shapes.resize(readCount(POSITION_LIMIT));
+    for (auto& positions : shapes) {
+      readPositions(positions);
+    }
+  };
+
+  /* Returns whether all integers have been read. */
+  bool done() const { return m_next == m_end; };
+};
+
 }  // namespace
 
 Position2D xy_to_position(const int x, const int y) {
@@ -182,67 +450,137 @@ void position_to_xy(const Position2D p, int& x, int& y) {
   y = p % POSITION_LIMIT;
 };
 
-/*
-- Parse the file, loading all objects and their pixels.
-- Compute the initial position of every object.
-- Compute the boundaries of every object.
-- Compute the collisions between every pair of objects.
-*/
-PushWorldPuzzle::PushWorldPuzzle(const std::string& filename) {
-  std::string line, elem_id;
-  int line_idx = 0;
-  int x, y;
-  int elems_per_row;
+PositionBitmap::PositionBitmap(const std::unordered_set<Position2D>& positions)
+    : m_min_x(0),
+      m_min_y(0),
+      m_width(0),
+      m_height(0),
+      m_positions(positions.begin(), positions.end()) {
+  if (positions.empty()) {
+    return;
+  }
 
-  std::map<std::string, PointSet> obj_pixels;
-  std::vector<std::string> line_elems, cell_elems;
+  std::sort(m_positions.begin(), m_positions.end());
+
+  // Compute the bounding box of all positions.
+  int x, y;
+  int max_x = INT_MIN;
+  int max_y = INT_MIN;
+  m_min_x = INT_MAX;
+  m_min_y = INT_MAX;
+
+  for (const auto p : m_positions) {
+    displacement_to_xy(p, x, y);
+    m_min_x = std::min(x, m_min_x);
+    m_min_y = std::min(y, m_min_y);
+    max_x = std::max(x, max_x);
+    max_y = std::max(y, max_y);
+  }
 
-  // Parse the file, loading all objects and their pixels.
-  std::ifstream pw_file(filename);
+  m_width = max_x - m_min_x + 1;
+  m_height = max_y - m_min_y + 1;
+  m_bits.resize((m_width * m_height + 63) / 64, 0);
 
-  if (pw_file) {  // opened successfully
-    while (getline(pw_file, line)) {
-      y = line_idx + 1;
+  for (const auto p : m_positions) {
+    displacement_to_xy(p, x, y);
+    const unsigned int i = (x - m_min_x) * m_height + (y - m_min_y);
+    m_bits[i >> 6] |= uint64_t(1) << (i & 63);
+  }
+}
 
-      boost::trim(line);
-      boost::split(line_elems, line, boost::is_any_of(" "),
-                   boost::token_compress_on);
+CompiledCollisions::CompiledCollisions(const ObjectCollisions& collisions,
+                                       const int num_objects)
+    : m_num_objects(num_objects) {
+  m_static_collisions.resize(NUM_ACTIONS * num_objects);
+  m_dynamic_collisions.resize(NUM_ACTIONS * num_objects * num_objects);
+
+  for (int a = 0; a < NUM_ACTIONS && a < collisions.static_collisions.size();
+       a++) {
+    const auto& static_collisions = collisions.static_collisions[a];
+    for (int i = 0; i < num_objects && i < static_collisions.size(); i++) {
+      m_static_collisions[a * num_objects + i] =
+          PositionBitmap(static_collisions[i]);
+    }
+  }
 
-      if (y == 1) {
-        elems_per_row = line_elems.size();
-      } else if (line_elems.size() == 0) {
-        continue;  // ignore linebreaks
-      } else if (elems_per_row != line_elems.size()) {
-        throw std::invalid_argument(
-            "Rows do not contain the same number of elements.");
+  for (int a = 0; a < NUM_ACTIONS && a < collisions.dynamic_collisions.size();
+       a++) {
+    const auto& dynamic_collisions = collisions.dynamic_collisions[a];
+    for (int i = 0; i < num_objects && i < dynamic_collisions.size(); i++) {
+      for (int j = 0; j < num_objects && j < dynamic_collisions[i].size();
+           j++) {
+        m_dynamic_collisions[(a * num_objects + i) * num_objects + j] =
+            PositionBitmap(dynamic_collisions[i][j]);
       }
+    }
+  }
 
-      for (x = 1; x <= line_elems.size(); x++) {
-        boost::split(cell_elems, line_elems[x - 1], boost::is_any_of("+"),
-                     boost::token_compress_on);
-
-        for (int k = 0; k < cell_elems.size(); k++) {
-          elem_id = cell_elems[k];
-          boost::to_lower(elem_id);
-          if (elem_id != ".") {
-            obj_pixels[elem_id].insert(Point{x, y});
-          }
-        }
+  // Copy the bounding boxes of all dynamic collisions into padded rows.
+  m_bounds_stride = (num_objects + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+  const size_t num_bounds = NUM_ACTIONS * num_objects * m_bounds_stride;
+  m_min_x.assign(num_bounds, 0);
+  m_min_y.assign(num_bounds, 0);
+  m_biased_width.assign(num_bounds, INT32_MIN);
+  m_biased_height.assign(num_bounds, INT32_MIN);
+
+  for (int a = 0; a < NUM_ACTIONS; a++) {
+    for (int i = 0; i < num_objects; i++) {
+      for (int j = 0; j < num_objects; j++) {
+        const auto& bitmap = getDynamicCollisions(a, i, j);
+        const size_t k = (a * num_objects + i) * m_bounds_stride + j;
+        m_min_x[k] = bitmap.getMinX();
+        m_min_y[k] = bitmap.getMinY();
+        m_biased_width[k] = bitmap.getWidth() ^ 0x80000000u;
+        m_biased_height[k] = bitmap.getHeight() ^ 0x80000000u;
       }
-      line_idx++;
     }
-    pw_file.close();
-  } else {
+  }
+}
+
+PushWorldPuzzle::PushWorldPuzzle(const std::string& filename) {
+  std::string text;
+
+  // Read the whole file at once.
+  std::ifstream pw_file(filename, std::ios::binary);
+  if (!pw_file) {
     throw std::invalid_argument("Unable to open file");
   }
+  pw_file.seekg(0, std::ios::end);
+  text.resize(pw_file.tellg());
+  pw_file.seekg(0, std::ios::beg);
+  pw_file.read(&text[0], text.size());
+  pw_file.close();
+
+  loadText(text);
+}
+
+PushWorldPuzzle PushWorldPuzzle::fromText(const std::string_view text) {
+  PushWorldPuzzle puzzle;
+  puzzle.loadText(text);
+  return puzzle;
+}
+
+/*
+- Parse the text, loading all objects and their pixels.
+- Compute the initial position of every object.
+- Compute the boundaries of every object.
+- Compute the collisions between every pair of objects.
+*/
+void PushWorldPuzzle::loadText(const std::string_view text) {
+  // Parse the text, loading all objects and their pixels.
+  std::map<std::string, Pixels> obj_pixels;
+  int num_columns, num_rows;
+  parsePuzzle(text, obj_pixels, num_columns, num_rows);
 
   if (obj_pixels.find("a") == obj_pixels.end())
     throw std::invalid_argument(
         "Every puzzle must have an agent object whose pixels are "
         "indicated by 'a'.");
 
-  int width = x + 1;
-  int height = y + 2;
+  const int width = num_columns + 2;
+  const int height = num_rows + 2;
+  m_width = width;
+  m_height = height;
 
   if (width >= POSITION_LIMIT || height >= POSITION_LIMIT) {
     throw std::domain_error(
@@ -251,13 +589,14 @@ PushWorldPuzzle::PushWorldPuzzle(const std::string& filename) {
   }
 
   // Add walls at the boundaries of the puzzle.
+  auto& walls = obj_pixels["w"];
   for (int xx = 0; xx < width; xx++) {
-    obj_pixels["w"].insert(Point{xx, 0});
-    obj_pixels["w"].insert(Point{xx, height - 1});
+    walls.push_back(Point{xx, 0});
+    walls.push_back(Point{xx, height - 1});
   }
   for (int yy = 0; yy < height; yy++) {
-    obj_pixels["w"].insert(Point{0, yy});
-    obj_pixels["w"].insert(Point{width - 1, yy});
+    walls.push_back(Point{0, yy});
+    walls.push_back(Point{width - 1, yy});
   }
 
   std::vector<std::string> objects;
@@ -267,19 +606,17 @@ PushWorldPuzzle::PushWorldPuzzle(const std::string& filename) {
   std::string moveable_id;
 
   // Compute the initial positions and collision boundaries of every object.
-  PointSet pixels;
   std::map<std::string, Point> object_positions;
-  Point position;
 
-  for (const auto& pixels_in_object : obj_pixels) {
-    elem_id = pixels_in_object.first;
-    pixels = pixels_in_object.second;
+  for (auto& pixels_in_object : obj_pixels) {
+    const auto& elem_id = pixels_in_object.first;
+    auto& pixels = pixels_in_object.second;
+    sortPixels(pixels);
 
     if (elem_id != "w" && elem_id != "aw") {
-      position = getObjectPosition(pixels);
+      const Point position = getObjectPosition(pixels);
       object_positions[elem_id] = position;
-      pixels = offsetObjectPixels(pixels, position);
-      obj_pixels[elem_id] = pixels;
+      offsetObjectPixels(pixels, position);
     }
 
     if (elem_id[0] == 'g') {
@@ -307,7 +644,7 @@ PushWorldPuzzle::PushWorldPuzzle(const std::string& filename) {
 
   // Create the initial state.
   for (const auto& pixels_in_object : obj_pixels) {
-    elem_id = pixels_in_object.first;
+    const auto& elem_id = pixels_in_object.first;
     if (elem_id[0] == 'm' &&
         find(objects.begin(), objects.end(), elem_id) == objects.end()) {
       objects.push_back(elem_id);
@@ -324,16 +661,37 @@ PushWorldPuzzle::PushWorldPuzzle(const std::string& filename) {
   // Create all collision data structures.
   m_object_collisions.resize(m_num_objects);
 
-  // Walls for the agent include both "aw" and "w" pixels.
-  for (const auto& px : obj_pixels["w"]) {
-    obj_pixels["aw"].insert(px);
+  std::vector<const Pixels*> object_pixels;
+  std::vector<PixelGrid> object_grids;
+  for (const auto& object : objects) {
+    object_pixels.push_back(&obj_pixels[object]);
+    object_grids.emplace_back(*object_pixels.back());
+  }
+
+  // Record the cells of all objects before the agent walls are merged with the
+  // other walls below.
+  auto& agent_walls = obj_pixels["aw"];
+  m_shapes.objects.clear();
+  for (const auto* pixels : object_pixels) {
+    m_shapes.objects.push_back(pixels_to_positions(*pixels));
+  }
+  m_shapes.goals.clear();
+  for (const auto& goal : goals) {
+    m_shapes.goals.push_back(pixels_to_positions(obj_pixels[goal]));
   }
+  m_shapes.walls = pixels_to_positions(walls);
+  m_shapes.agent_walls = pixels_to_positions(agent_walls);
+
+  // Walls for the agent include both "aw" and "w" pixels.
+  agent_walls.insert(agent_walls.end(), walls.begin(), walls.end());
+  const PixelGrid wall_grid(walls);
+  const PixelGrid agent_wall_grid(agent_walls);
 
   // Populate the agent collisions.
   for (int action = 0; action < NUM_ACTIONS; action++) {
     populateBoundedCollisions(
         m_object_collisions.static_collisions[action][AGENT], action,
-        obj_pixels["a"], obj_pixels["aw"], width, height);
+        *object_pixels[AGENT], agent_wall_grid, width, height);
   }
 
   // Populate the wall collisions of all objects other than the agent.
@@ -341,7 +699,7 @@ PushWorldPuzzle::PushWorldPuzzle(const std::string& filename) {
     for (int action = 0; action < NUM_ACTIONS; action++) {
       populateBoundedCollisions(
           m_object_collisions.static_collisions[action][m], action,
-          obj_pixels[objects[m]], obj_pixels["w"], width, height);
+          *object_pixels[m], wall_grid, width, height);
     }
   }
 
@@ -353,7 +711,7 @@ PushWorldPuzzle::PushWorldPuzzle(const std::string& filename) {
       for (int action = 0; action < NUM_ACTIONS; action++) {
         populateCollisions(
             m_object_collisions.dynamic_collisions[action][pusher][pushee],
-            action, obj_pixels[objects[pusher]], obj_pixels[objects[pushee]]);
+            action, *object_pixels[pusher], object_grids[pushee]);
       }
     }
   }
@@ -367,96 +725,479 @@ PushWorldPuzzle::PushWorldPuzzle(const State& initial_state, const Goal& goal,
       m_num_objects(initial_state.size()),
       m_goal(goal),
       m_object_collisions(object_collisions) {
+  // Objects cannot move past the positions where they collide with static
+  // obstacles, so these positions bound the size of the puzzle.
+  m_width = 1;
+  m_height = 1;
+
+  for (const auto p : initial_state) expandBounds(p, m_width, m_height);
+  for (const auto p : goal) expandBounds(p, m_width, m_height);
+  for (const auto& action_collisions : object_collisions.static_collisions) {
+    for (const auto& positions : action_collisions) {
+      for (const auto p : positions) expandBounds(p, m_width, m_height);
+    }
+  }
+
   init();
 }
 
+PushWorldPuzzle PushWorldPuzzle::loadCompiled(const std::string& filename) {
+  const MappedFile file(filename);
+  return fromCompiled(std::string_view(file.data(), file.size()));
+}
+
+PushWorldPuzzle PushWorldPuzzle::fromCompiled(const std::string_view data) {
+  // The integers in `data` are read in place, which requires alignment.
+  if (reinterpret_cast<uintptr_t>(data.data()) % alignof(int32_t) != 0) {
+    return fromCompiled(std::string(data));
+  }
+
+  if (data.size() < sizeof(COMPILED_PUZZLE_MAGIC) ||
+      std::memcmp(data.data(), COMPILED_PUZZLE_MAGIC,
+                  sizeof(COMPILED_PUZZLE_MAGIC)) != 0) {
+    throw std::invalid_argument("The data is not a compiled PushWorld puzzle.");
+  }
+  CompiledPuzzleReader reader(data.data() + sizeof(COMPILED_PUZZLE_MAGIC),
+                              data.size() - sizeof(COMPILED_PUZZLE_MAGIC));
+
+  if (*reader.read(1) != COMPILED_PUZZLE_VERSION) {
+    throw std::invalid_argument(
+        "Unsupported version of the compiled puzzle format.");
+  }
+
+  PushWorldPuzzle puzzle;
+  puzzle.m_num_objects = reader.readCount(POSITION_LIMIT);
+  puzzle.m_width = reader.readCount(POSITION_LIMIT);
+  puzzle.m_height = reader.readCount(POSITION_LIMIT);
+  const int num_goals = reader.readCount(puzzle.m_num_objects);
+
+  const int32_t* values = reader.read(puzzle.m_num_objects);
+  puzzle.m_initial_state.assign(values, values + puzzle.m_num_objects);
+  values = reader.read(num_goals);
+  puzzle.m_goal.assign(values, values + num_goals);
+
+  const int num_objects = puzzle.m_num_objects;
+  auto& collisions = puzzle.m_object_collisions;
+  collisions.resize(num_objects);
+
+  for (int a = 0; a < NUM_ACTIONS; a++) {
+    for (int i = 0; i < num_objects; i++) {
+      reader.readPositions(collisions.static_collisions[a][i]);
+    }
+  }
+  for (int a = 0; a < NUM_ACTIONS; a++) {
+    for (int i = 0; i < num_objects; i++) {
+      for (int j = 0; j < num_objects; j++) {
+        reader.readPositions(collisions.dynamic_collisions[a][i][j]);
+      }
+    }
+  }
+
+  auto& shapes = puzzle.m_shapes;
+  reader.readShapes(shapes.objects);
+  reader.readShapes(shapes.goals);
+  reader.readPositions(shapes.walls);
+  reader.readPositions(shapes.agent_walls);
+
+  if (!reader.done()) {
+    throw std::invalid_argument("The compiled puzzle file is corrupt.");
+  }
+
+  puzzle.init();
+  return puzzle;
+}
+
+std::string PushWorldPuzzle::toCompiled() const {
+  std::vector<int32_t> buffer{COMPILED_PUZZLE_VERSION, m_num_objects, m_width,
+                              m_height, static_cast<int32_t>(m_goal.size())};
+  buffer.insert(buffer.end(), m_initial_state.begin(), m_initial_state.end());
+  buffer.insert(buffer.end(), m_goal.begin(), m_goal.end());
+
+  for (int a = 0; a < NUM_ACTIONS; a++) {
+    for (int i = 0; i < m_num_objects; i++) {
+      appendPositions(buffer, m_object_collisions.static_collisions[a][i]);
+    }
+  }
+  for (int a = 0; a < NUM_ACTIONS; a++) {
+    for (int i = 0; i < m_num_objects; i++) {
+      for (int j = 0; j < m_num_objects; j++) {
+        appendPositions(buffer,
+                        m_object_collisions.dynamic_collisions[a][i][j]);
+      }
+    }
+  }
+
+  appendShapes(buffer, m_shapes.objects);
+  appendShapes(buffer, m_shapes.goals);
+  appendPositions(buffer, m_shapes.walls);
+  appendPositions(buffer, m_shapes.agent_walls);
+
+  std::string data(COMPILED_PUZZLE_MAGIC, sizeof(COMPILED_PUZZLE_MAGIC));
+  data.append(reinterpret_cast<const char*>(buffer.data()),
+              buffer.size() * sizeof(int32_t));
+  return data;
+}
+
+void PushWorldPuzzle::saveCompiled(const std::string& filename) const {
+  const std::string data = toCompiled();
+  std::ofstream file(filename, std::ios::binary);
+  file.write(data.data(), data.size());
+  if (!file) {
+    throw std::invalid_argument("Unable to write file: " + filename);
+  }
+}
+
 void PushWorldPuzzle::init() {
-  m_pushing_frontier.resize(m_num_objects);
+  m_compiled_collisions =
+      CompiledCollisions(m_object_collisions, m_num_objects);
+  setTransitionKernel(TransitionKernel::AUTO);
+  findInterchangeableObjects();
+}
 
-  m_pushed_object_idxs.resize(m_num_objects);
-  m_pushed_object_idxs[0] = AGENT;
+bool PushWorldPuzzle::areInterchangeable(const int i, const int j) const {
+  const auto& static_collisions = m_object_collisions.static_collisions;
+  const auto& dynamic_collisions = m_object_collisions.dynamic_collisions;
 
-  m_pushed_objects.resize(m_num_objects);
-  m_pushed_objects[AGENT] = true;
-  for (int i = 1; i < m_num_objects; i++) {
-    m_pushed_objects[i] = false;
+  for (int a = 0; a < NUM_ACTIONS; a++) {
+    if (static_collisions[a][i] != static_collisions[a][j] ||
+        dynamic_collisions[a][i][j] != dynamic_collisions[a][j][i]) {
+      return false;
+    }
+    for (int k = 0; k < m_num_objects; k++) {
+      if (k != i && k != j &&
+          (dynamic_collisions[a][i][k] != dynamic_collisions[a][j][k] ||
+           dynamic_collisions[a][k][i] != dynamic_collisions[a][k][j])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void PushWorldPuzzle::findInterchangeableObjects() {
+  // Swapping any two objects within a group is a symmetry of the puzzle, and
+  // these swaps generate all permutations of the group.
+  std::vector<std::vector<int>> groups;
+  for (int i = m_goal.size() + 1; i < m_num_objects; i++) {
+    bool grouped = false;
+    for (auto& group : groups) {
+      if (std::all_of(group.begin(), group.end(),
+                      [&](const int j) { return areInterchangeable(i, j); })) {
+        group.push_back(i);
+        grouped = true;
+        break;
+      }
+    }
+    if (!grouped) {
+      groups.push_back({i});
+    }
+  }
+
+  m_interchangeable_objects.clear();
+  for (auto& group : groups) {
+    if (group.size() > 1) {
+      m_interchangeable_objects.push_back(std::move(group));
+    }
+  }
+}
+
+bool PushWorldPuzzle::canonicalizeGroup(const std::vector<int>& group,
+                                        State& state) {
+  // Groups are small, so an insertion sort is fastest, and it does not
+  // allocate memory.
+  bool changed = false;
+  for (size_t i = 1; i < group.size(); i++) {
+    const Position2D position = state[group[i]];
+    size_t j = i;
+    for (; j > 0 && state[group[j - 1]] > position; j--) {
+      state[group[j]] = state[group[j - 1]];
+      changed = true;
+    }
+    state[group[j]] = position;
+  }
+  return changed;
+}
+
+void PushWorldPuzzle::setTransitionKernel(const TransitionKernel kernel) {
+  static const auto fixed_size_kernels = makeFixedSizeKernels(
+      std::make_integer_sequence<int, FIXED_SIZE_KERNEL_MAX_OBJECTS + 1>());
+
+  const bool fits_fixed_size = m_num_objects <= FIXED_SIZE_KERNEL_MAX_OBJECTS;
+  m_use_simd_kernel = false;
+  m_fixed_size_kernel = nullptr;
+
+  switch (kernel) {
+    case TransitionKernel::AUTO:
+      if (fits_fixed_size) {
+        m_fixed_size_kernel = fixed_size_kernels[m_num_objects];
+      } else {
+        m_use_simd_kernel = SIMD_KERNEL_AVAILABLE;
+      }
+      break;
+    case TransitionKernel::SCALAR:
+      break;
+    case TransitionKernel::SIMD:
+      m_use_simd_kernel = SIMD_KERNEL_AVAILABLE;
+      break;
+    case TransitionKernel::FIXED_SIZE:
+      if (fits_fixed_size) {
+        m_fixed_size_kernel = fixed_size_kernels[m_num_objects];
+      }
+      break;
   }
 }
 
 RelativeState PushWorldPuzzle::getNextState(const State& state,
                                     const Action action) const {
+  RelativeState relative_next_state;
+  if (!getNextState(state, action, relative_next_state)) {
+    relative_next_state.state = state;
+  }
+  return relative_next_state;
+}
+
+bool PushWorldPuzzle::getNextState(const State& state, const Action action,
+                                   RelativeState& next) const {
+  return getNextState(state, action, next, m_scratch);
+}
+
+size_t PushWorldPuzzle::getSuccessors(const State* states,
+                                      const size_t num_states,
+                                      const std::vector<Action>& actions,
+                                      std::vector<RelativeState>& successors,
+                                      std::vector<uint8_t>& moved) const {
+  const size_t num_successors = num_states * actions.size();
+  if (successors.size() < num_successors) {
+    successors.resize(num_successors);
+  }
+  if (moved.size() < num_successors) {
+    moved.resize(num_successors);
+  }
+
+  size_t num_moved = 0;
+  RelativeState* next = successors.data();
+  uint8_t* next_moved = moved.data();
+  for (size_t i = 0; i < num_states; i++) {
+    for (const Action action : actions) {
+      *next_moved = getNextState(states[i], action, *next++, m_scratch);
+      num_moved += *next_moved++;
+    }
+  }
+  return num_moved;
+}
+
+bool PushWorldPuzzle::getNextState(const State& state, const Action action,
+                                   RelativeState& next,
+                                   TransitionScratch& scratch) const {
+  if (m_fixed_size_kernel != nullptr) {
+    return (this->*m_fixed_size_kernel)(state, action, next);
+  }
+
   const int agent_pos = state[AGENT];
-  const auto& static_collisions = m_object_collisions.static_collisions[action];
-  const auto& static_agent_collisions = static_collisions[AGENT];
+  const auto& collisions = m_compiled_collisions;
+
+  if (scratch.pushed_objects.size() != m_num_objects) {
+    // Between calls, only the agent is marked as pushed.
+    scratch.pushing_frontier.assign(m_num_objects, AGENT);
+    scratch.pushed_object_idxs.assign(m_num_objects, AGENT);
+    scratch.pushed_objects.assign(m_num_objects, false);
+    scratch.pushed_objects[AGENT] = true;
+  }
+  auto& pushing_frontier = scratch.pushing_frontier;
+  auto& pushed_object_idxs = scratch.pushed_object_idxs;
+  auto& pushed_objects = scratch.pushed_objects;
 
-  RelativeState relative_next_state;
+  next.moved_object_indices.clear();
 
-  if (static_agent_collisions.find(agent_pos) !=
-      static_agent_collisions.end()) {
+  if (collisions.getStaticCollisions(action, AGENT).contains(agent_pos)) {
     // The agent cannot move.
-    relative_next_state.state = state;
-    return relative_next_state;
+    return false;
   }
 
   // The frontier stores all objects that are moved by this action that have not
   // yet been checked for whether they push other objects. It is a "search
   // frontier" for pushed objects.
-  m_pushing_frontier[0] = AGENT;
+  pushing_frontier[0] = AGENT;
   int num_pushed_objects = 1;
   int num_frontier_objects = 1;
-  const auto& dynamic_collisions =
-      m_object_collisions.dynamic_collisions[action];
 
+  // Marks the obstacle as pushed, or returns false if it cannot move.
+  const auto push = [&](const int obstacle_idx) {
+    if (collisions.getStaticCollisions(action, obstacle_idx)
+            .contains(state[obstacle_idx])) {
+      // transitive stopping; nothing can move.
+      for (int i = 1; i < num_pushed_objects; i++) {
+        pushed_objects[pushed_object_idxs[i]] = false;
+      }
+      return false;
+    }
+
+    pushed_objects[obstacle_idx] = true;
+    pushed_object_idxs[num_pushed_objects++] = obstacle_idx;
+    pushing_frontier[num_frontier_objects++] = obstacle_idx;
+    return true;
+  };
+
+#if defined(__SSE2__)
+  if (m_use_simd_kernel) {
+    const int stride = collisions.getBoundsStride();
+    if (static_cast<int>(scratch.xs.size()) != stride) {
+      // Padding objects are never tested, since their bounds are empty.
+      scratch.xs.assign(stride, 0);
+      scratch.ys.assign(stride, 0);
+    }
+    int32_t* xs = scratch.xs.data();
+    int32_t* ys = scratch.ys.data();
+    for (int i = 0; i < m_num_objects; i++) {
+      position_to_xy(state[i], xs[i], ys[i]);
+    }
+
+    const __m128i sign_bit = _mm_set1_epi32(INT32_MIN);
+
+    while (num_frontier_objects) {
+      const auto object_idx = pushing_frontier[--num_frontier_objects];
+      const Position2D object_position = state[object_idx];
+      const auto bounds =
+          collisions.getDynamicCollisionBounds(action, object_idx);
+      const __m128i object_x = _mm_set1_epi32(xs[object_idx]);
+      const __m128i object_y = _mm_set1_epi32(ys[object_idx]);
+
+      for (int first = 0; first < stride;
+           first += CompiledCollisions::SIMD_WIDTH) {
+        // Compute the offset of each relative position from the bounding box
+        // of the corresponding collisions, and test whether it is inside of the
+        // box with unsigned comparisons.
+        const auto load = [first](const int32_t* values) {
+          return _mm_loadu_si128(
+              reinterpret_cast<const __m128i*>(values + first));
+        };
+        const __m128i dx = _mm_sub_epi32(
+            _mm_sub_epi32(object_x, load(xs)), load(bounds.min_x));
+        const __m128i dy = _mm_sub_epi32(
+            _mm_sub_epi32(object_y, load(ys)), load(bounds.min_y));
+        const __m128i in_x = _mm_cmplt_epi32(_mm_xor_si128(dx, sign_bit),
+                                             load(bounds.biased_width));
+        const __m128i in_y = _mm_cmplt_epi32(_mm_xor_si128(dy, sign_bit),
+                                             load(bounds.biased_height));
+        int candidates =
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(in_x, in_y)));
+
+        // Only objects inside of a bounding box require a bitmap lookup.
+        while (candidates) {
+          const int obstacle_idx = first + __builtin_ctz(candidates);
+          candidates &= candidates - 1;
+          if (pushed_objects[obstacle_idx]) continue;  // already pushed
+
+          if (collisions.getDynamicCollisions(action, object_idx, obstacle_idx)
+                  .contains(object_position - state[obstacle_idx]) &&
+              !push(obstacle_idx)) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+#endif
+
+  // This is the scalar kernel. After the SIMD kernel, the frontier is empty.
   while (num_frontier_objects) {
-    auto object_idx = m_pushing_frontier[--num_frontier_objects];
+    auto object_idx = pushing_frontier[--num_frontier_objects];
     const Position2D object_position = state[object_idx];
-    const auto& dynamic_object_collisions = dynamic_collisions[object_idx];
 
     for (int obstacle_idx = 1; obstacle_idx < m_num_objects; obstacle_idx++) {
-      if (m_pushed_objects[obstacle_idx]) continue;  // already pushed
+      if (pushed_objects[obstacle_idx]) continue;  // already pushed
 
       int obstacle_position = state[obstacle_idx];
       int relative_pos = object_position - obstacle_position;
 
       // Test whether the obstacle is pushed by the object.
-      if (dynamic_object_collisions[obstacle_idx].find(relative_pos) !=
-          dynamic_object_collisions[obstacle_idx].end()) {
-        if (static_collisions[obstacle_idx].find(obstacle_position) !=
-            static_collisions[obstacle_idx].end()) {
-          // transitive stopping; nothing can move.
-          for (int i = 1; i < num_pushed_objects; i++) {
-            m_pushed_objects[m_pushed_object_idxs[i]] = false;
-          }
-
-          relative_next_state.state = state;
-          return relative_next_state;
-        }
-
-        m_pushed_objects[obstacle_idx] = true;
-        m_pushed_object_idxs[num_pushed_objects++] = obstacle_idx;
-        m_pushing_frontier[num_frontier_objects++] = obstacle_idx;
+      if (collisions.getDynamicCollisions(action, object_idx, obstacle_idx)
+              .contains(relative_pos) &&
+          !push(obstacle_idx)) {
+        return false;
       }
     }
   }
 
-  relative_next_state.state.resize(m_initial_state.size());
+  next.state.resize(m_num_objects);
   const auto displacement = ACTION_DISPLACEMENTS[action];
 
   // minor optimization to keep this out of the loop below
-  relative_next_state.state[AGENT] = state[AGENT] + displacement;
-  relative_next_state.moved_object_indices.push_back(AGENT);
+  next.state[AGENT] = state[AGENT] + displacement;
+  next.moved_object_indices.push_back(AGENT);
 
   for (int i = 1; i < m_num_objects; i++) {
-    if (m_pushed_objects[i]) {
-      relative_next_state.state[i] = state[i] + displacement;
-      relative_next_state.moved_object_indices.push_back(i);
-      m_pushed_objects[i] = false;
+    if (pushed_objects[i]) {
+      next.state[i] = state[i] + displacement;
+      next.moved_object_indices.push_back(i);
+      pushed_objects[i] = false;
     } else {
-      relative_next_state.state[i] = state[i];
+      next.state[i] = state[i];
     }
   }
 
-  return relative_next_state;
+  return true;
+}
+
+template <int N>
+bool PushWorldPuzzle::getFixedSizeNextState(const State& state,
+                                            const Action action,
+                                            RelativeState& next) const {
+  const auto& collisions = m_compiled_collisions;
+  next.moved_object_indices.clear();
+
+  if (collisions.getStaticCollisions(action, AGENT).contains(state[AGENT])) {
+    // The agent cannot move.
+    return false;
+  }
+
+  // Bit `i` is set if object `i` is pushed. The agent is always pushed.
+  uint32_t pushed_objects = 1;
+  std::array<int, N> pushing_frontier;
+  pushing_frontier[0] = AGENT;
+  int num_frontier_objects = 1;
+
+  while (num_frontier_objects) {
+    const int object_idx = pushing_frontier[--num_frontier_objects];
+    const Position2D object_position = state[object_idx];
+
+    for (int obstacle_idx = 1; obstacle_idx < N; obstacle_idx++) {
+      if (pushed_objects & (uint32_t(1) << obstacle_idx)) continue;
+
+      const Position2D obstacle_position = state[obstacle_idx];
+      if (collisions.getDynamicCollisions(action, object_idx, obstacle_idx)
+              .contains(object_position - obstacle_position)) {
+        if (collisions.getStaticCollisions(action, obstacle_idx)
+                .contains(obstacle_position)) {
+          // transitive stopping; nothing can move.
+          return false;
+        }
+        pushed_objects |= uint32_t(1) << obstacle_idx;
+        pushing_frontier[num_frontier_objects++] = obstacle_idx;
+      }
+    }
+  }
+
+  next.state.resize(N);
+  const auto displacement = ACTION_DISPLACEMENTS[action];
+
+  for (int i = 0; i < N; i++) {
+    if (pushed_objects & (uint32_t(1) << i)) {
+      next.state[i] = state[i] + displacement;
+      next.moved_object_indices.push_back(i);
+    } else {
+      next.state[i] = state[i];
+    }
+  }
+
+  return true;
+}
+
+template <int... Ns>
+std::array<PushWorldPuzzle::FixedSizeKernel, sizeof...(Ns)>
+PushWorldPuzzle::makeFixedSizeKernels(std::integer_sequence<int, Ns...>) {
+  // A puzzle always contains the agent, so the kernel for 0 objects is null.
+  return {(Ns == 0 ? nullptr : &PushWorldPuzzle::getFixedSizeNextState<Ns>)...};
 }
 
 bool PushWorldPuzzle::satisfiesGoal(const State& state) const {
@@ -470,9 +1211,13 @@ bool PushWorldPuzzle::satisfiesGoal(const State& state) const {
 
 bool PushWorldPuzzle::isValidPlan(const Plan& plan) const {
   auto state = m_initial_state;
+  RelativeState next;
 
   for (const auto action : plan) {
-    state = getNextState(state, action).state;
+    // Alternate between two buffers to avoid allocating a state per action.
+    if (getNextState(state, action, next)) {
+      std::swap(state, next.state);
+    }
   }
 
   return satisfiesGoal(state);
@@ -0,0 +1,471 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "puzzle_collection.h"
+
+#include <zlib.h>
+
+#include <algorithm>  // sort, transform
+#include <cctype>     // tolower
+#include <cstring>    // memcpy
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pushworld {
+
+namespace {
+
+static const std::string ZIP_EXTENSION = ".zip";
+static const std::string PUZZLE_EXTENSION = ".pwp";
+
+// Signatures of the zip records that are read.
+static const uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+static const uint32_t ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+static const uint32_t ZIP_END_OF_DIRECTORY_SIGNATURE = 0x06054b50;
+
+// Sizes of the fixed-length parts of zip records.
+static const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+static const size_t ZIP_CENTRAL_HEADER_SIZE = 46;
+static const size_t ZIP_END_OF_DIRECTORY_SIZE = 22;
+
+// The version of the zip format that is needed to read deflated entries.
+static const uint16_t ZIP_VERSION = 20;
+
+// The maximum number of entries and offset of an archive without Zip64.
+static const size_t ZIP_MAX_ENTRIES = 0xfffe;
+static const uint64_t ZIP_MAX_OFFSET = 0xfffffffe;
+
+// The DOS date of the entries that are written, which is 1980-01-01, so that
+// archives are reproducible.
+static const uint16_t ZIP_DOS_DATE = (1 << 5) | 1;
+
+// Zip compression methods.
+static const uint16_t ZIP_STORED = 0;
+static const uint16_t ZIP_DEFLATED = 8;
+
+// The first bytes of every archive written by `saveArchive`.
+static const char ARCHIVE_MAGIC[4] = {'P', 'W', 'P', 'A'};
+
+// Incremented whenever the archive format changes.
+static const uint32_t ARCHIVE_VERSION = 1;
+
+// Puzzle data in archives is aligned so that compiled puzzles can be read in
+// place.
+static const size_t ARCHIVE_ALIGNMENT = 8;
+
+/**
+ * The index of an archive written by `saveArchive` contains one record per
+ * puzzle. Offsets are measured from the start of the file.
+ */
+struct ArchiveRecord {
+  uint64_t name_offset;
+  uint64_t name_size;
+  uint64_t data_offset;
+  uint64_t data_size;
+};
+
+/* Returns the `string` in lowercase. */
+std::string to_lower(std::string string) {
+  std::transform(string.begin(), string.end(), string.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return string;
+}
+
+/* Returns whether the `name` ends with the `suffix`, ignoring case. */
+bool has_suffix(const std::string_view name, const std::string& suffix) {
+  return name.size() >= suffix.size() &&
+         to_lower(std::string(name.substr(name.size() - suffix.size()))) ==
+             suffix;
+}
+
+/* Reads a little-endian integer of `num_bytes` bytes from `data`. */
+uint32_t read_le(const char* data, const int num_bytes) {
+  uint32_t value = 0;
+  for (int i = num_bytes - 1; i >= 0; i--) {
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  }
+  return value;
+}
+
+/* Throws `std::invalid_argument` with a message about a corrupt archive. */
+[[noreturn]] void throw_corrupt(const std::string& detail) {
+  throw std::invalid_argument("The puzzle collection is corrupt: " + detail);
+}
+
+/* Appends the `num_bytes` low bytes of the `value` to `data` in little-endian
+ * order. */
+void append_le(std::string& data, const uint32_t value, const int num_bytes) {
+  for (int i = 0; i < num_bytes; i++) {
+    data += static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+/* Decompresses raw deflate `data` into exactly `size` bytes. */
+std::string inflate_data(const std::string_view data, const size_t size) {
+  std::string output(size, '\0');
+
+  z_stream stream{};
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+    throw std::runtime_error("Failed to initialize zlib.");
+  }
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = size;
+
+  const int status = inflate(&stream, Z_FINISH);
+  const size_t num_output_bytes = stream.total_out;
+  inflateEnd(&stream);
+
+  if (status != Z_STREAM_END || num_output_bytes != size) {
+    throw_corrupt("a deflated entry could not be decompressed");
+  }
+  return output;
+}
+
+/* Compresses the `data` with raw deflate, as in zip entries. */
+std::string deflate_data(const std::string_view data) {
+  z_stream stream{};
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("Failed to initialize zlib.");
+  }
+  std::string output(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = output.size();
+
+  const int status = deflate(&stream, Z_FINISH);
+  output.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  if (status != Z_STREAM_END) {
+    throw std::runtime_error("Failed to compress a zip entry.");
+  }
+  return output;
+}
+
+}  // namespace
+
+bool is_puzzle_collection(const std::string& filename) {
+  return has_suffix(filename, ZIP_EXTENSION) ||
+         has_suffix(filename, PUZZLE_ARCHIVE_EXTENSION);
+}
+
+PuzzleCollection::PuzzleCollection(const std::string& filename)
+    : m_file(filename) {
+  if (m_file.size() >= sizeof(ARCHIVE_MAGIC) &&
+      std::memcmp(m_file.data(), ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) == 0) {
+    readArchiveIndex();
+  } else {
+    readZipIndex();
+  }
+
+  std::sort(m_entries.begin(), m_entries.end(),
+            [](const Entry& a, const Entry& b) { return a.name < b.name; });
+}
+
+void PuzzleCollection::readZipIndex() {
+  const char* const file = m_file.data();
+  const size_t file_size = m_file.size();
+
+  // The end of central directory record is at the end of the file, followed
+  // only by a comment of at most 65535 bytes.
+  if (file_size < ZIP_END_OF_DIRECTORY_SIZE) {
+    throw std::invalid_argument("The file is not a puzzle collection.");
+  }
+  size_t end_of_directory = file_size - ZIP_END_OF_DIRECTORY_SIZE;
+  const size_t min_end_of_directory =
+      end_of_directory > 0xffff ? end_of_directory - 0xffff : 0;
+  while (read_le(file + end_of_directory, 4) !=
+         ZIP_END_OF_DIRECTORY_SIGNATURE) {
+    if (end_of_directory == min_end_of_directory) {
+      throw std::invalid_argument("The file is not a puzzle collection.");
+    }
+    end_of_directory--;
+  }
+
+  const char* record = file + end_of_directory;
+  const uint32_t num_entries = read_le(record + 10, 2);
+  const uint32_t directory_offset = read_le(record + 16, 4);
+  if (num_entries == 0xffff || directory_offset == 0xffffffff) {
+    throw std::invalid_argument("Zip64 archives are not supported.");
+  }
+
+  size_t offset = directory_offset;
+  for (uint32_t i = 0; i < num_entries; i++) {
+    if (offset + ZIP_CENTRAL_HEADER_SIZE > end_of_directory ||
+        read_le(file + offset, 4) != ZIP_CENTRAL_HEADER_SIGNATURE) {
+      throw_corrupt("invalid central directory");
+    }
+    const char* header = file + offset;
+    const uint16_t flags = read_le(header + 8, 2);
+    const uint16_t method = read_le(header + 10, 2);
+    const uint32_t compressed_size = read_le(header + 20, 4);
+    const uint32_t size = read_le(header + 24, 4);
+    const uint16_t name_size = read_le(header + 28, 2);
+    const uint16_t extra_size = read_le(header + 30, 2);
+    const uint16_t comment_size = read_le(header + 32, 2);
+    const uint32_t local_offset = read_le(header + 42, 4);
+
+    const size_t name_offset = offset + ZIP_CENTRAL_HEADER_SIZE;
+    offset = name_offset + name_size + extra_size + comment_size;
+    if (offset > end_of_directory) {
+      throw_corrupt("invalid central directory");
+    }
+
+    const std::string_view name(file + name_offset, name_size);
+    const bool compiled = has_suffix(name, COMPILED_PUZZLE_EXTENSION);
+    if (!compiled && !has_suffix(name, PUZZLE_EXTENSION)) {
+      continue;  // e.g. a directory
+    }
+
+    // The data follows the local header, whose variable-length fields may
+    // differ from those in the central directory.
+    if (local_offset + ZIP_LOCAL_HEADER_SIZE > file_size ||
+        read_le(file + local_offset, 4) != ZIP_LOCAL_HEADER_SIGNATURE) {
+      throw_corrupt("invalid local header of " + std::string(name));
+    }
+    const size_t data_offset = local_offset + ZIP_LOCAL_HEADER_SIZE +
+                               read_le(file + local_offset + 26, 2) +
+                               read_le(file + local_offset + 28, 2);
+    if (data_offset + compressed_size > file_size) {
+      throw_corrupt("truncated data of " + std::string(name));
+    }
+
+    // Bit 0 of the flags indicates encryption.
+    const uint16_t entry_method = (flags & 1) ? 0xffff : method;
+    m_entries.push_back(Entry{
+        name, std::string_view(file + data_offset, compressed_size), size,
+        entry_method, compiled});
+  }
+}
+
+void PuzzleCollection::readArchiveIndex() {
+  const char* const file = m_file.data();
+  const size_t file_size = m_file.size();
+  const size_t header_size = sizeof(ARCHIVE_MAGIC) + 2 * sizeof(uint32_t);
+
+  if (file_size < header_size) {
+    throw_corrupt("truncated header");
+  }
+  uint32_t version, num_entries;
+  std::memcpy(&version, file + sizeof(ARCHIVE_MAGIC), sizeof(uint32_t));
+  std::memcpy(&num_entries, file + sizeof(ARCHIVE_MAGIC) + sizeof(uint32_t),
+              sizeof(uint32_t));
+  if (version != ARCHIVE_VERSION) {
+    throw std::invalid_argument("Unsupported version of the puzzle archive.");
+  }
+  if (num_entries > (file_size - header_size) / sizeof(ArchiveRecord)) {
+    throw_corrupt("truncated index");
+  }
+
+  for (uint32_t i = 0; i < num_entries; i++) {
+    ArchiveRecord record;
+    std::memcpy(&record, file + header_size + i * sizeof(ArchiveRecord),
+                sizeof(ArchiveRecord));
+    if (record.name_offset > file_size ||
+        record.name_size > file_size - record.name_offset ||
+        record.data_offset > file_size ||
+        record.data_size > file_size - record.data_offset ||
+        record.data_size > UINT32_MAX) {
+      throw_corrupt("invalid index record");
+    }
+    m_entries.push_back(
+        Entry{std::string_view(file + record.name_offset, record.name_size),
+              std::string_view(file + record.data_offset, record.data_size),
+              static_cast<uint32_t>(record.data_size), ZIP_STORED, true});
+  }
+}
+
+PushWorldPuzzle PuzzleCollection::getPuzzle(const size_t index) const {
+  const Entry& entry = m_entries.at(index);
+
+  std::string inflated;
+  std::string_view data;
+  if (entry.method == ZIP_STORED) {
+    if (entry.data.size() != entry.size) {
+      throw_corrupt("inconsistent size of " + std::string(entry.name));
+    }
+    data = entry.data;
+  } else if (entry.method == ZIP_DEFLATED) {
+    inflated = inflate_data(entry.data, entry.size);
+    data = inflated;
+  } else {
+    throw std::invalid_argument(
+        "Unsupported compression or encryption of " + std::string(entry.name));
+  }
+
+  return entry.compiled ? PushWorldPuzzle::fromCompiled(data)
+                        : PushWorldPuzzle::fromText(data);
+}
+
+void PuzzleCollection::saveArchive(const std::string& filename) const {
+  std::vector<ArchiveRecord> records(m_entries.size());
+  std::vector<std::string> compiled_puzzles(m_entries.size());
+
+  // Names are stored after the index, followed by the aligned puzzle data.
+  uint64_t offset = sizeof(ARCHIVE_MAGIC) + 2 * sizeof(uint32_t) +
+                    records.size() * sizeof(ArchiveRecord);
+  for (size_t i = 0; i < m_entries.size(); i++) {
+    records[i].name_offset = offset;
+    records[i].name_size = m_entries[i].name.size();
+    offset += records[i].name_size;
+  }
+  for (size_t i = 0; i < m_entries.size(); i++) {
+    compiled_puzzles[i] = getPuzzle(i).toCompiled();
+    offset = (offset + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT *
+             ARCHIVE_ALIGNMENT;
+    records[i].data_offset = offset;
+    records[i].data_size = compiled_puzzles[i].size();
+    offset += records[i].data_size;
+  }
+
+  std::string archive(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+  const uint32_t header[] = {ARCHIVE_VERSION,
+                             static_cast<uint32_t>(records.size())};
+  archive.append(reinterpret_cast<const char*>(header), sizeof(header));
+  archive.append(reinterpret_cast<const char*>(records.data()),
+                 records.size() * sizeof(ArchiveRecord));
+  for (const auto& entry : m_entries) {
+    archive.append(entry.name);
+  }
+  for (size_t i = 0; i < m_entries.size(); i++) {
+    archive.resize(records[i].data_offset, '\0');
+    archive.append(compiled_puzzles[i]);
+  }
+
+  std::ofstream file(filename, std::ios::binary);
+  file.write(archive.data(), archive.size());
+  if (!file) {
+    throw std::invalid_argument("Unable to write file: " + filename);
+  }
+}
+
+ZipArchiveWriter::ZipArchiveWriter(const std::string& filename)
+    : m_filename(filename),
+      m_file(filename, std::ios::binary | std::ios::trunc),
+      m_offset(0) {
+  if (!m_file) {
+    throw std::invalid_argument("Unable to write file: " + filename);
+  }
+}
+
+ZipArchiveWriter::~ZipArchiveWriter() {
+  if (m_file.is_open()) {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+}
+
+void ZipArchiveWriter::add(const std::string& name,
+                           const std::string_view data) {
+  if (!m_file.is_open()) {
+    throw std::runtime_error("The zip archive is closed: " + m_filename);
+  }
+  if (m_entries.size() == ZIP_MAX_ENTRIES || name.size() > 0xffff ||
+      data.size() > ZIP_MAX_OFFSET) {
+    throw std::domain_error("The zip archive is too large: " + m_filename);
+  }
+
+  const std::string compressed = deflate_data(data);
+  const uint64_t end_offset = m_offset + ZIP_LOCAL_HEADER_SIZE + name.size() +
+                              compressed.size();
+  if (end_offset > ZIP_MAX_OFFSET) {
+    throw std::domain_error("The zip archive is too large: " + m_filename);
+  }
+
+  Entry entry{name,
+              static_cast<uint32_t>(crc32(
+                  0, reinterpret_cast<const Bytef*>(data.data()), data.size())),
+              static_cast<uint32_t>(compressed.size()),
+              static_cast<uint32_t>(data.size()),
+              static_cast<uint32_t>(m_offset)};
+
+  std::string header;
+  append_le(header, ZIP_LOCAL_HEADER_SIGNATURE, 4);
+  append_le(header, ZIP_VERSION, 2);
+  append_le(header, 0, 2);  // flags
+  append_le(header, ZIP_DEFLATED, 2);
+  append_le(header, 0, 2);  // time
+  append_le(header, ZIP_DOS_DATE, 2);
+  append_le(header, entry.crc, 4);
+  append_le(header, entry.compressed_size, 4);
+  append_le(header, entry.size, 4);
+  append_le(header, name.size(), 2);
+  append_le(header, 0, 2);  // extra field size
+  header += name;
+
+  m_file.write(header.data(), header.size());
+  m_file.write(compressed.data(), compressed.size());
+  if (!m_file) {
+    throw std::runtime_error("Unable to write file: " + m_filename);
+  }
+  m_offset = end_offset;
+  m_entries.push_back(std::move(entry));
+}
+
+void ZipArchiveWriter::close() {
+  if (!m_file.is_open()) {
+    return;
+  }
+
+  std::string directory;
+  for (const auto& entry : m_entries) {
+    append_le(directory, ZIP_CENTRAL_HEADER_SIGNATURE, 4);
+    append_le(directory, ZIP_VERSION, 2);  // version made by
+    append_le(directory, ZIP_VERSION, 2);  // version needed to extract
+    append_le(directory, 0, 2);            // flags
+    append_le(directory, ZIP_DEFLATED, 2);
+    append_le(directory, 0, 2);  // time
+    append_le(directory, ZIP_DOS_DATE, 2);
+    append_le(directory, entry.crc, 4);
+    append_le(directory, entry.compressed_size, 4);
+    append_le(directory, entry.size, 4);
+    append_le(directory, entry.name.size(), 2);
+    append_le(directory, 0, 2);  // extra field size
+    append_le(directory, 0, 2);  // comment size
+    append_le(directory, 0, 2);  // disk number
+    append_le(directory, 0, 2);  // internal attributes
+    append_le(directory, 0, 4);  // external attributes
+    append_le(directory, entry.offset, 4);
+    directory += entry.name;
+  }
+
+  const size_t directory_size = directory.size();
+  append_le(directory, ZIP_END_OF_DIRECTORY_SIGNATURE, 4);
+  append_le(directory, 0, 2);  // disk number
+  append_le(directory, 0, 2);  // disk of the central directory
+  append_le(directory, m_entries.size(), 2);
+  append_le(directory, m_entries.size(), 2);
+  append_le(directory, directory_size, 4);
+  append_le(directory, m_offset, 4);
+  append_le(directory, 0, 2);  // comment size
+
+  m_file.write(directory.data(), directory.size());
+  m_file.close();
+  if (!m_file) {
+    throw std::runtime_error("Unable to write file: " + m_filename);
+  }
+}
+
+}  // namespace pushworld
@@ -0,0 +1,216 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "puzzle_generator.h"
+
+#include <algorithm>  // max
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace pushworld {
+
+namespace {
+
+// The number of random positions to try for each object, and the number of
+// random puzzles to try for each generated puzzle, before giving up.
+static const int MAX_PLACEMENT_ATTEMPTS = 100;
+static const int MAX_PUZZLE_ATTEMPTS = 10000;
+
+/* Throws `std::invalid_argument` unless `min_value <= max_value`. */
+void check_range(const int min_value, const int max_value,
+                 const std::string& name) {
+  if (min_value > max_value) {
+    throw std::invalid_argument("min_" + name +
+                                " must be no bigger than max_" + name);
+  }
+}
+
+}  // namespace
+
+Level0PuzzleGenerator::Level0PuzzleGenerator(
+    const Level0GeneratorOptions& options, const unsigned int seed)
+    : m_options(options), m_random(seed) {
+  if (options.min_puzzle_size < 2) {
+    throw std::invalid_argument("min_puzzle_size must be >1");
+  }
+  check_range(options.min_puzzle_size, options.max_puzzle_size,
+              "puzzle_size");
+  if (options.min_num_walls < 0) {
+    throw std::invalid_argument("min_num_walls must be >=0");
+  }
+  check_range(options.min_num_walls, options.max_num_walls, "num_walls");
+  if (options.min_num_obstacles < 0) {
+    throw std::invalid_argument("min_num_obstacles must be >=0");
+  }
+  check_range(options.min_num_obstacles, options.max_num_obstacles,
+              "num_obstacles");
+  if (options.min_num_goal_objects < 1 || options.max_num_goal_objects > 2) {
+    throw std::invalid_argument(
+        "min_num_goal_objects must be >0 and max_num_goal_objects must be <3");
+  }
+  check_range(options.min_num_goal_objects, options.max_num_goal_objects,
+              "num_goal_objects");
+
+  if (options.complex_shapes) {
+    m_shapes = {
+        {{0, 0}},
+        {{0, 0}, {0, 1}},
+        {{0, 0}, {1, 0}},
+        {{0, 0}, {1, 0}, {1, 1}},
+        {{0, 0}, {0, 1}, {1, 1}},
+        {{0, 0}, {0, 1}, {1, 0}},
+        {{1, 0}, {0, 1}, {1, 1}},
+        {{0, 0}, {0, 1}, {0, 2}},
+        {{0, 0}, {1, 0}, {2, 0}},
+    };
+  } else {
+    m_shapes = {{{0, 0}}};
+  }
+
+  if (options.max_num_goal_objects > int(m_shapes.size())) {
+    throw std::invalid_argument(
+        "Each goal object needs a distinct shape, so simple shapes only "
+        "support one goal object");
+  }
+}
+
+int Level0PuzzleGenerator::randomInt(const int min, const int max) {
+  return std::uniform_int_distribution<int>(min, max)(m_random);
+}
+
+bool Level0PuzzleGenerator::placeObject(
+    std::vector<std::vector<std::string>>& grid, const std::string& symbol,
+    const Shape& shape) {
+  const int height = grid.size();
+  const int width = grid[0].size();
+
+  int shape_height = 0;
+  int shape_width = 0;
+  for (const auto& [y, x] : shape) {
+    shape_height = std::max(shape_height, y + 1);
+    shape_width = std::max(shape_width, x + 1);
+  }
+  if (shape_height > height || shape_width > width) {
+    return false;
+  }
+
+  for (int attempt = 0; attempt < MAX_PLACEMENT_ATTEMPTS; attempt++) {
+    const int x = randomInt(0, width - shape_width);
+    const int y = randomInt(0, height - shape_height);
+
+    bool clear = true;
+    for (const auto& [dy, dx] : shape) {
+      if (grid[y + dy][x + dx] != ".") {
+        clear = false;
+        break;
+      }
+    }
+
+    if (clear) {
+      for (const auto& [dy, dx] : shape) {
+        grid[y + dy][x + dx] = symbol;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string Level0PuzzleGenerator::tryGenerate(const int width,
+                                               const int height,
+                                               const int num_walls,
+                                               const int num_obstacles,
+                                               const int num_goal_objects) {
+  std::vector<std::vector<std::string>> grid(
+      height, std::vector<std::string>(width, "."));
+  const int num_shapes = m_shapes.size();
+
+  const int goal_1_shape = randomInt(0, num_shapes - 1);
+  if (!placeObject(grid, "M1", m_shapes[goal_1_shape]) ||
+      !placeObject(grid, "G1", m_shapes[goal_1_shape])) {
+    return "";
+  }
+
+  if (num_goal_objects == 2) {
+    int goal_2_shape;
+    do {
+      goal_2_shape = randomInt(0, num_shapes - 1);
+    } while (goal_2_shape == goal_1_shape);
+
+    if (!placeObject(grid, "M2", m_shapes[goal_2_shape]) ||
+        !placeObject(grid, "G2", m_shapes[goal_2_shape])) {
+      return "";
+    }
+  }
+
+  if (!placeObject(grid, "A", m_shapes[randomInt(0, num_shapes - 1)])) {
+    return "";
+  }
+
+  for (int i = 0; i < num_obstacles; i++) {
+    if (!placeObject(grid, "M" + std::to_string(1 + i + num_goal_objects),
+                     m_shapes[randomInt(0, num_shapes - 1)])) {
+      return "";
+    }
+  }
+
+  for (int i = 0; i < num_walls; i++) {
+    if (!placeObject(grid, "W", {{0, 0}})) {
+      return "";
+    }
+  }
+
+  std::string text;
+  for (const auto& row : grid) {
+    for (int x = 0; x < width; x++) {
+      if (x > 0) {
+        text += "  ";
+      }
+      text += row[x];
+    }
+    text += "\n";
+  }
+  return text;
+}
+
+std::string Level0PuzzleGenerator::generate() {
+  const auto& options = m_options;
+
+  for (int attempt = 0; attempt < MAX_PUZZLE_ATTEMPTS; attempt++) {
+    const int width =
+        randomInt(options.min_puzzle_size, options.max_puzzle_size);
+    const int height =
+        randomInt(options.min_puzzle_size, options.max_puzzle_size);
+    const int num_walls =
+        randomInt(options.min_num_walls, options.max_num_walls);
+    const int num_obstacles =
+        randomInt(options.min_num_obstacles, options.max_num_obstacles);
+    const int num_goal_objects =
+        randomInt(options.min_num_goal_objects, options.max_num_goal_objects);
+
+    std::string text =
+        tryGenerate(width, height, num_walls, num_obstacles, num_goal_objects);
+    if (!text.empty()) {
+      return text;
+    }
+  }
+
+  throw std::domain_error(
+      "Failed to place all objects in a random puzzle. The puzzles may be too "
+      "small for the numbers of objects.");
+}
+
+}  // namespace pushworld
@@ -0,0 +1,206 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>  // max, min
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>  // pair
+#include <vector>
+
+#include "benchmark_runner.h"
+#include "puzzle_collection.h"
+#include "pushworld_puzzle.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// These definitions match `pushworld.utils.process` in the Python package.
+static const double GIGABYTE = 1e9;
+
+static const char* USAGE =
+    "Usage: run_benchmark [options] <mode> <results> <puzzles>...\n\n"
+    "Solves every PushWorld puzzle in the given files or directories using "
+    "a pool of threads, and saves one YAML file of results per puzzle in the "
+    "same format as `benchmark_rgd.py`.\n\n"
+    "Arguments:\n"
+    "    <mode>    : A heuristic mode of `run_planner`, e.g. \"RGD\", "
+    "\"N+RGD\" or \"PORTFOLIO\".\n"
+    "    <results> : The directory in which to save results. Subdirectories "
+    "of each puzzle directory are replicated in this directory.\n"
+    "    <puzzles> : Paths of .pwp files, directories that are searched "
+    "recursively for .pwp files, or puzzle collections (.zip archives such "
+    "as level0.zip, or .pwpa archives of compiled puzzles), which are read "
+    "without extracting them.\n\n"
+    "Options:\n"
+    "    --threads <N>         : The number of puzzles to solve in parallel. "
+    "Defaults to the number of hardware threads.\n"
+    "    --time-limit <sec>    : The maximum time to solve each puzzle, "
+    "or 0 for no limit. Defaults to 1800.\n"
+    "    --memory-limit <GB>   : The maximum memory of the search of each "
+    "puzzle, or 0 for no limit. Defaults to 30.\n\n";
+
+/**
+ * A puzzle to solve, which is loaded either from the `puzzle_path` or from the
+ * puzzle with the given `index` in the `collection`.
+ */
+struct PuzzleTask {
+  std::string puzzle_path;
+  std::shared_ptr<const pushworld::PuzzleCollection> collection;
+  size_t index;
+  std::string result_path;
+};
+
+/* Parses a non-negative number from a command-line option. */
+double parse_option(const std::string& option, const std::string& value) {
+  const std::string error = "Invalid value for " + option + ": " + value;
+  size_t end = 0;
+  double number = 0;
+  try {
+    number = std::stod(value, &end);
+  } catch (const std::exception&) {
+    throw std::invalid_argument(error);
+  }
+  if (end != value.size() || !(number >= 0)) {
+    throw std::invalid_argument(error);
+  }
+  return number;
+}
+
+}  // namespace
+
+/**
+ * Solves all puzzles in the given paths on a pool of threads and saves the
+ * results of each puzzle in a YAML file.
+ */
+int main(int argc, char* argv[]) {
+  try {
+    int num_threads = std::max(1u, std::thread::hardware_concurrency());
+    pushworld::PlanningLimits limits{1800, size_t(30 * GIGABYTE)};
+    std::vector<std::string> args;
+
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      if (arg == "--threads" || arg == "--time-limit" ||
+          arg == "--memory-limit") {
+        if (++i == argc) {
+          throw std::invalid_argument("Missing value for " + arg);
+        }
+        const double value = parse_option(arg, argv[i]);
+        if (arg == "--threads") {
+          num_threads = std::max(1, int(value));
+        } else if (arg == "--time-limit") {
+          limits.time_limit =
+              value == 0 ? std::nullopt : std::optional<int>(value);
+        } else {
+          limits.memory_limit =
+              value == 0 ? std::nullopt
+                         : std::optional<size_t>(value * GIGABYTE);
+        }
+      } else {
+        args.push_back(arg);
+      }
+    }
+
+    if (args.size() < 3) {
+      std::cout << USAGE;
+      return 0;
+    }
+
+    const std::string& mode = args[0];
+    const std::string& results_path = args[1];
+
+    // Fail early if the mode is invalid.
+    pushworld::get_planner_name(mode);
+
+    std::vector<PuzzleTask> tasks;
+    for (size_t i = 2; i < args.size(); i++) {
+      if (pushworld::is_puzzle_collection(args[i])) {
+        const auto collection =
+            std::make_shared<const pushworld::PuzzleCollection>(args[i]);
+        for (auto& [index, result_path] :
+             pushworld::map_collection_puzzles(*collection, results_path)) {
+          const std::string puzzle_path =
+              args[i] + "/" + std::string(collection->getName(index));
+          tasks.push_back(PuzzleTask{puzzle_path, collection, index,
+                                     std::move(result_path)});
+        }
+        continue;
+      }
+      for (auto& [puzzle_path, result_path] :
+           pushworld::map_puzzle_files(args[i], results_path)) {
+        tasks.push_back(PuzzleTask{std::move(puzzle_path), nullptr, 0,
+                                   std::move(result_path)});
+      }
+    }
+
+    std::atomic<size_t> next_puzzle(0);
+    size_t num_finished = 0;
+    std::mutex output_mutex;
+
+    // Each worker repeatedly claims the next unsolved puzzle.
+    auto worker = [&]() {
+      size_t i;
+      while ((i = next_puzzle++) < tasks.size()) {
+        const PuzzleTask& task = tasks[i];
+        std::string status;
+
+        try {
+          const auto result =
+              task.collection == nullptr
+                  ? pushworld::run_planner_with_limits(
+                        mode, task.puzzle_path, limits)
+                  : pushworld::run_planner_with_limits(
+                        mode,
+                        std::make_shared<pushworld::PushWorldPuzzle>(
+                            task.collection->getPuzzle(task.index)),
+                        fs::path(task.puzzle_path).stem().string(), limits);
+          std::ofstream(task.result_path) << pushworld::to_yaml(result);
+          status = result.failure_reason.value_or("solved") + " in " +
+                   std::to_string(result.planning_time) + "s";
+        } catch (const std::exception& e) {
+          status = std::string("ERROR: ") + e.what();
+        }
+
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cout << "[" << ++num_finished << "/" << tasks.size() << "] "
+                  << task.puzzle_path << ": " << status << std::endl;
+      }
+    };
+
+    std::vector<std::thread> threads;
+    const size_t pool_size = std::min<size_t>(num_threads, tasks.size());
+    for (size_t i = 0; i < pool_size; i++) {
+      threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  } catch (std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << "\n";
+    return 1;
+  } catch (...) {
+    std::cerr << "UNKNOWN ERROR\n";
+    return 1;
+  }
+  return 0;
+}
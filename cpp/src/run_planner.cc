@@ -12,55 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstddef>
 #include <iostream>
 #include <memory>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-#include "heuristics/novelty.h"
-#include "heuristics/recursive_graph_distance.h"
-#include "heuristics/weighted_sum.h"
+#include "planner.h"
 #include "pushworld_puzzle.h"
-#include "search/best_first_search.h"
-#include "search/priority_queue.h"
-#include "search/search.h"
+#include "search/search_context.h"
+#include "search/search_statistics.h"
 
-namespace pushworld {
-
-/**
- * Solves the given puzzle using best-first search with a heuristic determined
- * by the mode. Supported modes include:
- *
- *      "RGD": The recursive graph distance heuristic.
- *      "N+RGD": A lexicographic combination of the novelty heuristic followed
- * by the recursive graph distance heuristic.
- */
-std::optional<Plan> solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
-                          const std::string& mode) {
-  priority_queue::FibonacciPriorityQueue<std::shared_ptr<search::SearchNode>,
-                                         float>
-      frontier;
-  auto rgd =
-      std::make_shared<heuristic::RecursiveGraphDistanceHeuristic>(puzzle);
-
-  if (mode == "RGD") {
-    return best_first_search(*puzzle, *rgd, frontier);
-  } else if (mode == "N+RGD") {
-    heuristic::HeuristicsAndWeights heuristics_and_weights = {
-        {std::make_shared<heuristic::NoveltyHeuristic>(
-             puzzle->getInitialState().size()),
-         // The maximum novelty is 3, so 3e6 maintains sub-integer precision
-         // with a `float` type. All RGD heuristic values are either integers
-         // or infinite.
-         1e6f},
-        {rgd, 1.0f}};
-    heuristic::WeightedSumHeuristic heuristic(heuristics_and_weights);
-    return best_first_search(*puzzle, heuristic, frontier);
-  } else {
-    throw std::domain_error("Unrecognized mode: " + mode);
-  }
-}
-
-}  // namespace pushworld
+static const double GIGABYTE = 1e9;
 
 /**
  * Solves a given PushWorld puzzle and prints the resulting solution, if one
@@ -68,9 +33,92 @@ std::optional<Plan> solve(const std::shared_ptr<PushWorldPuzzle> puzzle,
  */
 int main(int argc, char* argv[]) {
   try {
-    if (argc != 3) {
+    // The time limit includes loading the puzzle and building the heuristics.
+    pushworld::search::SearchContext context;
+    int num_threads = 1;
+    double time_limit = 0.0;
+    double memory_limit = 0.0;
+    bool anytime = false;
+    bool lazy = false;
+    bool canonicalize_objects = false;
+    std::optional<std::string> external_directory;
+    std::string statistics_format;
+    std::vector<std::string> args;
+
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      if (arg == "--threads") {
+        if (++i == argc) {
+          throw std::invalid_argument("Missing value for --threads");
+        }
+        num_threads = std::stoi(argv[i]);
+        if (num_threads < 1) {
+          throw std::invalid_argument("--threads must be positive");
+        }
+      } else if (arg == "--time-limit") {
+        if (++i == argc) {
+          throw std::invalid_argument("Missing value for --time-limit");
+        }
+        time_limit = std::stod(argv[i]);
+        if (time_limit <= 0.0) {
+          throw std::invalid_argument("--time-limit must be positive");
+        }
+      } else if (arg == "--memory-limit") {
+        if (++i == argc) {
+          throw std::invalid_argument("Missing value for --memory-limit");
+        }
+        memory_limit = std::stod(argv[i]);
+        if (memory_limit <= 0.0) {
+          throw std::invalid_argument("--memory-limit must be positive");
+        }
+      } else if (arg == "--external") {
+        if (++i == argc) {
+          throw std::invalid_argument("Missing value for --external");
+        }
+        external_directory = argv[i];
+      } else if (arg == "--anytime") {
+        anytime = true;
+      } else if (arg == "--lazy") {
+        lazy = true;
+      } else if (arg == "--canonicalize") {
+        canonicalize_objects = true;
+      } else if (arg == "--statistics") {
+        if (++i == argc) {
+          throw std::invalid_argument("Missing value for --statistics");
+        }
+        statistics_format = argv[i];
+        if (statistics_format != "json" && statistics_format != "yaml") {
+          throw std::invalid_argument(
+              "--statistics must be \"json\" or \"yaml\"");
+        }
+      } else {
+        args.push_back(arg);
+      }
+    }
+
+    if (num_threads > 1 && anytime) {
+      throw std::invalid_argument(
+          "--anytime cannot be combined with --threads");
+    }
+    if (anytime && memory_limit > 0.0) {
+      throw std::invalid_argument(
+          "--memory-limit cannot be combined with --anytime");
+    }
+    if (external_directory && (num_threads > 1 || anytime)) {
+      throw std::invalid_argument(
+          "--external cannot be combined with --threads or --anytime");
+    }
+    if (lazy && (num_threads > 1 || anytime || external_directory)) {
+      throw std::invalid_argument(
+          "--lazy cannot be combined with --threads, --anytime or --external");
+    }
+
+    if (args.size() != 2) {
       std::cout
-          << ("Usage: run_planner <mode> <puzzle>\n\n"
+          << ("Usage: run_planner [--threads <N>] [--time-limit <seconds>] "
+              "[--memory-limit <gigabytes>] [--anytime] [--lazy] "
+              "[--canonicalize] [--external <directory>] "
+              "[--statistics <format>] <mode> <puzzle>\n\n"
               "Prints a plan of (L)eft, (R)ight, (U)p, (D)own actions that "
               "solve the given PushWorld puzzle, or prints \"NO SOLUTION\" "
               "if no solution exists.\n\n"
@@ -79,20 +127,140 @@ int main(int argc, char* argv[]) {
               "heuristic.\n"
               "                \"N+RGD\" - A lexicographic combination of the "
               "novelty heuristic with the RGD heuristic.\n"
-              "    <puzzle> : The path of a PushWorld file in .pwp format.\n\n");
+              "                \"PORTFOLIO\" - Runs several configurations of "
+              "both heuristics on separate threads and returns the first "
+              "result.\n"
+              "    <puzzle> : The path of a PushWorld file in .pwp format, or "
+              "of a compiled puzzle from `compile_puzzles` in .pwpc "
+              "format.\n"
+              "    --threads <N> : The number of threads that search in "
+              "parallel. Defaults to 1. With more than 1 thread, the plan "
+              "can differ between runs.\n"
+              "    --time-limit <seconds> : Stops the search after the given "
+              "number of seconds and prints \"TIME LIMIT REACHED\" instead "
+              "of a plan.\n"
+              "    --memory-limit <gigabytes> : Stops the search once the "
+              "states, search nodes and heuristics use more than the given "
+              "memory, and prints \"MEMORY LIMIT REACHED\" instead of a "
+              "plan.\n"
+              "    --anytime : Searches for progressively shorter plans until "
+              "the time limit, if any, and prints each plan on a new line as "
+              "soon as it is found, so the last plan is the shortest. Prints "
+              "\"NO SOLUTION\" if no plan was found.\n"
+              "    --lazy : Evaluates the heuristic of each state only when it "
+              "is expanded instead of when it is generated, which performs "
+              "fewer evaluations but expands states in a less informed "
+              "order. In the \"PORTFOLIO\" mode, every search evaluates states "
+              "lazily.\n"
+              "    --canonicalize : Treats states that only differ by "
+              "permuting interchangeable objects, which have identical "
+              "collisions and no goals, as duplicates. This reduces the "
+              "search on many puzzles, but slows it down on others.\n"
+              "    --external <directory> : Writes the visited states and the "
+              "frontier to temporary files in the given directory once they "
+              "exceed the memory limit, or 1 gigabyte by default, so the "
+              "search is only limited by the disk. The files are removed when "
+              "the search ends.\n"
+              "    --statistics <format> : Prints statistics of the search "
+              "after the plan, either as \"json\" on a single line or as "
+              "\"yaml\". Statistics are also printed when a limit is "
+              "reached.\n\n");
       return 0;
     }
 
-    const auto puzzle = std::make_shared<pushworld::PushWorldPuzzle>(argv[2]);
-    const auto plan = pushworld::solve(puzzle, argv[1]);
+    if (time_limit > 0.0) {
+      context.setTimeLimit(time_limit);
+    }
+    // With --external, the memory limit is the budget of the states in memory
+    // instead of a limit of the search.
+    pushworld::search::ExternalSearchOptions external_options;
+    if (memory_limit > 0.0) {
+      if (external_directory) {
+        external_options.memory_budget = size_t(memory_limit * GIGABYTE);
+      } else {
+        context.setMemoryLimit(size_t(memory_limit * GIGABYTE));
+      }
+    }
 
-    if (plan == std::nullopt) {
-      std::cout << "NO SOLUTION\n";
-    } else {
-      for (const pushworld::Action& action : *plan) {
+    const std::string& puzzle_path = args[1];
+    const std::string compiled_extension =
+        pushworld::COMPILED_PUZZLE_EXTENSION;
+    const bool is_compiled =
+        puzzle_path.size() >= compiled_extension.size() &&
+        puzzle_path.compare(puzzle_path.size() - compiled_extension.size(),
+                            compiled_extension.size(),
+                            compiled_extension) == 0;
+    const auto puzzle =
+        is_compiled ? std::make_shared<pushworld::PushWorldPuzzle>(
+                          pushworld::PushWorldPuzzle::loadCompiled(puzzle_path))
+                    : std::make_shared<pushworld::PushWorldPuzzle>(puzzle_path);
+    const auto print_plan = [](const pushworld::Plan& plan) {
+      for (const pushworld::Action& action : plan) {
         std::cout << pushworld::ACTION_TO_CHAR[action];
       }
-      std::cout << "\n";
+      std::cout << std::endl;
+    };
+
+    pushworld::search::SearchStatistics statistics;
+    auto* const statistics_ptr =
+        statistics_format.empty() ? nullptr : &statistics;
+
+    if (anytime) {
+      pushworld::search::AnytimeSearchOptions options;
+      options.deadline = context.deadline();
+      options.on_plan = print_plan;
+      const auto plan = pushworld::solve_anytime(
+          puzzle, args[0], options, statistics_ptr, canonicalize_objects);
+      if (plan == std::nullopt) {
+        std::cout << "NO SOLUTION\n";
+      }
+    } else {
+      using pushworld::search::SearchStatus;
+      external_options.directory = external_directory.value_or("");
+      // The options apply to every search of the portfolio.
+      const bool is_portfolio = args[0] == "PORTFOLIO";
+      auto members = is_portfolio
+                         ? pushworld::default_portfolio()
+                         : std::vector<pushworld::PortfolioMember>{{args[0]}};
+      for (auto& member : members) {
+        member.lazy_evaluation = lazy;
+        member.canonicalize_objects = canonicalize_objects;
+      }
+      const auto result =
+          external_directory
+              ? pushworld::solve_external(puzzle, args[0], external_options,
+                                          context, statistics_ptr,
+                                          canonicalize_objects)
+          : num_threads > 1
+              ? pushworld::solve(puzzle, args[0], num_threads, context,
+                                 statistics_ptr, canonicalize_objects)
+          : is_portfolio
+              ? pushworld::solve_portfolio(puzzle, members, context,
+                                           statistics_ptr)
+              : pushworld::solve(puzzle, members[0], context, statistics_ptr);
+      switch (result.status) {
+        case SearchStatus::SOLVED:
+          print_plan(*result.plan);
+          break;
+        case SearchStatus::NO_SOLUTION:
+          std::cout << "NO SOLUTION\n";
+          break;
+        case SearchStatus::TIME_LIMIT:
+          std::cout << "TIME LIMIT REACHED\n";
+          break;
+        case SearchStatus::MEMORY_LIMIT:
+          std::cout << "MEMORY LIMIT REACHED\n";
+          break;
+        case SearchStatus::CANCELLED:
+          std::cout << "CANCELLED\n";
+          break;
+      }
+    }
+
+    if (statistics_format == "json") {
+      std::cout << pushworld::search::to_json(statistics) << "\n";
+    } else if (statistics_format == "yaml") {
+      std::cout << pushworld::search::to_yaml(statistics);
     }
   } catch (std::exception& e) {
     std::cerr << "ERROR: " << e.what() << "\n";
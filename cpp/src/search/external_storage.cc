@@ -0,0 +1,405 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "search/external_storage.h"
+
+#include <stdlib.h>  // mkdtemp
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <numeric>  // iota
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "search/packed_state_set.h"
+
+namespace fs = std::filesystem;
+
+namespace pushworld {
+namespace search {
+
+namespace {
+
+// Marks that no block of a run is loaded in `ExternalStateMap::m_block`.
+const size_t NO_BLOCK = SIZE_MAX;
+
+/* Returns whether the `num_words` words at `a` are lexicographically less
+ * than the `num_words` words at `b`. */
+bool words_less(const PackedWord* a, const PackedWord* b, const int num_words) {
+  return std::lexicographical_compare(a, a + num_words, b, b + num_words);
+}
+
+/**
+ * Removes every record of `records` for which `contains(record)` is true,
+ * without changing the order of the remaining records.
+ */
+template <typename Predicate>
+void remove_records(std::vector<PackedWord>& records, const int record_words,
+                    Predicate contains) {
+  auto output = records.begin();
+  for (auto input = records.begin(); input != records.end();
+       input += record_words) {
+    if (!contains(&*input)) {
+      output = std::copy(input, input + record_words, output);
+    }
+  }
+  records.erase(output, records.end());
+}
+
+}  // namespace
+
+void sort_unique_records(std::vector<PackedWord>& records,
+                         const int record_words, const int key_words) {
+  const size_t num_records = records.size() / record_words;
+  std::vector<size_t> order(num_records);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](const size_t a, const size_t b) {
+                     return words_less(records.data() + a * record_words,
+                                       records.data() + b * record_words,
+                                       key_words);
+                   });
+
+  std::vector<PackedWord> sorted;
+  sorted.reserve(records.size());
+  for (const size_t i : order) {
+    const PackedWord* record = records.data() + i * record_words;
+    if (!sorted.empty() &&
+        std::equal(record, record + key_words,
+                   sorted.data() + sorted.size() - record_words)) {
+      continue;
+    }
+    sorted.insert(sorted.end(), record, record + record_words);
+  }
+  records.swap(sorted);
+}
+
+ScratchDirectory::ScratchDirectory(const std::string& parent)
+    : m_next_file_id(0) {
+  std::string path =
+      ((parent.empty() ? fs::temp_directory_path() : fs::path(parent)) /
+       "pushworld_search_XXXXXX")
+          .string();
+  if (mkdtemp(path.data()) == nullptr) {
+    throw std::runtime_error("Failed to create a directory in: " +
+                             fs::path(path).parent_path().string());
+  }
+  m_path = path;
+}
+
+ScratchDirectory::~ScratchDirectory() {
+  std::error_code error;
+  fs::remove_all(m_path, error);
+}
+
+std::string ScratchDirectory::newFilePath(const std::string& prefix) {
+  return (fs::path(m_path) /
+          (prefix + "_" + std::to_string(m_next_file_id++) + ".bin"))
+      .string();
+}
+
+RecordFile::RecordFile(const std::string& path, const int record_words)
+    : m_path(path),
+      m_file(std::fopen(path.c_str(), "w+b")),
+      m_record_words(record_words),
+      m_records_per_block(std::max(
+          size_t(1), BLOCK_BYTES / (record_words * sizeof(PackedWord)))),
+      m_size(0),
+      m_file_bytes(0) {
+  if (m_file == nullptr) {
+    throw std::runtime_error("Failed to create the file: " + path);
+  }
+}
+
+RecordFile::~RecordFile() {
+  std::fclose(m_file);
+  std::remove(m_path.c_str());
+}
+
+void RecordFile::append(const PackedWord* records, const size_t num_records) {
+  const size_t block_words = m_records_per_block * m_record_words;
+  const PackedWord* const end = records + num_records * m_record_words;
+  m_size += num_records;
+
+  while (records != end) {
+    const size_t num_words = std::min(block_words - m_buffer.size(),
+                                      static_cast<size_t>(end - records));
+    m_buffer.insert(m_buffer.end(), records, records + num_words);
+    records += num_words;
+    if (m_buffer.size() == block_words) {
+      writeBuffer();
+    }
+  }
+}
+
+void RecordFile::flush() {
+  if (!m_buffer.empty()) {
+    writeBuffer();
+  }
+}
+
+void RecordFile::writeBuffer() {
+  const uLong source_bytes = m_buffer.size() * sizeof(PackedWord);
+  uLongf compressed_bytes = compressBound(source_bytes);
+  m_compressed.resize(compressed_bytes);
+  if (compress2(m_compressed.data(), &compressed_bytes,
+                reinterpret_cast<const Bytef*>(m_buffer.data()), source_bytes,
+                Z_BEST_SPEED) != Z_OK) {
+    throw std::runtime_error("Failed to compress a block of the file: " +
+                             m_path);
+  }
+
+  if (std::fseek(m_file, 0, SEEK_END) != 0 ||
+      std::fwrite(m_compressed.data(), 1, compressed_bytes, m_file) !=
+          compressed_bytes) {
+    throw std::runtime_error("Failed to write to the file: " + m_path);
+  }
+
+  m_blocks.push_back({m_file_bytes, uint32_t(compressed_bytes),
+                      uint32_t(m_buffer.size() / m_record_words)});
+  m_first_records.insert(m_first_records.end(), m_buffer.begin(),
+                         m_buffer.begin() + m_record_words);
+  m_file_bytes += compressed_bytes;
+  m_buffer.clear();
+}
+
+void RecordFile::readBlock(const size_t block,
+                           std::vector<PackedWord>& records) const {
+  const Block& info = m_blocks[block];
+  m_compressed.resize(info.compressed_bytes);
+  if (std::fseek(m_file, info.offset, SEEK_SET) != 0 ||
+      std::fread(m_compressed.data(), 1, info.compressed_bytes, m_file) !=
+          info.compressed_bytes) {
+    throw std::runtime_error("Failed to read from the file: " + m_path);
+  }
+
+  records.resize(size_t(info.num_records) * m_record_words);
+  const uLongf expected_bytes = records.size() * sizeof(PackedWord);
+  uLongf bytes = expected_bytes;
+  if (uncompress(reinterpret_cast<Bytef*>(records.data()), &bytes,
+                 m_compressed.data(), info.compressed_bytes) != Z_OK ||
+      bytes != expected_bytes) {
+    throw std::runtime_error("Found a corrupt block in the file: " + m_path);
+  }
+}
+
+ExternalStateMap::ExternalStateMap(const StatePacker& packer,
+                                   ScratchDirectory& directory,
+                                   const size_t memory_budget)
+    : m_packer(packer),
+      m_state_words(packer.numWords()),
+      m_directory(directory),
+      m_memory_budget(memory_budget),
+      m_memory_states(packer),
+      m_num_disk_states(0) {}
+
+void ExternalStateMap::insert(const PackedWord* state,
+                              const PackedWord* parent) {
+  if (!m_memory_states.insertPacked(state).second) {
+    return;
+  }
+  m_memory_parents.insert(m_memory_parents.end(), parent,
+                          parent + m_state_words);
+
+  if (m_memory_states.memoryUsage() +
+          m_memory_parents.capacity() * sizeof(PackedWord) >
+      m_memory_budget) {
+    flush();
+  }
+}
+
+void ExternalStateMap::flush() {
+  const int record_words = 2 * m_state_words;
+  std::vector<PackedWord> records;
+  records.reserve(m_memory_states.size() * record_words);
+  for (PackedStateSet::Index i = 0; i < m_memory_states.size(); i++) {
+    const PackedWord* state = m_memory_states.getPackedState(i);
+    const PackedWord* parent = m_memory_parents.data() + i * m_state_words;
+    records.insert(records.end(), state, state + m_state_words);
+    records.insert(records.end(), parent, parent + m_state_words);
+  }
+  sort_unique_records(records, record_words, m_state_words);
+
+  auto run = std::make_unique<RecordFile>(m_directory.newFilePath("visited"),
+                                          record_words);
+  run->append(records.data(), records.size() / record_words);
+  run->flush();
+  m_num_disk_states += run->size();
+  m_runs.push_back(std::move(run));
+
+  // Release the memory instead of only clearing it.
+  m_memory_states = PackedStateSet(m_packer);
+  std::vector<PackedWord>().swap(m_memory_parents);
+
+  if (m_runs.size() > MAX_RUNS) {
+    mergeRuns();
+  }
+}
+
+void ExternalStateMap::mergeRuns() {
+  const int record_words = 2 * m_state_words;
+
+  // The next record of each run is at `position` in its loaded `block`.
+  struct Cursor {
+    const RecordFile* run;
+    size_t block;
+    std::vector<PackedWord> records;
+    size_t position;
+  };
+  std::vector<Cursor> cursors;
+  for (const auto& run : m_runs) {
+    if (run->numBlocks() > 0) {
+      cursors.push_back({run.get(), 0, {}, 0});
+      run->readBlock(0, cursors.back().records);
+    }
+  }
+
+  auto merged = std::make_unique<RecordFile>(
+      m_directory.newFilePath("visited"), record_words);
+  while (!cursors.empty()) {
+    size_t min_cursor = 0;
+    for (size_t i = 1; i < cursors.size(); i++) {
+      if (words_less(cursors[i].records.data() + cursors[i].position,
+                     cursors[min_cursor].records.data() +
+                         cursors[min_cursor].position,
+                     m_state_words)) {
+        min_cursor = i;
+      }
+    }
+
+    Cursor& cursor = cursors[min_cursor];
+    merged->append(cursor.records.data() + cursor.position, 1);
+    cursor.position += record_words;
+    if (cursor.position == cursor.records.size()) {
+      if (++cursor.block < cursor.run->numBlocks()) {
+        cursor.run->readBlock(cursor.block, cursor.records);
+        cursor.position = 0;
+      } else {
+        cursors.erase(cursors.begin() + min_cursor);
+      }
+    }
+  }
+  merged->flush();
+
+  m_runs.clear();
+  m_runs.push_back(std::move(merged));
+}
+
+const PackedWord* ExternalStateMap::findInRun(const RecordFile& run,
+                                              const PackedWord* state,
+                                              size_t& loaded_block) const {
+  // Find the last block whose first state is not greater than the `state`.
+  size_t low = 0;
+  size_t high = run.numBlocks();
+  while (low < high) {
+    const size_t middle = (low + high) / 2;
+    if (words_less(state, run.firstRecord(middle), m_state_words)) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  if (low == 0) {
+    return nullptr;
+  }
+  if (loaded_block != low - 1) {
+    loaded_block = low - 1;
+    run.readBlock(loaded_block, m_block);
+  }
+
+  // Find the first record whose state is not less than the `state`.
+  const int record_words = run.recordWords();
+  low = 0;
+  high = m_block.size() / record_words;
+  while (low < high) {
+    const size_t middle = (low + high) / 2;
+    if (words_less(m_block.data() + middle * record_words, state,
+                   m_state_words)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  const PackedWord* record = m_block.data() + low * record_words;
+  if (low * record_words < m_block.size() &&
+      std::equal(state, state + m_state_words, record)) {
+    return record;
+  }
+  return nullptr;
+}
+
+void ExternalStateMap::removeContained(std::vector<PackedWord>& records,
+                                       const int record_words) const {
+  remove_records(records, record_words, [&](const PackedWord* record) {
+    return containsInMemory(record);
+  });
+
+  // The records are sorted, so each block of a run is read at most once.
+  for (const auto& run : m_runs) {
+    size_t loaded_block = NO_BLOCK;
+    remove_records(records, record_words, [&](const PackedWord* record) {
+      return findInRun(*run, record, loaded_block) != nullptr;
+    });
+  }
+}
+
+bool ExternalStateMap::findParent(const PackedWord* state,
+                                  PackedWord* parent) const {
+  const auto found = m_memory_states.findPacked(state);
+  if (found.second) {
+    const PackedWord* record =
+        m_memory_parents.data() + size_t(found.first) * m_state_words;
+    std::copy(record, record + m_state_words, parent);
+    return true;
+  }
+
+  for (auto run = m_runs.rbegin(); run != m_runs.rend(); run++) {
+    size_t loaded_block = NO_BLOCK;
+    const PackedWord* record = findInRun(**run, state, loaded_block);
+    if (record != nullptr) {
+      std::copy(record + m_state_words, record + 2 * m_state_words, parent);
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t ExternalStateMap::memoryUsage() const {
+  size_t bytes = m_memory_states.memoryUsage() +
+                 (m_memory_parents.capacity() + m_block.capacity()) *
+                     sizeof(PackedWord);
+  for (const auto& run : m_runs) {
+    bytes += run->memoryUsage();
+  }
+  return bytes;
+}
+
+size_t ExternalStateMap::diskUsage() const {
+  size_t bytes = 0;
+  for (const auto& run : m_runs) {
+    bytes += run->diskUsage();
+  }
+  return bytes;
+}
+
+}  // namespace search
+}  // namespace pushworld
@@ -0,0 +1,229 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "search/packed_state_set.h"
+
+#include <algorithm>  // equal, fill
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>  // pair
+#include <vector>
+
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace search {
+
+namespace {
+
+static const int WORD_BITS = 64;
+
+// The initial number of slots in a `PackedStateSet`. Must be a power of 2.
+static const size_t MIN_NUM_SLOTS = 16;
+
+/* Returns the number of bits required to store values in [0, limit). */
+int bits_for_limit(const int limit) {
+  int bits = 0;
+  while ((1 << bits) < limit) {
+    bits++;
+  }
+  return bits;
+}
+
+/* The finalizer of the SplitMix64 generator, which thoroughly mixes bits. */
+uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+}  // namespace
+
+StatePacker::StatePacker(const PushWorldPuzzle& puzzle)
+    : StatePacker(puzzle.getInitialState().size(), puzzle.getWidth(),
+                  puzzle.getHeight()) {}
+
+StatePacker::StatePacker(const int num_objects, const int width,
+                         const int height)
+    : m_num_objects(num_objects), m_width(width), m_height(height) {
+  if (width <= 0 || height <= 0 || width > POSITION_LIMIT ||
+      height > POSITION_LIMIT) {
+    throw std::domain_error("Invalid puzzle size: " + std::to_string(width) +
+                            "x" + std::to_string(height));
+  }
+
+  m_bits_y = bits_for_limit(height);
+  m_bits_per_position = bits_for_limit(width) + m_bits_y;
+
+  // Every state has at least one word so that packed states have distinct
+  // addresses, even if there is only one possible position.
+  m_num_words = std::max(
+      1, (num_objects * m_bits_per_position + WORD_BITS - 1) / WORD_BITS);
+}
+
+void StatePacker::pack(const State& state, PackedWord* packed) const {
+  std::fill(packed, packed + m_num_words, 0);
+
+  int bit = 0;
+  for (int i = 0; i < m_num_objects; i++, bit += m_bits_per_position) {
+    const int x = state[i] / POSITION_LIMIT;
+    const int y = state[i] % POSITION_LIMIT;
+
+    // Negative values wrap around to large unsigned values.
+    if (unsigned(x) >= unsigned(m_width) ||
+        unsigned(y) >= unsigned(m_height)) {
+      throw std::domain_error(
+          "Cannot pack a position that is outside of the puzzle bounds.");
+    }
+
+    const PackedWord value = (PackedWord(x) << m_bits_y) | PackedWord(y);
+    const int word = bit / WORD_BITS;
+    const int offset = bit % WORD_BITS;
+
+    packed[word] |= value << offset;
+
+    // Check whether the value continues into the next word.
+    if (offset + m_bits_per_position > WORD_BITS) {
+      packed[word + 1] |= value >> (WORD_BITS - offset);
+    }
+  }
+}
+
+void StatePacker::unpack(const PackedWord* packed, State& state) const {
+  state.resize(m_num_objects);
+
+  const PackedWord position_mask = (PackedWord(1) << m_bits_per_position) - 1;
+  const PackedWord y_mask = (PackedWord(1) << m_bits_y) - 1;
+
+  int bit = 0;
+  for (int i = 0; i < m_num_objects; i++, bit += m_bits_per_position) {
+    const int word = bit / WORD_BITS;
+    const int offset = bit % WORD_BITS;
+
+    PackedWord value = packed[word] >> offset;
+    if (offset + m_bits_per_position > WORD_BITS) {
+      value |= packed[word + 1] << (WORD_BITS - offset);
+    }
+    value &= position_mask;
+
+    state[i] = xy_to_position(value >> m_bits_y, value & y_mask);
+  }
+}
+
+uint64_t StatePacker::hash(const PackedWord* packed) const {
+  uint64_t seed = 0;
+  for (int i = 0; i < m_num_words; i++) {
+    seed = mix(seed ^ packed[i]);
+  }
+  return seed;
+}
+
+PackedStateSet::PackedStateSet(const StatePacker& packer)
+    : m_packer(packer), m_buffer(packer.numWords()) {
+  clear();
+}
+
+void PackedStateSet::clear() {
+  m_states.clear();
+  m_size = 0;
+  m_slots.assign(MIN_NUM_SLOTS, 0);
+  m_slot_mask = MIN_NUM_SLOTS - 1;
+}
+
+size_t PackedStateSet::findSlot(const PackedWord* packed) const {
+  const int num_words = m_packer.numWords();
+  size_t slot = m_packer.hash(packed) & m_slot_mask;
+
+  // Linear probing
+  while (true) {
+    const Index entry = m_slots[slot];
+    if (entry == 0) {
+      return slot;
+    }
+
+    const PackedWord* other = getPackedState(entry - 1);
+    if (std::equal(packed, packed + num_words, other)) {
+      return slot;
+    }
+
+    slot = (slot + 1) & m_slot_mask;
+  }
+}
+
+void PackedStateSet::grow() {
+  m_slots.assign(m_slots.size() * 2, 0);
+  m_slot_mask = m_slots.size() - 1;
+
+  for (Index i = 0; i < m_size; i++) {
+    m_slots[findSlot(getPackedState(i))] = i + 1;
+  }
+}
+
+std::pair<PackedStateSet::Index, bool> PackedStateSet::insert(
+    const State& state) {
+  m_packer.pack(state, m_buffer.data());
+  return insertPacked(m_buffer.data());
+}
+
+std::pair<PackedStateSet::Index, bool> PackedStateSet::insertPacked(
+    const PackedWord* packed) {
+  const size_t slot = findSlot(packed);
+  const Index entry = m_slots[slot];
+
+  if (entry != 0) {
+    // The state is already present.
+    return std::make_pair(entry - 1, false);
+  }
+
+  if (m_size == std::numeric_limits<Index>::max()) {
+    // The slots store `index + 1`, so a larger index would not fit.
+    throw std::domain_error("A PackedStateSet cannot contain more than " +
+                            std::to_string(m_size) + " states.");
+  }
+
+  const Index index = m_size++;
+  m_states.insert(m_states.end(), packed, packed + m_packer.numWords());
+  m_slots[slot] = index + 1;
+
+  // Keep the load factor at most 0.75 for fast probing.
+  if (size_t(m_size) * 4 > m_slots.size() * 3) {
+    grow();
+  }
+
+  return std::make_pair(index, true);
+}
+
+bool PackedStateSet::contains(const State& state) const {
+  m_packer.pack(state, m_buffer.data());
+  return m_slots[findSlot(m_buffer.data())] != 0;
+}
+
+std::pair<PackedStateSet::Index, bool> PackedStateSet::findPacked(
+    const PackedWord* packed) const {
+  const Index entry = m_slots[findSlot(packed)];
+  return std::make_pair(entry - 1, entry != 0);
+}
+
+size_t PackedStateSet::memoryUsage() const {
+  return m_states.capacity() * sizeof(PackedWord) +
+         m_slots.capacity() * sizeof(Index) +
+         m_buffer.capacity() * sizeof(PackedWord);
+}
+
+}  // namespace search
+}  // namespace pushworld
@@ -23,8 +23,9 @@
 namespace pushworld {
 namespace search {
 
-RandomActionIterator::RandomActionIterator(const int num_action_groups) {
-  std::default_random_engine random_engine(42);
+RandomActionIterator::RandomActionIterator(const int num_action_groups,
+                                           const unsigned int seed) {
+  std::default_random_engine random_engine(seed);
 
   m_action_groups.resize(num_action_groups);
 
@@ -16,40 +16,119 @@
 
 #include <algorithm>  // std::reverse
 #include <memory>
+#include <stdexcept>
+#include <utility>  // std::swap
+#include <vector>
 
 #include "pushworld_puzzle.h"
+#include "search/packed_state_set.h"
 
 namespace pushworld {
 namespace search {
 
+namespace {
+
+/**
+ * Returns the action that transitions the `parent_state` to the `state`. The
+ * `next` state is used as scratch memory.
+ *
+ * Throws `std::invalid_argument` if no such action exists.
+ */
+Action findAction(const PushWorldPuzzle& puzzle, const State& parent_state,
+                  const State& state, RelativeState& next) {
+  for (Action action = 0; action < NUM_ACTIONS; action++) {
+    const bool moved = puzzle.getNextState(parent_state, action, next);
+    if (state == (moved ? next.state : parent_state)) {
+      return action;
+    }
+  }
+
+  // Searches may store canonical states, in which interchangeable objects are
+  // permuted. Any action that results in an equivalent state is part of a
+  // valid plan.
+  if (!puzzle.getInterchangeableObjects().empty()) {
+    for (Action action = 0; action < NUM_ACTIONS; action++) {
+      if (puzzle.getNextState(parent_state, action, next) &&
+          (puzzle.canonicalize(next.state), state == next.state)) {
+        return action;
+      }
+    }
+  }
+
+  throw std::invalid_argument(
+      "A parent state exists for which no action can transition to "
+      "the state of a child search node.");
+}
+
+}  // namespace
+
 Plan backtrackPlan(const PushWorldPuzzle& puzzle,
                    const std::shared_ptr<SearchNode>& end_node) {
   Plan plan;
   std::shared_ptr<SearchNode> node = end_node;
-  Action action;
+  RelativeState next;
 
   while (node->parent != nullptr) {
-    // Determine which action produced this state transition. When NUM_ACTIONS
-    // is small, it is faster to reconstruct the actions during backtracking
-    // rather than store actions with every node during a search.
-    for (action = 0; action < NUM_ACTIONS; action++) {
-      if (node->state ==
-          puzzle.getNextState(node->parent->state, action).state) {
-        plan.push_back(action);
-        break;
+    plan.push_back(node->action != NO_ACTION
+                       ? node->action
+                       : findAction(puzzle, node->parent->state, node->state,
+                                    next));
+    node = node->parent;
+  }
+
+  std::reverse(plan.begin(), plan.end());
+  return plan;
+}
+
+Plan backtrackPlan(const PushWorldPuzzle& puzzle, const PackedStateSet& states,
+                   const SearchNodeStore& nodes, const NodeId end_node) {
+  Plan plan;
+  State state, parent_state;
+  RelativeState next;
+
+  // States are only unpacked for nodes without a stored action.
+  NodeId node = end_node;
+  NodeId state_node = NO_PARENT;  // The node whose state is in `state`.
+
+  while (nodes[node].parent != NO_PARENT) {
+    const NodeId parent = nodes[node].parent;
+    const Action action = nodes.getAction(node);
+    if (action != NO_ACTION) {
+      plan.push_back(action);
+    } else {
+      if (state_node != node) {
+        states.getState(nodes[node].state_index, state);
       }
+      states.getState(nodes[parent].state_index, parent_state);
+      plan.push_back(findAction(puzzle, parent_state, state, next));
+      std::swap(state, parent_state);
+      state_node = parent;
     }
+    node = parent;
+  }
+
+  std::reverse(plan.begin(), plan.end());
+  return plan;
+}
 
-    if (action == NUM_ACTIONS) {
-      throw std::invalid_argument(
-          "A parent state exists for which no action can transition to "
-          "the state of a child search node.");
+void set_moved_object_indices(const State& parent_state, RelativeState& next) {
+  next.moved_object_indices.clear();
+  for (int i = 0; i < next.state.size(); i++) {
+    if (next.state[i] != parent_state[i]) {
+      next.moved_object_indices.push_back(i);
     }
+  }
+}
 
-    node = node->parent;
+Plan planFromStates(const PushWorldPuzzle& puzzle,
+                    const std::vector<State>& path) {
+  Plan plan;
+  RelativeState next;
+
+  for (size_t i = 1; i < path.size(); i++) {
+    plan.push_back(findAction(puzzle, path[i - 1], path[i], next));
   }
 
-  std::reverse(plan.begin(), plan.end());
   return plan;
 }
 
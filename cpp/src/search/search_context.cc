@@ -0,0 +1,49 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "search/search_context.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace pushworld {
+namespace search {
+
+std::string to_string(const SearchStatus status) {
+  switch (status) {
+    case SearchStatus::SOLVED:
+      return "SOLVED";
+    case SearchStatus::NO_SOLUTION:
+      return "NO_SOLUTION";
+    case SearchStatus::TIME_LIMIT:
+      return "TIME_LIMIT";
+    case SearchStatus::MEMORY_LIMIT:
+      return "MEMORY_LIMIT";
+    case SearchStatus::CANCELLED:
+      return "CANCELLED";
+  }
+  throw std::domain_error("Unrecognized search status");
+}
+
+void SearchContext::setCheckInterval(const size_t expansions) {
+  if (expansions == 0) {
+    throw std::invalid_argument("The check interval must be positive");
+  }
+  m_check_interval = expansions;
+}
+
+}  // namespace search
+}  // namespace pushworld
@@ -0,0 +1,102 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "search/search_statistics.h"
+
+#include <sstream>
+#include <string>
+#include <utility>  // pair
+#include <vector>
+
+namespace pushworld {
+namespace search {
+
+namespace {
+
+/* Returns the `value` with a fixed number of decimal places. */
+std::string format_seconds(const double value) {
+  std::ostringstream stream;
+  stream.precision(6);
+  stream << std::fixed << value;
+  return stream.str();
+}
+
+/**
+ * Returns the key-value pairs of the `statistics` in sorted order of keys, with
+ * values formatted as numbers. The `heuristic_counters` are omitted and belong
+ * between "generations" and "heuristic_seconds" in sorted order.
+ */
+std::vector<std::pair<std::string, std::string>> get_fields(
+    const SearchStatistics& statistics) {
+  return {
+      {"dead_ends", std::to_string(statistics.dead_ends)},
+      {"duplicates", std::to_string(statistics.duplicates)},
+      {"evaluations", std::to_string(statistics.evaluations)},
+      {"expansions", std::to_string(statistics.expansions)},
+      {"generations", std::to_string(statistics.generations)},
+      {"heuristic_seconds", format_seconds(statistics.heuristic_seconds)},
+      {"max_frontier_size", std::to_string(statistics.max_frontier_size)},
+      {"successor_seconds", format_seconds(statistics.successor_seconds)},
+      {"total_seconds", format_seconds(statistics.total_seconds)},
+  };
+}
+
+// The index in `get_fields` before which `heuristic_counters` is written.
+static const int COUNTERS_FIELD_INDEX = 5;
+
+}  // namespace
+
+std::string to_json(const SearchStatistics& statistics) {
+  const auto fields = get_fields(statistics);
+  std::ostringstream out;
+  out << "{";
+  for (int i = 0; i < fields.size(); i++) {
+    if (i == COUNTERS_FIELD_INDEX) {
+      out << ", \"heuristic_counters\": {";
+      bool first = true;
+      for (const auto& counter : statistics.heuristic_counters) {
+        out << (first ? "" : ", ") << "\"" << counter.first
+            << "\": " << counter.second;
+        first = false;
+      }
+      out << "}";
+    }
+    out << (i == 0 ? "" : ", ") << "\"" << fields[i].first
+        << "\": " << fields[i].second;
+  }
+  out << "}";
+  return out.str();
+}
+
+std::string to_yaml(const SearchStatistics& statistics) {
+  const auto fields = get_fields(statistics);
+  std::ostringstream out;
+  for (int i = 0; i < fields.size(); i++) {
+    if (i == COUNTERS_FIELD_INDEX) {
+      if (statistics.heuristic_counters.empty()) {
+        out << "heuristic_counters: {}\n";
+      } else {
+        out << "heuristic_counters:\n";
+        for (const auto& counter : statistics.heuristic_counters) {
+          out << "  " << counter.first << ": " << counter.second << "\n";
+        }
+      }
+    }
+    out << fields[i].first << ": " << fields[i].second << "\n";
+  }
+  return out.str();
+}
+
+}  // namespace search
+}  // namespace pushworld
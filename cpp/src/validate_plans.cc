@@ -0,0 +1,273 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>  // max, min, sort, transform
+#include <atomic>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "plan_validator.h"
+#include "puzzle_collection.h"
+#include "pushworld_puzzle.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+static const char* USAGE =
+    "Usage: validate_plans [options] <puzzles> <plans>...\n\n"
+    "Checks that every given plan solves its PushWorld puzzle, using a pool "
+    "of threads. Invalid plans are printed, and the exit code is 1 if any "
+    "plan is invalid.\n\n"
+    "Arguments:\n"
+    "    <puzzles> : A .pwp file, a directory that is searched recursively "
+    "for .pwp files, or a puzzle collection (a .zip archive such as "
+    "level0.zip, or a .pwpa archive of compiled puzzles). Plans refer to "
+    "puzzles by their file names without the extension.\n"
+    "    <plans>   : Paths of plan files, or directories that are searched "
+    "recursively for .yaml files. A .yaml file contains the `puzzle` and "
+    "`plan` keys, as in benchmark/solutions or the results of "
+    "`run_benchmark`. Any other file contains one puzzle name and plan per "
+    "line, separated by a space.\n\n"
+    "Options:\n"
+    "    --threads <N> : The number of plan files to validate in parallel. "
+    "Defaults to the number of hardware threads.\n"
+    "    --trace       : Prints the indices of the objects that move on each "
+    "action of every plan.\n\n";
+
+/* Returns the lowercase extension of the `path`. */
+std::string lowercase_extension(const fs::path& path) {
+  std::string extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension;
+}
+
+/**
+ * Finds the puzzles that plans can refer to, and loads them by name. Puzzles
+ * are loaded on demand, so that indexing a large collection is cheap.
+ */
+class PuzzleIndex {
+ private:
+  std::shared_ptr<const pushworld::PuzzleCollection> m_collection;
+
+  // Maps puzzle names to file paths, or to indices in `m_collection` as
+  // strings.
+  std::unordered_map<std::string, std::string> m_puzzles;
+
+  void add(const std::string& name, const std::string& location) {
+    if (!m_puzzles.emplace(name, location).second) {
+      throw std::invalid_argument("Multiple puzzles are named: " + name);
+    }
+  }
+
+ public:
+  explicit PuzzleIndex(const std::string& puzzles_path) {
+    if (pushworld::is_puzzle_collection(puzzles_path)) {
+      m_collection =
+          std::make_shared<const pushworld::PuzzleCollection>(puzzles_path);
+      for (size_t i = 0; i < m_collection->size(); i++) {
+        const fs::path name(m_collection->getName(i));
+        add(name.stem().string(), std::to_string(i));
+      }
+      return;
+    }
+
+    if (fs::is_regular_file(puzzles_path)) {
+      add(fs::path(puzzles_path).stem().string(), puzzles_path);
+      return;
+    }
+    if (!fs::is_directory(puzzles_path)) {
+      throw std::invalid_argument("No such file or directory: " +
+                                  puzzles_path);
+    }
+    for (const auto& entry : fs::recursive_directory_iterator(puzzles_path)) {
+      if (entry.is_regular_file() &&
+          lowercase_extension(entry.path()) == ".pwp") {
+        add(entry.path().stem().string(), entry.path().string());
+      }
+    }
+  }
+
+  /**
+   * Loads the puzzle with the given `name`. Throws `std::invalid_argument` if
+   * there is no such puzzle.
+   */
+  pushworld::PushWorldPuzzle load(const std::string& name) const {
+    const auto it = m_puzzles.find(name);
+    if (it == m_puzzles.end()) {
+      throw std::invalid_argument("Unknown puzzle: " + name);
+    }
+    if (m_collection != nullptr) {
+      return m_collection->getPuzzle(std::stoul(it->second));
+    }
+    return pushworld::PushWorldPuzzle(it->second);
+  }
+};
+
+/**
+ * Returns the plan files in the given paths. Directories are searched
+ * recursively for .yaml files, in sorted order.
+ */
+std::vector<std::string> find_plan_files(
+    const std::vector<std::string>& plans_paths) {
+  std::vector<std::string> plan_files;
+  for (const auto& path : plans_paths) {
+    if (!fs::is_directory(path)) {
+      plan_files.push_back(path);
+      continue;
+    }
+    std::vector<std::string> directory_files;
+    for (const auto& entry : fs::recursive_directory_iterator(path)) {
+      if (entry.is_regular_file() &&
+          lowercase_extension(entry.path()) == ".yaml") {
+        directory_files.push_back(entry.path().string());
+      }
+    }
+    std::sort(directory_files.begin(), directory_files.end());
+    plan_files.insert(plan_files.end(), directory_files.begin(),
+                      directory_files.end());
+  }
+  return plan_files;
+}
+
+/* Returns a line of the `trace` for the `t`-th action of the `plan`. */
+std::string format_trace_step(const std::string& plan, const size_t t,
+                              const std::vector<int>& moved_object_indices) {
+  std::string line = "  " + std::to_string(t) + " " + plan[t] + ":";
+  for (const int i : moved_object_indices) {
+    line += " " + std::to_string(i);
+  }
+  return line + "\n";
+}
+
+}  // namespace
+
+/**
+ * Validates every plan in the given files against the puzzles that they
+ * solve.
+ */
+int main(int argc, char* argv[]) {
+  try {
+    int num_threads = std::max(1u, std::thread::hardware_concurrency());
+    bool trace = false;
+    std::vector<std::string> args;
+
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      if (arg == "--threads") {
+        if (++i == argc) {
+          throw std::invalid_argument("Missing value for " + arg);
+        }
+        try {
+          num_threads = std::max(1, std::stoi(argv[i]));
+        } catch (const std::exception&) {
+          throw std::invalid_argument("Invalid value for " + arg + ": " +
+                                      argv[i]);
+        }
+      } else if (arg == "--trace") {
+        trace = true;
+      } else {
+        args.push_back(arg);
+      }
+    }
+
+    if (args.size() < 2) {
+      std::cout << USAGE;
+      return 0;
+    }
+
+    const PuzzleIndex puzzles(args[0]);
+    const auto plan_files =
+        find_plan_files(std::vector<std::string>(args.begin() + 1, args.end()));
+
+    std::atomic<size_t> next_file(0);
+    size_t num_valid = 0;
+    size_t num_invalid = 0;
+    std::mutex output_mutex;
+
+    // Each worker repeatedly claims the next plan file, so that plans are
+    // streamed from the files instead of being read up front.
+    auto worker = [&]() {
+      pushworld::PlanValidator validator;
+      size_t i;
+      while ((i = next_file++) < plan_files.size()) {
+        std::string output;
+        size_t file_valid = 0;
+        size_t file_invalid = 0;
+
+        try {
+          for (const auto& record :
+               pushworld::read_plan_file(plan_files[i])) {
+            const std::string prefix = record.source + ": " + record.puzzle;
+            try {
+              const auto result = validator.validate(
+                  puzzles.load(record.puzzle), record.plan, trace);
+              if (result.valid) {
+                file_valid++;
+              } else {
+                file_invalid++;
+              }
+              if (!result.valid || trace) {
+                output += prefix + ": " +
+                          result.failure_reason.value_or("valid") + "\n";
+              }
+              for (size_t t = 0; t < result.trace.size(); t++) {
+                output += format_trace_step(record.plan, t, result.trace[t]);
+              }
+            } catch (const std::exception& e) {
+              file_invalid++;
+              output += prefix + ": ERROR: " + e.what() + "\n";
+            }
+          }
+        } catch (const std::exception& e) {
+          file_invalid++;
+          output += plan_files[i] + ": ERROR: " + e.what() + "\n";
+        }
+
+        std::lock_guard<std::mutex> lock(output_mutex);
+        num_valid += file_valid;
+        num_invalid += file_invalid;
+        std::cout << output << std::flush;
+      }
+    };
+
+    std::vector<std::thread> threads;
+    const size_t pool_size = std::min<size_t>(num_threads, plan_files.size());
+    for (size_t i = 0; i < pool_size; i++) {
+      threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    std::cout << num_valid << " valid, " << num_invalid << " invalid\n";
+    return num_invalid == 0 ? 0 : 1;
+  } catch (std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << "\n";
+    return 1;
+  } catch (...) {
+    std::cerr << "UNKNOWN ERROR\n";
+    return 1;
+  }
+}
@@ -0,0 +1,116 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "heuristics/clock_cache.h"
+
+#include <stdlib.h>  // srand, rand
+
+#include <boost/test/unit_test.hpp>
+
+namespace pushworld {
+namespace heuristic {
+
+BOOST_AUTO_TEST_SUITE(clock_cache)
+
+/* Checks hits, misses, and statistics of a cache that never evicts. */
+BOOST_AUTO_TEST_CASE(test_find_and_insert) {
+  ClockCache<int, float> cache(1 << 16);
+  BOOST_TEST(cache.size() == 0);
+  BOOST_TEST(cache.capacity() > 100);
+  const size_t initial_memory_usage = cache.memoryUsage();
+
+  BOOST_TEST(cache.find(3) == nullptr);
+  cache.insert(3, 0.5f);
+  BOOST_TEST(cache.size() == 1);
+  BOOST_REQUIRE(cache.find(3) != nullptr);
+  BOOST_TEST(*cache.find(3) == 0.5f);
+  BOOST_TEST(cache.find(4) == nullptr);
+
+  for (int i = 10; i < 110; i++) {
+    cache.insert(i, i * 2.0f);
+  }
+  for (int i = 10; i < 110; i++) {
+    BOOST_REQUIRE(cache.find(i) != nullptr);
+    BOOST_TEST(*cache.find(i) == i * 2.0f);
+  }
+
+  // The table grows within its budget.
+  BOOST_TEST(cache.memoryUsage() > initial_memory_usage);
+  BOOST_TEST(cache.memoryUsage() <= 1 << 16);
+
+  const auto& statistics = cache.statistics();
+  BOOST_TEST(statistics.hits == 202);
+  BOOST_TEST(statistics.misses == 2);
+  BOOST_TEST(statistics.evictions == 0);
+}
+
+/* Checks that a full cache evicts unreferenced entries first. */
+BOOST_AUTO_TEST_CASE(test_eviction) {
+  // The smallest cache has 16 slots and capacity for 8 entries.
+  ClockCache<int, int> cache(0);
+  BOOST_TEST(cache.capacity() == 8);
+
+  for (int i = 0; i < 8; i++) {
+    cache.insert(i, -i);
+  }
+  // Reference every entry except 5.
+  for (int i = 0; i < 8; i++) {
+    if (i != 5) {
+      cache.find(i);
+    }
+  }
+
+  cache.insert(100, -100);
+  BOOST_TEST(cache.size() == 8);
+  BOOST_TEST(cache.statistics().evictions == 1);
+  BOOST_TEST(cache.find(5) == nullptr);
+  for (const int i : {0, 1, 2, 3, 4, 6, 7, 100}) {
+    BOOST_REQUIRE(cache.find(i) != nullptr);
+    BOOST_TEST(*cache.find(i) == -i);
+  }
+}
+
+/**
+ * Checks that all entries remain correct and reachable after many evictions,
+ * which shift entries in the hash table.
+ */
+BOOST_AUTO_TEST_CASE(test_random_operations) {
+  ClockCache<int, int> cache(1 << 10);
+
+  std::srand(0);
+  int num_errors = 0;
+  for (int i = 0; i < 20000; i++) {
+    const int key = std::rand() % 200;
+    const int* value = cache.find(key);
+    if (value == nullptr) {
+      cache.insert(key, key * 7);
+    } else if (*value != key * 7) {
+      num_errors++;
+    }
+    if (cache.size() > cache.capacity() || cache.memoryUsage() > 1 << 10) {
+      num_errors++;
+    }
+  }
+
+  BOOST_TEST(num_errors == 0);
+  const auto& statistics = cache.statistics();
+  BOOST_TEST(statistics.hits + statistics.misses == 20000);
+  BOOST_TEST(statistics.evictions == statistics.misses - cache.size());
+  BOOST_TEST(statistics.evictions > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace heuristic
+}  // namespace pushworld
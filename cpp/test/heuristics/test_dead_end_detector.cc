@@ -0,0 +1,120 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "heuristics/dead_end_detector.h"
+#include "heuristics/recursive_graph_distance.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace heuristic {
+
+BOOST_AUTO_TEST_SUITE(dead_end_detector)
+
+/**
+ * Checks the dead ends of a corridor in which the goal object can only be
+ * pushed to the right.
+ */
+BOOST_AUTO_TEST_CASE(test_dead_end_positions) {
+  const auto puzzle = PushWorldPuzzle::fromText("A M0 . G0 .\n");
+  const DeadEndDetector dead_ends(puzzle);
+
+  // The grid is surrounded by walls, so the corridor spans x = 1 to 5. The goal
+  // object cannot be pushed away from either end of the corridor. Its feasible
+  // movement graph ignores the agent, so it can reach the left end.
+  BOOST_TEST(!dead_ends.isDeadEndPosition(1, xy_to_position(2, 1)));
+  BOOST_TEST(!dead_ends.isDeadEndPosition(1, xy_to_position(3, 1)));
+  BOOST_TEST(!dead_ends.isDeadEndPosition(1, xy_to_position(4, 1)));
+  BOOST_TEST(dead_ends.isDeadEndPosition(1, xy_to_position(1, 1)));
+  BOOST_TEST(dead_ends.isDeadEndPosition(1, xy_to_position(5, 1)));
+  BOOST_TEST(dead_ends.numDeadEndPositions() == 2);
+
+  // Positions outside of the feasible movement graph are dead ends.
+  BOOST_TEST(dead_ends.isDeadEndPosition(1, xy_to_position(2, 2)));
+
+  // Objects without a goal are never in a dead end.
+  BOOST_TEST(!dead_ends.isDeadEndPosition(AGENT, xy_to_position(5, 1)));
+  BOOST_TEST(!dead_ends.isDeadEndPosition(2, xy_to_position(5, 1)));
+
+  const State initial_state = puzzle.getInitialState();
+  BOOST_TEST(!dead_ends.isDeadEnd(initial_state));
+  const State dead_end{xy_to_position(4, 1), xy_to_position(5, 1)};
+  BOOST_TEST(dead_ends.isDeadEnd(dead_end));
+
+  // Only the moved objects of a relative state are checked.
+  BOOST_TEST(dead_ends.isDeadEnd(RelativeState{dead_end, {AGENT, 1}}));
+  BOOST_TEST(!dead_ends.isDeadEnd(RelativeState{dead_end, {AGENT}}));
+}
+
+/* Checks that the initial state of an unsolvable puzzle is a dead end. */
+BOOST_AUTO_TEST_CASE(test_no_solution) {
+  const PushWorldPuzzle puzzle("puzzles/no_solution.pwp");
+  const DeadEndDetector dead_ends(puzzle);
+  BOOST_TEST(dead_ends.isDeadEnd(puzzle.getInitialState()));
+}
+
+/**
+ * Checks that every reachable state that is a dead end has an infinite cost
+ * in the RGD heuristic, and that dead ends occur.
+ */
+BOOST_AUTO_TEST_CASE(test_dead_ends_are_infinite) {
+  for (const std::string filename :
+       {"puzzles/multiple_goals.pwp", "puzzles/file_parsing.pwp",
+        "puzzles/many_objects.pwp"}) {
+    const auto puzzle = std::make_shared<PushWorldPuzzle>(filename);
+    const DeadEndDetector dead_ends(*puzzle);
+    RecursiveGraphDistanceHeuristic rgd(puzzle);
+
+    StateSet visited{puzzle->getInitialState()};
+    std::deque<State> frontier{puzzle->getInitialState()};
+    RelativeState next;
+    std::vector<int> all_object_indices(puzzle->getInitialState().size());
+    for (int i = 0; i < all_object_indices.size(); i++) {
+      all_object_indices[i] = i;
+    }
+    int num_dead_ends = 0;
+
+    while (!frontier.empty() && visited.size() < 5000) {
+      const State state = frontier.front();
+      frontier.pop_front();
+
+      for (int action = 0; action < NUM_ACTIONS; action++) {
+        if (!puzzle->getNextState(state, action, next) ||
+            !visited.insert(next.state).second) {
+          continue;
+        }
+        frontier.push_back(next.state);
+
+        if (dead_ends.isDeadEnd(next.state)) {
+          num_dead_ends++;
+          BOOST_TEST(std::isinf(rgd.estimate_cost_to_goal(
+              RelativeState{next.state, all_object_indices})));
+        }
+      }
+    }
+
+    BOOST_TEST(num_dead_ends > 0);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace heuristic
+}  // namespace pushworld
@@ -151,6 +151,80 @@ BOOST_AUTO_TEST_CASE(test_path_distances) {
   }
 }
 
+/* Checks that `DenseMovementGraph` stores the same edges as its source graph. */
+BOOST_AUTO_TEST_CASE(test_dense_movement_graph) {
+  PushWorldPuzzle puzzle("puzzles/shortest_path_tool.pwp");
+  const auto movement_graphs = build_feasible_movement_graphs(puzzle);
+
+  for (const auto& pair : movement_graphs) {
+    const auto& graph = *pair.second;
+    const DenseMovementGraph dense_graph(graph);
+    BOOST_TEST(dense_graph.numNodes() == graph.size());
+
+    Position2D previous_position = -1;
+    for (int i = 0; i < dense_graph.numNodes(); i++) {
+      // Node indices are assigned in increasing order of positions.
+      const Position2D position = dense_graph.getPosition(i);
+      BOOST_TEST(position > previous_position);
+      previous_position = position;
+      BOOST_TEST(dense_graph.getNodeIndex(position) == i);
+
+      const auto& next_positions = graph.at(position);
+      for (Action action = 0; action < NUM_ACTIONS; action++) {
+        const bool has_edge = dense_graph.getActionMask(i) & (1 << action);
+        const Position2D next_position =
+            position + ACTION_DISPLACEMENTS[action];
+        BOOST_TEST(has_edge == (next_positions.count(next_position) == 1));
+        if (has_edge) {
+          BOOST_TEST(dense_graph.getNextNodeIndex(i, action) ==
+                     dense_graph.getNodeIndex(next_position));
+        }
+      }
+    }
+
+    BOOST_TEST(dense_graph.getNodeIndex(xy_to_position(100, 100)) == -1);
+    BOOST_TEST(dense_graph.getNodeIndex(xy_to_position(-1, -1)) == -1);
+  }
+}
+
+/* Checks that `AllPairsPathDistances` matches `PathDistances`. */
+BOOST_AUTO_TEST_CASE(test_all_pairs_path_distances) {
+  for (const auto filename :
+       {"puzzles/trivial.pwp", "puzzles/trivial_tool.pwp",
+        "puzzles/shortest_path_tool.pwp", "puzzles/file_parsing.pwp"}) {
+    PushWorldPuzzle puzzle(filename);
+    const auto movement_graphs = build_feasible_movement_graphs(puzzle);
+
+    for (const auto& pair : movement_graphs) {
+      const auto& graph = *pair.second;
+      const PathDistances expected(pair.second);
+
+      for (const int num_threads : {1, 3}) {
+        const AllPairsPathDistances distances(graph, num_threads);
+        BOOST_TEST(distances.numNodes() == graph.size());
+
+        int num_mismatches = 0;
+        for (const auto& start : graph) {
+          for (const auto& target : graph) {
+            if (distances.getDistance(start.first, target.first) !=
+                expected.getDistance(start.first, target.first)) {
+              num_mismatches++;
+            }
+          }
+        }
+        BOOST_TEST(num_mismatches == 0);
+
+        // Positions outside of the graph are unreachable.
+        const auto start = graph.begin()->first;
+        BOOST_TEST(distances.getDistance(start, xy_to_position(100, 100)) ==
+                   std::numeric_limits<float>::infinity());
+        BOOST_TEST(distances.getDistance(xy_to_position(-1, 0), start) ==
+                   std::numeric_limits<float>::infinity());
+      }
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace heuristic
@@ -0,0 +1,108 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <boost/test/unit_test.hpp>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>  // pair
+#include <vector>
+
+#include "heuristics/heuristic.h"
+#include "heuristics/lexicographic.h"
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+namespace heuristic {
+
+BOOST_AUTO_TEST_SUITE(lexicographic_heuristic)
+
+namespace {
+
+/* A heuristic that returns a fixed cost and counts how often it is called. */
+class ConstantHeuristic : public Heuristic<float> {
+ public:
+  float cost;
+  int num_calls;
+
+  ConstantHeuristic(const float cost) : cost(cost), num_calls(0){};
+  float estimate_cost_to_goal(const RelativeState& relative_state) {
+    num_calls++;
+    return cost;
+  }
+};
+
+}  // namespace
+
+/* Checks `LexicographicHeuristic`. */
+BOOST_AUTO_TEST_CASE(test_lexicographic_heuristic) {
+  const float INF = std::numeric_limits<float>::infinity();
+  RelativeState relative_state;
+
+  auto primary = std::make_shared<ConstantHeuristic>(2.0f);
+  auto secondary = std::make_shared<ConstantHeuristic>(7.0f);
+  LexicographicHeuristic h(primary, secondary);
+
+  BOOST_TEST((h.estimate_cost_to_goal(relative_state) ==
+              std::make_pair(2.0f, 7.0f)));
+
+  // Any infinite cost makes both components infinite, and both heuristics are
+  // always evaluated.
+  secondary->cost = INF;
+  BOOST_TEST((h.estimate_cost_to_goal(relative_state) ==
+              std::make_pair(INF, INF)));
+
+  primary->cost = INF;
+  secondary->cost = 1.0f;
+  BOOST_TEST((h.estimate_cost_to_goal(relative_state) ==
+              std::make_pair(INF, INF)));
+  BOOST_TEST(primary->num_calls == 3);
+  BOOST_TEST(secondary->num_calls == 3);
+
+  BOOST_CHECK_THROW(LexicographicHeuristic(nullptr, secondary),
+                    std::invalid_argument);
+}
+
+/**
+ * Checks that `LexicographicHeuristic::estimate_costs` returns the same costs
+ * as `estimate_cost_to_goal`, and evaluates each heuristic once per state.
+ */
+BOOST_AUTO_TEST_CASE(test_estimate_costs) {
+  const float INF = std::numeric_limits<float>::infinity();
+  const std::vector<RelativeState> states(4);
+
+  auto primary = std::make_shared<ConstantHeuristic>(2.0f);
+  auto secondary = std::make_shared<ConstantHeuristic>(7.0f);
+  LexicographicHeuristic h(primary, secondary);
+
+  std::vector<std::pair<float, float>> costs(states.size());
+  h.estimate_costs(states.data(), states.size(), costs.data());
+  for (const auto& cost : costs) {
+    BOOST_TEST((cost == std::make_pair(2.0f, 7.0f)));
+  }
+  BOOST_TEST(primary->num_calls == 4);
+  BOOST_TEST(secondary->num_calls == 4);
+
+  secondary->cost = INF;
+  h.estimate_costs(states.data(), 2, costs.data());
+  BOOST_TEST((costs[0] == std::make_pair(INF, INF)));
+  BOOST_TEST((costs[1] == std::make_pair(INF, INF)));
+  BOOST_TEST((costs[2] == std::make_pair(2.0f, 7.0f)));
+  BOOST_TEST(primary->num_calls == 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace heuristic
+}  // namespace pushworld
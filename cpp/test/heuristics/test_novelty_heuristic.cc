@@ -16,6 +16,7 @@
 #include <deque>
 #include <numeric>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "heuristics/novelty.h"
@@ -165,6 +166,104 @@ BOOST_AUTO_TEST_CASE(test_alternative_implementation) {
              num_test_states);
 }
 
+/**
+ * Checks that `NoveltyHeuristic` returns identical costs when it stores visited
+ * positions in dense bitmaps, with and without falling back to hash sets for
+ * pairs of objects.
+ */
+BOOST_AUTO_TEST_CASE(test_dense_tables) {
+  PushWorldPuzzle puzzle("puzzles/file_parsing.pwp");
+  const State& initial_state = puzzle.getInitialState();
+
+  std::vector<int> all_object_indices(initial_state.size());
+  std::iota(all_object_indices.begin(), all_object_indices.end(), 0);
+
+  StateSet visited_states;
+  visited_states.insert(initial_state);
+
+  std::deque<RelativeState> frontier;
+  frontier.push_back(RelativeState{initial_state, all_object_indices});
+
+  NoveltyHeuristic hashed_heuristic(initial_state.size());
+  NoveltyHeuristic dense_heuristic(puzzle);
+  NoveltyHeuristic fallback_heuristic(puzzle, 0);
+  NoveltyHeuristic mixed_heuristic(puzzle, 100);
+
+  // The dense bitmaps are allocated up front, while the hash sets grow.
+  const size_t initial_hashed_bytes = hashed_heuristic.memory_usage();
+  const size_t initial_dense_bytes = dense_heuristic.memory_usage();
+  BOOST_TEST(initial_dense_bytes > 0);
+
+  int num_mismatches = 0;
+
+  for (int i = 0; i < 1000; i++) {
+    const RelativeState relative_state = frontier.front();
+    frontier.pop_front();
+
+    const auto cost = hashed_heuristic.estimate_cost_to_goal(relative_state);
+    if (dense_heuristic.estimate_cost_to_goal(relative_state) != cost ||
+        fallback_heuristic.estimate_cost_to_goal(relative_state) != cost ||
+        mixed_heuristic.estimate_cost_to_goal(relative_state) != cost) {
+      num_mismatches++;
+    }
+
+    for (int action = 0; action < NUM_ACTIONS; action++) {
+      RelativeState next_relative_state =
+          puzzle.getNextState(relative_state.state, action);
+      if (visited_states.insert(next_relative_state.state).second) {
+        frontier.push_back(std::move(next_relative_state));
+      }
+    }
+  }
+
+  BOOST_TEST(num_mismatches == 0);
+  BOOST_TEST(hashed_heuristic.memory_usage() > initial_hashed_bytes);
+  BOOST_TEST(dense_heuristic.memory_usage() == initial_dense_bytes);
+
+  // Positions that are not in any movement graph are stored in hash sets.
+  RelativeState unreachable_state{initial_state, all_object_indices};
+  unreachable_state.state[1] = xy_to_position(100, 100);
+  BOOST_TEST(dense_heuristic.estimate_cost_to_goal(unreachable_state) == 1);
+  BOOST_TEST(dense_heuristic.estimate_cost_to_goal(unreachable_state) == 3);
+}
+
+/**
+ * Checks that interchangeable objects share their visited positions, so that
+ * permuting them does not result in a novel state.
+ */
+BOOST_AUTO_TEST_CASE(test_interchangeable_objects) {
+  PushWorldPuzzle puzzle("puzzles/many_objects.pwp");
+  const State& initial_state = puzzle.getInitialState();
+
+  std::vector<int> all_object_indices(initial_state.size());
+  std::iota(all_object_indices.begin(), all_object_indices.end(), 0);
+
+  // M2 and M9 are interchangeable, whereas M1 is the goal object.
+  RelativeState swapped_state{initial_state, all_object_indices};
+  std::swap(swapped_state.state[2], swapped_state.state[9]);
+  RelativeState shifted_state = swapped_state;
+  std::swap(shifted_state.state[1], shifted_state.state[2]);
+
+  for (const size_t max_pair_bits :
+       {NoveltyHeuristic::DEFAULT_MAX_PAIR_BITS, size_t(0)}) {
+    NoveltyHeuristic heuristic(puzzle, max_pair_bits, true);
+    BOOST_TEST(heuristic.estimate_cost_to_goal(
+                   RelativeState{initial_state, all_object_indices}) == 1);
+    BOOST_TEST(heuristic.estimate_cost_to_goal(swapped_state) == 3);
+    BOOST_TEST(heuristic.estimate_cost_to_goal(shifted_state) < 3);
+  }
+
+  // By default, and without the puzzle, objects are distinguished by their
+  // indices.
+  NoveltyHeuristic dense_heuristic(puzzle);
+  NoveltyHeuristic hashed_heuristic(initial_state.size());
+  for (auto* heuristic : {&dense_heuristic, &hashed_heuristic}) {
+    heuristic->estimate_cost_to_goal(
+        RelativeState{initial_state, all_object_indices});
+    BOOST_TEST(heuristic->estimate_cost_to_goal(swapped_state) == 1);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace heuristic
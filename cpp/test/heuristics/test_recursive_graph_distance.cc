@@ -12,11 +12,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <stdlib.h>  // srand, rand
+
+#include <algorithm>  // max
 #include <boost/test/unit_test.hpp>
+#include <limits>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "heuristics/recursive_graph_distance.h"
 #include "pushworld_puzzle.h"
+#include "search/search_context.h"
 
 namespace pushworld {
 namespace heuristic {
@@ -140,6 +147,137 @@ BOOST_AUTO_TEST_CASE(test_transitive_pushing) {
   BOOST_TEST(h9.estimate_cost_to_goal(s0) == 6);
 }
 
+/**
+ * Checks that small pushing-cost caches evict entries without changing the
+ * estimated costs, and that they never grow beyond their memory budget.
+ */
+BOOST_AUTO_TEST_CASE(test_bounded_pushing_cost_cache) {
+  const auto puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/shortest_path_tool.pwp");
+  std::srand(0);
+  std::vector<RelativeState> states{{puzzle->getInitialState(), {}}};
+  for (int i = 0; i < 300; i++) {
+    states.push_back(
+        puzzle->getNextState(states.back().state, std::rand() % NUM_ACTIONS));
+  }
+
+  RecursiveGraphDistanceHeuristic rgd(puzzle);
+  std::vector<float> costs;
+  for (const auto& s : states) {
+    costs.push_back(rgd.estimate_cost_to_goal(s));
+  }
+  BOOST_TEST(rgd.getPushingCostCacheStatistics().evictions == 0);
+  BOOST_TEST(rgd.getPushingCostCacheStatistics().hits > 0);
+
+  for (const size_t max_bytes : {size_t(0), size_t(4096)}) {
+    RecursiveGraphDistanceHeuristic bounded_rgd(puzzle, true, max_bytes);
+
+    // The table always has room for a minimum number of entries.
+    const size_t memory_bound =
+        std::max(max_bytes, bounded_rgd.getPushingCostCacheMemoryUsage());
+
+    int num_mismatches = 0;
+    int num_overflows = 0;
+    for (size_t i = 0; i < states.size(); i++) {
+      if (bounded_rgd.estimate_cost_to_goal(states[i]) != costs[i]) {
+        num_mismatches++;
+      }
+      if (bounded_rgd.getPushingCostCacheMemoryUsage() > memory_bound) {
+        num_overflows++;
+      }
+    }
+    BOOST_TEST(num_mismatches == 0);
+    BOOST_TEST(num_overflows == 0);
+
+    BOOST_TEST(bounded_rgd.getPushingCostCacheStatistics().evictions > 0);
+    BOOST_TEST(bounded_rgd.getPushingCostCacheMemoryUsage() <
+               rgd.getPushingCostCacheMemoryUsage());
+  }
+}
+
+/**
+ * Checks that heuristics with shared `RecursiveGraphDistanceTables` return the
+ * same costs as independent heuristics, including from concurrent threads.
+ */
+BOOST_AUTO_TEST_CASE(test_shared_tables) {
+  const auto puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/shortest_path_tool.pwp");
+
+  // Collect states from a random walk.
+  std::srand(0);
+  std::vector<State> states{puzzle->getInitialState()};
+  for (int i = 0; i < 300; i++) {
+    states.push_back(
+        puzzle->getNextState(states.back(), std::rand() % NUM_ACTIONS).state);
+  }
+
+  for (const bool fewest_tools : {true, false}) {
+    RecursiveGraphDistanceHeuristic independent(puzzle, fewest_tools);
+    std::vector<float> expected_costs;
+    for (const auto& state : states) {
+      expected_costs.push_back(
+          independent.estimate_cost_to_goal(RelativeState{state, {}}));
+    }
+
+    const auto tables =
+        std::make_shared<const RecursiveGraphDistanceTables>(*puzzle, 2);
+    const int num_threads = 3;
+    std::vector<int> num_mismatches(num_threads, 0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t]() {
+        RecursiveGraphDistanceHeuristic shared(puzzle, tables, fewest_tools);
+        for (int i = 0; i < states.size(); i++) {
+          if (shared.estimate_cost_to_goal(RelativeState{states[i], {}}) !=
+              expected_costs[i]) {
+            num_mismatches[t]++;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+      BOOST_TEST(num_mismatches[t] == 0);
+    }
+  }
+}
+
+/**
+ * Checks that evaluations return early once the search context must stop, and
+ * only while the context is set.
+ */
+BOOST_AUTO_TEST_CASE(test_search_context) {
+  const auto puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/transitive_pushing.pwp");
+  const RelativeState s0{puzzle->getInitialState(), {}};
+  RecursiveGraphDistanceHeuristic rgd(puzzle, false /* fewest_tools */);
+
+  search::SearchContext context;
+  rgd.set_search_context(&context);
+  for (int i = 0; i < RecursiveGraphDistanceHeuristic::CONTEXT_CHECK_INTERVAL;
+       i++) {
+    BOOST_TEST(rgd.estimate_cost_to_goal(s0) == 3);
+  }
+
+  // The context is checked once every `CONTEXT_CHECK_INTERVAL` recursive
+  // pushing costs, and every evaluation computes at least one.
+  context.cancel();
+  bool stopped = false;
+  for (int i = 0; i < RecursiveGraphDistanceHeuristic::CONTEXT_CHECK_INTERVAL;
+       i++) {
+    stopped = stopped || rgd.estimate_cost_to_goal(s0) ==
+                             std::numeric_limits<float>::infinity();
+  }
+  BOOST_TEST(stopped);
+
+  rgd.set_search_context(nullptr);
+  BOOST_TEST(rgd.estimate_cost_to_goal(s0) == 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace heuristic
@@ -14,6 +14,7 @@
 
 #include <boost/test/unit_test.hpp>
 #include <memory>
+#include <vector>
 
 #include "heuristics/heuristic.h"
 #include "heuristics/weighted_sum.h"
@@ -61,6 +62,28 @@ BOOST_AUTO_TEST_CASE(test_novelty_heuristic) {
   }
 }
 
+/**
+ * Checks that `WeightedSumHeuristic::estimate_costs` returns the same costs as
+ * `estimate_cost_to_goal`.
+ */
+BOOST_AUTO_TEST_CASE(test_estimate_costs) {
+  const std::vector<RelativeState> states(5);
+  HeuristicsAndWeights heuristics_and_weights = {
+      {std::make_shared<ConstantHeuristic>(3.0f), 0.5f},
+      {std::make_shared<ConstantHeuristic>(-1.0f), 2.0f},
+      {std::make_shared<ConstantHeuristic>(4.0f), 1.0f}};
+  WeightedSumHeuristic h(heuristics_and_weights);
+
+  std::vector<float> costs(states.size(), -100.0f);
+  h.estimate_costs(states.data(), states.size(), costs.data());
+  for (const float cost : costs) {
+    BOOST_TEST(cost == h.estimate_cost_to_goal(states[0]));
+  }
+
+  // An empty batch does not write any cost.
+  h.estimate_costs(states.data(), 0, nullptr);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace heuristic
@@ -0,0 +1,133 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "search/anytime_search.h"
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "heuristics/recursive_graph_distance.h"
+#include "pushworld_puzzle.h"
+#include "search/priority_queue.h"
+
+namespace pushworld {
+namespace search {
+
+BOOST_AUTO_TEST_SUITE(anytime_search_suite)
+
+namespace {
+
+/* Returns the length of a shortest plan, found with breadth-first search. */
+int shortest_plan_length(const PushWorldPuzzle& puzzle) {
+  StateSet visited{puzzle.getInitialState()};
+  std::deque<std::pair<State, int>> frontier{{puzzle.getInitialState(), 0}};
+  RelativeState next;
+
+  while (!frontier.empty()) {
+    const auto [state, length] = frontier.front();
+    frontier.pop_front();
+    if (puzzle.satisfiesGoal(state)) {
+      return length;
+    }
+    for (int action = 0; action < NUM_ACTIONS; action++) {
+      if (puzzle.getNextState(state, action, next) &&
+          visited.insert(next.state).second) {
+        frontier.emplace_back(next.state, length + 1);
+      }
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
+/**
+ * Checks that every reported plan is valid and shorter than the previous plan,
+ * and that the search finds a shortest plan when it has enough time.
+ */
+BOOST_AUTO_TEST_CASE(test_anytime_search) {
+  for (const std::string filename :
+       {"puzzles/multiple_goals.pwp", "puzzles/easy_search.pwp",
+        "puzzles/trivial.pwp"}) {
+    const auto puzzle = std::make_shared<PushWorldPuzzle>(filename);
+    heuristic::RecursiveGraphDistanceHeuristic rgd(puzzle);
+    priority_queue::IntegerBucketPriorityQueue<NodeId, float> frontier;
+    const heuristic::DeadEndDetector dead_ends(*puzzle);
+
+    std::vector<Plan> plans;
+    AnytimeSearchOptions options;
+    options.on_plan = [&](const Plan& plan) { plans.push_back(plan); };
+
+    SearchStatistics statistics;
+    const auto plan = anytime_search(*puzzle, rgd, frontier, rgd, options,
+                                     &statistics, &dead_ends);
+    BOOST_TEST(!plans.empty());
+    for (int i = 0; i < plans.size(); i++) {
+      BOOST_TEST(puzzle->isValidPlan(plans[i]));
+      if (i > 0) {
+        BOOST_TEST(plans[i].size() < plans[i - 1].size());
+      }
+    }
+    BOOST_TEST(*plan == plans.back());
+    BOOST_TEST(plan->size() == shortest_plan_length(*puzzle));
+    BOOST_TEST(statistics.expansions > 0);
+    BOOST_TEST(statistics.total_seconds > 0.0);
+  }
+}
+
+/* Checks that the search returns soon after the deadline. */
+BOOST_AUTO_TEST_CASE(test_anytime_search_deadline) {
+  const auto puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/many_objects.pwp");
+  heuristic::RecursiveGraphDistanceHeuristic rgd(puzzle);
+  priority_queue::IntegerBucketPriorityQueue<NodeId, float> frontier;
+
+  AnytimeSearchOptions options;
+  options.deadline = std::chrono::steady_clock::now();
+  SearchStatistics statistics;
+  const auto plan =
+      anytime_search(*puzzle, rgd, frontier, rgd, options, &statistics);
+  if (plan != std::nullopt) {
+    BOOST_TEST(puzzle->isValidPlan(*plan));
+  }
+  BOOST_TEST(statistics.total_seconds < 1.0);
+}
+
+/* Checks that the search rejects weights that are not positive. */
+BOOST_AUTO_TEST_CASE(test_anytime_search_weights) {
+  const auto puzzle = std::make_shared<PushWorldPuzzle>("puzzles/trivial.pwp");
+  heuristic::RecursiveGraphDistanceHeuristic rgd(puzzle);
+  priority_queue::IntegerBucketPriorityQueue<NodeId, float> frontier;
+
+  AnytimeSearchOptions options;
+  options.weights = {2, 0};
+  BOOST_CHECK_THROW(anytime_search(*puzzle, rgd, frontier, rgd, options),
+                    std::invalid_argument);
+
+  // Without weighted A* searches, the first plan is returned.
+  options.weights.clear();
+  const auto plan = anytime_search(*puzzle, rgd, frontier, rgd, options);
+  BOOST_TEST(puzzle->isValidPlan(*plan));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace search
+}  // namespace pushworld
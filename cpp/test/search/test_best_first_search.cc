@@ -13,11 +13,15 @@
 // limitations under the License.
 
 #include <boost/test/unit_test.hpp>
+#include <limits>
 #include <memory>
 
+#include "heuristics/dead_end_detector.h"
 #include "pushworld_puzzle.h"
 #include "search/best_first_search.h"
 #include "search/priority_queue.h"
+#include "search/random_action_iterator.h"
+#include "search/search_context.h"
 
 namespace pushworld {
 namespace search {
@@ -35,6 +39,15 @@ class NullHeuristic : public pushworld::heuristic::Heuristic<int> {
   };
 };
 
+/* Always returns an infinite cost to the goal. */
+class InfiniteHeuristic : public pushworld::heuristic::Heuristic<float> {
+ public:
+  float estimate_cost_to_goal(
+      const pushworld::RelativeState& /*relative_state*/) override {
+    return std::numeric_limits<float>::infinity();
+  };
+};
+
 /* Computes the sum of Manhattan distances of each object from its goal
  * position. */
 class ManhattanDistanceHeuristic : public pushworld::heuristic::Heuristic<int> {
@@ -77,6 +90,29 @@ class InvertedManhattanDistanceHeuristic
   };
 };
 
+/**
+ * Always returns zero cost to the goal, and cancels the `context` on the
+ * `cancel_at`-th evaluation.
+ */
+class CancellingHeuristic : public pushworld::heuristic::Heuristic<int> {
+ private:
+  SearchContext& m_context;
+  const int m_cancel_at;
+  int m_evaluations;
+
+ public:
+  CancellingHeuristic(SearchContext& context, const int cancel_at)
+      : m_context(context), m_cancel_at(cancel_at), m_evaluations(0){};
+
+  int estimate_cost_to_goal(
+      const pushworld::RelativeState& relative_state) override {
+    if (++m_evaluations == m_cancel_at) {
+      m_context.cancel();
+    }
+    return 0;
+  };
+};
+
 }  // namespace
 
 BOOST_AUTO_TEST_CASE(test_best_first_search) {
@@ -124,6 +160,311 @@ BOOST_AUTO_TEST_CASE(test_best_first_search) {
   BOOST_TEST(*plan == expected_plan);
 }
 
+/* Checks the variant of `best_first_search` that stores nodes in an arena. */
+BOOST_AUTO_TEST_CASE(test_best_first_search_arena) {
+  NullHeuristic null_heuristic;
+  priority_queue::FibonacciPriorityQueue<NodeId, int> frontier;
+  SearchNodeStore nodes;
+
+  pushworld::PushWorldPuzzle easy_search_puzzle("puzzles/easy_search.pwp");
+  PackedStateSet visited{StatePacker(easy_search_puzzle)};
+  ManhattanDistanceHeuristic distance_heuristic(easy_search_puzzle.getGoal());
+
+  auto plan = best_first_search(easy_search_puzzle, distance_heuristic,
+                                frontier, visited, nodes);
+  BOOST_TEST(plan->size() == 3);
+  BOOST_TEST(easy_search_puzzle.isValidPlan(*plan));
+  // Every visited state has exactly one node. Unlike `StateSet` above, the
+  // visited states include the goal state.
+  BOOST_TEST(nodes.size() == visited.size());
+  BOOST_TEST(visited.size() >= 10);
+  BOOST_TEST(visited.size() <= 13);
+
+  // The search should terminate if no solution exists.
+  pushworld::PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+  PackedStateSet no_solution_visited{StatePacker(no_solution_puzzle)};
+  plan = best_first_search(no_solution_puzzle, null_heuristic, frontier,
+                           no_solution_visited, nodes);
+  BOOST_CHECK(plan == std::nullopt);
+  BOOST_CHECK(frontier.empty());
+  BOOST_CHECK(no_solution_visited.size() == 9);
+  BOOST_CHECK(nodes.size() == 9);
+
+  // Check a puzzle with only one possible solution.
+  pushworld::PushWorldPuzzle trivial_puzzle("puzzles/trivial.pwp");
+  PackedStateSet trivial_visited{StatePacker(trivial_puzzle)};
+  plan = best_first_search(trivial_puzzle, null_heuristic, frontier,
+                           trivial_visited, nodes);
+  pushworld::Plan expected_plan{pushworld::RIGHT, pushworld::DOWN,
+                                pushworld::RIGHT, pushworld::UP};
+  BOOST_TEST(*plan == expected_plan);
+}
+
+/**
+ * Checks that plans are valid in a puzzle with interchangeable objects, both
+ * by default and when its states are visited in their canonical form.
+ */
+BOOST_AUTO_TEST_CASE(test_best_first_search_interchangeable_objects) {
+  pushworld::PushWorldPuzzle puzzle("puzzles/many_objects.pwp");
+  BOOST_TEST(!puzzle.getInterchangeableObjects().empty());
+  ManhattanDistanceHeuristic distance_heuristic(puzzle.getGoal());
+
+  priority_queue::FibonacciPriorityQueue<NodeId, int> frontier;
+  SearchNodeStore nodes;
+  PackedStateSet visited{StatePacker(puzzle)};
+  auto plan =
+      best_first_search(puzzle, distance_heuristic, frontier, visited, nodes);
+  BOOST_TEST(plan.has_value());
+  BOOST_TEST(puzzle.isValidPlan(*plan));
+
+  const SearchContext context;
+  auto result = best_first_search(puzzle, distance_heuristic, frontier,
+                                  visited, nodes, context, nullptr, nullptr,
+                                  RandomActionIterator::DEFAULT_SEED, true);
+  BOOST_CHECK(result.status == SearchStatus::SOLVED);
+  BOOST_TEST(puzzle.isValidPlan(*result.plan));
+
+  // Only canonical states are visited.
+  State state;
+  for (size_t i = 0; i < visited.size(); i++) {
+    visited.getState(PackedStateSet::Index(i), state);
+    BOOST_TEST(!puzzle.canonicalize(state));
+  }
+
+  // The goal is also reached when states are evaluated lazily.
+  for (const bool canonicalize_objects : {false, true}) {
+    priority_queue::FibonacciPriorityQueue<NodeId, int> lazy_frontier;
+    SearchNodeStore lazy_nodes;
+    PackedStateSet lazy_visited{StatePacker(puzzle)};
+    result = lazy_best_first_search(
+        puzzle, distance_heuristic, lazy_frontier, lazy_visited, lazy_nodes,
+        context, nullptr, nullptr, RandomActionIterator::DEFAULT_SEED,
+        canonicalize_objects);
+    BOOST_CHECK(result.status == SearchStatus::SOLVED);
+    BOOST_TEST(puzzle.isValidPlan(*result.plan));
+  }
+}
+
+/* Checks the statistics that the arena variant of `best_first_search` reports. */
+BOOST_AUTO_TEST_CASE(test_best_first_search_statistics) {
+  priority_queue::FibonacciPriorityQueue<NodeId, int> frontier;
+  SearchNodeStore nodes;
+  SearchStatistics statistics;
+
+  pushworld::PushWorldPuzzle easy_search_puzzle("puzzles/easy_search.pwp");
+  PackedStateSet visited{StatePacker(easy_search_puzzle)};
+  ManhattanDistanceHeuristic distance_heuristic(easy_search_puzzle.getGoal());
+
+  auto plan = best_first_search(easy_search_puzzle, distance_heuristic,
+                                frontier, visited, nodes, &statistics);
+  BOOST_TEST(easy_search_puzzle.isValidPlan(*plan));
+  BOOST_TEST(statistics.expansions > 0);
+  // Every new state except the goal is evaluated, and so is the initial state.
+  // The new siblings of the goal are not evaluated, since the successors of
+  // each expansion are evaluated as a batch after the goal check.
+  BOOST_TEST(statistics.generations - statistics.duplicates + 1 ==
+             visited.size());
+  BOOST_TEST(statistics.evaluations <= visited.size() - 1);
+  BOOST_TEST(statistics.evaluations + NUM_ACTIONS > visited.size() - 1);
+  BOOST_TEST(statistics.max_frontier_size > 0);
+  BOOST_TEST(statistics.max_frontier_size <= statistics.evaluations);
+  BOOST_TEST(statistics.total_seconds >= statistics.heuristic_seconds);
+
+  // Statistics from a previous search are reset.
+  NullHeuristic null_heuristic;
+  pushworld::PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+  PackedStateSet no_solution_visited{StatePacker(no_solution_puzzle)};
+  plan = best_first_search(no_solution_puzzle, null_heuristic, frontier,
+                           no_solution_visited, nodes, &statistics);
+  BOOST_CHECK(plan == std::nullopt);
+  BOOST_TEST(statistics.expansions == 9);
+  BOOST_TEST(statistics.evaluations == 9);
+  BOOST_TEST(statistics.generations - statistics.duplicates == 8);
+  BOOST_TEST(statistics.heuristic_counters.empty());
+}
+
+/**
+ * Checks that the arena variant of `best_first_search` discards dead ends
+ * before evaluating the heuristic.
+ */
+BOOST_AUTO_TEST_CASE(test_best_first_search_dead_ends) {
+  priority_queue::FibonacciPriorityQueue<NodeId, int> frontier;
+  SearchNodeStore nodes;
+  SearchStatistics statistics;
+  SearchStatistics pruned_statistics;
+
+  pushworld::PushWorldPuzzle puzzle("puzzles/multiple_goals.pwp");
+  const heuristic::DeadEndDetector dead_ends(puzzle);
+  PackedStateSet visited{StatePacker(puzzle)};
+  ManhattanDistanceHeuristic distance_heuristic(puzzle.getGoal());
+
+  auto plan = best_first_search(puzzle, distance_heuristic, frontier, visited,
+                                nodes, &statistics);
+  auto pruned_plan = best_first_search(puzzle, distance_heuristic, frontier,
+                                       visited, nodes, &pruned_statistics,
+                                       &dead_ends);
+  BOOST_TEST(puzzle.isValidPlan(*pruned_plan));
+  BOOST_TEST(statistics.dead_ends == 0);
+  BOOST_TEST(pruned_statistics.dead_ends > 0);
+  BOOST_TEST(pruned_statistics.evaluations < statistics.evaluations);
+  // Dead ends are not visited.
+  BOOST_TEST(pruned_statistics.generations - pruned_statistics.duplicates -
+                 pruned_statistics.dead_ends + 1 ==
+             visited.size());
+
+  // The initial state of this puzzle is a dead end.
+  NullHeuristic null_heuristic;
+  pushworld::PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+  const heuristic::DeadEndDetector no_solution_dead_ends(no_solution_puzzle);
+  PackedStateSet no_solution_visited{StatePacker(no_solution_puzzle)};
+  plan = best_first_search(no_solution_puzzle, null_heuristic, frontier,
+                           no_solution_visited, nodes, &statistics,
+                           &no_solution_dead_ends);
+  BOOST_CHECK(plan == std::nullopt);
+  BOOST_TEST(statistics.expansions == 0);
+  BOOST_TEST(statistics.evaluations == 0);
+}
+
+/**
+ * Checks that the arena variant of `best_first_search` stops with a distinct
+ * status when a limit of its context is reached.
+ */
+BOOST_AUTO_TEST_CASE(test_best_first_search_context) {
+  priority_queue::FibonacciPriorityQueue<NodeId, int> frontier;
+  SearchNodeStore nodes;
+  SearchStatistics statistics;
+  NullHeuristic null_heuristic;
+
+  pushworld::PushWorldPuzzle easy_search_puzzle("puzzles/easy_search.pwp");
+  PackedStateSet visited{StatePacker(easy_search_puzzle)};
+  ManhattanDistanceHeuristic distance_heuristic(easy_search_puzzle.getGoal());
+  pushworld::PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+  PackedStateSet no_solution_visited{StatePacker(no_solution_puzzle)};
+
+  {
+    const SearchContext context;
+    auto result = best_first_search(easy_search_puzzle, distance_heuristic,
+                                    frontier, visited, nodes, context);
+    BOOST_CHECK(result.status == SearchStatus::SOLVED);
+    BOOST_TEST(easy_search_puzzle.isValidPlan(*result.plan));
+
+    result = best_first_search(no_solution_puzzle, null_heuristic, frontier,
+                               no_solution_visited, nodes, context);
+    BOOST_CHECK(result.status == SearchStatus::NO_SOLUTION);
+    BOOST_CHECK(result.plan == std::nullopt);
+  }
+
+  // Limits are checked before the first expansion.
+  {
+    SearchContext context;
+    context.setMemoryLimit(0);
+    const auto result =
+        best_first_search(no_solution_puzzle, null_heuristic, frontier,
+                          no_solution_visited, nodes, context, &statistics);
+    BOOST_CHECK(result.status == SearchStatus::MEMORY_LIMIT);
+    BOOST_CHECK(result.plan == std::nullopt);
+    BOOST_TEST(statistics.expansions == 0);
+    BOOST_TEST(statistics.evaluations == 1);
+  }
+  {
+    SearchContext context;
+    context.setDeadline(SearchContext::Clock::now());
+    const auto result =
+        best_first_search(no_solution_puzzle, null_heuristic, frontier,
+                          no_solution_visited, nodes, context);
+    BOOST_CHECK(result.status == SearchStatus::TIME_LIMIT);
+  }
+
+  // Cancellation during the search is observed at the next check, and the
+  // statistics describe the search up to that point.
+  {
+    SearchContext context;
+    context.setCheckInterval(1);
+    CancellingHeuristic cancelling_heuristic(context, 4);
+    const auto result =
+        best_first_search(no_solution_puzzle, cancelling_heuristic, frontier,
+                          no_solution_visited, nodes, context, &statistics);
+    BOOST_CHECK(result.status == SearchStatus::CANCELLED);
+    BOOST_TEST(statistics.evaluations >= 4);
+    BOOST_TEST(statistics.evaluations < 9);
+    BOOST_TEST(statistics.expansions < 9);
+    BOOST_TEST(statistics.total_seconds > 0.0);
+  }
+
+  // A budget that is larger than the whole search is never reached.
+  {
+    SearchContext context;
+    context.setCheckInterval(1);
+    context.setMemoryLimit(size_t(1) << 30);
+    const auto result =
+        best_first_search(no_solution_puzzle, null_heuristic, frontier,
+                          no_solution_visited, nodes, context);
+    BOOST_CHECK(result.status == SearchStatus::NO_SOLUTION);
+  }
+}
+
+/**
+ * Checks that `lazy_best_first_search` finds valid plans, and only evaluates
+ * the states that it expands.
+ */
+BOOST_AUTO_TEST_CASE(test_lazy_best_first_search) {
+  priority_queue::FibonacciPriorityQueue<NodeId, int> frontier;
+  SearchNodeStore nodes;
+  SearchStatistics statistics;
+  SearchStatistics eager_statistics;
+  const SearchContext context;
+
+  pushworld::PushWorldPuzzle puzzle("puzzles/multiple_goals.pwp");
+  PackedStateSet visited{StatePacker(puzzle)};
+  ManhattanDistanceHeuristic distance_heuristic(puzzle.getGoal());
+
+  auto result = lazy_best_first_search(puzzle, distance_heuristic, frontier,
+                                       visited, nodes, context, &statistics);
+  BOOST_CHECK(result.status == SearchStatus::SOLVED);
+  BOOST_TEST(puzzle.isValidPlan(*result.plan));
+  BOOST_TEST(statistics.expansions > 0);
+  BOOST_TEST(statistics.evaluations == statistics.expansions);
+  BOOST_TEST(statistics.evaluations < statistics.generations);
+
+  best_first_search(puzzle, distance_heuristic, frontier, visited, nodes,
+                    context, &eager_statistics);
+  BOOST_TEST(statistics.evaluations < eager_statistics.evaluations);
+
+  // Dead ends are discarded before they enter the frontier.
+  const heuristic::DeadEndDetector dead_ends(puzzle);
+  result = lazy_best_first_search(puzzle, distance_heuristic, frontier,
+                                  visited, nodes, context, &statistics,
+                                  &dead_ends);
+  BOOST_TEST(puzzle.isValidPlan(*result.plan));
+  BOOST_TEST(statistics.dead_ends > 0);
+
+  NullHeuristic null_heuristic;
+  pushworld::PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+  PackedStateSet no_solution_visited{StatePacker(no_solution_puzzle)};
+  result = lazy_best_first_search(no_solution_puzzle, null_heuristic, frontier,
+                                  no_solution_visited, nodes, context,
+                                  &statistics);
+  BOOST_CHECK(result.status == SearchStatus::NO_SOLUTION);
+  BOOST_TEST(statistics.evaluations == no_solution_visited.size());
+
+  SearchContext cancelled;
+  cancelled.cancel();
+  result = lazy_best_first_search(puzzle, distance_heuristic, frontier,
+                                  visited, nodes, cancelled, &statistics);
+  BOOST_CHECK(result.status == SearchStatus::CANCELLED);
+  BOOST_TEST(statistics.evaluations == 0);
+
+  // States with an infinite cost are not expanded.
+  priority_queue::FibonacciPriorityQueue<NodeId, float> float_frontier;
+  InfiniteHeuristic infinite_heuristic;
+  result = lazy_best_first_search(puzzle, infinite_heuristic, float_frontier,
+                                  visited, nodes, context, &statistics);
+  BOOST_CHECK(result.status == SearchStatus::NO_SOLUTION);
+  BOOST_TEST(statistics.evaluations == 1);
+  BOOST_TEST(statistics.generations == 0);
+  BOOST_TEST(statistics.dead_ends == 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace search
@@ -0,0 +1,124 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>  // abs
+
+#include "heuristics/dead_end_detector.h"
+#include "pushworld_puzzle.h"
+#include "search/external_best_first_search.h"
+#include "search/search_context.h"
+#include "search/search_statistics.h"
+
+namespace pushworld {
+namespace search {
+
+BOOST_AUTO_TEST_SUITE(external_best_first_search_suite)
+
+namespace {
+
+/* Computes the sum of Manhattan distances of each object from its goal
+ * position. */
+class ManhattanDistanceHeuristic : public pushworld::heuristic::Heuristic<int> {
+ private:
+  pushworld::Goal m_goal;
+
+ public:
+  ManhattanDistanceHeuristic(const pushworld::Goal& goal) : m_goal(goal){};
+
+  int estimate_cost_to_goal(
+      const pushworld::RelativeState& relative_state) override {
+    int cost = 0;
+    int goal_x, goal_y, object_x, object_y;
+
+    for (int i = 0; i < m_goal.size();) {
+      pushworld::position_to_xy(m_goal[i++], goal_x, goal_y);
+      pushworld::position_to_xy(relative_state.state[i], object_x, object_y);
+      cost += std::abs(goal_x - object_x) + std::abs(goal_y - object_y);
+    }
+
+    return cost;
+  };
+};
+
+/* Always returns zero cost to the goal. */
+class NullHeuristic : public pushworld::heuristic::Heuristic<int> {
+ public:
+  int estimate_cost_to_goal(
+      const pushworld::RelativeState& relative_state) override {
+    return 0;
+  };
+};
+
+}  // namespace
+
+/**
+ * Checks that `external_best_first_search` finds valid plans when its states
+ * are written to disk, and proves that puzzles have no solution.
+ */
+BOOST_AUTO_TEST_CASE(test_external_best_first_search) {
+  const SearchContext unlimited;
+  SearchStatistics statistics;
+
+  // With a tiny budget, every batch has a single state and most visited
+  // states are on disk.
+  ExternalSearchOptions options;
+  options.memory_budget = 1024;
+
+  PushWorldPuzzle easy_search_puzzle("puzzles/easy_search.pwp");
+  ManhattanDistanceHeuristic distance_heuristic(easy_search_puzzle.getGoal());
+  auto result = external_best_first_search(
+      easy_search_puzzle, distance_heuristic, options, unlimited, &statistics);
+  BOOST_CHECK(result.status == SearchStatus::SOLVED);
+  BOOST_TEST(easy_search_puzzle.isValidPlan(*result.plan));
+  BOOST_TEST(statistics.expansions > 0);
+  BOOST_TEST(statistics.evaluations > 0);
+
+  // With the default budget, nothing is written to disk.
+  result = external_best_first_search(
+      easy_search_puzzle, distance_heuristic, ExternalSearchOptions(),
+      unlimited);
+  BOOST_CHECK(result.status == SearchStatus::SOLVED);
+  BOOST_TEST(easy_search_puzzle.isValidPlan(*result.plan));
+
+  // The search exhausts all states on disk before it proves that no solution
+  // exists.
+  PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+  NullHeuristic null_heuristic;
+  result = external_best_first_search(no_solution_puzzle, null_heuristic,
+                                      options, unlimited, &statistics);
+  BOOST_CHECK(result.status == SearchStatus::NO_SOLUTION);
+  BOOST_TEST(!result.plan.has_value());
+  BOOST_TEST(statistics.expansions > 1);
+
+  // The same search with dead end detection.
+  const heuristic::DeadEndDetector dead_ends(no_solution_puzzle);
+  result = external_best_first_search(no_solution_puzzle, null_heuristic,
+                                      options, unlimited, nullptr, &dead_ends);
+  BOOST_CHECK(result.status == SearchStatus::NO_SOLUTION);
+
+  // A cancelled context stops the search before the first expansion.
+  SearchContext cancelled;
+  cancelled.cancel();
+  result = external_best_first_search(easy_search_puzzle, distance_heuristic,
+                                      options, cancelled, &statistics);
+  BOOST_CHECK(result.status == SearchStatus::CANCELLED);
+  BOOST_TEST(statistics.expansions == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace search
+}  // namespace pushworld
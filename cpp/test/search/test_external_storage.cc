@@ -0,0 +1,181 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <stdlib.h>  // srand, rand
+
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "pushworld_puzzle.h"
+#include "search/external_storage.h"
+#include "search/packed_state_set.h"
+
+namespace pushworld {
+namespace search {
+
+BOOST_AUTO_TEST_SUITE(external_storage)
+
+/* Checks that records are sorted by their keys and that duplicate keys are
+ * removed. */
+BOOST_AUTO_TEST_CASE(test_sort_unique_records) {
+  // Records of 3 words with keys of 2 words.
+  std::vector<PackedWord> records = {
+      2, 1, 10,  //
+      1, 5, 11,  //
+      2, 1, 12,  //
+      1, 2, 13,  //
+      0, 9, 14,  //
+  };
+  sort_unique_records(records, 3, 2);
+  const std::vector<PackedWord> expected = {
+      0, 9, 14,  //
+      1, 2, 13,  //
+      1, 5, 11,  //
+      2, 1, 10,  //
+  };
+  BOOST_TEST(records == expected);
+
+  std::vector<PackedWord> empty;
+  sort_unique_records(empty, 3, 2);
+  BOOST_TEST(empty.empty());
+}
+
+/* Checks that `ScratchDirectory` creates and removes a unique directory. */
+BOOST_AUTO_TEST_CASE(test_scratch_directory) {
+  std::string path;
+  {
+    ScratchDirectory directory;
+    ScratchDirectory other;
+    path = directory.path();
+    BOOST_TEST(std::filesystem::is_directory(path));
+    BOOST_TEST(path != other.path());
+    BOOST_TEST(directory.newFilePath("a") != directory.newFilePath("a"));
+  }
+  BOOST_TEST(!std::filesystem::exists(path));
+
+  BOOST_CHECK_THROW(ScratchDirectory("/nonexistent/directory"),
+                    std::runtime_error);
+}
+
+/* Checks that a `RecordFile` reads the blocks of records that were appended. */
+BOOST_AUTO_TEST_CASE(test_record_file) {
+  ScratchDirectory directory;
+  const std::string path = directory.newFilePath("records");
+
+  const int record_words = 3;
+  const size_t records_per_block =
+      RecordFile::BLOCK_BYTES / (record_words * sizeof(PackedWord));
+  const size_t num_records = 2 * records_per_block + 5;
+  std::vector<PackedWord> records(num_records * record_words);
+  for (size_t i = 0; i < records.size(); i++) {
+    records[i] = i;
+  }
+
+  {
+    RecordFile file(path, record_words);
+    BOOST_TEST(file.recordWords() == record_words);
+
+    // Append in chunks that do not align with the blocks.
+    const size_t chunk = 1000;
+    for (size_t i = 0; i < num_records; i += chunk) {
+      const size_t n = std::min(chunk, num_records - i);
+      file.append(records.data() + i * record_words, n);
+    }
+    BOOST_TEST(file.size() == num_records);
+    BOOST_TEST(file.numBlocks() == 2);
+    file.flush();
+    BOOST_TEST(file.numBlocks() == 3);
+    BOOST_TEST(file.diskUsage() > 0);
+    // Consecutive integers are compressible.
+    BOOST_TEST(file.diskUsage() < records.size() * sizeof(PackedWord));
+
+    std::vector<PackedWord> read;
+    std::vector<PackedWord> all;
+    for (size_t block = 0; block < file.numBlocks(); block++) {
+      file.readBlock(block, read);
+      BOOST_TEST(read.front() == file.firstRecord(block)[0]);
+      all.insert(all.end(), read.begin(), read.end());
+    }
+    BOOST_TEST(all == records);
+    BOOST_TEST(std::filesystem::exists(path));
+  }
+  BOOST_TEST(!std::filesystem::exists(path));
+}
+
+/**
+ * Checks that an `ExternalStateMap` finds the parents of states in memory and
+ * on disk, and removes visited states from sorted batches.
+ */
+BOOST_AUTO_TEST_CASE(test_external_state_map) {
+  std::srand(0);
+  const StatePacker packer(5, 20, 20);
+  const int words = packer.numWords();
+  ScratchDirectory directory;
+
+  // A tiny budget writes many runs, which are merged.
+  ExternalStateMap map(packer, directory, 4096);
+
+  const int num_states = 5000;
+  std::vector<PackedWord> states;
+  PackedStateSet unique(packer);
+  std::vector<PackedWord> packed(words);
+  while (unique.size() < num_states) {
+    State state(5);
+    for (auto& position : state) {
+      position = xy_to_position(rand() % 20, rand() % 20);
+    }
+    if (unique.insert(state).second) {
+      packer.pack(state, packed.data());
+      states.insert(states.end(), packed.begin(), packed.end());
+    }
+  }
+
+  // Each state's parent is the previous state.
+  for (int i = 1; i < num_states; i++) {
+    map.insert(states.data() + i * words, states.data() + (i - 1) * words);
+  }
+  BOOST_TEST(map.size() == num_states - 1);
+  BOOST_TEST(map.numDiskStates() > 0);
+  BOOST_TEST(map.numRuns() > 0);
+  BOOST_TEST(map.numRuns() <= ExternalStateMap::MAX_RUNS);
+  BOOST_TEST(map.diskUsage() > 0);
+
+  std::vector<PackedWord> parent(words);
+  for (int i = 1; i < num_states; i++) {
+    BOOST_TEST(map.findParent(states.data() + i * words, parent.data()));
+    BOOST_TEST(std::equal(parent.begin(), parent.end(),
+                          states.data() + (i - 1) * words));
+  }
+  BOOST_TEST(!map.findParent(states.data(), parent.data()));
+
+  // Batches of (state, index) records. Only the first state is not visited.
+  std::vector<PackedWord> batch;
+  for (int i = 0; i < num_states; i += 7) {
+    batch.insert(batch.end(), states.begin() + i * words,
+                 states.begin() + (i + 1) * words);
+    batch.push_back(i);
+  }
+  sort_unique_records(batch, words + 1, words);
+  map.removeContained(batch, words + 1);
+  BOOST_TEST(batch.size() == size_t(words + 1));
+  BOOST_TEST(batch.back() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace search
+}  // namespace pushworld
@@ -0,0 +1,176 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>  // srand, rand
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "pushworld_puzzle.h"
+#include "search/best_first_search.h"
+#include "search/packed_state_set.h"
+#include "search/priority_queue.h"
+
+namespace pushworld {
+namespace search {
+
+BOOST_AUTO_TEST_SUITE(packed_state_set)
+
+namespace {
+
+/* Always returns zero cost to the goal. */
+class NullHeuristic : public pushworld::heuristic::Heuristic<int> {
+ public:
+  int estimate_cost_to_goal(
+      const pushworld::RelativeState& relative_state) override {
+    return 0;
+  };
+};
+
+/* Returns a random state with positions inside the given bounds. */
+State random_state(const int num_objects, const int width, const int height) {
+  State state(num_objects);
+  for (auto& position : state) {
+    position = xy_to_position(rand() % width, rand() % height);
+  }
+  return state;
+}
+
+}  // namespace
+
+/* Checks that `StatePacker` decodes the same states that it encodes. */
+BOOST_AUTO_TEST_CASE(test_state_packer) {
+  std::srand(0);
+
+  // Positions with 5 bits straddle word boundaries when there are 13 objects.
+  const StatePacker packer(13, 7, 4);
+  BOOST_TEST(packer.numObjects() == 13);
+  BOOST_TEST(packer.numWords() == 2);
+
+  std::vector<PackedWord> packed(packer.numWords());
+  State unpacked;
+
+  for (int i = 0; i < 100; i++) {
+    const State state = random_state(13, 7, 4);
+    packer.pack(state, packed.data());
+    packer.unpack(packed.data(), unpacked);
+    BOOST_TEST(unpacked == state);
+  }
+
+  // Positions outside of the bounds cannot be packed.
+  State state = random_state(13, 7, 4);
+  state[5] = xy_to_position(7, 0);
+  BOOST_CHECK_THROW(packer.pack(state, packed.data()), std::domain_error);
+  state[5] = xy_to_position(0, 4);
+  BOOST_CHECK_THROW(packer.pack(state, packed.data()), std::domain_error);
+
+  // The size of every puzzle bounds the positions of its objects.
+  PushWorldPuzzle puzzle("puzzles/file_parsing.pwp");
+  const StatePacker puzzle_packer(puzzle);
+  packed.resize(puzzle_packer.numWords());
+  puzzle_packer.pack(puzzle.getInitialState(), packed.data());
+  puzzle_packer.unpack(packed.data(), unpacked);
+  BOOST_TEST(unpacked == puzzle.getInitialState());
+}
+
+/* Checks that `PackedStateSet` has the same contents as a `StateSet`. */
+BOOST_AUTO_TEST_CASE(test_packed_state_set) {
+  std::srand(0);
+
+  PackedStateSet states(StatePacker(3, 5, 5));
+  StateSet expected_states;
+  std::vector<State> inserted_states;
+  State decoded_state;
+
+  BOOST_TEST(states.empty());
+
+  // Insert enough states to require growing the hash table several times.
+  for (int i = 0; i < 2000; i++) {
+    const State state = random_state(3, 5, 5);
+    const bool expected_new = expected_states.insert(state).second;
+    const auto result = states.insert(state);
+
+    BOOST_TEST(result.second == expected_new);
+    if (result.second) {
+      BOOST_TEST(result.first == inserted_states.size());
+      inserted_states.push_back(state);
+    } else {
+      BOOST_TEST(inserted_states[result.first] == state);
+    }
+  }
+
+  BOOST_TEST(states.size() == expected_states.size());
+  BOOST_TEST(states.memoryUsage() > 0);
+
+  // Indices remain stable after the hash table grows.
+  for (int i = 0; i < inserted_states.size(); i++) {
+    states.getState(i, decoded_state);
+    BOOST_TEST(decoded_state == inserted_states[i]);
+    BOOST_TEST(states.contains(decoded_state));
+  }
+
+  for (int i = 0; i < 100; i++) {
+    const State state = random_state(3, 5, 5);
+    BOOST_TEST(states.contains(state) == (expected_states.count(state) == 1));
+  }
+
+  // Packed states are equivalent to unpacked states.
+  const StatePacker& packer = states.getPacker();
+  std::vector<PackedWord> packed(packer.numWords());
+  packer.pack(inserted_states[3], packed.data());
+  BOOST_TEST(packer.hash(packed.data()) ==
+             packer.hash(states.getPackedState(3)));
+  const auto result = states.insertPacked(packed.data());
+  BOOST_TEST(result.first == 3);
+  BOOST_TEST(!result.second);
+  const auto found = states.findPacked(packed.data());
+  BOOST_TEST(found.first == 3);
+  BOOST_TEST(found.second);
+
+  states.clear();
+  BOOST_TEST(states.empty());
+  BOOST_TEST(!states.contains(inserted_states[0]));
+  BOOST_TEST(!states.findPacked(packed.data()).second);
+}
+
+/* Checks `best_first_search` with a `PackedStateSet` of visited states. */
+BOOST_AUTO_TEST_CASE(test_best_first_search_packed) {
+  NullHeuristic null_heuristic;
+  priority_queue::FibonacciPriorityQueue<std::shared_ptr<SearchNode>, int>
+      frontier;
+
+  pushworld::PushWorldPuzzle trivial_puzzle("puzzles/trivial.pwp");
+  PackedStateSet visited_states{StatePacker(trivial_puzzle)};
+  auto plan = best_first_search(trivial_puzzle, null_heuristic, frontier,
+                                visited_states);
+  pushworld::Plan expected_plan{pushworld::RIGHT, pushworld::DOWN,
+                                pushworld::RIGHT, pushworld::UP};
+  BOOST_TEST(*plan == expected_plan);
+
+  // The search should terminate if no solution exists.
+  pushworld::PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+  PackedStateSet no_solution_visited{StatePacker(no_solution_puzzle)};
+  plan = best_first_search(no_solution_puzzle, null_heuristic, frontier,
+                           no_solution_visited);
+  BOOST_CHECK(plan == std::nullopt);
+  BOOST_CHECK(frontier.empty());
+  BOOST_CHECK(no_solution_visited.size() == 9);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace search
+}  // namespace pushworld
@@ -0,0 +1,223 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "search/parallel_best_first_search.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+#include "heuristics/dead_end_detector.h"
+#include "heuristics/heuristic.h"
+#include "pushworld_puzzle.h"
+#include "search/packed_state_set.h"
+#include "search/priority_queue.h"
+#include "search/search_context.h"
+
+namespace pushworld {
+namespace search {
+
+BOOST_AUTO_TEST_SUITE(parallel_best_first_search_suite)
+
+namespace {
+
+/* Always returns zero cost to the goal. */
+class NullHeuristic : public heuristic::Heuristic<int> {
+ public:
+  int estimate_cost_to_goal(const RelativeState& relative_state) override {
+    return 0;
+  };
+};
+
+/* Returns the Manhattan distance from each goal object to its goal. */
+class GoalDistanceHeuristic : public heuristic::Heuristic<int> {
+ private:
+  const Goal m_goal;
+
+ public:
+  explicit GoalDistanceHeuristic(const Goal& goal) : m_goal(goal){};
+
+  int estimate_cost_to_goal(const RelativeState& relative_state) override {
+    int cost = 0;
+    int goal_x, goal_y, object_x, object_y;
+    for (size_t i = 0; i < m_goal.size(); i++) {
+      position_to_xy(m_goal[i], goal_x, goal_y);
+      position_to_xy(relative_state.state[i + 1], object_x, object_y);
+      cost += std::abs(goal_x - object_x) + std::abs(goal_y - object_y);
+    }
+    return cost;
+  };
+};
+
+std::unique_ptr<heuristic::Heuristic<int>> make_null_heuristic() {
+  return std::make_unique<NullHeuristic>();
+}
+
+std::unique_ptr<priority_queue::PriorityQueue<PackedStateSet::Index, int>>
+make_frontier() {
+  return std::make_unique<
+      priority_queue::IntegerBucketPriorityQueue<PackedStateSet::Index, int>>();
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_parallel_best_first_search) {
+  PushWorldPuzzle easy_search_puzzle("puzzles/easy_search.pwp");
+  PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+  PushWorldPuzzle trivial_puzzle("puzzles/trivial.pwp");
+  const Plan expected_plan{RIGHT, DOWN, RIGHT, UP};
+
+  for (const int num_threads : {1, 2, 4}) {
+    // Repeat to exercise different thread timings.
+    for (int repeat = 0; repeat < 10; repeat++) {
+      auto plan = parallel_best_first_search<int>(
+          easy_search_puzzle, make_null_heuristic, make_frontier,
+          num_threads);
+      BOOST_TEST((plan != std::nullopt));
+      BOOST_TEST(easy_search_puzzle.isValidPlan(*plan));
+
+      // The search must terminate when no solution exists.
+      plan = parallel_best_first_search<int>(
+          no_solution_puzzle, make_null_heuristic, make_frontier,
+          num_threads);
+      BOOST_TEST((plan == std::nullopt));
+
+      plan = parallel_best_first_search<int>(
+          trivial_puzzle, make_null_heuristic, make_frontier, num_threads);
+      BOOST_TEST(*plan == expected_plan);
+    }
+  }
+
+  BOOST_CHECK_THROW(parallel_best_first_search<int>(
+                        trivial_puzzle, make_null_heuristic, make_frontier, 0),
+                    std::invalid_argument);
+}
+
+/* Checks the statistics summed over all threads of an exhaustive search. */
+BOOST_AUTO_TEST_CASE(test_parallel_best_first_search_statistics) {
+  PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+
+  for (const int num_threads : {1, 2, 4}) {
+    SearchStatistics statistics;
+    const auto plan = parallel_best_first_search<int>(
+        no_solution_puzzle, make_null_heuristic, make_frontier, num_threads,
+        &statistics);
+    BOOST_TEST((plan == std::nullopt));
+
+    // All 9 reachable states are expanded exactly once.
+    BOOST_TEST(statistics.expansions == 9);
+    BOOST_TEST(statistics.generations >= statistics.duplicates + 8);
+    BOOST_TEST(statistics.total_seconds > 0.0);
+  }
+}
+
+/* Checks that every thread discards dead ends when a detector is given. */
+BOOST_AUTO_TEST_CASE(test_parallel_best_first_search_dead_ends) {
+  PushWorldPuzzle puzzle("puzzles/multiple_goals.pwp");
+  PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+  const heuristic::DeadEndDetector dead_ends(puzzle);
+  const heuristic::DeadEndDetector no_solution_dead_ends(no_solution_puzzle);
+
+  for (const int num_threads : {1, 2, 4}) {
+    SearchStatistics statistics;
+    auto plan = parallel_best_first_search<int>(
+        puzzle, make_null_heuristic, make_frontier, num_threads, &statistics,
+        &dead_ends);
+    BOOST_TEST(puzzle.isValidPlan(*plan));
+    BOOST_TEST(statistics.dead_ends > 0);
+
+    // The initial state is a dead end, so nothing is expanded.
+    plan = parallel_best_first_search<int>(
+        no_solution_puzzle, make_null_heuristic, make_frontier, num_threads,
+        &statistics, &no_solution_dead_ends);
+    BOOST_TEST((plan == std::nullopt));
+    BOOST_TEST(statistics.expansions == 0);
+  }
+}
+
+/* Checks that plans are valid when states are canonicalized. */
+BOOST_AUTO_TEST_CASE(test_parallel_best_first_search_interchangeable_objects) {
+  PushWorldPuzzle puzzle("puzzles/many_objects.pwp");
+  const SearchContext context;
+  const auto make_heuristic = [&]() {
+    return std::make_unique<GoalDistanceHeuristic>(puzzle.getGoal());
+  };
+
+  for (const int num_threads : {1, 2, 4}) {
+    const auto result = parallel_best_first_search<int>(
+        puzzle, make_heuristic, make_frontier, num_threads, context, nullptr,
+        nullptr, true);
+    BOOST_CHECK(result.status == SearchStatus::SOLVED);
+    BOOST_TEST(puzzle.isValidPlan(*result.plan));
+  }
+}
+
+/* Checks that all threads stop when a limit of the context is reached. */
+BOOST_AUTO_TEST_CASE(test_parallel_best_first_search_context) {
+  PushWorldPuzzle easy_search_puzzle("puzzles/easy_search.pwp");
+  PushWorldPuzzle no_solution_puzzle("puzzles/no_solution.pwp");
+
+  for (const int num_threads : {1, 2, 4}) {
+    {
+      // Without limits, the search ends as without a context.
+      const SearchContext context;
+      auto result = parallel_best_first_search<int>(
+          easy_search_puzzle, make_null_heuristic, make_frontier, num_threads,
+          context);
+      BOOST_CHECK(result.status == SearchStatus::SOLVED);
+      BOOST_TEST(easy_search_puzzle.isValidPlan(*result.plan));
+
+      result = parallel_best_first_search<int>(
+          no_solution_puzzle, make_null_heuristic, make_frontier, num_threads,
+          context);
+      BOOST_CHECK(result.status == SearchStatus::NO_SOLUTION);
+      BOOST_TEST((result.plan == std::nullopt));
+    }
+    {
+      // The limits are checked before the first expansion.
+      SearchContext context;
+      context.setMemoryLimit(0);
+      SearchStatistics statistics;
+      const auto result = parallel_best_first_search<int>(
+          no_solution_puzzle, make_null_heuristic, make_frontier, num_threads,
+          context, &statistics);
+      BOOST_CHECK(result.status == SearchStatus::MEMORY_LIMIT);
+      BOOST_TEST((result.plan == std::nullopt));
+      BOOST_TEST(statistics.expansions == 0);
+    }
+    {
+      SearchContext context;
+      context.setDeadline(SearchContext::Clock::now());
+      const auto result = parallel_best_first_search<int>(
+          no_solution_puzzle, make_null_heuristic, make_frontier, num_threads,
+          context);
+      BOOST_CHECK(result.status == SearchStatus::TIME_LIMIT);
+    }
+    {
+      SearchContext context;
+      context.cancel();
+      const auto result = parallel_best_first_search<int>(
+          no_solution_puzzle, make_null_heuristic, make_frontier, num_threads,
+          context);
+      BOOST_CHECK(result.status == SearchStatus::CANCELLED);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace search
+}  // namespace pushworld
@@ -13,8 +13,12 @@
 // limitations under the License.
 
 #include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>  // pair
 #include <vector>
 
 #include "search/priority_queue.h"
@@ -27,7 +31,8 @@ BOOST_AUTO_TEST_SUITE(priority_queue)
 BOOST_AUTO_TEST_CASE(test_priority_queue) {
   std::vector<std::shared_ptr<PriorityQueue<std::string, int>>> queues{
       std::make_shared<FibonacciPriorityQueue<std::string, int>>(),
-      std::make_shared<BucketPriorityQueue<std::string, int>>()};
+      std::make_shared<BucketPriorityQueue<std::string, int>>(),
+      std::make_shared<IntegerBucketPriorityQueue<std::string, int>>()};
 
   for (auto& queue : queues) {
     BOOST_TEST(queue->empty());
@@ -71,6 +76,92 @@ BOOST_AUTO_TEST_CASE(test_priority_queue) {
   }
 }
 
+/* Checks priorities that are specific to `IntegerBucketPriorityQueue`. */
+BOOST_AUTO_TEST_CASE(test_integer_bucket_priority_queue) {
+  const float INF = std::numeric_limits<float>::infinity();
+  IntegerBucketPriorityQueue<int, float> queue;
+
+  BOOST_CHECK_THROW(queue.top(), std::out_of_range);
+  BOOST_CHECK_THROW(queue.pop(), std::out_of_range);
+  BOOST_CHECK_THROW(queue.push(0, 0.5f), std::invalid_argument);
+  BOOST_CHECK_THROW(queue.push(0, -INF), std::invalid_argument);
+  BOOST_CHECK_THROW(queue.push(0, std::nanf("")), std::invalid_argument);
+  BOOST_TEST(queue.empty());
+
+  // Push priorities in an order that requires growing the buckets both below
+  // and above the first priority.
+  queue.push(1, INF);
+  queue.push(2, 10.0f);
+  queue.push(3, -50.0f);
+  queue.push(4, 100.0f);
+  queue.push(5, -50.0f);
+  queue.push(6, 0.0f);
+  BOOST_TEST(queue.size() == 6);
+
+  // Equal priorities are last-in-first-out.
+  const std::vector<std::pair<int, float>> expected{
+      {5, -50.0f}, {3, -50.0f}, {6, 0.0f}, {2, 10.0f}, {4, 100.0f}, {1, INF}};
+  for (const auto& pair : expected) {
+    BOOST_TEST(queue.top() == pair.first);
+    BOOST_TEST(queue.min_priority() == pair.second);
+    queue.pop();
+
+    // Pushing below the current minimum priority is allowed.
+    if (pair.first == 6) {
+      queue.push(7, -100.0f);
+      BOOST_TEST(queue.top() == 7);
+      BOOST_TEST(queue.min_priority() == -100.0f);
+      queue.pop();
+    }
+  }
+  BOOST_TEST(queue.empty());
+
+  // The queue is reusable after `clear`.
+  queue.push(1, 3.0f);
+  queue.push(2, INF);
+  queue.clear();
+  BOOST_TEST(queue.empty());
+  queue.push(3, 1000.0f);
+  queue.push(4, 999.0f);
+  BOOST_TEST(queue.top() == 4);
+  queue.pop();
+  BOOST_TEST(queue.top() == 3);
+}
+
+/* Checks `IntegerBucketPriorityQueue` with lexicographic priorities. */
+BOOST_AUTO_TEST_CASE(test_lexicographic_integer_bucket_priority_queue) {
+  const float INF = std::numeric_limits<float>::infinity();
+  using Priority = std::pair<float, float>;
+  IntegerBucketPriorityQueue<int, Priority> queue;
+
+  BOOST_CHECK_THROW(queue.top(), std::out_of_range);
+  BOOST_CHECK_THROW(queue.push(0, {1.5f, 0.0f}), std::invalid_argument);
+  BOOST_CHECK_THROW(queue.push(0, {1.0f, 0.5f}), std::invalid_argument);
+
+  queue.push(1, {3.0f, 0.0f});
+  queue.push(2, {1.0f, 100.0f});
+  queue.push(3, {INF, INF});
+  queue.push(4, {1.0f, 5.0f});
+  queue.push(5, {2.0f, INF});
+  queue.push(6, {2.0f, -1.0f});
+  BOOST_TEST(queue.size() == 6);
+
+  const std::vector<std::pair<int, Priority>> expected{
+      {4, {1.0f, 5.0f}}, {2, {1.0f, 100.0f}}, {6, {2.0f, -1.0f}},
+      {5, {2.0f, INF}},  {1, {3.0f, 0.0f}},   {3, {INF, INF}}};
+  for (const auto& pair : expected) {
+    BOOST_TEST(queue.top() == pair.first);
+    BOOST_TEST((queue.min_priority() == pair.second));
+    queue.pop();
+  }
+  BOOST_TEST(queue.empty());
+
+  queue.push(1, {2.0f, 2.0f});
+  queue.clear();
+  BOOST_TEST(queue.empty());
+  BOOST_TEST(queue.size() == 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace priority_queue
@@ -70,6 +70,22 @@ BOOST_AUTO_TEST_CASE(test_random_action_iterator) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_random_action_iterator_seed) {
+  const int num_action_groups = 100;
+  RandomActionIterator default_iter(num_action_groups);
+  RandomActionIterator same_seed_iter(num_action_groups,
+                                      RandomActionIterator::DEFAULT_SEED);
+  RandomActionIterator other_seed_iter(num_action_groups, 7);
+
+  int num_differences = 0;
+  for (int i = 0; i < num_action_groups; i++) {
+    const auto& action_group = default_iter.next();
+    BOOST_TEST(same_seed_iter.next() == action_group);
+    num_differences += other_seed_iter.next() != action_group;
+  }
+  BOOST_TEST(num_differences > 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace search
@@ -14,8 +14,11 @@
 
 #include <boost/test/unit_test.hpp>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
 #include "pushworld_puzzle.h"
+#include "search/packed_state_set.h"
 #include "search/search.h"
 
 namespace pushworld {
@@ -46,6 +49,107 @@ BOOST_AUTO_TEST_CASE(test_backtrack_plan) {
   plan = backtrackPlan(world, search_node->parent);
   expected_plan = {RIGHT, DOWN, RIGHT};
   BOOST_TEST(plan == expected_plan);
+
+  // Stored actions are used without checking the states.
+  search_node = std::make_shared<SearchNode>(search_node->parent,
+                                             initial_state, LEFT);
+  expected_plan = {RIGHT, DOWN, RIGHT, LEFT};
+  BOOST_TEST(backtrackPlan(world, search_node) == expected_plan);
+}
+
+/* Checks that a `SearchNodeStore` assigns sequential IDs across chunks. */
+BOOST_AUTO_TEST_CASE(test_search_node_store) {
+  SearchNodeStore nodes;
+  BOOST_TEST(nodes.size() == 0);
+
+  // Add enough nodes to span multiple chunks.
+  const NodeId num_nodes = 200000;
+  // Every third node has no action.
+  const auto expected_action = [](const NodeId i) {
+    return i % 3 == 0 ? NO_ACTION : Action(i % NUM_ACTIONS);
+  };
+  for (NodeId i = 0; i < num_nodes; i++) {
+    BOOST_TEST(nodes.add(i == 0 ? NO_PARENT : i - 1, i * 2,
+                         expected_action(i)) == i);
+  }
+  BOOST_TEST(nodes.size() == num_nodes);
+  BOOST_TEST(nodes.memoryUsage() >= num_nodes * sizeof(CompactSearchNode));
+
+  for (NodeId i = 0; i < num_nodes; i++) {
+    BOOST_TEST(nodes[i].parent == (i == 0 ? NO_PARENT : i - 1));
+    BOOST_TEST(nodes[i].state_index == i * 2);
+    BOOST_TEST(nodes.getAction(i) == expected_action(i));
+  }
+
+  nodes.clear();
+  BOOST_TEST(nodes.size() == 0);
+  BOOST_TEST(nodes.memoryUsage() == 0);
+  BOOST_TEST(nodes.add(NO_PARENT, 7) == 0);
+  BOOST_TEST(nodes.getAction(0) == NO_ACTION);
+}
+
+/* Checks that `backtrackPlan` returns expected results for arena nodes. */
+BOOST_AUTO_TEST_CASE(test_backtrack_plan_arena) {
+  PushWorldPuzzle world("puzzles/trivial.pwp");
+  const auto initial_state = world.getInitialState();
+
+  PackedStateSet states{StatePacker(world)};
+  SearchNodeStore nodes;
+
+  NodeId node = nodes.add(NO_PARENT, states.insert(initial_state).first);
+  auto plan = backtrackPlan(world, states, nodes, node);
+  BOOST_TEST(plan.empty());
+
+  Plan expected_plan{RIGHT, DOWN, RIGHT, UP};
+  State state = initial_state;
+  std::vector<NodeId> path{node};
+
+  for (const auto action : expected_plan) {
+    state = world.getNextState(state, action).state;
+    node = nodes.add(node, states.insert(state).first);
+    path.push_back(node);
+  }
+
+  plan = backtrackPlan(world, states, nodes, node);
+  BOOST_TEST(plan == expected_plan);
+
+  plan = backtrackPlan(world, states, nodes, path[3]);
+  expected_plan = {RIGHT, DOWN, RIGHT};
+  BOOST_TEST(plan == expected_plan);
+
+  // A node whose parent cannot reach its state is invalid.
+  const NodeId invalid = nodes.add(path[0], nodes[path[4]].state_index);
+  BOOST_CHECK_THROW(backtrackPlan(world, states, nodes, invalid),
+                    std::invalid_argument);
+
+  // Stored actions are used without checking the states, and they can be
+  // mixed with reconstructed actions.
+  node = path[0];
+  for (size_t i = 0; i < expected_plan.size(); i++) {
+    const auto action = i % 2 == 0 ? expected_plan[i] : NO_ACTION;
+    node = nodes.add(node, nodes[path[i + 1]].state_index, action);
+  }
+  BOOST_TEST(backtrackPlan(world, states, nodes, node) == expected_plan);
+  node = nodes.add(path[0], nodes[path[4]].state_index, LEFT);
+  BOOST_TEST(backtrackPlan(world, states, nodes, node) == Plan{LEFT});
+}
+
+/* Checks that `planFromStates` reconstructs actions between states. */
+BOOST_AUTO_TEST_CASE(test_plan_from_states) {
+  PushWorldPuzzle world("puzzles/trivial.pwp");
+
+  std::vector<State> path{world.getInitialState()};
+  BOOST_TEST(planFromStates(world, path).empty());
+
+  const Plan expected_plan{RIGHT, DOWN, RIGHT, UP};
+  for (const auto action : expected_plan) {
+    path.push_back(world.getNextState(path.back(), action).state);
+  }
+  BOOST_TEST(planFromStates(world, path) == expected_plan);
+
+  // Skipping a state makes the path invalid.
+  path.erase(path.begin() + 1);
+  BOOST_CHECK_THROW(planFromStates(world, path), std::invalid_argument);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "search/search_context.h"
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <stdexcept>
+
+namespace pushworld {
+namespace search {
+
+BOOST_AUTO_TEST_SUITE(search_context_suite)
+
+BOOST_AUTO_TEST_CASE(test_unlimited_context) {
+  const SearchContext context;
+  BOOST_TEST(!context.cancelled());
+  BOOST_TEST(context.checkInterval() == SearchContext::DEFAULT_CHECK_INTERVAL);
+  BOOST_CHECK(context.deadline() == SearchContext::Clock::time_point::max());
+  BOOST_CHECK(context.check(size_t(1) << 40) == std::nullopt);
+}
+
+BOOST_AUTO_TEST_CASE(test_context_limits) {
+  SearchContext context;
+
+  context.setMemoryLimit(100);
+  BOOST_TEST(context.memoryLimit() == 100);
+  BOOST_CHECK(context.check(100) == std::nullopt);
+  BOOST_CHECK(context.check(101) == SearchStatus::MEMORY_LIMIT);
+
+  context.setTimeLimit(3600.0);
+  BOOST_CHECK(context.check(0) == std::nullopt);
+  context.setDeadline(SearchContext::Clock::now() - std::chrono::seconds(1));
+  BOOST_CHECK(context.check(0) == SearchStatus::TIME_LIMIT);
+
+  // The memory limit takes precedence over the deadline.
+  BOOST_CHECK(context.check(101) == SearchStatus::MEMORY_LIMIT);
+
+  // Cancellation takes precedence over all limits.
+  context.cancel();
+  BOOST_TEST(context.cancelled());
+  BOOST_CHECK(context.check(101) == SearchStatus::CANCELLED);
+
+  context.setCheckInterval(1);
+  BOOST_TEST(context.checkInterval() == 1);
+  BOOST_CHECK_THROW(context.setCheckInterval(0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_child_context) {
+  SearchContext parent;
+  parent.setMemoryLimit(100);
+  parent.setCheckInterval(8);
+
+  SearchContext child(&parent);
+  SearchContext sibling(&parent);
+  BOOST_TEST(child.memoryLimit() == 100);
+  BOOST_TEST(child.checkInterval() == 8);
+
+  // Cancelling a child does not affect its parent or its siblings.
+  child.cancel();
+  BOOST_TEST(child.cancelled());
+  BOOST_TEST(!parent.cancelled());
+  BOOST_TEST(!sibling.cancelled());
+
+  parent.cancel();
+  BOOST_TEST(sibling.cancelled());
+  BOOST_CHECK(sibling.check(0) == SearchStatus::CANCELLED);
+}
+
+BOOST_AUTO_TEST_CASE(test_status_to_string) {
+  BOOST_TEST(to_string(SearchStatus::SOLVED) == "SOLVED");
+  BOOST_TEST(to_string(SearchStatus::NO_SOLUTION) == "NO_SOLUTION");
+  BOOST_TEST(to_string(SearchStatus::TIME_LIMIT) == "TIME_LIMIT");
+  BOOST_TEST(to_string(SearchStatus::MEMORY_LIMIT) == "MEMORY_LIMIT");
+  BOOST_TEST(to_string(SearchStatus::CANCELLED) == "CANCELLED");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace search
+}  // namespace pushworld
@@ -0,0 +1,84 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "search/search_statistics.h"
+
+#include <boost/test/unit_test.hpp>
+#include <string>
+
+namespace pushworld {
+namespace search {
+
+BOOST_AUTO_TEST_SUITE(search_statistics_suite)
+
+namespace {
+
+SearchStatistics make_statistics() {
+  SearchStatistics statistics;
+  statistics.expansions = 3;
+  statistics.generations = 10;
+  statistics.duplicates = 4;
+  statistics.evaluations = 6;
+  statistics.dead_ends = 2;
+  statistics.max_frontier_size = 5;
+  statistics.heuristic_seconds = 0.25;
+  statistics.successor_seconds = 0.125;
+  statistics.total_seconds = 0.5;
+  return statistics;
+}
+
+}  // namespace
+
+/* Checks that `to_json` writes all fields in sorted order on a single line. */
+BOOST_AUTO_TEST_CASE(test_to_json) {
+  auto statistics = make_statistics();
+  BOOST_TEST(to_json(statistics) ==
+             "{\"dead_ends\": 2, \"duplicates\": 4, \"evaluations\": 6, "
+             "\"expansions\": 3, \"generations\": 10, "
+             "\"heuristic_counters\": {}, \"heuristic_seconds\": 0.250000, "
+             "\"max_frontier_size\": 5, \"successor_seconds\": 0.125000, "
+             "\"total_seconds\": 0.500000}");
+
+  statistics.heuristic_counters["b"] = 2;
+  statistics.heuristic_counters["a"] = 1;
+  const std::string json = to_json(statistics);
+  BOOST_TEST(json.find("\"heuristic_counters\": {\"a\": 1, \"b\": 2}, ") !=
+             std::string::npos);
+}
+
+/* Checks that `to_yaml` writes one key per line with nested counters. */
+BOOST_AUTO_TEST_CASE(test_to_yaml) {
+  auto statistics = make_statistics();
+  BOOST_TEST(to_yaml(statistics) ==
+             "dead_ends: 2\n"
+             "duplicates: 4\n"
+             "evaluations: 6\n"
+             "expansions: 3\n"
+             "generations: 10\n"
+             "heuristic_counters: {}\n"
+             "heuristic_seconds: 0.250000\n"
+             "max_frontier_size: 5\n"
+             "successor_seconds: 0.125000\n"
+             "total_seconds: 0.500000\n");
+
+  statistics.heuristic_counters["hits"] = 7;
+  const std::string yaml = to_yaml(statistics);
+  BOOST_TEST(yaml.find("heuristic_counters:\n  hits: 7\nheuristic_seconds") !=
+             std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace search
+}  // namespace pushworld
@@ -0,0 +1,86 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "search/spsc_queue.h"
+
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace pushworld {
+namespace search {
+
+BOOST_AUTO_TEST_SUITE(spsc_queue)
+
+/* Checks `SpscQueue` from a single thread. */
+BOOST_AUTO_TEST_CASE(test_spsc_queue) {
+  BOOST_CHECK_THROW(SpscQueue<int>(0), std::invalid_argument);
+  BOOST_CHECK_THROW(SpscQueue<int>(3), std::invalid_argument);
+
+  SpscQueue<std::vector<int>> queue(2);
+  std::vector<int> element;
+  BOOST_TEST(!queue.try_pop(element));
+
+  std::vector<int> a{1, 2}, b{3}, c{4, 5, 6};
+  BOOST_TEST(queue.try_push(a));
+  BOOST_TEST(queue.try_push(b));
+
+  // The queue is full, so `c` is not moved.
+  BOOST_TEST(!queue.try_push(c));
+  BOOST_TEST(c.size() == 3);
+
+  BOOST_TEST(queue.try_pop(element));
+  BOOST_TEST(element == std::vector<int>({1, 2}));
+  BOOST_TEST(queue.try_push(c));
+  BOOST_TEST(queue.try_pop(element));
+  BOOST_TEST(element == std::vector<int>({3}));
+  BOOST_TEST(queue.try_pop(element));
+  BOOST_TEST(element == std::vector<int>({4, 5, 6}));
+  BOOST_TEST(!queue.try_pop(element));
+}
+
+/* Checks that all elements are received in order across threads. */
+BOOST_AUTO_TEST_CASE(test_spsc_queue_threads) {
+  const int num_elements = 100000;
+  SpscQueue<int> queue(16);
+
+  std::thread producer([&]() {
+    for (int i = 0; i < num_elements; i++) {
+      int element = i;
+      while (!queue.try_push(element)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int num_out_of_order = 0;
+  for (int i = 0; i < num_elements; i++) {
+    int element;
+    while (!queue.try_pop(element)) {
+      std::this_thread::yield();
+    }
+    if (element != i) {
+      num_out_of_order++;
+    }
+  }
+  producer.join();
+
+  BOOST_TEST(num_out_of_order == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace search
+}  // namespace pushworld
@@ -0,0 +1,274 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "batched_env.h"
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+
+BOOST_AUTO_TEST_SUITE(batched_env)
+
+namespace {
+
+using Puzzles = std::vector<std::shared_ptr<const PushWorldPuzzle>>;
+
+// Solves `puzzles/trivial.pwp`.
+static const Action TRIVIAL_PLAN[] = {RIGHT, DOWN, RIGHT, UP};
+
+/* Returns the (red, green, blue) values of a pixel in an observation. */
+std::vector<float> get_pixel(const std::vector<float>& observation,
+                             const int width, const int row,
+                             const int column) {
+  const auto begin = observation.begin() + (row * width + column) * 3;
+  return std::vector<float>(begin, begin + 3);
+}
+
+/* Converts a color from the range [0, 255] into the range [0, 1]. */
+std::vector<float> color(const int red, const int green, const int blue) {
+  return {red / 255.0f, green / 255.0f, blue / 255.0f};
+}
+
+}  // namespace
+
+/* Checks that stepping the batch matches `PushWorldPuzzle::getNextState`. */
+BOOST_AUTO_TEST_CASE(test_step) {
+  const Puzzles puzzles{
+      std::make_shared<PushWorldPuzzle>("puzzles/trivial.pwp"),
+      std::make_shared<PushWorldPuzzle>("puzzles/multiple_goals.pwp")};
+  const int num_envs = 4;
+  BatchedPushWorldEnv env(puzzles, num_envs, 0, false);
+  BOOST_TEST(env.getStateSize() == 3);
+
+  env.reset(nullptr);
+  for (int i = 0; i < num_envs; i++) {
+    env.resetEnv(i, i % 2, nullptr);
+  }
+
+  std::vector<State> states;
+  for (int i = 0; i < num_envs; i++) {
+    states.push_back(puzzles[i % 2]->getInitialState());
+  }
+
+  std::vector<double> rewards(num_envs);
+  std::vector<uint8_t> terminated(num_envs);
+  std::vector<uint8_t> truncated(num_envs);
+  std::vector<Action> actions(num_envs);
+
+  for (int t = 0; t < 20; t++) {
+    for (int i = 0; i < num_envs; i++) {
+      actions[i] = (t * 3 + i * 7 + t / 5) % NUM_ACTIONS;
+    }
+    env.step(actions.data(), nullptr, rewards.data(), terminated.data(),
+             truncated.data());
+
+    for (int i = 0; i < num_envs; i++) {
+      BOOST_TEST(env.getPuzzleIndices()[i] == i % 2);
+      BOOST_TEST(env.getSteps()[i] == t + 1);
+      states[i] = puzzles[i % 2]->getNextState(states[i], actions[i]).state;
+
+      const Position2D* state = env.getStates() + i * env.getStateSize();
+      BOOST_TEST(State(state, state + states[i].size()) == states[i]);
+      BOOST_TEST(!truncated[i]);
+      BOOST_TEST(
+          terminated[i] == puzzles[i % 2]->satisfiesGoal(states[i]),
+          "env " << i);
+    }
+  }
+
+  // The trivial puzzle has fewer objects than the state size.
+  BOOST_TEST(env.getStates()[2] == 0);
+
+  // Invalid actions do not change any environment.
+  const State all_states(env.getStates(),
+                         env.getStates() + num_envs * env.getStateSize());
+  actions = {LEFT, LEFT, NUM_ACTIONS, LEFT};
+  BOOST_CHECK_THROW(env.step(actions.data(), nullptr, rewards.data(),
+                             terminated.data(), truncated.data()),
+                    std::invalid_argument);
+  BOOST_TEST(State(env.getStates(),
+                   env.getStates() + num_envs * env.getStateSize()) ==
+             all_states);
+
+  BOOST_CHECK_THROW(env.resetEnv(num_envs, 0, nullptr), std::invalid_argument);
+  BOOST_CHECK_THROW(env.resetEnv(0, 2, nullptr), std::invalid_argument);
+}
+
+/* Checks the rewards, termination, truncation, and auto-reset of episodes. */
+BOOST_AUTO_TEST_CASE(test_episodes) {
+  const auto puzzle = std::make_shared<PushWorldPuzzle>("puzzles/trivial.pwp");
+  const int max_steps = 6;
+  BatchedPushWorldEnv env({puzzle}, 2, max_steps);
+  env.reset(nullptr);
+
+  double rewards[2];
+  uint8_t terminated[2];
+  uint8_t truncated[2];
+
+  // The first environment solves the puzzle, while the second one stays in its
+  // initial state by moving into the agent wall below the agent.
+  for (int t = 0; t < 4; t++) {
+    const Action actions[] = {TRIVIAL_PLAN[t], DOWN};
+    env.step(actions, nullptr, rewards, terminated, truncated);
+
+    BOOST_TEST(terminated[0] == (t == 3));
+    BOOST_TEST(!terminated[1]);
+    BOOST_TEST(!truncated[0]);
+    BOOST_TEST(!truncated[1]);
+    BOOST_TEST(rewards[0] == (t == 3 ? 10 : -0.01));
+    BOOST_TEST(rewards[1] == -0.01);
+  }
+
+  // The first environment was reset after solving the puzzle.
+  BOOST_TEST(env.getSteps()[0] == 0);
+  BOOST_TEST(env.getStates()[0] == puzzle->getInitialState()[0]);
+  BOOST_TEST(env.getStates()[1] == puzzle->getInitialState()[1]);
+  BOOST_TEST(env.getSteps()[1] == 4);
+
+  // The second environment reaches the step limit.
+  const Action actions[] = {RIGHT, DOWN};
+  for (int t = 0; t < 2; t++) {
+    env.step(actions, nullptr, rewards, terminated, truncated);
+  }
+  BOOST_TEST(!truncated[0]);
+  BOOST_TEST(truncated[1]);
+  BOOST_TEST(!terminated[1]);
+  BOOST_TEST(env.getSteps()[1] == 0);
+}
+
+/* Checks that achieving an individual goal is rewarded. */
+BOOST_AUTO_TEST_CASE(test_goal_rewards) {
+  const auto puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/multiple_goals.pwp");
+  BatchedPushWorldEnv env({puzzle}, 1);
+  env.reset(nullptr);
+
+  double reward;
+  uint8_t terminated;
+  uint8_t truncated;
+
+  // The agent reaches M1 and then pushes it into G1.
+  const Action left = LEFT;
+  env.step(&left, nullptr, &reward, &terminated, &truncated);
+  BOOST_TEST(reward == -0.01);
+  env.step(&left, nullptr, &reward, &terminated, &truncated);
+  BOOST_TEST(reward == 1 - 0.01);
+  BOOST_TEST(!terminated);
+}
+
+/* Checks the pixels of rendered observations. */
+BOOST_AUTO_TEST_CASE(test_observations) {
+  const auto puzzle = std::make_shared<PushWorldPuzzle>("puzzles/trivial.pwp");
+  const int pixels_per_cell = 10;
+  const int border_width = 2;
+
+  // The puzzle has 5x5 cells, which are padded to 8 rows and 6 columns.
+  BatchedPushWorldEnv env({puzzle}, 2, 0, true, 8, 6, pixels_per_cell,
+                          border_width);
+  const int height = env.getObservationHeight();
+  const int width = env.getObservationWidth();
+  BOOST_TEST(height == 80);
+  BOOST_TEST(width == 60);
+  BOOST_TEST(env.getObservationSize() == 80 * 60 * 3);
+
+  std::vector<float> observations(2 * env.getObservationSize(), -1);
+  env.reset(observations.data());
+  std::vector<float> observation(
+      observations.begin(), observations.begin() + env.getObservationSize());
+  BOOST_TEST(std::vector<float>(observations.begin() + observation.size(),
+                                observations.end()) == observation);
+
+  // The image of the puzzle starts at row 15 and column 5.
+  const auto pixel = [&](const int x, const int y, const int dx,
+                         const int dy) {
+    return get_pixel(observation, width, 15 + y * pixels_per_cell + dy,
+                     5 + x * pixels_per_cell + dx);
+  };
+  const std::vector<float> black{0, 0, 0};
+  const std::vector<float> white{1, 1, 1};
+
+  BOOST_TEST(get_pixel(observation, width, 0, 0) == black);
+  BOOST_TEST(get_pixel(observation, width, 14, 30) == black);
+  BOOST_TEST(get_pixel(observation, width, 40, 4) == black);
+  BOOST_TEST(get_pixel(observation, width, 40, 55) == black);
+  BOOST_TEST(get_pixel(observation, width, 65, 30) == black);
+
+  // An empty cell.
+  BOOST_TEST(pixel(2, 1, 0, 0) == white);
+  BOOST_TEST(pixel(2, 1, 9, 9) == white);
+
+  // The agent, its border, and the border of the adjacent movable object.
+  BOOST_TEST(pixel(1, 2, 5, 5) == color(0x00, 0xDC, 0x00));
+  BOOST_TEST(pixel(1, 2, 0, 5) == color(0x00, 0x6E, 0x00));
+  BOOST_TEST(pixel(1, 2, 9, 9) == color(0x00, 0x6E, 0x00));
+  BOOST_TEST(pixel(2, 2, 1, 5) == color(0x6E, 0x00, 0x00));
+  BOOST_TEST(pixel(2, 2, 2, 5) == color(0xDC, 0x00, 0x00));
+
+  // Walls, agent walls, and the transparent goal.
+  BOOST_TEST(pixel(0, 0, 5, 5) == color(0x0A, 0x0A, 0x0A));
+  BOOST_TEST(pixel(1, 1, 5, 5) == color(0x0A, 0x0A, 0x0A));
+  BOOST_TEST(pixel(1, 3, 5, 5) == color(0xFA, 0xC7, 0x1E));
+  BOOST_TEST(pixel(1, 3, 8, 5) == color(0x7D, 0x64, 0x0F));
+  BOOST_TEST(pixel(3, 1, 5, 5) == white);
+  BOOST_TEST(pixel(3, 1, 5, 0) == color(0xB9, 0x00, 0x00));
+
+  // Borders are drawn on both sides of touching walls.
+  BOOST_TEST(pixel(0, 2, 9, 5) == color(0x05, 0x05, 0x05));
+  BOOST_TEST(pixel(0, 2, 5, 9) == color(0x0A, 0x0A, 0x0A));
+
+  // After solving the puzzle, the goal border is drawn on top of the object.
+  double rewards[2];
+  uint8_t terminated[2];
+  uint8_t truncated[2];
+  for (int t = 0; t < 3; t++) {
+    const Action actions[] = {TRIVIAL_PLAN[t], TRIVIAL_PLAN[t]};
+    env.step(actions, observations.data(), rewards, terminated, truncated);
+  }
+  observation.assign(observations.begin(),
+                     observations.begin() + env.getObservationSize());
+  BOOST_TEST(pixel(3, 2, 5, 5) == color(0xDC, 0x00, 0x00));
+  BOOST_TEST(pixel(3, 3, 5, 5) == color(0x00, 0xDC, 0x00));
+  BOOST_TEST(pixel(1, 2, 5, 5) == white);
+}
+
+/* Checks that invalid arguments are rejected. */
+BOOST_AUTO_TEST_CASE(test_invalid_arguments) {
+  const auto puzzle = std::make_shared<PushWorldPuzzle>("puzzles/trivial.pwp");
+
+  BOOST_CHECK_THROW(BatchedPushWorldEnv({}, 1), std::invalid_argument);
+  BOOST_CHECK_THROW(BatchedPushWorldEnv({puzzle}, 0), std::invalid_argument);
+  BOOST_CHECK_THROW(BatchedPushWorldEnv({puzzle}, 1, 0, true, 4, 5),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(BatchedPushWorldEnv({puzzle}, 1, 0, true, 0, 0, 4, 2),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(BatchedPushWorldEnv({puzzle}, 1, 0, true, 0, 0, 5, 0),
+                    std::invalid_argument);
+
+  // Puzzles without shapes cannot be rendered.
+  const auto constructed = std::make_shared<PushWorldPuzzle>(
+      puzzle->getInitialState(), puzzle->getGoal(),
+      puzzle->getObjectCollisions());
+  BOOST_CHECK_THROW(BatchedPushWorldEnv({constructed}, 1),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace pushworld
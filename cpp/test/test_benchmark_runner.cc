@@ -0,0 +1,175 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark_runner.h"
+
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "puzzle_collection.h"
+#include "pushworld_puzzle.h"
+
+namespace fs = std::filesystem;
+
+namespace pushworld {
+
+BOOST_AUTO_TEST_SUITE(benchmark_runner)
+
+/* Checks that `to_yaml` matches the output of `yaml.dump` in Python. */
+BOOST_AUTO_TEST_CASE(test_to_yaml) {
+  PlanningResult result{"RGD", "2 Obstacle", "LRUD", 0.25, std::nullopt};
+  BOOST_TEST(to_yaml(result) ==
+             "plan: LRUD\n"
+             "planner: RGD\n"
+             "planning_time: 0.25\n"
+             "puzzle: 2 Obstacle\n");
+
+  result.plan = std::nullopt;
+  result.failure_reason = "time limit reached";
+  result.planning_time = 1800;
+  BOOST_TEST(to_yaml(result) ==
+             "failure_reason: time limit reached\n"
+             "plan: null\n"
+             "planner: RGD\n"
+             "planning_time: 1800.0\n"
+             "puzzle: 2 Obstacle\n");
+
+  // Strings that YAML would parse as other types or syntax are quoted.
+  result.puzzle = "123";
+  BOOST_TEST(to_yaml(result).find("puzzle: '123'\n") != std::string::npos);
+  result.puzzle = "yes";
+  BOOST_TEST(to_yaml(result).find("puzzle: 'yes'\n") != std::string::npos);
+  result.puzzle = "It's: here";
+  BOOST_TEST(to_yaml(result).find("puzzle: 'It''s: here'\n") !=
+             std::string::npos);
+  result.plan = "";
+  BOOST_TEST(to_yaml(result).find("plan: ''\n") != std::string::npos);
+}
+
+/* Checks `get_planner_name`. */
+BOOST_AUTO_TEST_CASE(test_get_planner_name) {
+  BOOST_TEST(get_planner_name("RGD") == "RGD");
+  BOOST_TEST(get_planner_name("N+RGD") == "Novelty+RGD");
+  BOOST_TEST(get_planner_name("PORTFOLIO") == "Portfolio");
+  BOOST_CHECK_THROW(get_planner_name("foo"), std::domain_error);
+}
+
+/* Checks that `map_puzzle_files` finds puzzles and creates directories. */
+BOOST_AUTO_TEST_CASE(test_map_puzzle_files) {
+  const fs::path results = fs::temp_directory_path() / "test_map_puzzle_files";
+  fs::remove_all(results);
+
+  const auto file_paths = map_puzzle_files("puzzles", results.string());
+  BOOST_TEST(file_paths.size() == 16);
+  for (const auto& [puzzle_path, result_path] : file_paths) {
+    BOOST_TEST(fs::path(puzzle_path).extension() == ".pwp");
+    BOOST_TEST(fs::path(result_path).parent_path() == results);
+    BOOST_TEST(fs::path(result_path).stem() == fs::path(puzzle_path).stem());
+    BOOST_TEST(fs::path(result_path).extension() == ".yaml");
+  }
+  BOOST_TEST(fs::is_directory(results));
+
+  const auto single_file =
+      map_puzzle_files("puzzles/trivial.pwp", (results / "single").string());
+  BOOST_TEST(single_file.size() == 1);
+  BOOST_TEST(single_file[0].second == (results / "single/trivial.yaml"));
+  BOOST_TEST(fs::is_directory(results / "single"));
+
+  BOOST_CHECK_THROW(map_puzzle_files("puzzles/missing", results.string()),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(map_puzzle_files("main.cc", results.string()),
+                    std::invalid_argument);
+
+  fs::remove_all(results);
+}
+
+/* Checks that `map_collection_puzzles` replicates directories of puzzles. */
+BOOST_AUTO_TEST_CASE(test_map_collection_puzzles) {
+  const fs::path results =
+      fs::temp_directory_path() / "test_map_collection_puzzles";
+  fs::remove_all(results);
+
+  const PuzzleCollection collection("puzzles/collection.zip");
+  const auto result_paths =
+      map_collection_puzzles(collection, results.string());
+  BOOST_TEST_REQUIRE(result_paths.size() == 2);
+  BOOST_TEST(result_paths[0].first == 0);
+  BOOST_TEST(result_paths[0].second ==
+             (results / "collection/goals/multiple_goals.yaml"));
+  BOOST_TEST(result_paths[1].first == 1);
+  BOOST_TEST(result_paths[1].second ==
+             (results / "collection/trivial.yaml"));
+  BOOST_TEST(fs::is_directory(results / "collection/goals"));
+
+  // Puzzles from collections can be solved without extracting them.
+  const auto result = run_planner_with_limits(
+      "RGD", std::make_shared<PushWorldPuzzle>(collection.getPuzzle(1)),
+      "trivial", PlanningLimits{60, std::nullopt});
+  BOOST_TEST(result.puzzle == "trivial");
+  BOOST_TEST((result.plan == std::optional<std::string>("RDRU")));
+
+  // The in-process search stops at its memory budget.
+  const auto limited_result = run_planner_with_limits(
+      "RGD", std::make_shared<PushWorldPuzzle>(collection.getPuzzle(1)),
+      "trivial", PlanningLimits{std::nullopt, 1});
+  BOOST_TEST((limited_result.plan == std::nullopt));
+  BOOST_TEST((limited_result.failure_reason ==
+              std::optional<std::string>("memory error")));
+
+  fs::remove_all(results);
+}
+
+/* Checks that `run_planner_with_limits` reports all kinds of results. */
+BOOST_AUTO_TEST_CASE(test_run_planner_with_limits) {
+  const PlanningLimits limits{60, std::nullopt};
+
+  auto result =
+      run_planner_with_limits("N+RGD", "puzzles/trivial.pwp", limits);
+  BOOST_TEST(result.planner == "Novelty+RGD");
+  BOOST_TEST(result.puzzle == "trivial");
+  BOOST_TEST((result.plan == std::optional<std::string>("RDRU")));
+  BOOST_TEST((result.failure_reason == std::nullopt));
+  BOOST_TEST(result.planning_time >= 0.0);
+
+  result = run_planner_with_limits("RGD", "puzzles/no_solution.pwp", limits);
+  BOOST_TEST((result.plan == std::nullopt));
+  BOOST_TEST((result.failure_reason ==
+              std::optional<std::string>("no solution exists")));
+
+  // The search stops at its memory budget.
+  result = run_planner_with_limits("RGD", "puzzles/trivial.pwp",
+                                   PlanningLimits{std::nullopt, 1});
+  BOOST_TEST((result.plan == std::nullopt));
+  BOOST_TEST(
+      (result.failure_reason == std::optional<std::string>("memory error")));
+
+  // The deadline has already passed when the search begins.
+  result = run_planner_with_limits("RGD", "puzzles/easy_search.pwp",
+                                   PlanningLimits{0, std::nullopt});
+  BOOST_TEST((result.failure_reason ==
+              std::optional<std::string>("time limit reached")));
+  BOOST_TEST(result.planning_time == 0.0);
+
+  BOOST_CHECK_THROW(
+      run_planner_with_limits("foo", "puzzles/trivial.pwp", limits),
+      std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace pushworld
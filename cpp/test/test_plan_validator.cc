@@ -0,0 +1,139 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "plan_validator.h"
+
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pushworld_puzzle.h"
+
+namespace fs = std::filesystem;
+
+namespace pushworld {
+
+BOOST_AUTO_TEST_SUITE(plan_validator)
+
+/* Checks that `parse_plan` converts 'LRUD' characters into actions. */
+BOOST_AUTO_TEST_CASE(test_parse_plan) {
+  const Plan expected_plan{RIGHT, DOWN, RIGHT, UP};
+  BOOST_CHECK(parse_plan("RDRU") == expected_plan);
+  BOOST_CHECK(parse_plan("") == Plan());
+  BOOST_CHECK(parse_plan("RDxU") == std::nullopt);
+}
+
+/* Checks that `PlanValidator` agrees with `PushWorldPuzzle::isValidPlan`. */
+BOOST_AUTO_TEST_CASE(test_validate) {
+  const PushWorldPuzzle puzzle("puzzles/trivial.pwp");
+  PlanValidator validator;
+
+  auto result = validator.validate(puzzle, "RDRU");
+  BOOST_TEST(result.valid);
+  BOOST_CHECK(result.failure_reason == std::nullopt);
+  BOOST_TEST(result.num_moving_actions == 4);
+  BOOST_TEST(result.trace.empty());
+
+  // The first action is blocked by the boundary of the puzzle.
+  result = validator.validate(puzzle, "LRDRU", true);
+  BOOST_TEST(result.valid);
+  BOOST_TEST(result.num_moving_actions == 4);
+  const std::vector<std::vector<int>> expected_trace{
+      {}, {0, 1}, {0}, {0}, {0, 1}};
+  BOOST_CHECK(result.trace == expected_trace);
+
+  result = validator.validate(puzzle, "RD");
+  BOOST_TEST(!result.valid);
+  BOOST_CHECK(result.failure_reason == std::string("goal not reached"));
+  BOOST_TEST(puzzle.isValidPlan(*parse_plan("RD")) == result.valid);
+
+  result = validator.validate(puzzle, "RDRx");
+  BOOST_TEST(!result.valid);
+  BOOST_CHECK(result.failure_reason ==
+              std::string("invalid action 'x' at step 3"));
+
+  // Validators in separate threads can replay plans in the same puzzle.
+  std::vector<int> num_valid(4, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_valid.size(); t++) {
+    threads.emplace_back([&puzzle, &num_valid, t]() {
+      PlanValidator thread_validator;
+      for (int i = 0; i < 1000; i++) {
+        num_valid[t] += thread_validator.validate(puzzle, "LRDRU").valid;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const int count : num_valid) {
+    BOOST_TEST(count == 1000);
+  }
+}
+
+/* Checks that `read_plan_file` reads YAML and text files of plans. */
+BOOST_AUTO_TEST_CASE(test_read_plan_file) {
+  const fs::path directory = fs::temp_directory_path() / "test_read_plan_file";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+
+  const auto solution_path = (directory / "solution.yaml").string();
+  std::ofstream(solution_path) << "planner: human\n"
+                                  "puzzle: 'It''s: Trivial'\n"
+                                  "plan: RDRU\n";
+  auto records = read_plan_file(solution_path);
+  BOOST_TEST(records.size() == 1);
+  BOOST_TEST(records[0].puzzle == "It's: Trivial");
+  BOOST_TEST(records[0].plan == "RDRU");
+  BOOST_TEST(records[0].source == solution_path + ":3");
+
+  // Results without a plan contain no records.
+  const auto failure_path = (directory / "failure.yaml").string();
+  std::ofstream(failure_path) << "failure_reason: time limit reached\n"
+                                 "plan: null\n"
+                                 "planner: RGD\n"
+                                 "planning_time: 1800.0\n"
+                                 "puzzle: trivial\n";
+  BOOST_TEST(read_plan_file(failure_path).empty());
+
+  // Text files contain one plan per line, after the puzzle name.
+  const auto text_path = (directory / "plans.txt").string();
+  std::ofstream(text_path) << "trivial RDRU\n"
+                              "\n"
+                              "A Perfect Fit  LRUD\n";
+  records = read_plan_file(text_path);
+  BOOST_TEST(records.size() == 2);
+  BOOST_TEST(records[0].puzzle == "trivial");
+  BOOST_TEST(records[0].plan == "RDRU");
+  BOOST_TEST(records[1].puzzle == "A Perfect Fit");
+  BOOST_TEST(records[1].plan == "LRUD");
+  BOOST_TEST(records[1].source == text_path + ":3");
+
+  std::ofstream(text_path) << "trivial\n";
+  BOOST_CHECK_THROW(read_plan_file(text_path), std::invalid_argument);
+  BOOST_CHECK_THROW(read_plan_file((directory / "missing.yaml").string()),
+                    std::invalid_argument);
+
+  fs::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace pushworld
@@ -0,0 +1,219 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "planner.h"
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+
+BOOST_AUTO_TEST_SUITE(planner)
+
+/* Checks that `solve` supports all modes. */
+BOOST_AUTO_TEST_CASE(test_solve) {
+  const auto trivial_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/trivial.pwp");
+  const auto no_solution_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/no_solution.pwp");
+  const Plan expected_plan{RIGHT, DOWN, RIGHT, UP};
+
+  for (const auto mode : {"RGD", "N+RGD"}) {
+    const auto plan = solve(trivial_puzzle, mode);
+    BOOST_TEST((plan != std::nullopt));
+    BOOST_TEST(*plan == expected_plan);
+
+    BOOST_TEST((solve(no_solution_puzzle, mode) == std::nullopt));
+  }
+
+  BOOST_CHECK_THROW(solve(trivial_puzzle, "foo"), std::domain_error);
+  BOOST_CHECK_THROW(solve(trivial_puzzle, "foo", 2), std::domain_error);
+
+  // Parallel searches can return different plans, but they must be valid.
+  const auto easy_search_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/easy_search.pwp");
+  for (const auto mode : {"RGD", "N+RGD"}) {
+    const auto plan = solve(easy_search_puzzle, mode, 3);
+    BOOST_TEST((plan != std::nullopt));
+    BOOST_TEST(easy_search_puzzle->isValidPlan(*plan));
+
+    BOOST_TEST((solve(no_solution_puzzle, mode, 3) == std::nullopt));
+  }
+}
+
+/**
+ * Checks that `solve_anytime` supports all modes, and that it returns a plan
+ * that is no longer than the plan of `solve`.
+ */
+BOOST_AUTO_TEST_CASE(test_solve_with_context) {
+  const auto trivial_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/trivial.pwp");
+  const auto no_solution_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/no_solution.pwp");
+  const Plan expected_plan{RIGHT, DOWN, RIGHT, UP};
+
+  for (const auto mode : {"RGD", "N+RGD"}) {
+    const search::SearchContext context;
+    auto result = solve(trivial_puzzle, mode, context);
+    BOOST_CHECK(result.status == search::SearchStatus::SOLVED);
+    BOOST_TEST(*result.plan == expected_plan);
+
+    result = solve(no_solution_puzzle, mode, context);
+    BOOST_CHECK(result.status == search::SearchStatus::NO_SOLUTION);
+
+    search::SearchContext cancelled;
+    cancelled.cancel();
+    search::SearchStatistics statistics;
+    result = solve(trivial_puzzle, mode, cancelled, &statistics);
+    BOOST_CHECK(result.status == search::SearchStatus::CANCELLED);
+    BOOST_CHECK(result.plan == std::nullopt);
+    BOOST_TEST(statistics.expansions == 0);
+
+    // Parallel searches also stop at the limits of the context.
+    result = solve(trivial_puzzle, mode, 3, context);
+    BOOST_CHECK(result.status == search::SearchStatus::SOLVED);
+    result = solve(trivial_puzzle, mode, 3, cancelled, &statistics);
+    BOOST_CHECK(result.status == search::SearchStatus::CANCELLED);
+    BOOST_TEST(statistics.expansions == 0);
+  }
+
+  const search::SearchContext context;
+  BOOST_CHECK_THROW(solve(trivial_puzzle, "foo", context), std::domain_error);
+}
+
+/* Checks that `solve` supports lazy evaluation in all modes. */
+BOOST_AUTO_TEST_CASE(test_solve_lazy) {
+  const auto easy_search_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/easy_search.pwp");
+  const auto no_solution_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/no_solution.pwp");
+  const search::SearchContext context;
+
+  for (const auto mode : {"RGD", "N+RGD"}) {
+    PortfolioMember member{mode};
+    member.lazy_evaluation = true;
+    search::SearchStatistics statistics;
+    auto result = solve(easy_search_puzzle, member, context, &statistics);
+    BOOST_CHECK(result.status == search::SearchStatus::SOLVED);
+    BOOST_TEST(easy_search_puzzle->isValidPlan(*result.plan));
+    BOOST_TEST(statistics.evaluations == statistics.expansions);
+
+    result = solve(no_solution_puzzle, member, context);
+    BOOST_CHECK(result.status == search::SearchStatus::NO_SOLUTION);
+  }
+
+  BOOST_CHECK_THROW(solve(easy_search_puzzle, PortfolioMember{"PORTFOLIO"},
+                          context),
+                    std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_solve_portfolio) {
+  const auto easy_search_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/easy_search.pwp");
+  const auto no_solution_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/no_solution.pwp");
+
+  auto plan = solve(easy_search_puzzle, "PORTFOLIO");
+  BOOST_TEST((plan != std::nullopt));
+  BOOST_TEST(easy_search_puzzle->isValidPlan(*plan));
+  BOOST_TEST((solve(no_solution_puzzle, "PORTFOLIO") == std::nullopt));
+
+  // The number of threads is ignored.
+  plan = solve(easy_search_puzzle, "PORTFOLIO", 3);
+  BOOST_TEST(easy_search_puzzle->isValidPlan(*plan));
+
+  const std::vector<PortfolioMember> portfolio{
+      {"RGD", true, 1}, {"RGD", true, 2}, {"RGD", false, 3}};
+  const search::SearchContext context;
+  search::SearchStatistics statistics;
+  auto result =
+      solve_portfolio(easy_search_puzzle, portfolio, context, &statistics);
+  BOOST_CHECK(result.status == search::SearchStatus::SOLVED);
+  BOOST_TEST(easy_search_puzzle->isValidPlan(*result.plan));
+  BOOST_TEST(statistics.expansions > 0);
+  BOOST_TEST(statistics.heuristic_counters.count(
+                 "rgd_pushing_cost_cache_hits") == 1);
+
+  result = solve_portfolio(no_solution_puzzle, portfolio, context);
+  BOOST_CHECK(result.status == search::SearchStatus::NO_SOLUTION);
+
+  search::SearchContext cancelled;
+  cancelled.cancel();
+  result = solve_portfolio(easy_search_puzzle, portfolio, cancelled);
+  BOOST_CHECK(result.status == search::SearchStatus::CANCELLED);
+  BOOST_CHECK(result.plan == std::nullopt);
+
+  search::SearchContext no_memory;
+  no_memory.setMemoryLimit(0);
+  result = solve_portfolio(easy_search_puzzle, portfolio, no_memory);
+  BOOST_CHECK(result.status == search::SearchStatus::MEMORY_LIMIT);
+
+  BOOST_CHECK_THROW(solve_portfolio(easy_search_puzzle, {}, context),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(
+      solve_portfolio(easy_search_puzzle, {{"RGD"}, {"foo"}}, context),
+      std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_solve_external) {
+  const auto easy_search_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/easy_search.pwp");
+  const auto no_solution_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/no_solution.pwp");
+  const search::SearchContext context;
+  search::ExternalSearchOptions options;
+  options.memory_budget = 1024;
+
+  for (const auto mode : {"RGD", "N+RGD"}) {
+    auto result = solve_external(easy_search_puzzle, mode, options, context);
+    BOOST_CHECK(result.status == search::SearchStatus::SOLVED);
+    BOOST_TEST(easy_search_puzzle->isValidPlan(*result.plan));
+
+    result = solve_external(no_solution_puzzle, mode, options, context);
+    BOOST_CHECK(result.status == search::SearchStatus::NO_SOLUTION);
+  }
+
+  BOOST_CHECK_THROW(
+      solve_external(easy_search_puzzle, "PORTFOLIO", options, context),
+      std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_solve_anytime) {
+  const auto puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/multiple_goals.pwp");
+  const auto no_solution_puzzle =
+      std::make_shared<PushWorldPuzzle>("puzzles/no_solution.pwp");
+  const search::AnytimeSearchOptions options;
+
+  for (const auto mode : {"RGD", "N+RGD"}) {
+    const auto plan = solve_anytime(puzzle, mode, options);
+    BOOST_TEST((plan != std::nullopt));
+    BOOST_TEST(puzzle->isValidPlan(*plan));
+    BOOST_TEST(plan->size() <= solve(puzzle, mode)->size());
+
+    BOOST_TEST(
+        (solve_anytime(no_solution_puzzle, mode, options) == std::nullopt));
+  }
+
+  BOOST_CHECK_THROW(solve_anytime(puzzle, "foo", options), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace pushworld
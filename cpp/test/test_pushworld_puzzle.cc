@@ -14,9 +14,17 @@
 
 #include <stdlib.h>  // srand, rand
 
+#include <algorithm>  // is_sorted
 #include <boost/test/unit_test.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "pushworld_puzzle.h"
 
@@ -80,14 +88,95 @@ BOOST_AUTO_TEST_CASE(test_position_arithmetic) {
   }
 }
 
+/* Checks `displacement_to_xy` on signed displacements. */
+BOOST_AUTO_TEST_CASE(test_displacement_conversions) {
+  int x, y;
+  int dx, dy;
+
+  std::srand(0);
+
+  for (int i = 0; i < 100; i++) {
+    // This isn't a uniform distribution, but it doesn't matter here.
+    dx = rand() % 5000 - 2500;
+    dy = rand() % 5000 - 2500;
+    displacement_to_xy(xy_to_position(dx, dy), x, y);
+    BOOST_TEST(x == dx);
+    BOOST_TEST(y == dy);
+  }
+
+  // Non-negative positions are converted in the same way as `position_to_xy`.
+  displacement_to_xy(xy_to_position(12, 34), x, y);
+  BOOST_TEST(x == 12);
+  BOOST_TEST(y == 34);
+}
+
+/* Checks that `PositionBitmap` has the same membership as an `unordered_set`.
+ */
+BOOST_AUTO_TEST_CASE(test_position_bitmap) {
+  std::srand(0);
+
+  PositionBitmap empty_bitmap;
+  BOOST_TEST(empty_bitmap.empty());
+  BOOST_TEST(!empty_bitmap.contains(0));
+  BOOST_TEST(!PositionBitmap(std::unordered_set<Position2D>()).contains(0));
+
+  for (int i = 0; i < 10; i++) {
+    std::unordered_set<Position2D> positions;
+    for (int j = 0; j < 20; j++) {
+      positions.insert(xy_to_position(rand() % 11 - 5, rand() % 11 - 5));
+    }
+
+    const PositionBitmap bitmap(positions);
+    BOOST_TEST(bitmap.size() == positions.size());
+    BOOST_TEST(std::is_sorted(bitmap.positions().begin(),
+                              bitmap.positions().end()));
+
+    for (int x = -8; x <= 8; x++) {
+      for (int y = -8; y <= 8; y++) {
+        const auto p = xy_to_position(x, y);
+        BOOST_TEST(bitmap.contains(p) == (positions.count(p) == 1));
+      }
+    }
+  }
+}
+
+/* Checks that `CompiledCollisions` matches the `ObjectCollisions` of a puzzle.
+ */
+BOOST_AUTO_TEST_CASE(test_compiled_collisions) {
+  PushWorldPuzzle puzzle("puzzles/file_parsing.pwp");
+  const auto& object_collisions = puzzle.getObjectCollisions();
+  const auto& compiled_collisions = puzzle.getCompiledCollisions();
+  const int num_objects = puzzle.getInitialState().size();
+
+  for (int action = 0; action < NUM_ACTIONS; action++) {
+    for (int i = 0; i < num_objects; i++) {
+      const auto& expected = object_collisions.static_collisions[action][i];
+      const auto& bitmap = compiled_collisions.getStaticCollisions(action, i);
+      BOOST_TEST(bitmap.size() == expected.size());
+      for (const auto p : expected) {
+        BOOST_TEST(bitmap.contains(p));
+      }
+
+      for (int j = 0; j < num_objects; j++) {
+        const auto& expected =
+            object_collisions.dynamic_collisions[action][i][j];
+        const auto& bitmap =
+            compiled_collisions.getDynamicCollisions(action, i, j);
+        BOOST_TEST(bitmap.size() == expected.size());
+        for (const auto p : expected) {
+          BOOST_TEST(bitmap.contains(p));
+        }
+      }
+    }
+  }
+}
+
 /* Checks that the agent moves as expected with each action. */
 BOOST_AUTO_TEST_CASE(test_agent_movement) {
   RelativeState next_relative_state;
   const State initial_state = {xy_to_position(1, 1)};
   int num_moveables = 1;
-  int num_goal_entities = 0;
   const Goal goal = {};
-  int x, y;
 
   ObjectCollisions object_collisions(num_moveables);
   PushWorldPuzzle puzzle(initial_state, goal, object_collisions);
@@ -226,6 +315,241 @@ BOOST_AUTO_TEST_CASE(test_transitive_pushing) {
   BOOST_TEST(s2.state[2] == xy_to_position(6, 1));
 }
 
+/**
+ * Checks that the `getNextState` overload that reuses a caller-owned buffer
+ * returns the same states as the overload that returns a new state.
+ */
+BOOST_AUTO_TEST_CASE(test_next_state_buffer) {
+  PushWorldPuzzle puzzle("puzzles/file_parsing.pwp");
+
+  StateSet visited_states{puzzle.getInitialState()};
+  std::vector<State> frontier{puzzle.getInitialState()};
+  RelativeState next;
+  int num_blocked_actions = 0;
+
+  // Explore states depth-first and compare both overloads in every state.
+  for (int i = 0; i < 1000 && !frontier.empty(); i++) {
+    const State state = frontier.back();
+    frontier.pop_back();
+
+    for (int action = 0; action < NUM_ACTIONS; action++) {
+      const auto expected = puzzle.getNextState(state, action);
+      const auto previous_state = next.state;
+      const bool moved = puzzle.getNextState(state, action, next);
+
+      BOOST_TEST(moved == !expected.moved_object_indices.empty());
+      BOOST_TEST(next.moved_object_indices == expected.moved_object_indices);
+
+      if (moved) {
+        BOOST_TEST(next.state == expected.state);
+        if (visited_states.insert(next.state).second) {
+          frontier.push_back(next.state);
+        }
+      } else {
+        // The buffer is not modified when nothing moves.
+        BOOST_TEST(next.state == previous_state);
+        BOOST_TEST(expected.state == state);
+        num_blocked_actions++;
+      }
+    }
+  }
+
+  BOOST_TEST(num_blocked_actions > 0);
+}
+
+/* Checks that `getSuccessors` computes the same states as `getNextState`. */
+BOOST_AUTO_TEST_CASE(test_successors) {
+  PushWorldPuzzle puzzle("puzzles/file_parsing.pwp");
+
+  // Collect some states by a breadth-first search.
+  StateSet visited_states{puzzle.getInitialState()};
+  std::vector<State> states{puzzle.getInitialState()};
+  for (size_t i = 0; i < states.size() && states.size() < 50; i++) {
+    for (int action = 0; action < NUM_ACTIONS; action++) {
+      const auto next = puzzle.getNextState(states[i], action);
+      if (visited_states.insert(next.state).second) {
+        states.push_back(next.state);
+      }
+    }
+  }
+
+  const std::vector<Action> actions{RIGHT, UP, LEFT, DOWN};
+  std::vector<RelativeState> successors;
+  std::vector<uint8_t> moved;
+  for (const size_t num_states : {states.size(), size_t(3)}) {
+    const size_t num_moved = puzzle.getSuccessors(
+        states.data(), num_states, actions, successors, moved);
+    BOOST_TEST(successors.size() >= num_states * actions.size());
+    BOOST_TEST(moved.size() >= num_states * actions.size());
+
+    size_t expected_num_moved = 0;
+    for (size_t i = 0; i < num_states; i++) {
+      for (size_t j = 0; j < actions.size(); j++) {
+        const auto expected = puzzle.getNextState(states[i], actions[j]);
+        const size_t k = i * actions.size() + j;
+        BOOST_TEST(bool(moved[k]) == !expected.moved_object_indices.empty());
+        BOOST_TEST(successors[k].moved_object_indices ==
+                   expected.moved_object_indices);
+        if (moved[k]) {
+          BOOST_TEST(successors[k].state == expected.state);
+          expected_num_moved++;
+        }
+      }
+    }
+    BOOST_TEST(num_moved == expected_num_moved);
+    BOOST_TEST(num_moved > 0);
+  }
+
+  // Each vector is resized on its own, even if the other one is large enough.
+  moved.clear();
+  puzzle.getSuccessors(states.data(), 3, actions, successors, moved);
+  BOOST_TEST(moved.size() >= 3 * actions.size());
+}
+
+/**
+ * Checks that the SIMD and fixed-size kernels compute the same transitions as
+ * the scalar kernel.
+ */
+BOOST_AUTO_TEST_CASE(test_transition_kernels) {
+  const TransitionKernel simd_kernel = SIMD_KERNEL_AVAILABLE
+                                           ? TransitionKernel::SIMD
+                                           : TransitionKernel::SCALAR;
+
+  for (const std::string filename :
+       {"puzzles/many_objects.pwp", "puzzles/file_parsing.pwp",
+        "puzzles/transitive_pushing.pwp"}) {
+    PushWorldPuzzle scalar_puzzle(filename);
+    PushWorldPuzzle simd_puzzle(filename);
+    PushWorldPuzzle fixed_size_puzzle(filename);
+    scalar_puzzle.setTransitionKernel(TransitionKernel::SCALAR);
+    simd_puzzle.setTransitionKernel(TransitionKernel::SIMD);
+    fixed_size_puzzle.setTransitionKernel(TransitionKernel::FIXED_SIZE);
+    BOOST_CHECK(scalar_puzzle.getTransitionKernel() ==
+                TransitionKernel::SCALAR);
+    BOOST_CHECK(simd_puzzle.getTransitionKernel() == simd_kernel);
+    BOOST_CHECK(fixed_size_puzzle.getTransitionKernel() ==
+                TransitionKernel::FIXED_SIZE);
+
+    StateSet visited_states{scalar_puzzle.getInitialState()};
+    std::vector<State> frontier{scalar_puzzle.getInitialState()};
+    RelativeState scalar_next;
+    RelativeState other_next;
+    int num_pushes = 0;
+
+    for (int i = 0; i < 2000 && !frontier.empty(); i++) {
+      const State state = frontier.back();
+      frontier.pop_back();
+
+      for (int action = 0; action < NUM_ACTIONS; action++) {
+        const bool moved =
+            scalar_puzzle.getNextState(state, action, scalar_next);
+
+        for (const PushWorldPuzzle* puzzle :
+             {&simd_puzzle, &fixed_size_puzzle}) {
+          BOOST_TEST(puzzle->getNextState(state, action, other_next) == moved);
+          BOOST_TEST(other_next.moved_object_indices ==
+                     scalar_next.moved_object_indices);
+          if (moved) {
+            BOOST_TEST(other_next.state == scalar_next.state);
+          }
+        }
+
+        if (moved) {
+          num_pushes += scalar_next.moved_object_indices.size() > 1;
+          if (visited_states.insert(scalar_next.state).second) {
+            frontier.push_back(scalar_next.state);
+          }
+        }
+      }
+    }
+
+    BOOST_TEST(num_pushes > 0);
+  }
+}
+
+/**
+ * Checks that `TransitionKernel::AUTO` selects the fixed-size kernel if one
+ * exists for the number of objects, and otherwise the SIMD kernel.
+ */
+BOOST_AUTO_TEST_CASE(test_auto_transition_kernel) {
+  for (const std::string filename :
+       {"puzzles/trivial.pwp", "puzzles/many_objects.pwp"}) {
+    const PushWorldPuzzle puzzle(filename);
+    BOOST_TEST(puzzle.getInitialState().size() <=
+               FIXED_SIZE_KERNEL_MAX_OBJECTS);
+    BOOST_CHECK(puzzle.getTransitionKernel() == TransitionKernel::FIXED_SIZE);
+  }
+
+  // Build a puzzle with more objects than any fixed-size kernel.
+  const int num_objects = FIXED_SIZE_KERNEL_MAX_OBJECTS + 3;
+  std::string puzzle_text = "A";
+  for (int i = 0; i < num_objects - 1; i++) {
+    puzzle_text += " M" + std::to_string(i);
+  }
+  puzzle_text += " . G0\n";
+  const auto puzzle = PushWorldPuzzle::fromText(puzzle_text);
+  BOOST_TEST(puzzle.getInitialState().size() == num_objects);
+  BOOST_CHECK(puzzle.getTransitionKernel() ==
+              (SIMD_KERNEL_AVAILABLE ? TransitionKernel::SIMD
+                                     : TransitionKernel::SCALAR));
+
+  // The fixed-size kernel falls back to the scalar kernel. The agent pushes
+  // every object.
+  PushWorldPuzzle fixed_size_puzzle = puzzle;
+  fixed_size_puzzle.setTransitionKernel(TransitionKernel::FIXED_SIZE);
+  BOOST_CHECK(fixed_size_puzzle.getTransitionKernel() ==
+              TransitionKernel::SCALAR);
+  BOOST_TEST(fixed_size_puzzle.getNextState(puzzle.getInitialState(), RIGHT)
+                 .moved_object_indices.size() == num_objects);
+}
+
+/**
+ * Checks that `getNextState` with caller-owned scratch memory can be called
+ * concurrently from multiple threads.
+ */
+BOOST_AUTO_TEST_CASE(test_next_state_concurrent) {
+  const PushWorldPuzzle puzzle("puzzles/file_parsing.pwp");
+
+  // Compute a sequence of transitions serially.
+  std::vector<State> states{puzzle.getInitialState()};
+  std::vector<RelativeState> expected;
+  for (int i = 0; i < 200; i++) {
+    const State& state = states[i];
+    const Action action = i % NUM_ACTIONS;
+    expected.push_back(puzzle.getNextState(state, action));
+    states.push_back(expected.back().state);
+  }
+
+  const int num_threads = 4;
+  std::vector<int> num_mismatches(num_threads, 0);
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      TransitionScratch scratch;
+      RelativeState next;
+      for (int repeat = 0; repeat < 50; repeat++) {
+        for (int i = 0; i < expected.size(); i++) {
+          const bool moved =
+              puzzle.getNextState(states[i], i % NUM_ACTIONS, next, scratch);
+          const State& next_state = moved ? next.state : states[i];
+          if (next_state != expected[i].state ||
+              next.moved_object_indices != expected[i].moved_object_indices) {
+            num_mismatches[t]++;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < num_threads; t++) {
+    BOOST_TEST(num_mismatches[t] == 0);
+  }
+}
+
 /* Checks `Pushpuzzle.satisfiesGoal` */
 BOOST_AUTO_TEST_CASE(test_goal_checking) {
   State initial_state = {xy_to_position(1, 1), xy_to_position(2, 2),
@@ -256,6 +580,43 @@ BOOST_AUTO_TEST_CASE(test_goal_checking) {
   BOOST_TEST(!puzzle2.satisfiesGoal(s8));
 }
 
+/**
+ * Checks that interchangeable objects are found, and that states are
+ * canonicalized by sorting their positions.
+ */
+BOOST_AUTO_TEST_CASE(test_interchangeable_objects) {
+  BOOST_TEST(PushWorldPuzzle("puzzles/trivial.pwp")
+                 .getInterchangeableObjects()
+                 .empty());
+
+  // The goal object M1 and the larger objects M6 and M7 have no equivalent.
+  PushWorldPuzzle puzzle("puzzles/many_objects.pwp");
+  const std::vector<std::vector<int>> expected_groups = {{2, 3, 4, 5, 8, 9}};
+  BOOST_CHECK(puzzle.getInterchangeableObjects() == expected_groups);
+
+  State canonical_state = puzzle.getInitialState();
+  puzzle.canonicalize(canonical_state);
+  BOOST_TEST(!puzzle.canonicalize(canonical_state));
+
+  // Only the positions of interchangeable objects are reordered.
+  std::vector<Position2D> positions;
+  for (int i = 0; i < canonical_state.size(); i++) {
+    if (i < 2 || i == 6 || i == 7) {
+      BOOST_TEST(canonical_state[i] == puzzle.getInitialState()[i]);
+    } else {
+      positions.push_back(canonical_state[i]);
+    }
+  }
+  BOOST_TEST(std::is_sorted(positions.begin(), positions.end()));
+
+  // Every permutation of the positions of M2 and M9 has the same canonical
+  // state.
+  State state = canonical_state;
+  std::swap(state[2], state[9]);
+  BOOST_TEST(puzzle.canonicalize(state));
+  BOOST_TEST(state == canonical_state);
+}
+
 /* Checks that a small PushWorld puzzle file is correctly parsed. */
 BOOST_AUTO_TEST_CASE(test_trivial_file_parsing) {
   std::string filename = "puzzles/trivial.pwp";
@@ -513,6 +874,113 @@ BOOST_AUTO_TEST_CASE(test_file_parsing) {
   BOOST_TEST(dynamic_collisions[UP][1][4].size() == 4);     // M1, M2
 }
 
+/* Checks that whitespace, letter case, and empty lines do not affect parsing.
+ */
+BOOST_AUTO_TEST_CASE(test_file_parsing_whitespace) {
+  const auto path =
+      std::filesystem::temp_directory_path() / "test_file_parsing_whitespace";
+
+  {
+    std::ofstream file(path);
+    file << "\n  w\t.  g0\r\n\na m0 .\n\n Aw . .  \n\n";
+  }
+  const PushWorldPuzzle puzzle(path.string());
+  const PushWorldPuzzle expected("puzzles/trivial.pwp");
+
+  BOOST_TEST(puzzle.getInitialState() == expected.getInitialState());
+  BOOST_TEST(puzzle.getGoal() == expected.getGoal());
+  BOOST_TEST(puzzle.getWidth() == expected.getWidth());
+  BOOST_TEST(puzzle.getHeight() == expected.getHeight());
+  BOOST_TEST(puzzle.getObjectCollisions().static_collisions ==
+             expected.getObjectCollisions().static_collisions);
+  BOOST_TEST(puzzle.getObjectCollisions().dynamic_collisions ==
+             expected.getObjectCollisions().dynamic_collisions);
+
+  {
+    std::ofstream file(path);
+    file << "A . .\n. .\n";
+  }
+  BOOST_CHECK_THROW(PushWorldPuzzle(path.string()), std::invalid_argument);
+
+  std::filesystem::remove(path);
+}
+
+/* Checks the object shapes that are loaded from a puzzle file. */
+BOOST_AUTO_TEST_CASE(test_object_shapes) {
+  const PushWorldPuzzle puzzle("puzzles/trivial.pwp");
+  const auto& shapes = puzzle.getShapes();
+  const std::vector<Position2D> single_cell{xy_to_position(0, 0)};
+
+  BOOST_TEST(shapes.objects.size() == 2);
+  BOOST_TEST(shapes.objects[AGENT] == single_cell);
+  BOOST_TEST(shapes.objects[1] == single_cell);
+  BOOST_TEST(shapes.goals.size() == 1);
+  BOOST_TEST(shapes.goals[0] == single_cell);
+  BOOST_TEST(shapes.agent_walls ==
+             std::vector<Position2D>{xy_to_position(1, 3)});
+
+  // The 16 boundary walls and the wall inside of the puzzle.
+  const std::unordered_set<Position2D> walls(shapes.walls.begin(),
+                                             shapes.walls.end());
+  BOOST_TEST(walls.size() == 17);
+  BOOST_TEST(shapes.walls.size() == 17);
+  BOOST_TEST(walls.count(xy_to_position(1, 1)) == 1);
+  BOOST_TEST(walls.count(xy_to_position(4, 4)) == 1);
+
+  // Puzzles that are constructed from collisions have no shapes.
+  const PushWorldPuzzle constructed(puzzle.getInitialState(), puzzle.getGoal(),
+                                    puzzle.getObjectCollisions());
+  BOOST_TEST(constructed.getShapes().objects.empty());
+  BOOST_TEST(constructed.getShapes().walls.empty());
+}
+
+/* Checks that compiled puzzles are identical to the puzzles they came from. */
+BOOST_AUTO_TEST_CASE(test_compiled_puzzle) {
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("test_compiled_puzzle" +
+                     std::string(COMPILED_PUZZLE_EXTENSION));
+
+  for (const std::string filename :
+       {"puzzles/file_parsing.pwp", "puzzles/trivial_overlap.pwp",
+        "puzzles/transitive_pushing.pwp", "puzzles/multiple_goals.pwp"}) {
+    const PushWorldPuzzle puzzle(filename);
+    puzzle.saveCompiled(path.string());
+    const auto compiled = PushWorldPuzzle::loadCompiled(path.string());
+
+    BOOST_TEST(compiled.getInitialState() == puzzle.getInitialState());
+    BOOST_TEST(compiled.getGoal() == puzzle.getGoal());
+    BOOST_TEST(compiled.getWidth() == puzzle.getWidth());
+    BOOST_TEST(compiled.getHeight() == puzzle.getHeight());
+    BOOST_TEST(compiled.getObjectCollisions().static_collisions ==
+               puzzle.getObjectCollisions().static_collisions);
+    BOOST_TEST(compiled.getObjectCollisions().dynamic_collisions ==
+               puzzle.getObjectCollisions().dynamic_collisions);
+    BOOST_CHECK(compiled.getShapes() == puzzle.getShapes());
+
+    // Transitions use the compiled collisions, which are rebuilt on loading.
+    for (int action = 0; action < NUM_ACTIONS; action++) {
+      const auto state = puzzle.getInitialState();
+      const auto expected = puzzle.getNextState(state, action);
+      const auto next = compiled.getNextState(state, action);
+      BOOST_TEST(next.state == expected.state);
+      BOOST_TEST(next.moved_object_indices == expected.moved_object_indices);
+    }
+  }
+
+  // Files in other formats are rejected.
+  BOOST_CHECK_THROW(PushWorldPuzzle::loadCompiled("puzzles/trivial.pwp"),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(PushWorldPuzzle::loadCompiled("puzzles/missing.pwpc"),
+                    std::invalid_argument);
+
+  // Truncated files are rejected.
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+  BOOST_CHECK_THROW(PushWorldPuzzle::loadCompiled(path.string()),
+                    std::invalid_argument);
+
+  std::filesystem::remove(path);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace pushworld
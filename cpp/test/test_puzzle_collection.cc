@@ -0,0 +1,145 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "puzzle_collection.h"
+
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "pushworld_puzzle.h"
+
+namespace fs = std::filesystem;
+
+namespace pushworld {
+
+BOOST_AUTO_TEST_SUITE(puzzle_collection)
+
+namespace {
+
+/**
+ * Checks that two puzzles have identical states, goals, collisions, and
+ * shapes.
+ */
+void check_equal_puzzles(const PushWorldPuzzle& actual,
+                         const PushWorldPuzzle& expected) {
+  BOOST_TEST(actual.getInitialState() == expected.getInitialState());
+  BOOST_TEST(actual.getGoal() == expected.getGoal());
+  BOOST_TEST(actual.getWidth() == expected.getWidth());
+  BOOST_TEST(actual.getHeight() == expected.getHeight());
+  BOOST_TEST(actual.getObjectCollisions().static_collisions ==
+             expected.getObjectCollisions().static_collisions);
+  BOOST_TEST(actual.getObjectCollisions().dynamic_collisions ==
+             expected.getObjectCollisions().dynamic_collisions);
+  BOOST_CHECK(actual.getShapes() == expected.getShapes());
+}
+
+/* Checks the contents of `puzzles/collection.zip` or an archive of it. */
+void check_collection(const PuzzleCollection& collection) {
+  // The zip archive also contains a directory and a text file, which are not
+  // puzzles.
+  BOOST_TEST_REQUIRE(collection.size() == 2);
+  BOOST_TEST(collection.getName(0) == "collection/goals/multiple_goals.pwp");
+  BOOST_TEST(collection.getName(1) == "collection/trivial.pwp");
+
+  check_equal_puzzles(collection.getPuzzle(0),
+                      PushWorldPuzzle("puzzles/multiple_goals.pwp"));
+  check_equal_puzzles(collection.getPuzzle(1),
+                      PushWorldPuzzle("puzzles/trivial.pwp"));
+  BOOST_CHECK_THROW(collection.getPuzzle(2), std::out_of_range);
+}
+
+}  // namespace
+
+/* Checks `is_puzzle_collection`. */
+BOOST_AUTO_TEST_CASE(test_is_puzzle_collection) {
+  BOOST_TEST(is_puzzle_collection("level0.zip"));
+  BOOST_TEST(is_puzzle_collection("dir/level0.ZIP"));
+  BOOST_TEST(is_puzzle_collection("level0.pwpa"));
+  BOOST_TEST(!is_puzzle_collection("trivial.pwp"));
+  BOOST_TEST(!is_puzzle_collection("zip"));
+}
+
+/* Checks that puzzles are read from stored and deflated zip entries. */
+BOOST_AUTO_TEST_CASE(test_zip_collection) {
+  check_collection(PuzzleCollection("puzzles/collection.zip"));
+
+  BOOST_CHECK_THROW(PuzzleCollection("puzzles/missing.zip"),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(PuzzleCollection("puzzles/trivial.pwp"),
+                    std::invalid_argument);
+}
+
+/* Checks that archives of compiled puzzles contain the same puzzles. */
+BOOST_AUTO_TEST_CASE(test_archive_collection) {
+  const fs::path path =
+      fs::temp_directory_path() /
+      ("test_archive_collection" + std::string(PUZZLE_ARCHIVE_EXTENSION));
+
+  PuzzleCollection("puzzles/collection.zip").saveArchive(path.string());
+  check_collection(PuzzleCollection(path.string()));
+
+  // Truncated archives are rejected.
+  fs::resize_file(path, 20);
+  BOOST_CHECK_THROW(PuzzleCollection(path.string()), std::invalid_argument);
+
+  fs::remove(path);
+}
+
+/* Checks that zip archives that are written by `ZipArchiveWriter` can be read
+ * as puzzle collections. */
+BOOST_AUTO_TEST_CASE(test_zip_archive_writer) {
+  const fs::path path = fs::temp_directory_path() / "test_zip_writer.zip";
+
+  auto read_file = [](const std::string& filename) {
+    std::ostringstream text;
+    text << std::ifstream(filename).rdbuf();
+    return text.str();
+  };
+
+  {
+    ZipArchiveWriter writer(path.string());
+    writer.add("collection/goals/multiple_goals.pwp",
+               read_file("puzzles/multiple_goals.pwp"));
+    writer.add("collection/notes.txt", "Not a puzzle");
+    writer.add("collection/trivial.pwp", read_file("puzzles/trivial.pwp"));
+    writer.close();
+    BOOST_CHECK_THROW(writer.add("collection/empty.pwp", ""),
+                      std::runtime_error);
+  }
+  check_collection(PuzzleCollection(path.string()));
+
+  // The destructor closes archives that were not closed.
+  {
+    ZipArchiveWriter writer(path.string());
+    writer.add("trivial.pwp", read_file("puzzles/trivial.pwp"));
+  }
+  const PuzzleCollection collection(path.string());
+  BOOST_TEST_REQUIRE(collection.size() == 1);
+  check_equal_puzzles(collection.getPuzzle(0),
+                      PushWorldPuzzle("puzzles/trivial.pwp"));
+
+  fs::remove(path);
+
+  BOOST_CHECK_THROW(ZipArchiveWriter("missing_directory/test.zip"),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace pushworld
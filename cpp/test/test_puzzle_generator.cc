@@ -0,0 +1,139 @@
+// Copyright 2022 DeepMind Technologies Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "puzzle_generator.h"
+
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "pushworld_puzzle.h"
+
+namespace pushworld {
+
+BOOST_AUTO_TEST_SUITE(puzzle_generator)
+
+namespace {
+
+/* Returns the number of pixels in the .pwp `text` that are the `symbol`. */
+int count_pixels(const std::string& text, const std::string& symbol) {
+  std::istringstream stream(text);
+  std::string pixel;
+  int count = 0;
+  while (stream >> pixel) {
+    if (pixel == symbol) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+/* Checks that generated puzzles can be loaded and match the options. */
+BOOST_AUTO_TEST_CASE(test_generated_puzzles) {
+  Level0GeneratorOptions options;
+  options.max_num_goal_objects = 2;
+  Level0PuzzleGenerator generator(options, 0);
+
+  for (int i = 0; i < 100; i++) {
+    const std::string text = generator.generate();
+    const auto puzzle = PushWorldPuzzle::fromText(text);
+
+    // The dimensions include the boundary walls.
+    BOOST_TEST(puzzle.getWidth() >= 8 + 2);
+    BOOST_TEST(puzzle.getWidth() <= 12 + 2);
+    BOOST_TEST(puzzle.getHeight() >= 8 + 2);
+    BOOST_TEST(puzzle.getHeight() <= 12 + 2);
+
+    const int num_goals = puzzle.getGoal().size();
+    BOOST_TEST((num_goals == 1 || num_goals == 2));
+
+    // The agent, the goal objects, and the obstacles.
+    const int num_objects = puzzle.getInitialState().size();
+    BOOST_TEST(num_objects >= 1 + num_goals + 1);
+    BOOST_TEST(num_objects <= 1 + num_goals + 2);
+
+    const int num_walls = count_pixels(text, "W");
+    BOOST_TEST(num_walls >= 2);
+    BOOST_TEST(num_walls <= 4);
+  }
+}
+
+/* Checks that the puzzles only depend on the options and the seed. */
+BOOST_AUTO_TEST_CASE(test_seed) {
+  Level0PuzzleGenerator generator_1(Level0GeneratorOptions(), 7);
+  Level0PuzzleGenerator generator_2(Level0GeneratorOptions(), 7);
+  Level0PuzzleGenerator generator_3(Level0GeneratorOptions(), 8);
+
+  int num_differences = 0;
+  for (int i = 0; i < 10; i++) {
+    const std::string text = generator_1.generate();
+    BOOST_TEST(generator_2.generate() == text);
+    if (generator_3.generate() != text) {
+      num_differences++;
+    }
+  }
+  BOOST_TEST(num_differences > 0);
+}
+
+/* Checks that all objects in puzzles with simple shapes are single pixels. */
+BOOST_AUTO_TEST_CASE(test_simple_shapes) {
+  Level0GeneratorOptions options;
+  options.complex_shapes = false;
+  options.min_num_obstacles = 2;
+  Level0PuzzleGenerator generator(options, 0);
+
+  for (int i = 0; i < 20; i++) {
+    const std::string text = generator.generate();
+    for (const std::string symbol : {"A", "M1", "G1", "M2", "M3"}) {
+      BOOST_TEST(count_pixels(text, symbol) == 1);
+    }
+  }
+}
+
+/* Checks that invalid options are rejected. */
+BOOST_AUTO_TEST_CASE(test_invalid_options) {
+  auto check_invalid = [](auto modify) {
+    Level0GeneratorOptions options;
+    modify(options);
+    BOOST_CHECK_THROW(Level0PuzzleGenerator(options, 0),
+                      std::invalid_argument);
+  };
+  check_invalid([](auto& o) { o.min_puzzle_size = 1; });
+  check_invalid([](auto& o) { o.max_puzzle_size = 7; });
+  check_invalid([](auto& o) { o.min_num_walls = -1; });
+  check_invalid([](auto& o) { o.min_num_walls = 5; });
+  check_invalid([](auto& o) { o.max_num_obstacles = 0; });
+  check_invalid([](auto& o) { o.min_num_goal_objects = 0; });
+  check_invalid([](auto& o) { o.max_num_goal_objects = 3; });
+  check_invalid([](auto& o) {
+    o.max_num_goal_objects = 2;
+    o.complex_shapes = false;
+  });
+
+  // The objects do not fit in 2x2 puzzles.
+  Level0GeneratorOptions options;
+  options.min_puzzle_size = 2;
+  options.max_puzzle_size = 2;
+  options.min_num_obstacles = 2;
+  Level0PuzzleGenerator generator(options, 0);
+  BOOST_CHECK_THROW(generator.generate(), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace pushworld
@@ -0,0 +1,278 @@
+# Copyright 2022 DeepMind Technologies Limited
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import ctypes
+from typing import List, Optional, Tuple
+
+import numpy as np
+
+from pushworld.config import NATIVE_ENV_LIBRARY_PATH, PUZZLE_EXTENSION
+from pushworld.puzzle import DEFAULT_BORDER_WIDTH, DEFAULT_PIXELS_PER_CELL, State
+from pushworld.utils.env_utils import get_max_puzzle_dimensions
+from pushworld.utils.filesystem import iter_files_with_extension
+
+# Native positions are encoded as `x * POSITION_LIMIT + y`.
+POSITION_LIMIT = 10000
+
+_libraries = {}
+
+
+def _load_library(library_path: str) -> ctypes.CDLL:
+    """Loads the shared library of the native environment and declares the
+    signatures of its functions."""
+    if library_path in _libraries:
+        return _libraries[library_path]
+
+    lib = ctypes.CDLL(library_path)
+    c_int = ctypes.c_int
+    c_void_p = ctypes.c_void_p
+    c_int32_p = ctypes.POINTER(ctypes.c_int32)
+
+    lib.pushworld_env_last_error.argtypes = []
+    lib.pushworld_env_last_error.restype = ctypes.c_char_p
+    lib.pushworld_env_create.argtypes = [ctypes.POINTER(ctypes.c_char_p)] + [
+        c_int
+    ] * 8 + [ctypes.c_uint64]
+    lib.pushworld_env_create.restype = c_void_p
+    lib.pushworld_env_destroy.argtypes = [c_void_p]
+    lib.pushworld_env_destroy.restype = None
+    lib.pushworld_env_observation_shape.argtypes = [
+        c_void_p,
+        ctypes.POINTER(c_int),
+        ctypes.POINTER(c_int),
+    ]
+    lib.pushworld_env_observation_shape.restype = None
+    lib.pushworld_env_state_size.argtypes = [c_void_p]
+    lib.pushworld_env_state_size.restype = c_int
+    lib.pushworld_env_states.argtypes = [c_void_p]
+    lib.pushworld_env_states.restype = c_int32_p
+    lib.pushworld_env_puzzle_indices.argtypes = [c_void_p]
+    lib.pushworld_env_puzzle_indices.restype = c_int32_p
+    lib.pushworld_env_reset.argtypes = [c_void_p, c_void_p]
+    lib.pushworld_env_reset.restype = c_int
+    lib.pushworld_env_reset_env.argtypes = [c_void_p, c_int, c_int, c_void_p]
+    lib.pushworld_env_reset_env.restype = c_int
+    lib.pushworld_env_step.argtypes = [c_void_p] * 6
+    lib.pushworld_env_step.restype = c_int
+
+    _libraries[library_path] = lib
+    return lib
+
+
+def position_to_point(position: int) -> Tuple[int, int]:
+    """Converts a native position into an (x, y) point."""
+    return (position // POSITION_LIMIT, position % POSITION_LIMIT)
+
+
+class BatchedPushWorldEnv:
+    """A batch of PushWorld environments that are stepped together in C++.
+
+    This class wraps `BatchedPushWorldEnv` from the C++ planner, which must be
+    built first (see `cpp/README.md`). Observations and rewards are identical to
+    those of `pushworld.gym_env.PushWorldEnv`.
+
+    All arrays returned by this class are views of buffers that are shared with the
+    native environment, so no data is copied between C++ and Python. The contents
+    of these arrays are overwritten by the next call of `reset` or `step`, so
+    callers must copy any values that they need to keep.
+
+    Args:
+        puzzle_path: The path of a PushWorld puzzle file or of a directory that
+            contains puzzle files, possibly nested in subdirectories. Each
+            environment plays a randomly selected puzzle after each reset.
+        num_envs: The number of environments in the batch.
+        max_steps: If not None, an episode is truncated after `max_steps` steps.
+        border_width: The pixel width of the border drawn to indicate object
+            boundaries. Must be >= 1.
+        pixels_per_cell: The pixel width and height of a discrete position in the
+            environment. Must be >= 1 + 2 * border_width.
+        standard_padding: If True, all puzzles are padded to the maximum width and
+            height of the puzzles in the `pushworld.config.BENCHMARK_PUZZLES_PATH`
+            directory. If False, puzzles are padded to the maximum dimensions of
+            all puzzles found in the `puzzle_path`.
+        auto_reset: If True, `step` resets every environment whose episode ends,
+            and it returns the first observation of the new episode for that
+            environment.
+        seed: Seeds the random selection of puzzles.
+        library_path: The path of the shared library of the native environment.
+    """
+
+    def __init__(
+        self,
+        puzzle_path: str,
+        num_envs: int,
+        max_steps: Optional[int] = None,
+        border_width: int = DEFAULT_BORDER_WIDTH,
+        pixels_per_cell: int = DEFAULT_PIXELS_PER_CELL,
+        standard_padding: bool = False,
+        auto_reset: bool = True,
+        seed: int = 123,
+        library_path: str = NATIVE_ENV_LIBRARY_PATH,
+    ) -> None:
+        self._puzzle_paths = list(
+            iter_files_with_extension(puzzle_path, PUZZLE_EXTENSION)
+        )
+        if len(self._puzzle_paths) == 0:
+            raise ValueError(f"No PushWorld puzzles found in: {puzzle_path}")
+
+        height_cells, width_cells = (
+            get_max_puzzle_dimensions() if standard_padding else (0, 0)
+        )
+
+        self._lib = _load_library(library_path)
+        paths = (ctypes.c_char_p * len(self._puzzle_paths))(
+            *[path.encode() for path in self._puzzle_paths]
+        )
+        self._env = self._lib.pushworld_env_create(
+            paths,
+            len(self._puzzle_paths),
+            num_envs,
+            0 if max_steps is None else max_steps,
+            auto_reset,
+            height_cells,
+            width_cells,
+            pixels_per_cell,
+            border_width,
+            seed,
+        )
+        if not self._env:
+            raise ValueError(self._lib.pushworld_env_last_error().decode())
+
+        height = ctypes.c_int()
+        width = ctypes.c_int()
+        self._lib.pushworld_env_observation_shape(
+            self._env, ctypes.byref(height), ctypes.byref(width)
+        )
+        state_size = self._lib.pushworld_env_state_size(self._env)
+
+        self._observations = np.zeros(
+            (num_envs, height.value, width.value, 3), np.float32
+        )
+        self._rewards = np.zeros((num_envs,), np.float64)
+        self._terminated = np.zeros((num_envs,), np.bool_)
+        self._truncated = np.zeros((num_envs,), np.bool_)
+        self._actions = np.zeros((num_envs,), np.int32)
+
+        # Views of arrays that are owned by the native environment.
+        self._states = np.ctypeslib.as_array(
+            self._lib.pushworld_env_states(self._env), shape=(num_envs, state_size)
+        )
+        self._puzzle_indices = np.ctypeslib.as_array(
+            self._lib.pushworld_env_puzzle_indices(self._env), shape=(num_envs,)
+        )
+
+    def __del__(self) -> None:
+        if getattr(self, "_env", None):
+            self._lib.pushworld_env_destroy(self._env)
+            self._env = None
+
+    def _check(self, return_value: int) -> None:
+        """Raises the most recent native error if `return_value` indicates one."""
+        if return_value != 0:
+            raise ValueError(self._lib.pushworld_env_last_error().decode())
+
+    @property
+    def num_envs(self) -> int:
+        """The number of environments in the batch."""
+        return self._observations.shape[0]
+
+    @property
+    def puzzle_paths(self) -> List[str]:
+        """The paths of all puzzles, in the order of the puzzle indices."""
+        return self._puzzle_paths
+
+    @property
+    def observation_shape(self) -> Tuple[int, int, int]:
+        """The (height, width, 3) shape of the observation of each environment."""
+        return self._observations.shape[1:]
+
+    @property
+    def observations(self) -> np.ndarray:
+        """The most recent observations, with shape (num_envs, height, width, 3)."""
+        return self._observations
+
+    @property
+    def states(self) -> np.ndarray:
+        """The current states of all environments, as an `int32` array with shape
+        (num_envs, max number of objects). Positions are encoded as
+        `x * POSITION_LIMIT + y`, and positions beyond the number of objects in a
+        puzzle are zero.
+
+        The objects in these states are ordered as in the C++ planner, which can
+        differ from the order of the same objects in `pushworld.puzzle.State`."""
+        return self._states
+
+    @property
+    def puzzle_indices(self) -> np.ndarray:
+        """The index in `puzzle_paths` of the puzzle that each environment plays."""
+        return self._puzzle_indices
+
+    def get_state(self, index: int) -> State:
+        """Returns the state of the environment with the given index as a tuple of
+        (x, y) points, in the object order of `states`."""
+        return tuple(
+            position_to_point(p) for p in self._states[index] if p != 0
+        )
+
+    def reset(self) -> np.ndarray:
+        """Resets all environments to the initial states of randomly selected
+        puzzles, and returns their observations."""
+        self._check(
+            self._lib.pushworld_env_reset(
+                self._env, self._observations.ctypes.data_as(ctypes.c_void_p)
+            )
+        )
+        return self._observations
+
+    def reset_env(self, index: int, puzzle_index: Optional[int] = None) -> np.ndarray:
+        """Resets the environment with the given `index` to the initial state of the
+        puzzle with index `puzzle_index`, or of a randomly selected puzzle if it is
+        None. Returns the observation of this environment."""
+        observation = self._observations[index]
+        self._check(
+            self._lib.pushworld_env_reset_env(
+                self._env,
+                index,
+                -1 if puzzle_index is None else puzzle_index,
+                observation.ctypes.data_as(ctypes.c_void_p),
+            )
+        )
+        return observation
+
+    def step(
+        self, actions: np.ndarray
+    ) -> Tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+        """Performs one action in each environment.
+
+        Args:
+            actions: An array of one action per environment.
+
+        Returns:
+            A tuple of (observations, rewards, terminated, truncated) arrays, each
+            with one element per environment. If `auto_reset` is enabled, the
+            observation of every environment whose episode ended is the first
+            observation of its next episode.
+        """
+        self._actions[:] = actions
+        self._check(
+            self._lib.pushworld_env_step(
+                self._env,
+                self._actions.ctypes.data_as(ctypes.c_void_p),
+                self._observations.ctypes.data_as(ctypes.c_void_p),
+                self._rewards.ctypes.data_as(ctypes.c_void_p),
+                self._terminated.ctypes.data_as(ctypes.c_void_p),
+                self._truncated.ctypes.data_as(ctypes.c_void_p),
+            )
+        )
+        return self._observations, self._rewards, self._terminated, self._truncated
@@ -12,6 +12,7 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import json
 import os
 from typing import Optional
 
@@ -31,6 +32,7 @@ def benchmark_rgd_planner(
     heuristic: str = "N+RGD",
     time_limit: Optional[int] = 60 * 30,
     memory_limit: Optional[float] = 30,
+    record_statistics: bool = False,
 ) -> None:
     """Benchmarks a greedy best-first search using the recursive graph distance
     heuristic on a collection of PushWorld puzzles.
@@ -44,6 +46,8 @@ def benchmark_rgd_planner(
                 plan: <a string of 'UDLR' characters, or `null` if no plan found>
                 planning_time: <the time the planner spent searching for a plan>
                 failure_reason: <if a plan was not found, this summarizes why>
+                search_statistics: <if `record_statistics` is true, the statistics
+                    of the search that the planner printed, when available>
         puzzles_path: The path of the directory from which to load PushWorld puzzles
             to benchmark. Can also be the path of a single PushWorld puzzle file.
         planner_path: The path of the RGD planner executable.
@@ -53,10 +57,13 @@ def benchmark_rgd_planner(
             to run to solve a single puzzle. If None, there is no limit.
         memory_limit: In gigabytes, the maximum memory that the planner is allowed
             to use to solve a single puzzle. If None, there is no limit.
+        record_statistics: Whether to record the search statistics of the planner,
+            such as the number of expanded states, in each result file.
     """
     heuristic_to_planner_name = {
         "N+RGD": "Novelty+RGD",
         "RGD": "RGD",
+        "PORTFOLIO": "Portfolio",
     }
 
     if heuristic not in heuristic_to_planner_name:
@@ -75,14 +82,34 @@ def benchmark_rgd_planner(
             output_extension=".yaml",
         )
     ):
+        command = [RGD_PLANNER_PATH, heuristic, puzzle_file_path]
+        if record_statistics:
+            command[1:1] = ["--statistics", "json"]
+
+        # The planner also checks the limits during its search, so that it
+        # usually stops cleanly and still prints its statistics. The limits of
+        # the process remain as a backstop.
+        if time_limit is not None:
+            command[1:1] = ["--time-limit", str(time_limit)]
+        if memory_limit is not None:
+            command[1:1] = ["--memory-limit", str(memory_limit)]
+
         out, _, planning_time = run_process(
-            command=[RGD_PLANNER_PATH, heuristic, puzzle_file_path],
+            command=command,
             time_limit=time_limit,
             memory_limit=(
                 None if memory_limit is None else int(memory_limit * GIGABYTE)
             ),
         )
 
+        # The statistics are printed on the last line, after the plan.
+        search_statistics = None
+        if record_statistics:
+            lines = out.split("\n")
+            if lines[-1].startswith("{"):
+                search_statistics = json.loads(lines[-1])
+                out = "\n".join(lines[:-1]).strip()
+
         puzzle_name = os.path.splitext(os.path.split(puzzle_file_path)[1])[0]
 
         planning_result = {
@@ -91,7 +118,7 @@ def benchmark_rgd_planner(
             "planning_time": planning_time,
         }
 
-        if out == "":
+        if out == "" or out == "TIME LIMIT REACHED":
             planning_result["failure_reason"] = "time limit reached"
             planning_result["plan"] = None
             planning_result["planning_time"] = time_limit
@@ -100,7 +127,11 @@ def benchmark_rgd_planner(
             planning_result["failure_reason"] = "no solution exists"
             planning_result["plan"] = None
 
-        elif "std::bad_alloc" in out or "failed to map segment" in out:
+        elif (
+            out == "MEMORY LIMIT REACHED"
+            or "std::bad_alloc" in out
+            or "failed to map segment" in out
+        ):
             planning_result["failure_reason"] = "memory error"
             planning_result["plan"] = None
 
@@ -116,5 +147,8 @@ def benchmark_rgd_planner(
             planning_result["failure_reason"] = "unknown"
             planning_result["plan"] = None
 
+        if search_statistics is not None:
+            planning_result["search_statistics"] = search_statistics
+
         with open(planning_result_file_path, "w") as planning_result_file:
             yaml.dump(planning_result, planning_result_file)
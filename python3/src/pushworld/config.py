@@ -30,4 +30,9 @@ BENCHMARK_SOLUTIONS_PATH = os.path.join(BENCHMARK_PATH, "solutions")
 
 # Paths to planner executables
 RGD_PLANNER_PATH = os.path.join(MODULE_PATH, "../../../cpp/build/bin/run_planner")
+
+# Path to the shared library that implements `pushworld.batched_env`
+NATIVE_ENV_LIBRARY_PATH = os.path.join(
+    MODULE_PATH, "../../../cpp/build/lib/libpushworld_env.so"
+)
 FAST_DOWNWARD_PATH = os.path.join(MODULE_PATH, "../../../../downward/fast-downward.py")
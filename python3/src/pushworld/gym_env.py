@@ -18,6 +18,7 @@ from typing import Any, Dict, Optional, Tuple, Union
 import gym
 import numpy as np
 
+from pushworld.batched_env import BatchedPushWorldEnv
 from pushworld.config import PUZZLE_EXTENSION
 from pushworld.puzzle import (
     DEFAULT_BORDER_WIDTH,
@@ -52,6 +53,13 @@ class PushWorldEnv(gym.Env):
             height of the puzzles in the `pushworld.config.BENCHMARK_PUZZLES_PATH`
             directory. If False, puzzles are padded to the maximum dimensions of
             all puzzles found in the `puzzle_path`.
+        backend: Either "python", in which case puzzles are simulated and rendered
+            by `pushworld.puzzle.PushWorldPuzzle`, or "native", in which case they
+            are simulated and rendered in C++ by
+            `pushworld.batched_env.BatchedPushWorldEnv`. Both backends return
+            identical observations and rewards, but with the native backend the
+            objects in the "puzzle_state" of the info dictionary are ordered as in
+            the C++ planner.
     """
 
     def __init__(
@@ -61,6 +69,7 @@ class PushWorldEnv(gym.Env):
         border_width: int = DEFAULT_BORDER_WIDTH,
         pixels_per_cell: int = DEFAULT_PIXELS_PER_CELL,
         standard_padding: bool = False,
+        backend: str = "python",
     ) -> None:
         self._puzzles = []
         for puzzle_file_path in iter_files_with_extension(
@@ -74,6 +83,20 @@ class PushWorldEnv(gym.Env):
             raise ValueError("border_width must be >= 1")
         if pixels_per_cell < 3:
             raise ValueError("pixels_per_cell must be >= 3")
+        if backend not in ("python", "native"):
+            raise ValueError('backend must be "python" or "native"')
+
+        self._native_env = None
+        if backend == "native":
+            self._native_env = BatchedPushWorldEnv(
+                puzzle_path,
+                num_envs=1,
+                max_steps=max_steps,
+                border_width=border_width,
+                pixels_per_cell=pixels_per_cell,
+                standard_padding=standard_padding,
+                auto_reset=False,
+            )
 
         self._max_steps = max_steps
         self._pixels_per_cell = pixels_per_cell
@@ -171,6 +194,15 @@ class PushWorldEnv(gym.Env):
         if seed is not None:
             self._random_generator = random.Random(seed)
 
+        if self._native_env is not None:
+            # Select the puzzle with the same random draw as `random.choice`.
+            puzzle_index = self._random_generator.choice(range(len(self._puzzles)))
+            self._current_puzzle = self._puzzles[puzzle_index]
+            observation = self._native_env.reset_env(0, puzzle_index).copy()
+            self._current_state = self._native_env.get_state(0)
+            self._steps = 0
+            return observation, {"puzzle_state": self._current_state}
+
         self._current_puzzle = self._random_generator.choice(self._puzzles)
         self._current_state = self._current_puzzle.initial_state
         self._current_achieved_goals = self._current_puzzle.count_achieved_goals(
@@ -199,6 +231,20 @@ class PushWorldEnv(gym.Env):
             raise RuntimeError("reset() must be called before step() can be called.")
 
         self._steps += 1
+
+        if self._native_env is not None:
+            observations, rewards, terminated, truncated = self._native_env.step(
+                [action]
+            )
+            self._current_state = self._native_env.get_state(0)
+            return (
+                observations[0].copy(),
+                float(rewards[0]),
+                bool(terminated[0]),
+                bool(truncated[0]),
+                {"puzzle_state": self._current_state},
+            )
+
         previous_state = self._current_state
         self._current_state = self._current_puzzle.get_next_state(
             self._current_state, action
@@ -233,6 +279,18 @@ class PushWorldEnv(gym.Env):
             `uint8` array with shape (height, width, 3).
         """
         assert mode == 'rgb_array', 'mode must be rgb_array.'
+
+        if self._native_env is not None:
+            # Remove the padding from the most recent observation.
+            width, height = self._current_puzzle.dimensions
+            height *= self._pixels_per_cell
+            width *= self._pixels_per_cell
+            observation = self._native_env.observations[0]
+            top = (observation.shape[0] - height) // 2
+            left = (observation.shape[1] - width) // 2
+            image = observation[top : top + height, left : left + width] * 255
+            return np.round(image).astype(np.uint8)
+
         return self._current_puzzle.render(
             self._current_state,
             border_width=self._border_width,
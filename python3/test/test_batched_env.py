@@ -0,0 +1,115 @@
+# Copyright 2022 DeepMind Technologies Limited
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import os
+import random
+
+import numpy as np
+import pytest
+
+from pushworld.batched_env import BatchedPushWorldEnv, position_to_point
+from pushworld.config import NATIVE_ENV_LIBRARY_PATH
+from pushworld.gym_env import PushWorldEnv
+from pushworld.puzzle import Actions, NUM_ACTIONS, PushWorldPuzzle
+
+TEST_PUZZLES_PATH = os.path.join(os.path.split(__file__)[0], "puzzles")
+
+MISSING_NATIVE_LIBRARY = not os.path.exists(NATIVE_ENV_LIBRARY_PATH)
+SKIP_TEST_REASON = (
+    "The native environment library was not found. "
+    "You may need to update `NATIVE_ENV_LIBRARY_PATH` in `src/pushworld/config.py`."
+)
+
+
+@pytest.mark.skipif(MISSING_NATIVE_LIBRARY, reason=SKIP_TEST_REASON)
+@pytest.mark.parametrize("standard_padding", [True, False])
+def test_native_backend(standard_padding: bool):
+    """Checks that the native backend of `PushWorldEnv` returns the same values as
+    the Python backend."""
+    python_env = PushWorldEnv(
+        TEST_PUZZLES_PATH, max_steps=30, standard_padding=standard_padding
+    )
+    native_env = PushWorldEnv(
+        TEST_PUZZLES_PATH,
+        max_steps=30,
+        standard_padding=standard_padding,
+        backend="native",
+    )
+    assert native_env.observation_space == python_env.observation_space
+    random_generator = random.Random(0)
+
+    for episode in range(10):
+        python_observation, _ = python_env.reset()
+        native_observation, _ = native_env.reset()
+        assert native_env.current_puzzle is python_env.current_puzzle
+        assert (native_observation == python_observation).all()
+
+        for step in range(30):
+            action = random_generator.randrange(NUM_ACTIONS)
+            python_result = python_env.step(action)
+            native_result = native_env.step(action)
+            assert (native_result[0] == python_result[0]).all()
+            assert native_result[1:4] == python_result[1:4]
+            assert (native_env.render() == python_env.render()).all()
+            if python_result[2]:
+                break
+
+
+@pytest.mark.skipif(MISSING_NATIVE_LIBRARY, reason=SKIP_TEST_REASON)
+def test_auto_reset():
+    """Checks that `BatchedPushWorldEnv` resets environments whose episodes end."""
+    puzzle_file_path = os.path.join(TEST_PUZZLES_PATH, "trivial.pwp")
+    env = BatchedPushWorldEnv(puzzle_file_path, num_envs=2, max_steps=5)
+    initial_observations = env.reset().copy()
+    assert env.observation_shape == initial_observations.shape[1:]
+    assert (initial_observations[0] == initial_observations[1]).all()
+
+    # Only the first environment solves the puzzle, while the second one pushes
+    # the movable object against a wall.
+    plan = [Actions.RIGHT, Actions.DOWN, Actions.RIGHT, Actions.UP]
+    for action in plan:
+        observations, rewards, terminated, truncated = env.step(
+            [action, Actions.RIGHT]
+        )
+    assert terminated.tolist() == [True, False]
+    assert truncated.tolist() == [False, False]
+    assert rewards[0] == 10
+    assert (observations[0] == initial_observations[0]).all()
+    assert not (observations[1] == initial_observations[1]).all()
+
+    observations, rewards, terminated, truncated = env.step([Actions.RIGHT] * 2)
+    assert terminated.tolist() == [False, False]
+    assert truncated.tolist() == [False, True]
+    assert (observations[1] == initial_observations[1]).all()
+
+
+@pytest.mark.skipif(MISSING_NATIVE_LIBRARY, reason=SKIP_TEST_REASON)
+def test_states():
+    """Checks that the states of `BatchedPushWorldEnv` are shared without copies."""
+    puzzle_file_path = os.path.join(TEST_PUZZLES_PATH, "trivial.pwp")
+    puzzle = PushWorldPuzzle(puzzle_file_path)
+    env = BatchedPushWorldEnv(puzzle_file_path, num_envs=3)
+    env.reset()
+
+    states = env.states
+    assert states.shape == (3, 2)
+    assert env.puzzle_indices.tolist() == [0, 0, 0]
+    assert env.get_state(0) == puzzle.initial_state
+
+    env.step(np.full((3,), Actions.RIGHT))
+    next_state = puzzle.get_next_state(puzzle.initial_state, Actions.RIGHT)
+    assert tuple(position_to_point(p) for p in states[2]) == next_state
+
+    with pytest.raises(ValueError):
+        env.step([NUM_ACTIONS] * 3)
@@ -82,6 +82,30 @@ def test_success():
     assert result.get("failure_reason", None) is None
 
 
+@pytest.mark.skipif(MISSING_PLANNER_EXECUTABLE, reason=SKIP_TEST_REASON)
+def test_record_statistics():
+    """Verifies that search statistics are recorded next to the plan."""
+    puzzle_file_path = os.path.join(
+        BENCHMARK_PUZZLES_PATH, "level2", "Pull Dont Push" + PUZZLE_EXTENSION
+    )
+
+    result = _benchmark_puzzle(
+        puzzle_file_path,
+        time_limit=None,
+        memory_limit=None,
+        record_statistics=True,
+    )
+
+    puzzle = PushWorldPuzzle(puzzle_file_path)
+    plan = [Actions.FROM_CHAR[s] for s in result["plan"].upper()]
+    assert puzzle.is_valid_plan(plan)
+
+    statistics = result["search_statistics"]
+    assert statistics["expansions"] > 0
+    assert statistics["generations"] >= statistics["duplicates"]
+    assert "rgd_pushing_cost_cache_hits" in statistics["heuristic_counters"]
+
+
 @pytest.mark.skipif(MISSING_PLANNER_EXECUTABLE, reason=SKIP_TEST_REASON)
 def test_time_limit():
     """Verifies that `benchmark_rgd_planner` detects when a puzzle reaches the